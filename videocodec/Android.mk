@@ -181,7 +181,8 @@ endif
 LOCAL_SRC_FILES := \
     OMXComponentCodecBase.cpp\
     OMXVideoDecoderBase.cpp\
-    OMXVideoDecoderVP9HWR.cpp
+    OMXVideoDecoderVP9HWR.cpp\
+    VP9DecodeQueue.cpp
 
 LOCAL_LDFLAGS := -Wl,--no-warn-shared-textrel
 LOCAL_MODULE_TAGS := optional
@@ -199,6 +200,21 @@ endif
 include $(BUILD_SHARED_LIBRARY)
 # end VP9 SW decode and HW Render
 
+# Host test of the VP9 decode queue
+include $(CLEAR_VARS)
+LOCAL_SRC_FILES := \
+    VP9DecodeQueue.cpp\
+    test/VP9DecodeQueueTest.cpp
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH) \
+    $(LOCAL_PATH)/libvpx_internal/libvpx
+
+LOCAL_LDLIBS := -lpthread
+LOCAL_MODULE_TAGS := tests
+LOCAL_MODULE := vp9_decode_queue_test
+include $(BUILD_HOST_EXECUTABLE)
+
 
 include $(CLEAR_VARS)
 ifeq ($(TARGET_HAS_ISV),true)
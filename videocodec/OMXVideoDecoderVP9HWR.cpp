@@ -74,6 +74,14 @@ OMXVideoDecoderVP9HWR::OMXVideoDecoderVP9HWR()
     mNativeBufferCount = OUTPORT_NATIVE_BUFFER_COUNT;
     extUtilBufferCount = 0;
     extMappedNativeBufferCount = 0;
+    extRawBufferCount = 0;
+    extRawBufferSize = 0;
+    extRawBufferStride = 0;
+    extRawBufferHeightStride = 0;
+    extRawFrameStride = 0;
+    extRawFrameHeightStride = 0;
+    memset(&extPool, 0, sizeof(extPool));
+    memset(&extRawPool, 0, sizeof(extRawPool));
     BuildHandlerList();
 
     mDecodedImageWidth = 0;
@@ -81,6 +89,10 @@ OMXVideoDecoderVP9HWR::OMXVideoDecoderVP9HWR()
     mDecodedImageNewWidth = 0;
     mDecodedImageNewHeight = 0;
 
+    mDecodeQueue = NULL;
+    mHasOutputFrame = false;
+    mInputEoSQueued = false;
+
 #ifdef DECODE_WITH_GRALLOC_BUFFER
     // setup va
     VAStatus vaStatus = VA_STATUS_SUCCESS;
@@ -127,27 +139,22 @@ int getVP9FrameBuffer(void *user_priv,
         return -1; 
     }
 
+    // Raw data mode: decode straight into an output buffer when the frame
+    // fits the port, so FillRenderBuffer() has nothing to copy.
+    if ((ph->extRawBufferCount > 0) &&
+        (fb->fb_stride == ph->extRawFrameStride) &&
+        (fb->fb_height_stride == ph->extRawFrameHeightStride) &&
+        (vp9_get_frame_buffer(&ph->extRawPool, new_size, fb) == 0)) {
+        return 0;
+    }
+
     // TODO: Adaptive playback case needs to reconsider
     if (ph->extNativeBufferSize < new_size) {
         LOGE("Provided frame buffer size < requesting min size.");
         return -1;
     }
 
-    int i;
-    for (i = 0; i < ph->extMappedNativeBufferCount; i++ ) {
-        if ((ph->extMIDs[i]->m_render_done == true) &&
-            (ph->extMIDs[i]->m_released == true)) {
-            fb->data = ph->extMIDs[i]->m_usrAddr;
-            fb->size = ph->extNativeBufferSize;
-            fb->fb_stride = ph->extActualBufferStride;
-            fb->fb_height_stride = ph->extActualBufferHeightStride;
-            fb->fb_index = i;
-            ph->extMIDs[i]->m_released = false;
-            break;
-        }
-    }
-
-    if (i == ph->extMappedNativeBufferCount) {
+    if (vp9_get_frame_buffer(&ph->extPool, new_size, fb) != 0) {
         LOGE("No available frame buffer in pool.");
         return -1;
     }
@@ -155,24 +162,16 @@ int getVP9FrameBuffer(void *user_priv,
 }
 
 // call back function from libvpx to inform frame buffer
-// not used anymore.
+// is no longer referenced by the decoder.
 int releaseVP9FrameBuffer(void *user_priv, vpx_codec_frame_buffer_t *fb)
 {
     OMXVideoDecoderVP9HWR *ph = (OMXVideoDecoderVP9HWR *)user_priv;
-    if (fb == NULL || ph == NULL) {
+    if (fb == NULL || ph == NULL || fb->priv == NULL) {
         return -1; 
     }
 
-    int i;
-    for (i = 0; i < ph->extMappedNativeBufferCount; i++ ) {
-        if (fb->data == ph->extMIDs[i]->m_usrAddr) {
-            ph->extMIDs[i]->m_released = true;
-            break;
-        }
-    }
-
-    if (i == ph->extMappedNativeBufferCount) {
-        LOGE("Not found matching frame buffer in pool, libvpx's wrong?");
+    if (vp9_release_frame_buffer(NULL, fb) != 0) {
+        LOGE("Frame buffer %d is not held by the decoder, libvpx's wrong?", fb->fb_index);
         return -1;
     }
     return 0; 
@@ -241,6 +240,16 @@ OMX_ERRORTYPE OMXVideoDecoderVP9HWR::ProcessorInit(void)
 
     initDecoder();
 
+#ifdef DECODE_WITH_DECODE_THREAD
+    mDecodeQueue = new VP9DecodeQueue(this, DECODE_QUEUE_INPUT_DEPTH,
+                                      DECODE_QUEUE_OUTPUT_DEPTH, 1);
+    if (!mDecodeQueue->start()) {
+        LOGW("Failed to start the decode thread, decoding in ProcessorProcess().");
+        delete mDecodeQueue;
+        mDecodeQueue = NULL;
+    }
+#endif
+
     if (RAWDATA_MODE == mWorkingMode) {
         OMX_PARAM_PORTDEFINITIONTYPE paramPortDefinitionInput;
 
@@ -253,13 +262,28 @@ OMX_ERRORTYPE OMXVideoDecoderVP9HWR::ProcessorInit(void)
         extActualBufferStride = INTERNAL_MAX_FRAME_WIDTH;
         extActualBufferHeightStride = INTERNAL_MAX_FRAME_HEIGHT;
 
+        if (vp9_frame_buffer_pool_init(&extPool, OUTPORT_ACTUAL_BUFFER_COUNT, 0)) {
+            return OMX_ErrorInsufficientResources;
+        }
         for (i = 0; i < OUTPORT_ACTUAL_BUFFER_COUNT; i++ ) {
             extMIDs[i]->m_usrAddr = (unsigned char*)malloc(sizeof(unsigned char) *
                                     extNativeBufferSize);
-            extMIDs[i]->m_render_done = true;
-            extMIDs[i]->m_released = true;
+            if (extMIDs[i]->m_usrAddr == NULL) {
+                return OMX_ErrorInsufficientResources;
+            }
+            // in Raw data mode these are never handed out, so free right away
+            vp9_frame_buffer_pool_add(&extPool, extMIDs[i]->m_usrAddr, extNativeBufferSize,
+                                      extActualBufferStride, extActualBufferHeightStride);
+            vp9_frame_buffer_pool_unhold(&extPool, i, VP9_FB_HELD_BY_APP);
         }
         extMappedNativeBufferCount = OUTPORT_ACTUAL_BUFFER_COUNT;
+        extRawBufferCount = 0;
+        if (vp9_frame_buffer_pool_init(&extRawPool,
+                                       MAX_NATIVE_BUFFER_COUNT - extMappedNativeBufferCount,
+                                       extMappedNativeBufferCount)) {
+            return OMX_ErrorInsufficientResources;
+        }
+        updateRawBufferLayout();
         return OMX_ErrorNone;
     }
 
@@ -284,12 +308,14 @@ OMX_ERRORTYPE OMXVideoDecoderVP9HWR::ProcessorInit(void)
     extActualBufferStride = surfaceStride;
     extActualBufferHeightStride = surfaceHeight;
 
+    if (vp9_frame_buffer_pool_init(&extPool, mOMXBufferHeaderTypePtrNum, 0)) {
+        return OMX_ErrorInsufficientResources;
+    }
+
     for (i = 0; i < mOMXBufferHeaderTypePtrNum; i++) {
         OMX_BUFFERHEADERTYPE *buf_hdr = mOMXBufferHeaderTypePtrArray[i];
 
         extMIDs[i]->m_key = (unsigned int)(buf_hdr->pBuffer);
-        extMIDs[i]->m_render_done = false;
-        extMIDs[i]->m_released = true;
 
 
         VAStatus va_res; 
@@ -359,8 +385,14 @@ OMX_ERRORTYPE OMXVideoDecoderVP9HWR::ProcessorInit(void)
         // perform a cl flush here
         if (extMIDs[i]->m_usrAddr != NULL) {
             vp9CLflush((void*)extMIDs[i]->m_usrAddr, extNativeBufferSize);
+        } else {
+            LOGE("Failed to map vaSurface!");
+            return OMX_ErrorUndefined;
         }
-        
+
+        // The buffer is held by the client until it is filled for the first time.
+        vp9_frame_buffer_pool_add(&extPool, extMIDs[i]->m_usrAddr, extNativeBufferSize,
+                                  extActualBufferStride, extActualBufferHeightStride);
         extMappedNativeBufferCount++;
     }
     return OMX_ErrorNone;
@@ -369,10 +401,27 @@ OMX_ERRORTYPE OMXVideoDecoderVP9HWR::ProcessorInit(void)
 
 OMX_ERRORTYPE OMXVideoDecoderVP9HWR::ProcessorDeinit(void)
 {
+    if (mDecodeQueue != NULL) {
+        delete mDecodeQueue;
+        mDecodeQueue = NULL;
+    }
+    if (mHasOutputFrame) {
+        dropFrame(mOutputFrame);
+        mHasOutputFrame = false;
+    }
+    mInputEoSQueued = false;
+
     destroyDecoder();
 
     unsigned int i = 0;
 
+    LOGI("Frame buffers: peak %d of %d in use, %d gets failed.",
+         extPool.peak_in_use + extRawPool.peak_in_use,
+         extPool.num_buffers + extRawPool.num_buffers,
+         extPool.failed_gets + extRawPool.failed_gets);
+    vp9_frame_buffer_pool_free(&extPool);
+    vp9_frame_buffer_pool_free(&extRawPool);
+
     if (mWorkingMode == GRAPHICBUFFER_MODE) {
         for (i = 0; i < mOMXBufferHeaderTypePtrNum; i++) {
             if (extMIDs[i]->m_surface != NULL) {
@@ -387,7 +436,12 @@ OMX_ERRORTYPE OMXVideoDecoderVP9HWR::ProcessorDeinit(void)
                 extMIDs[i]->m_usrAddr = NULL;
             }
         }
+        for (i = 0; i < extRawBufferCount; i++) {
+            extMIDs[extMappedNativeBufferCount + i]->m_usrAddr = NULL;
+        }
+        extRawBufferCount = 0;
     }
+    extMappedNativeBufferCount = 0;
 
     mOMXBufferHeaderTypePtrNum = 0;
     memset(&mGraphicBufferParam, 0, sizeof(mGraphicBufferParam));
@@ -406,6 +460,15 @@ OMX_ERRORTYPE OMXVideoDecoderVP9HWR::ProcessorStop(void)
 
 OMX_ERRORTYPE OMXVideoDecoderVP9HWR::ProcessorFlush(OMX_U32 portIndex)
 {
+    // Decoded frames may sit in buffers the port is giving back.
+    if (mDecodeQueue != NULL) {
+        mDecodeQueue->flush();
+        if (mHasOutputFrame) {
+            dropFrame(mOutputFrame);
+            mHasOutputFrame = false;
+        }
+        mInputEoSQueued = false;
+    }
     return OMX_ErrorNone;
 }
 
@@ -414,13 +477,26 @@ OMX_ERRORTYPE OMXVideoDecoderVP9HWR::ProcessorPreFillBuffer(OMX_BUFFERHEADERTYPE
     unsigned int handle = (unsigned int)buffer->pBuffer;
     unsigned int i = 0;
 
+    if (mWorkingMode == RAWDATA_MODE) {
+        if (buffer->nOutputPortIndex == OUTPORT_INDEX) {
+            registerRawBuffer(buffer);
+            if (mDecodeQueue != NULL) {
+                mDecodeQueue->signal();
+            }
+        }
+        return OMX_ErrorNone;
+    }
+
     if (buffer->nOutputPortIndex == OUTPORT_INDEX){
-        for (i = 0; i < mOMXBufferHeaderTypePtrNum; i++) {
+        for (i = 0; i < (unsigned int)extPool.num_buffers; i++) {
             if (handle == extMIDs[i]->m_key) {
-                extMIDs[i]->m_render_done = true;
+                vp9_frame_buffer_pool_unhold(&extPool, i, VP9_FB_HELD_BY_APP);
                 break;
             }
         }
+        if (mDecodeQueue != NULL) {
+            mDecodeQueue->signal();
+        }
     }
     return OMX_ErrorNone;
 }
@@ -449,6 +525,10 @@ OMX_ERRORTYPE OMXVideoDecoderVP9HWR::ProcessorProcess(
         LOGW("Buffer has OMX_BUFFERFLAG_DECODEONLY flag.");
     }
 
+    if (mDecodeQueue != NULL) {
+        return processAsync(pBuffers, retains);
+    }
+
     if (inBuffer->nFlags & OMX_BUFFERFLAG_EOS) {
         if (inBuffer->nFilledLen == 0) {
             (*pBuffers[OUTPORT_INDEX])->nFilledLen = 0;
@@ -498,6 +578,165 @@ OMX_ERRORTYPE OMXVideoDecoderVP9HWR::ProcessorProcess(
     return ret;
 }
 
+// Decode thread mode: the input is copied to the decode queue and returned
+// right away, and the output buffer gets the oldest decoded frame. The
+// processing thread only waits for the decoder when it can not take more
+// input.
+OMX_ERRORTYPE OMXVideoDecoderVP9HWR::processAsync(OMX_BUFFERHEADERTYPE ***pBuffers,
+                                                  buffer_retain_t *retains)
+{
+    OMX_ERRORTYPE ret = OMX_ErrorNone;
+    OMX_BUFFERHEADERTYPE *inBuffer = *pBuffers[INPORT_INDEX];
+    OMX_BUFFERHEADERTYPE *outBuffer = *pBuffers[OUTPORT_INDEX];
+    OMX_BOOL isResolutionChange = OMX_FALSE;
+    bool inputEoS = (inBuffer->nFlags & OMX_BUFFERFLAG_EOS);
+    bool outputEoS = false;
+
+    if (inBuffer->nFilledLen > 0 || (inputEoS && !mInputEoSQueued)) {
+        if (mDecodeQueue->queueInput(inBuffer->pBuffer + inBuffer->nOffset,
+                                     inBuffer->nFilledLen,
+                                     inBuffer->nTimeStamp,
+                                     inBuffer->nFlags)) {
+            mInputEoSQueued = inputEoS;
+        } else {
+            retains[INPORT_INDEX] = BUFFER_RETAIN_GETAGAIN;
+        }
+    }
+
+    if (!mHasOutputFrame) {
+        bool wait = (retains[INPORT_INDEX] == BUFFER_RETAIN_GETAGAIN) || mInputEoSQueued;
+        mHasOutputFrame = mDecodeQueue->dequeueOutput(&mOutputFrame, wait);
+    }
+
+    if (!mHasOutputFrame) {
+        retains[OUTPORT_INDEX] = BUFFER_RETAIN_GETAGAIN;
+    } else if (!mOutputFrame.hasImage) {
+        // A failed decode or the end of the stream.
+        if (mOutputFrame.status != 0) {
+            ret = OMX_ErrorBadParameter;
+        }
+        if (mOutputFrame.flags & OMX_BUFFERFLAG_EOS) {
+            outBuffer->nFilledLen = 0;
+            outBuffer->nFlags = OMX_BUFFERFLAG_EOS;
+            outputEoS = true;
+        } else {
+            retains[OUTPORT_INDEX] = BUFFER_RETAIN_GETAGAIN;
+        }
+        mHasOutputFrame = false;
+    } else {
+        ret = FillRenderBuffer(pBuffers[OUTPORT_INDEX],
+                               &retains[OUTPORT_INDEX],
+                               mOutputFrame.flags,
+                               &isResolutionChange);
+        if (ret == OMX_ErrorNone) {
+            (*pBuffers[OUTPORT_INDEX])->nTimeStamp = mOutputFrame.timeStamp;
+            outputEoS = (mOutputFrame.flags & OMX_BUFFERFLAG_EOS);
+            // The frame has been copied or is held by the client now.
+            dropFrame(mOutputFrame);
+            mHasOutputFrame = false;
+            mDecodeQueue->signal();
+        } else if (ret == OMX_ErrorNotReady) {
+            retains[OUTPORT_INDEX] = BUFFER_RETAIN_GETAGAIN;
+            ret = OMX_ErrorNone;
+        }
+    }
+
+    if (isResolutionChange) {
+        HandleFormatChange();
+    }
+
+    // Retain the EOS input until the EOS has been output.
+    if (outputEoS) {
+        mInputEoSQueued = false;
+    } else if (inputEoS) {
+        retains[INPORT_INDEX] = BUFFER_RETAIN_GETAGAIN;
+        if (mInputEoSQueued) {
+            inBuffer->nFilledLen = 0;
+        }
+    }
+
+    return ret;
+}
+
+int OMXVideoDecoderVP9HWR::decodeInput(const VP9DecodeQueue::InputBuffer &input,
+                                       VP9DecodeQueue::OutputFrame *frames,
+                                       int maxFrames)
+{
+    int count = 0;
+
+    if (input.size > 0 &&
+        vpx_codec_decode((vpx_codec_ctx_t *)mCtx, input.data, input.size, NULL, 0)) {
+        LOGE("on2 decoder failed to decode frame.");
+        memset(&frames[0], 0, sizeof(frames[0]));
+        frames[0].status = -1;
+        frames[0].timeStamp = input.timeStamp;
+        frames[0].flags = input.flags;
+        return 1;
+    }
+
+    vpx_codec_iter_t iter = NULL;
+    vpx_image_t *img = NULL;
+    while (count < maxFrames &&
+           (img = vpx_codec_get_frame((vpx_codec_ctx_t *)mCtx, &iter)) != NULL) {
+        // libvpx may release the frame buffer on the next decode while the
+        // frame is still queued.
+        if (vp9_frame_buffer_pool_hold(frameBufferPool(img->fb_index), img->fb_index,
+                                       FB_HELD_BY_DECODE_QUEUE) != 0) {
+            LOGE("Frame buffer %d of a decoded frame is not in use.", img->fb_index);
+            continue;
+        }
+        frames[count].image = *img;
+        frames[count].hasImage = true;
+        frames[count].status = 0;
+        frames[count].timeStamp = input.timeStamp;
+        frames[count].flags = 0;
+        count++;
+    }
+
+    // EOS goes out with the last frame of the input, or on its own.
+    if (input.flags & OMX_BUFFERFLAG_EOS) {
+        if (count == 0) {
+            memset(&frames[0], 0, sizeof(frames[0]));
+            frames[0].timeStamp = input.timeStamp;
+            count = 1;
+        }
+        frames[count - 1].flags |= OMX_BUFFERFLAG_EOS;
+    }
+    return count;
+}
+
+bool OMXVideoDecoderVP9HWR::canDecode()
+{
+    return hasFreeFrameBuffers();
+}
+
+void OMXVideoDecoderVP9HWR::dropFrame(const VP9DecodeQueue::OutputFrame &frame)
+{
+    if (frame.hasImage) {
+        vp9_frame_buffer_pool_unhold(frameBufferPool(frame.image.fb_index),
+                                     frame.image.fb_index, FB_HELD_BY_DECODE_QUEUE);
+    }
+}
+
+VP9FrameBufferPool *OMXVideoDecoderVP9HWR::frameBufferPool(int fbIndex)
+{
+    return fbIndex >= extMappedNativeBufferCount ? &extRawPool : &extPool;
+}
+
+bool OMXVideoDecoderVP9HWR::hasFreeFrameBuffers()
+{
+    // Once output buffers are decoded into in raw data mode, they are the
+    // ones that have to be free; frames in the internal buffers are copied
+    // to them.
+    const VP9FrameBufferPool *pool = &extPool;
+    if (RAWDATA_MODE == mWorkingMode && extRawBufferCount > 0) {
+        pool = &extRawPool;
+    }
+
+    //libvpx sometimes needs 2 buffer when calling decode once.
+    return pool->num_free > 1;
+}
+
 OMX_ERRORTYPE OMXVideoDecoderVP9HWR::ProcessorReset(void)
 {
     return OMX_ErrorNone;
@@ -509,6 +748,110 @@ static int ALIGN(int x, int y)
     return (x + y - 1) & ~(y - 1); 
 }
 
+// Raw data mode: the output buffers can be decoded into when the port lays
+// out the frame the way libvpx does with an external stride: a luma stride
+// aligned to 32, so that the chroma stride is half of it, the V and then the
+// U plane after nSliceHeight luma rows, and no border.
+void OMXVideoDecoderVP9HWR::updateRawBufferLayout()
+{
+    const OMX_PARAM_PORTDEFINITIONTYPE *paramPortDefinitionOutput
+                                  = this->ports[OUTPORT_INDEX]->GetPortDefinition();
+    int width = paramPortDefinitionOutput->format.video.nFrameWidth;
+    int height = paramPortDefinitionOutput->format.video.nFrameHeight;
+    int stride = paramPortDefinitionOutput->format.video.nStride;
+    int sliceHeight = paramPortDefinitionOutput->format.video.nSliceHeight;
+    unsigned int size = stride * sliceHeight * 3 / 2;
+
+    extRawBufferSize = 0;
+    extRawBufferStride = 0;
+    extRawBufferHeightStride = 0;
+    extRawFrameStride = 0;
+    extRawFrameHeightStride = 0;
+
+    if (VPX_DECODE_BORDER != 0 || (stride & 0x1f) != 0 || (sliceHeight & 1) != 0 ||
+        stride < ALIGN(width, 32) || sliceHeight < ALIGN(height, 32) ||
+        size > paramPortDefinitionOutput->nBufferSize) {
+        LOGV("Output port layout %dx%d can not be decoded into.", stride, sliceHeight);
+        return;
+    }
+
+    extRawBufferSize = size;
+    extRawBufferStride = stride;
+    extRawBufferHeightStride = sliceHeight;
+    extRawFrameStride = ALIGN(width, 32);
+    extRawFrameHeightStride = ALIGN(height, 32);
+}
+
+int OMXVideoDecoderVP9HWR::findRawBuffer(OMX_BUFFERHEADERTYPE *buffer)
+{
+    for (int i = 0; i < extRawBufferCount; i++) {
+        if (mOMXBufferHeaderTypePtrArray[i] == buffer) {
+            return extMappedNativeBufferCount + i;
+        }
+    }
+    return -1;
+}
+
+// Raw data mode: called whenever an output buffer is handed to the component.
+// A buffer is registered the first time it comes in and can be decoded into
+// whenever libvpx has released it.
+void OMXVideoDecoderVP9HWR::registerRawBuffer(OMX_BUFFERHEADERTYPE *buffer)
+{
+    int i = findRawBuffer(buffer);
+
+    if (i < 0) {
+        if (extRawBufferStride == 0) {
+            return;
+        }
+        if (extRawBufferCount >= MAX_GRAPHIC_BUFFER_NUM ||
+            (i = vp9_frame_buffer_pool_add(&extRawPool, buffer->pBuffer, extRawBufferSize,
+                                           extRawBufferStride, extRawBufferHeightStride)) < 0) {
+            LOGW("Too many output buffers, buffer %p is only copied to.", buffer);
+            return;
+        }
+        extMIDs[i]->m_key = (unsigned int)(buffer->pBuffer);
+        extMIDs[i]->m_usrAddr = buffer->pBuffer;
+        mOMXBufferHeaderTypePtrArray[extRawBufferCount++] = buffer;
+    }
+    vp9_frame_buffer_pool_unhold(&extRawPool, i, VP9_FB_HELD_BY_APP);
+}
+
+// Raw data mode: the output buffers are freed when the port is reconfigured.
+// If libvpx still references frames in them the decoder has to be restarted,
+// decoding then resumes with the next key frame.
+void OMXVideoDecoderVP9HWR::releaseRawBuffers()
+{
+    if (mDecodeQueue != NULL) {
+        mDecodeQueue->pause();
+    }
+
+    for (int i = 0; i < extRawPool.num_buffers; i++) {
+        if (extRawPool.fb[i].holders & (VP9_FB_HELD_BY_DECODER | FB_HELD_BY_DECODE_QUEUE)) {
+            LOGW("Output buffers are still referenced, restarting the decoder.");
+            if (mDecodeQueue != NULL) {
+                mDecodeQueue->flush();
+            }
+            destroyDecoder();
+            initDecoder();
+            break;
+        }
+    }
+
+    for (int i = 0; i < extRawBufferCount; i++) {
+        extMIDs[extMappedNativeBufferCount + i]->m_usrAddr = NULL;
+    }
+    extRawBufferCount = 0;
+
+    int maxBuffers = extRawPool.max_buffers;
+    vp9_frame_buffer_pool_free(&extRawPool);
+    vp9_frame_buffer_pool_init(&extRawPool, maxBuffers, extMappedNativeBufferCount);
+    updateRawBufferLayout();
+
+    if (mDecodeQueue != NULL) {
+        mDecodeQueue->resume();
+    }
+}
+
 OMX_ERRORTYPE OMXVideoDecoderVP9HWR::HandleFormatChange(void)
 {
     mDecodedImageWidth = mDecodedImageNewWidth;
@@ -532,12 +875,14 @@ OMX_ERRORTYPE OMXVideoDecoderVP9HWR::HandleFormatChange(void)
 
     int widthCropped = mDecodedImageWidth;
     int heightCropped = mDecodedImageHeight;
-    int strideCropped = widthCropped;
-    int sliceHeightCropped = heightCropped;
+    // In raw data mode the frames are laid out the way libvpx decodes them,
+    // see updateRawBufferLayout().
+    int strideCropped = ALIGN(widthCropped, 32);
+    int sliceHeightCropped = ALIGN(heightCropped, 32);
 
     if (widthCropped == paramPortDefinitionOutput.format.video.nFrameWidth &&
         heightCropped == paramPortDefinitionOutput.format.video.nFrameHeight) {
-        if (mWorkingMode == RAWDATA_MODE) {
+        if (mWorkingMode == RAWDATA_MODE && extRawBufferStride != 0) {
             LOGW("Change of portsetting is not reported as size is not changed.");
             return OMX_ErrorNone;
         }
@@ -553,6 +898,7 @@ OMX_ERRORTYPE OMXVideoDecoderVP9HWR::HandleFormatChange(void)
         paramPortDefinitionOutput.format.video.nFrameHeight = heightCropped;
         paramPortDefinitionOutput.format.video.nStride = strideCropped;
         paramPortDefinitionOutput.format.video.nSliceHeight = sliceHeightCropped;
+        paramPortDefinitionOutput.nBufferSize = strideCropped * sliceHeightCropped * 3 / 2;
     } else if (mWorkingMode == GRAPHICBUFFER_MODE) {
         // when the width and height ES parse are not larger than allocated graphic buffer in outport,
         // there is no need to reallocate graphic buffer,just report the crop info to omx client
@@ -585,6 +931,10 @@ OMX_ERRORTYPE OMXVideoDecoderVP9HWR::HandleFormatChange(void)
     this->ports[INPORT_INDEX]->SetPortDefinition(&paramPortDefinitionInput, true);
     this->ports[OUTPORT_INDEX]->SetPortDefinition(&paramPortDefinitionOutput, true);
 
+    if (mWorkingMode == RAWDATA_MODE) {
+        releaseRawBuffers();
+    }
+
     this->ports[OUTPORT_INDEX]->ReportPortSettingsChanged();
     return OMX_ErrorNone;
 }
@@ -601,12 +951,22 @@ OMX_ERRORTYPE OMXVideoDecoderVP9HWR::FillRenderBuffer(OMX_BUFFERHEADERTYPE **pBu
 
     vpx_codec_iter_t iter = NULL;
     vpx_image_t *img = NULL;
-    img = vpx_codec_get_frame((vpx_codec_ctx_t *)mCtx, &iter);
+    if (mDecodeQueue != NULL) {
+        img = mHasOutputFrame ? &mOutputFrame.image : NULL;
+    } else {
+        img = vpx_codec_get_frame((vpx_codec_ctx_t *)mCtx, &iter);
+    }
 
     if (img != NULL) {
         if ((mDecodedImageWidth == 0) && (mDecodedImageHeight == 0)) { // init value
             mDecodedImageWidth = img->d_w;
             mDecodedImageHeight = img->d_h;
+            // Report a layout that can be decoded into in raw data mode.
+            if (mWorkingMode == RAWDATA_MODE && extRawBufferStride == 0) {
+                mDecodedImageNewWidth = img->d_w;
+                mDecodedImageNewHeight = img->d_h;
+                *isResolutionChange = OMX_TRUE;
+            }
         }
         if ((mDecodedImageWidth != img->d_w) && (mDecodedImageHeight != img->d_h)) {
             mDecodedImageNewWidth = img->d_w;
@@ -621,55 +981,69 @@ OMX_ERRORTYPE OMXVideoDecoderVP9HWR::FillRenderBuffer(OMX_BUFFERHEADERTYPE **pBu
             return OMX_ErrorNotReady;
         }
 
-        // in Raw data mode, this flag should be always true
-        extMIDs[img->fb_index]->m_render_done = true;
-
-        void *dst = buffer->pBuffer;
-        uint8_t *dst_y = (uint8_t *)dst;
-        const OMX_PARAM_PORTDEFINITIONTYPE *paramPortDefinitionInput
-                                      = this->ports[INPORT_INDEX]->GetPortDefinition();
-
-        size_t inBufferWidth = paramPortDefinitionInput->format.video.nFrameWidth;
-        size_t inBufferHeight = paramPortDefinitionInput->format.video.nFrameHeight;
-
         const OMX_PARAM_PORTDEFINITIONTYPE *paramPortDefinitionOutput
                                       = this->ports[OUTPORT_INDEX]->GetPortDefinition();
 
-        size_t dst_y_size = paramPortDefinitionOutput->format.video.nStride *
-                            paramPortDefinitionOutput->format.video.nFrameHeight;
-        size_t dst_c_stride = ALIGN(paramPortDefinitionOutput->format.video.nStride / 2, 16);
-        size_t dst_c_size = dst_c_stride * paramPortDefinitionOutput->format.video.nFrameHeight / 2;
-        uint8_t *dst_v = dst_y + dst_y_size;
-        uint8_t *dst_u = dst_v + dst_c_size;
+        size_t dst_stride = paramPortDefinitionOutput->format.video.nStride;
+        size_t dst_slice_height = paramPortDefinitionOutput->format.video.nSliceHeight;
+        if (dst_slice_height < paramPortDefinitionOutput->format.video.nFrameHeight) {
+            dst_slice_height = paramPortDefinitionOutput->format.video.nFrameHeight;
+        }
+        size_t dst_y_size = dst_stride * dst_slice_height;
+        size_t dst_c_stride = ALIGN(dst_stride / 2, 16);
+        size_t dst_c_size = dst_c_stride * dst_slice_height / 2;
+
+        if (img->fb_index >= extMappedNativeBufferCount) {
+            // Decoded in place, hand out the output buffer holding the frame.
+            buffer = *pBuffer =
+                mOMXBufferHeaderTypePtrArray[img->fb_index - extMappedNativeBufferCount];
+            vp9_frame_buffer_pool_hold(&extRawPool, img->fb_index, VP9_FB_HELD_BY_APP);
+        } else if (extRawBufferCount > 0) {
+            // The offered output buffer may hold a frame that libvpx still
+            // references, copy to one that neither libvpx nor the client holds.
+            int index = vp9_frame_buffer_pool_take(&extRawPool, VP9_FB_HELD_BY_APP);
+            if (index < 0) {
+                LOGE("No released output buffer to copy the frame to.");
+                return OMX_ErrorNotReady;
+            }
+            buffer = *pBuffer =
+                mOMXBufferHeaderTypePtrArray[index - extMappedNativeBufferCount];
+        }
+
+        if (img->fb_index < extMappedNativeBufferCount) {
+            uint8_t *dst_y = (uint8_t *)buffer->pBuffer;
+            uint8_t *dst_v = dst_y + dst_y_size;
+            uint8_t *dst_u = dst_v + dst_c_size;
 
-        //test border
-        dst_y += VPX_DECODE_BORDER * paramPortDefinitionOutput->format.video.nStride + VPX_DECODE_BORDER;
-        dst_v += (VPX_DECODE_BORDER/2) * dst_c_stride + (VPX_DECODE_BORDER/2);
-        dst_u += (VPX_DECODE_BORDER/2) * dst_c_stride + (VPX_DECODE_BORDER/2);
+            //test border
+            dst_y += VPX_DECODE_BORDER * dst_stride + VPX_DECODE_BORDER;
+            dst_v += (VPX_DECODE_BORDER/2) * dst_c_stride + (VPX_DECODE_BORDER/2);
+            dst_u += (VPX_DECODE_BORDER/2) * dst_c_stride + (VPX_DECODE_BORDER/2);
 
-        const uint8_t *srcLine = (const uint8_t *)img->planes[PLANE_Y];
+            const uint8_t *srcLine = (const uint8_t *)img->planes[PLANE_Y];
 
-        for (size_t i = 0; i < img->d_h; ++i) {
-            memcpy(dst_y, srcLine, img->d_w);
+            for (size_t i = 0; i < img->d_h; ++i) {
+                memcpy(dst_y, srcLine, img->d_w);
 
-            srcLine += img->stride[PLANE_Y];
-            dst_y += paramPortDefinitionOutput->format.video.nStride;
-        }
+                srcLine += img->stride[PLANE_Y];
+                dst_y += dst_stride;
+            }
 
-        srcLine = (const uint8_t *)img->planes[PLANE_U];
-        for (size_t i = 0; i < img->d_h / 2; ++i) {
-            memcpy(dst_u, srcLine, img->d_w / 2);
+            srcLine = (const uint8_t *)img->planes[PLANE_U];
+            for (size_t i = 0; i < img->d_h / 2; ++i) {
+                memcpy(dst_u, srcLine, img->d_w / 2);
 
-            srcLine += img->stride[PLANE_U];
-            dst_u += dst_c_stride;
-        }
+                srcLine += img->stride[PLANE_U];
+                dst_u += dst_c_stride;
+            }
 
-        srcLine = (const uint8_t *)img->planes[PLANE_V];
-        for (size_t i = 0; i < img->d_h / 2; ++i) {
-            memcpy(dst_v, srcLine, img->d_w / 2);
+            srcLine = (const uint8_t *)img->planes[PLANE_V];
+            for (size_t i = 0; i < img->d_h / 2; ++i) {
+                memcpy(dst_v, srcLine, img->d_w / 2);
 
-            srcLine += img->stride[PLANE_V];
-            dst_v += dst_c_stride;
+                srcLine += img->stride[PLANE_V];
+                dst_v += dst_c_stride;
+            }
         }
 
         buffer->nOffset = 0;
@@ -697,7 +1071,8 @@ OMX_ERRORTYPE OMXVideoDecoderVP9HWR::FillRenderBuffer(OMX_BUFFERHEADERTYPE **pBu
             return OMX_ErrorNotReady;
         }
 
-        extMIDs[img->fb_index]->m_render_done = false;
+        // Not decoded into again until the client returns it.
+        vp9_frame_buffer_pool_hold(&extPool, img->fb_index, VP9_FB_HELD_BY_APP);
 
         buffer->nOffset = 0;
 
@@ -845,32 +1220,16 @@ bool OMXVideoDecoderVP9HWR::IsAllBufferAvailable(void)
         return false;
     }
 
-    unsigned int i = 0;
-    int found = 0;
-
-    if (RAWDATA_MODE == mWorkingMode) {
-        for (i = 0; i < OUTPORT_ACTUAL_BUFFER_COUNT; i++) {
-            if (extMIDs[i]->m_released == true) {
-               found ++;
-               if (found > 1) { //libvpx sometimes needs 2 buffer when calling decode once.
-                   return true;
-               }
-            }
-        }
-    } else { // graphic buffer mode
-        for (i = 0; i < mOMXBufferHeaderTypePtrNum; i++) {
-            if ((extMIDs[i]->m_render_done == true) && (extMIDs[i]->m_released == true)) {
-               found ++;
-               if (found > 1) { //libvpx sometimes needs 2 buffer when calling decode once.
-                   return true;
-               }
-            }
+    if (mDecodeQueue != NULL) {
+        // A frame the output buffers could not take waits for one to be free.
+        if (mHasOutputFrame) {
+            return hasFreeFrameBuffers();
         }
+        // Take input while there is room for it, otherwise wait for a frame.
+        return !mDecodeQueue->isInputFull() || mDecodeQueue->isOutputPending();
     }
 
-    b = false;
-
-    return b;
+    return hasFreeFrameBuffers();
 }
 
 DECLARE_OMX_COMPONENT("OMX.Intel.VideoDecoder.VP9.hwr", "video_decoder.vp9", OMXVideoDecoderVP9HWR);
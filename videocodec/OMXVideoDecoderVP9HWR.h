@@ -23,6 +23,8 @@
 #include "vpx/vpx_decoder.h"
 #include "vpx/vpx_codec.h"
 #include "vpx/vp8dx.h"
+#include "vp9/common/vp9_frame_buffers.h"
+#include "VP9DecodeQueue.h"
 #include <va/va.h>
 #include <va/va_android.h>
 #include <va/va_tpi.h>
@@ -35,8 +37,6 @@ typedef struct vaapiMemId
 
     unsigned int       m_key; //Gralloc handle from which this srf was created
     unsigned char*     m_usrAddr;
-    bool               m_render_done;
-    bool               m_released;
 }vaapiMemId;
 
 typedef unsigned int Display;
@@ -45,10 +45,16 @@ typedef unsigned int Display;
 #define DECODE_WITH_GRALLOC_BUFFER
 #define VPX_DECODE_BORDER 0
 
+// Decode on a thread of its own instead of in ProcessorProcess().
+#define DECODE_WITH_DECODE_THREAD
+
+// Frame buffer holder for decoded frames waiting in the decode queue.
+#define FB_HELD_BY_DECODE_QUEUE (1 << 2)
+
 // Make it global to be accessed by callback realloc func
 #define MAX_NATIVE_BUFFER_COUNT 64
 
-class OMXVideoDecoderVP9HWR : public OMXVideoDecoderBase {
+class OMXVideoDecoderVP9HWR : public OMXVideoDecoderBase, private VP9DecodeQueue::Decoder {
 public:
     OMXVideoDecoderVP9HWR();
     virtual ~OMXVideoDecoderVP9HWR();
@@ -66,6 +72,27 @@ public:
     int extActualBufferStride;
     int extActualBufferHeightStride;
 
+    // In raw data mode the OMX output buffers are decoded into directly when
+    // their layout matches libvpx's. They are registered in extMIDs after the
+    // extMappedNativeBufferCount internal buffers, which are only used (and
+    // copied from) when no output buffer can take the frame.
+    int extRawBufferCount;
+    unsigned int extRawBufferSize;
+    int extRawBufferStride;
+    int extRawBufferHeightStride;
+    // Aligned size of the frames that fit the output port. Frames of other
+    // sizes go to the internal buffers until the port has been reconfigured.
+    int extRawFrameStride;
+    int extRawFrameHeightStride;
+
+    // Frame buffers libvpx decodes into, indexed by fb_index. extPool holds
+    // the graphic buffers, or the internal buffers in raw data mode, and
+    // extRawPool the output buffers registered in raw data mode. A buffer is
+    // held by the decoder while libvpx references it and by the application
+    // while the client has it, and can be decoded into when neither does.
+    VP9FrameBufferPool extPool;
+    VP9FrameBufferPool extRawPool;
+
 protected:
     virtual OMX_ERRORTYPE InitInputPortFormatSpecific(OMX_PARAM_PORTDEFINITIONTYPE *paramPortDefinitionInput);
     virtual OMX_ERRORTYPE ProcessorInit(void);
@@ -106,6 +133,21 @@ private:
     OMX_ERRORTYPE initDecoder();
     OMX_ERRORTYPE destroyDecoder();
 
+    OMX_ERRORTYPE processAsync(OMX_BUFFERHEADERTYPE ***pBuffers, buffer_retain_t *retains);
+    VP9FrameBufferPool *frameBufferPool(int fbIndex);
+    bool hasFreeFrameBuffers();
+
+    // VP9DecodeQueue::Decoder, called on the decode thread.
+    virtual int decodeInput(const VP9DecodeQueue::InputBuffer &input,
+                            VP9DecodeQueue::OutputFrame *frames, int maxFrames);
+    virtual bool canDecode();
+    virtual void dropFrame(const VP9DecodeQueue::OutputFrame &frame);
+
+    void updateRawBufferLayout();
+    int findRawBuffer(OMX_BUFFERHEADERTYPE *buffer);
+    void registerRawBuffer(OMX_BUFFERHEADERTYPE *buffer);
+    void releaseRawBuffers();
+
     enum {
         // OMX_PARAM_PORTDEFINITIONTYPE
         INPORT_MIN_BUFFER_COUNT = 1,
@@ -115,6 +157,8 @@ private:
         OUTPORT_ACTUAL_BUFFER_COUNT = 12,  // for raw data mode
         INTERNAL_MAX_FRAME_WIDTH = 1920,
         INTERNAL_MAX_FRAME_HEIGHT = 1088,
+        DECODE_QUEUE_INPUT_DEPTH = 2,
+        DECODE_QUEUE_OUTPUT_DEPTH = 2,
     };
 
     void *mCtx;
@@ -132,6 +176,14 @@ private:
     Display* mDisplay;
     VADisplay mVADisplay;
 
+    // Decode thread, NULL when decoding in ProcessorProcess().
+    VP9DecodeQueue *mDecodeQueue;
+    // Decoded frame that is being returned to the output port.
+    VP9DecodeQueue::OutputFrame mOutputFrame;
+    bool mHasOutputFrame;
+    // The EOS input has been queued and is retained until EOS comes out.
+    bool mInputEoSQueued;
+
 };
 
 #endif /* OMX_VIDEO_DECODER_VP9HWR_H_ */
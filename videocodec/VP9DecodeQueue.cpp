@@ -0,0 +1,242 @@
+/*
+* Copyright (c) 2014 Intel Corporation.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "VP9DecodeQueue.h"
+
+VP9DecodeQueue::VP9DecodeQueue(Decoder *decoder, int inputDepth, int outputDepth,
+                               int maxFramesPerInput)
+    : mDecoder(decoder),
+      mStarted(false),
+      mStop(false),
+      mDecoding(false),
+      mPaused(0),
+      mInputDepth(inputDepth),
+      mInputHead(0),
+      mInputCount(0),
+      mOutputDepth(outputDepth),
+      mOutputHead(0),
+      mOutputCount(0),
+      mMaxFramesPerInput(maxFramesPerInput)
+{
+    pthread_mutex_init(&mLock, NULL);
+    pthread_cond_init(&mCond, NULL);
+    mInputs = (InputBuffer *)calloc(inputDepth, sizeof(InputBuffer));
+    mOutputs = (OutputFrame *)calloc(outputDepth, sizeof(OutputFrame));
+    mDecodedFrames = (OutputFrame *)calloc(outputDepth, sizeof(OutputFrame));
+}
+
+VP9DecodeQueue::~VP9DecodeQueue()
+{
+    stop();
+    for (int i = 0; i < mInputDepth && mInputs != NULL; i++) {
+        free(mInputs[i].data);
+    }
+    free(mInputs);
+    free(mOutputs);
+    free(mDecodedFrames);
+    pthread_cond_destroy(&mCond);
+    pthread_mutex_destroy(&mLock);
+}
+
+bool VP9DecodeQueue::start()
+{
+    if (mInputs == NULL || mOutputs == NULL || mDecodedFrames == NULL ||
+        mMaxFramesPerInput > mOutputDepth) {
+        return false;
+    }
+    if (mStarted) {
+        return true;
+    }
+    mStop = false;
+    if (pthread_create(&mThread, NULL, threadFunc, this) != 0) {
+        return false;
+    }
+    mStarted = true;
+    return true;
+}
+
+void VP9DecodeQueue::stop()
+{
+    if (mStarted) {
+        pthread_mutex_lock(&mLock);
+        mStop = true;
+        pthread_cond_broadcast(&mCond);
+        pthread_mutex_unlock(&mLock);
+        pthread_join(mThread, NULL);
+        mStarted = false;
+    }
+    flush();
+}
+
+bool VP9DecodeQueue::queueInput(const uint8_t *data, uint32_t size,
+                                int64_t timeStamp, uint32_t flags)
+{
+    pthread_mutex_lock(&mLock);
+    if (mInputCount == mInputDepth) {
+        pthread_mutex_unlock(&mLock);
+        return false;
+    }
+
+    // Only the decode thread reads queued slots, so the free one is filled
+    // without the lock.
+    InputBuffer *input = &mInputs[(mInputHead + mInputCount) % mInputDepth];
+    pthread_mutex_unlock(&mLock);
+
+    if (input->capacity < size) {
+        uint8_t *buf = (uint8_t *)realloc(input->data, size);
+        if (buf == NULL) {
+            return false;
+        }
+        input->data = buf;
+        input->capacity = size;
+    }
+    if (size > 0) {
+        memcpy(input->data, data, size);
+    }
+    input->size = size;
+    input->timeStamp = timeStamp;
+    input->flags = flags;
+
+    pthread_mutex_lock(&mLock);
+    mInputCount++;
+    pthread_cond_broadcast(&mCond);
+    pthread_mutex_unlock(&mLock);
+    return true;
+}
+
+bool VP9DecodeQueue::dequeueOutput(OutputFrame *frame, bool wait)
+{
+    pthread_mutex_lock(&mLock);
+    while (wait && mOutputCount == 0 && !mStop &&
+           (mDecoding || (mInputCount > 0 && canDecodeLocked()))) {
+        pthread_cond_wait(&mCond, &mLock);
+    }
+    if (mOutputCount == 0) {
+        pthread_mutex_unlock(&mLock);
+        return false;
+    }
+    *frame = mOutputs[mOutputHead];
+    mOutputHead = (mOutputHead + 1) % mOutputDepth;
+    mOutputCount--;
+    pthread_cond_broadcast(&mCond);
+    pthread_mutex_unlock(&mLock);
+    return true;
+}
+
+void VP9DecodeQueue::pause()
+{
+    pthread_mutex_lock(&mLock);
+    mPaused++;
+    while (mDecoding) {
+        pthread_cond_wait(&mCond, &mLock);
+    }
+    pthread_mutex_unlock(&mLock);
+}
+
+void VP9DecodeQueue::resume()
+{
+    pthread_mutex_lock(&mLock);
+    mPaused--;
+    pthread_cond_broadcast(&mCond);
+    pthread_mutex_unlock(&mLock);
+}
+
+void VP9DecodeQueue::flush()
+{
+    pause();
+    pthread_mutex_lock(&mLock);
+    mInputHead = 0;
+    mInputCount = 0;
+    while (mOutputCount > 0) {
+        mDecoder->dropFrame(mOutputs[mOutputHead]);
+        mOutputHead = (mOutputHead + 1) % mOutputDepth;
+        mOutputCount--;
+    }
+    mOutputHead = 0;
+    pthread_mutex_unlock(&mLock);
+    resume();
+}
+
+void VP9DecodeQueue::signal()
+{
+    pthread_mutex_lock(&mLock);
+    pthread_cond_broadcast(&mCond);
+    pthread_mutex_unlock(&mLock);
+}
+
+bool VP9DecodeQueue::isInputFull()
+{
+    pthread_mutex_lock(&mLock);
+    bool full = (mInputCount == mInputDepth);
+    pthread_mutex_unlock(&mLock);
+    return full;
+}
+
+bool VP9DecodeQueue::isOutputPending()
+{
+    pthread_mutex_lock(&mLock);
+    bool pending = mOutputCount > 0 || mDecoding || (mInputCount > 0 && canDecodeLocked());
+    pthread_mutex_unlock(&mLock);
+    return pending;
+}
+
+// Whether the decode thread can take the next input. Called with mLock held.
+bool VP9DecodeQueue::canDecodeLocked()
+{
+    return mPaused == 0 &&
+           mOutputDepth - mOutputCount >= mMaxFramesPerInput &&
+           mDecoder->canDecode();
+}
+
+void *VP9DecodeQueue::threadFunc(void *arg)
+{
+    ((VP9DecodeQueue *)arg)->decodeLoop();
+    return NULL;
+}
+
+void VP9DecodeQueue::decodeLoop()
+{
+    pthread_mutex_lock(&mLock);
+    while (true) {
+        while (!mStop && (mInputCount == 0 || !canDecodeLocked())) {
+            pthread_cond_wait(&mCond, &mLock);
+        }
+        if (mStop) {
+            break;
+        }
+
+        const InputBuffer *input = &mInputs[mInputHead];
+        int maxFrames = mOutputDepth - mOutputCount;
+        mDecoding = true;
+        pthread_mutex_unlock(&mLock);
+
+        int count = mDecoder->decodeInput(*input, mDecodedFrames, maxFrames);
+
+        pthread_mutex_lock(&mLock);
+        mInputHead = (mInputHead + 1) % mInputDepth;
+        mInputCount--;
+        for (int i = 0; i < count; i++) {
+            mOutputs[(mOutputHead + mOutputCount) % mOutputDepth] = mDecodedFrames[i];
+            mOutputCount++;
+        }
+        mDecoding = false;
+        pthread_cond_broadcast(&mCond);
+    }
+    pthread_mutex_unlock(&mLock);
+}
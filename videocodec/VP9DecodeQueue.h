@@ -0,0 +1,118 @@
+/*
+* Copyright (c) 2014 Intel Corporation.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#ifndef VP9_DECODE_QUEUE_H_
+#define VP9_DECODE_QUEUE_H_
+
+#include <pthread.h>
+#include <stdint.h>
+#include "vpx/vpx_image.h"
+
+// Runs libvpx on a thread of its own. Compressed buffers are copied into a
+// bounded input queue, so the caller can return them at once, and the decoded
+// frames come back through a bounded output queue. The queue does not depend
+// on OMX, so it can be driven by a fake port on the host.
+class VP9DecodeQueue {
+public:
+    struct InputBuffer {
+        uint8_t *data;
+        uint32_t size;
+        uint32_t capacity;
+        int64_t timeStamp;
+        uint32_t flags;
+    };
+
+    struct OutputFrame {
+        // Only valid when hasImage is set; the frame buffer behind it must be
+        // kept by the decoder until the frame is dequeued or dropped.
+        vpx_image_t image;
+        bool hasImage;
+        // Non zero if the input could not be decoded.
+        int status;
+        int64_t timeStamp;
+        uint32_t flags;
+    };
+
+    class Decoder {
+    public:
+        virtual ~Decoder() {}
+        // Called on the decode thread. Decodes |input| and returns the number
+        // of frames, at most |maxFrames|, written to |frames|.
+        virtual int decodeInput(const InputBuffer &input, OutputFrame *frames, int maxFrames) = 0;
+        // Whether there are frame buffers to decode into. The decode thread
+        // waits until it is true and signal() is called.
+        virtual bool canDecode() = 0;
+        // Called for frames that are flushed before being dequeued.
+        virtual void dropFrame(const OutputFrame &frame) = 0;
+    };
+
+    VP9DecodeQueue(Decoder *decoder, int inputDepth, int outputDepth, int maxFramesPerInput);
+    ~VP9DecodeQueue();
+
+    bool start();
+    // Stops the decode thread and drops everything that is queued.
+    void stop();
+
+    // Copies |size| bytes for decoding. Returns false if the input queue is
+    // full or the copy can not be allocated.
+    bool queueInput(const uint8_t *data, uint32_t size, int64_t timeStamp, uint32_t flags);
+    // Returns the oldest decoded frame. With |wait| it blocks while the decode
+    // thread can still produce one.
+    bool dequeueOutput(OutputFrame *frame, bool wait);
+
+    // Waits for the frame being decoded and holds off decoding until resume(),
+    // so the decoder can be reconfigured. Calls nest.
+    void pause();
+    void resume();
+    // Drops all queued input and frames.
+    void flush();
+    // Wakes up the decode thread when canDecode() may have become true.
+    void signal();
+
+    bool isInputFull();
+    // Whether dequeueOutput() has a frame or can wait for one.
+    bool isOutputPending();
+
+private:
+    static void *threadFunc(void *arg);
+    void decodeLoop();
+    bool canDecodeLocked();
+
+    Decoder *mDecoder;
+    pthread_t mThread;
+    pthread_mutex_t mLock;
+    pthread_cond_t mCond;
+    bool mStarted;
+    bool mStop;
+    bool mDecoding;
+    int mPaused;
+
+    InputBuffer *mInputs;
+    int mInputDepth;
+    int mInputHead;
+    int mInputCount;
+
+    OutputFrame *mOutputs;
+    int mOutputDepth;
+    int mOutputHead;
+    int mOutputCount;
+
+    OutputFrame *mDecodedFrames;
+    int mMaxFramesPerInput;
+};
+
+#endif /* VP9_DECODE_QUEUE_H_ */
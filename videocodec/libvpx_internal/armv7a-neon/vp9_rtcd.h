@@ -253,6 +253,9 @@ void vp9_idct4x4_16_add_c(const int16_t *input, uint8_t *dest, int dest_stride);
 void vp9_idct4x4_16_add_neon(const int16_t *input, uint8_t *dest, int dest_stride);
 #define vp9_idct4x4_16_add vp9_idct4x4_16_add_neon
 
+void vp9_idct4x4_16_add_x4_c(int16_t *const *input, uint8_t *const *dest, int dest_stride);
+#define vp9_idct4x4_16_add_x4 vp9_idct4x4_16_add_x4_c
+
 void vp9_idct8x8_1_add_c(const int16_t *input, uint8_t *dest, int dest_stride);
 void vp9_idct8x8_1_add_neon(const int16_t *input, uint8_t *dest, int dest_stride);
 #define vp9_idct8x8_1_add vp9_idct8x8_1_add_neon
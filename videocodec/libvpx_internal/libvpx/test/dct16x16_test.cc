@@ -534,4 +534,19 @@ INSTANTIATE_TEST_CASE_P(
         make_tuple(&vp9_fht16x16_sse2, &vp9_iht16x16_256_add_sse2, 2),
         make_tuple(&vp9_fht16x16_sse2, &vp9_iht16x16_256_add_sse2, 3)));
 #endif
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_CASE_P(
+    AVX2, Trans16x16DCT,
+    ::testing::Values(
+        make_tuple(&vp9_fdct16x16_avx2,
+                   &vp9_idct16x16_256_add_avx2, 0)));
+INSTANTIATE_TEST_CASE_P(
+    AVX2, Trans16x16HT,
+    ::testing::Values(
+        make_tuple(&vp9_fht16x16_avx2, &vp9_iht16x16_256_add_avx2, 0),
+        make_tuple(&vp9_fht16x16_avx2, &vp9_iht16x16_256_add_avx2, 1),
+        make_tuple(&vp9_fht16x16_avx2, &vp9_iht16x16_256_add_avx2, 2),
+        make_tuple(&vp9_fht16x16_avx2, &vp9_iht16x16_256_add_avx2, 3)));
+#endif
 }  // namespace
@@ -0,0 +1,309 @@
+/*
+ *  Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "third_party/googletest/src/include/gtest/gtest.h"
+#include "test/codec_factory.h"
+#include "test/encode_test_driver.h"
+#include "test/util.h"
+#include "test/video_source.h"
+#include "vpx_ports/vpx_timer.h"
+#include "./vpx_version.h"
+
+namespace {
+
+const double kUsecsInSec = 1000000.0;
+
+// Decoding runs with 1 to LIBVPX_BENCH_MAX_THREADS threads.
+const int kDefaultMaxThreads = 4;
+
+// Each thread count decodes the stream this many times and the fastest run is
+// reported.
+const int kDecodeRuns = 3;
+
+/*
+ DecodeBenchTest encodes a synthetic stream, so that it runs offline, and then
+ times its decoding with each thread count. For every thread count it reports
+ the frame rate and speedup, the p50/p99 latency of the vpx_codec_decode()
+ calls and the time spent in each decoding stage, as one JSON object per
+ stream. If LIBVPX_BENCH_JSON is set, the objects are also appended to the
+ file it names, one per line.
+
+ Like DecodePerfTest, it does no correctness checks.
+ */
+
+struct BenchStream {
+  unsigned int width;
+  unsigned int height;
+  unsigned int frames;
+  // log2 of the number of VP8 token partitions or VP9 tile columns.
+  int partitions_log2;
+};
+
+const BenchStream kBenchStreams[] = {
+  { 640, 360, 60, 1 },
+  { 1280, 720, 60, 2 },
+};
+
+// Moving texture over gradients, so that the streams have both intra and
+// inter prediction to decode.
+class SyntheticVideoSource : public libvpx_test::DummyVideoSource {
+ public:
+  SyntheticVideoSource(unsigned int width, unsigned int height,
+                       unsigned int limit) {
+    SetSize(width, height);
+    limit_ = limit;
+  }
+
+ protected:
+  virtual void FillFrame() {
+    const unsigned int f = frame_;
+    for (int plane = 0; plane < 3; ++plane) {
+      const unsigned int w = plane ? (img_->d_w + 1) / 2 : img_->d_w;
+      const unsigned int h = plane ? (img_->d_h + 1) / 2 : img_->d_h;
+      for (unsigned int y = 0; y < h; ++y) {
+        uint8_t *const row = img_->planes[plane] + y * img_->stride[plane];
+        for (unsigned int x = 0; x < w; ++x) {
+          if (plane == 0)
+            row[x] = static_cast<uint8_t>(((x + 2 * f) ^ (y + f)) +
+                                          ((x * y) >> 10));
+          else
+            row[x] = static_cast<uint8_t>(64 * plane + ((x + y + f) >> 2));
+        }
+      }
+    }
+  }
+};
+
+struct DecodeStats {
+  double decode_secs;
+  std::vector<double> latency_ms;
+  vp9_decode_stage_times_t stages;
+  int64_t copy_us;
+};
+
+int MaxThreads() {
+  const char *const env = getenv("LIBVPX_BENCH_MAX_THREADS");
+  const int threads = env ? atoi(env) : kDefaultMaxThreads;
+  return threads > 0 ? threads : 1;
+}
+
+// Nearest-rank percentile of sorted values.
+double Percentile(const std::vector<double> &sorted, int percent) {
+  if (sorted.empty())
+    return 0;
+  size_t rank = (sorted.size() * percent + 99) / 100;
+  if (rank > 0)
+    --rank;
+  return sorted[rank];
+}
+
+// Copies the visible area of img to a packed I420 buffer, as a client
+// outputting the frame would.
+void CopyImage(const vpx_image_t *img, std::vector<uint8_t> *out) {
+  out->resize(img->d_w * img->d_h +
+              2 * ((img->d_w + 1) / 2) * ((img->d_h + 1) / 2));
+  uint8_t *dst = &(*out)[0];
+  for (int plane = 0; plane < 3; ++plane) {
+    const unsigned int w = plane ? (img->d_w + 1) / 2 : img->d_w;
+    const unsigned int h = plane ? (img->d_h + 1) / 2 : img->d_h;
+    for (unsigned int y = 0; y < h; ++y) {
+      memcpy(dst, img->planes[plane] + y * img->stride[plane], w);
+      dst += w;
+    }
+  }
+}
+
+void Append(std::string *json, const char *format, ...) {
+  char buf[256];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  *json += buf;
+}
+
+class DecodeBenchTest
+    : public ::libvpx_test::EncoderTest,
+      public ::libvpx_test::CodecTestWithParam<BenchStream> {
+ protected:
+  DecodeBenchTest() : EncoderTest(GET_PARAM(0)), stream_(GET_PARAM(1)) {}
+
+  virtual ~DecodeBenchTest() {}
+
+  virtual void SetUp() {
+    InitializeConfig();
+    SetMode(::libvpx_test::kRealTime);
+  }
+
+  bool IsVP9() const {
+#if CONFIG_VP9
+    return codec_ == &libvpx_test::kVP9;
+#else
+    return false;
+#endif
+  }
+
+  virtual void PreEncodeFrameHook(::libvpx_test::VideoSource *video,
+                                  ::libvpx_test::Encoder *encoder) {
+    if (video->frame() == 1) {
+      encoder->Control(VP8E_SET_CPUUSED, 5);
+      if (IsVP9())
+        encoder->Control(VP9E_SET_TILE_COLUMNS, stream_.partitions_log2);
+      else
+        encoder->Control(VP8E_SET_TOKEN_PARTITIONS, stream_.partitions_log2);
+    }
+  }
+
+  virtual bool DoDecode() const { return false; }
+
+  virtual void FramePktHook(const vpx_codec_cx_pkt_t *pkt) {
+    const char *const buf = static_cast<const char *>(pkt->data.frame.buf);
+    frames_.push_back(std::string(buf, pkt->data.frame.sz));
+  }
+
+  void Decode(int threads, DecodeStats *stats) {
+    vpx_codec_dec_cfg_t cfg = {0};
+    cfg.threads = threads;
+    libvpx_test::Decoder *const decoder = codec_->CreateDecoder(cfg, 0);
+    std::vector<uint8_t> output;
+
+    stats->decode_secs = 0;
+    stats->latency_ms.clear();
+    memset(&stats->stages, 0, sizeof(stats->stages));
+    stats->copy_us = 0;
+
+    for (size_t i = 0; i < frames_.size(); ++i) {
+      vpx_usec_timer t;
+      vpx_usec_timer_start(&t);
+      const vpx_codec_err_t res = decoder->DecodeFrame(
+          reinterpret_cast<const uint8_t *>(frames_[i].data()),
+          frames_[i].size());
+      vpx_usec_timer_mark(&t);
+      ASSERT_EQ(VPX_CODEC_OK, res) << decoder->DecodeError();
+      const int64_t elapsed = vpx_usec_timer_elapsed(&t);
+      stats->decode_secs += elapsed / kUsecsInSec;
+      stats->latency_ms.push_back(elapsed / 1000.0);
+
+      libvpx_test::DxDataIterator dec_iter = decoder->GetDxData();
+      const vpx_image_t *img;
+      while ((img = dec_iter.Next()) != NULL) {
+        vpx_usec_timer_start(&t);
+        CopyImage(img, &output);
+        vpx_usec_timer_mark(&t);
+        stats->copy_us += vpx_usec_timer_elapsed(&t);
+      }
+    }
+    if (IsVP9())
+      decoder->Control(VP9D_GET_STAGE_TIMES, &stats->stages);
+    std::sort(stats->latency_ms.begin(), stats->latency_ms.end());
+    delete decoder;
+  }
+
+  void AppendResult(std::string *json, int threads, const DecodeStats &stats,
+                    double single_thread_secs) {
+    const double fps = frames_.size() / stats.decode_secs;
+    Append(json, "\t\t{\n");
+    Append(json, "\t\t\t\"threadCount\" : %d,\n", threads);
+    Append(json, "\t\t\t\"decodeTimeSecs\" : %f,\n", stats.decode_secs);
+    Append(json, "\t\t\t\"framesPerSecond\" : %f,\n", fps);
+    Append(json, "\t\t\t\"speedup\" : %f,\n",
+           single_thread_secs / stats.decode_secs);
+    Append(json, "\t\t\t\"latencyMsP50\" : %f,\n",
+           Percentile(stats.latency_ms, 50));
+    Append(json, "\t\t\t\"latencyMsP99\" : %f,\n",
+           Percentile(stats.latency_ms, 99));
+    Append(json, "\t\t\t\"stageSecs\" : {\n");
+    if (IsVP9()) {
+      Append(json, "\t\t\t\t\"header\" : %f,\n",
+             stats.stages.header_us / kUsecsInSec);
+      Append(json, "\t\t\t\t\"tiles\" : %f,\n",
+             stats.stages.tiles_us / kUsecsInSec);
+      Append(json, "\t\t\t\t\"loopFilter\" : %f,\n",
+             stats.stages.loop_filter_us / kUsecsInSec);
+      Append(json, "\t\t\t\t\"postproc\" : %f,\n",
+             stats.stages.postproc_us / kUsecsInSec);
+    }
+    Append(json, "\t\t\t\t\"outputCopy\" : %f\n", stats.copy_us / kUsecsInSec);
+    Append(json, "\t\t\t}\n");
+    Append(json, "\t\t}");
+  }
+
+  BenchStream stream_;
+  std::vector<std::string> frames_;
+};
+
+TEST_P(DecodeBenchTest, Bench) {
+  const vpx_rational timebase = { 1, 30 };
+  cfg_.g_timebase = timebase;
+  cfg_.g_lag_in_frames = 0;
+  cfg_.rc_end_usage = VPX_CBR;
+  cfg_.rc_target_bitrate = stream_.width * stream_.height * 3 / 1000;
+
+  SyntheticVideoSource video(stream_.width, stream_.height, stream_.frames);
+  ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
+  ASSERT_FALSE(frames_.empty());
+
+  std::string json;
+  Append(&json, "{\n");
+  Append(&json, "\t\"version\" : \"%s\",\n", VERSION_STRING_NOSP);
+  Append(&json, "\t\"codec\" : \"%s\",\n", IsVP9() ? "vp9" : "vp8");
+  Append(&json, "\t\"width\" : %u,\n", stream_.width);
+  Append(&json, "\t\"height\" : %u,\n", stream_.height);
+  Append(&json, "\t\"partitionsLog2\" : %d,\n", stream_.partitions_log2);
+  Append(&json, "\t\"totalFrames\" : %u,\n",
+         static_cast<unsigned int>(frames_.size()));
+  Append(&json, "\t\"results\" : [\n");
+
+  const int max_threads = MaxThreads();
+  double single_thread_secs = 0;
+  for (int threads = 1; threads <= max_threads; ++threads) {
+    DecodeStats best, stats;
+    ASSERT_NO_FATAL_FAILURE(Decode(threads, &best));
+    for (int run = 1; run < kDecodeRuns; ++run) {
+      ASSERT_NO_FATAL_FAILURE(Decode(threads, &stats));
+      if (stats.decode_secs < best.decode_secs)
+        best = stats;
+    }
+    if (threads == 1)
+      single_thread_secs = best.decode_secs;
+    AppendResult(&json, threads, best, single_thread_secs);
+    Append(&json, threads < max_threads ? ",\n" : "\n");
+  }
+  Append(&json, "\t]\n");
+  Append(&json, "}\n");
+
+  printf("%s", json.c_str());
+  const char *const path = getenv("LIBVPX_BENCH_JSON");
+  if (path != NULL) {
+    std::string line;
+    for (size_t i = 0; i < json.size(); ++i) {
+      if (json[i] != '\t' && json[i] != '\n')
+        line += json[i];
+    }
+    line += '\n';
+    FILE *const file = fopen(path, "a");
+    ASSERT_TRUE(file != NULL) << "Can not open " << path;
+    fputs(line.c_str(), file);
+    fclose(file);
+  }
+}
+
+VP8_INSTANTIATE_TEST_CASE(DecodeBenchTest, ::testing::ValuesIn(kBenchStreams));
+VP9_INSTANTIATE_TEST_CASE(DecodeBenchTest, ::testing::ValuesIn(kBenchStreams));
+
+}  // namespace
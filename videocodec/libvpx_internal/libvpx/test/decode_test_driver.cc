@@ -25,9 +25,21 @@ vpx_codec_err_t Decoder::DecodeFrame(const uint8_t *cxdata, size_t size) {
   return res_dec;
 }
 
+vpx_codec_err_t Decoder::Flush() {
+  vpx_codec_err_t res_dec;
+  InitOnce();
+  REGISTER_STATE_CHECK(res_dec = vpx_codec_decode(&decoder_, NULL, 0, NULL, 0));
+  return res_dec;
+}
+
 void DecoderTest::RunLoop(CompressedVideoSource *video) {
   vpx_codec_dec_cfg_t dec_cfg = {0};
-  Decoder* const decoder = codec_->CreateDecoder(dec_cfg, 0);
+  RunLoop(video, dec_cfg);
+}
+
+void DecoderTest::RunLoop(CompressedVideoSource *video,
+                          const vpx_codec_dec_cfg_t &dec_cfg) {
+  Decoder* const decoder = codec_->CreateDecoder(dec_cfg, flags_, 0);
   ASSERT_TRUE(decoder != NULL);
 
   // Decode frames.
@@ -45,6 +57,16 @@ void DecoderTest::RunLoop(CompressedVideoSource *video) {
       DecompressedFrameHook(*img, video->frame_number());
   }
 
+  if (flags_ & VPX_CODEC_USE_FRAME_THREADING) {
+    const vpx_codec_err_t res_dec = decoder->Flush();
+    ASSERT_EQ(VPX_CODEC_OK, res_dec) << decoder->DecodeError();
+
+    DxDataIterator dec_iter = decoder->GetDxData();
+    const vpx_image_t *img = NULL;
+    while ((img = dec_iter.Next()))
+      DecompressedFrameHook(*img, video->frame_number());
+  }
+
   delete decoder;
 }
 }  // namespace libvpx_test
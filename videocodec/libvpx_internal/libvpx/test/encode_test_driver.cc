@@ -189,6 +189,10 @@ void EncoderTest::RunLoop(VideoSource *video) {
             PSNRPktHook(pkt);
             break;
 
+          case VPX_CODEC_DEADLINE_PKT:
+            DeadlinePktHook(pkt);
+            break;
+
           default:
             break;
         }
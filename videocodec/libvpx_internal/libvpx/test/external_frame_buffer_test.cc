@@ -27,6 +27,7 @@ struct ExternalFrameBuffer {
   uint8_t *data;
   size_t size;
   int in_use;
+  int stride;
 };
 
 // Class to manipulate a list of external frame buffers.
@@ -75,6 +76,25 @@ class ExternalFrameBufferList {
     return 0;
   }
 
+  // Hands out a frame buffer with a larger stride and height than the decoder
+  // asks for in |fb|, like a buffer laid out by the application's renderer.
+  // Returns < 0 on an error.
+  int GetPaddedFrameBuffer(size_t min_size, vpx_codec_frame_buffer_t *fb) {
+    EXPECT_TRUE(fb != NULL);
+    const int stride = fb->fb_stride + 64;
+    const int height_stride = fb->fb_height_stride + 32;
+    // The luma plane grows the most, the chroma planes are at most as large.
+    const size_t padding = 3 * (static_cast<size_t>(stride) * height_stride -
+        static_cast<size_t>(fb->fb_stride) * fb->fb_height_stride);
+    if (GetFreeFrameBuffer(min_size + padding, fb) < 0)
+      return -1;
+
+    fb->fb_stride = stride;
+    fb->fb_height_stride = height_stride;
+    reinterpret_cast<ExternalFrameBuffer*>(fb->priv)->stride = stride;
+    return 0;
+  }
+
   // Test function that will not allocate any data for the frame buffer.
   // Returns < 0 on an error.
   int GetZeroFrameBuffer(size_t min_size, vpx_codec_frame_buffer_t *fb) {
@@ -114,6 +134,9 @@ class ExternalFrameBufferList {
 
       ASSERT_TRUE(img->planes[0] >= ext_fb->data &&
                   img->planes[0] < (ext_fb->data + ext_fb->size));
+      if (ext_fb->stride > 0) {
+        ASSERT_EQ(ext_fb->stride, img->stride[VPX_PLANE_Y]);
+      }
     }
   }
 
@@ -195,7 +218,8 @@ class ExternalFrameBufferMD5Test
   ExternalFrameBufferMD5Test()
       : DecoderTest(GET_PARAM(::libvpx_test::kCodecFactoryParam)),
         md5_file_(NULL),
-        num_buffers_(0) {}
+        num_buffers_(0),
+        padded_buffers_(false) {}
 
   virtual ~ExternalFrameBufferMD5Test() {
     if (md5_file_ != NULL)
@@ -223,6 +247,7 @@ class ExternalFrameBufferMD5Test
   virtual void DecompressedFrameHook(const vpx_image_t &img,
                                      const unsigned int frame_number) {
     ASSERT_TRUE(md5_file_ != NULL);
+    ASSERT_NO_FATAL_FAILURE(fb_list_.CheckXImageFrameBuffer(&img));
     char expected_md5[33];
     char junk[128];
 
@@ -246,6 +271,8 @@ class ExternalFrameBufferMD5Test
                                vpx_codec_frame_buffer_t *fb) {
     ExternalFrameBufferMD5Test *const md5Test =
         reinterpret_cast<ExternalFrameBufferMD5Test*>(user_priv);
+    if (md5Test->padded_buffers_)
+      return md5Test->fb_list_.GetPaddedFrameBuffer(min_size, fb);
     return md5Test->fb_list_.GetFreeFrameBuffer(min_size, fb);
   }
 
@@ -260,10 +287,45 @@ class ExternalFrameBufferMD5Test
 
   void set_num_buffers(int num_buffers) { num_buffers_ = num_buffers; }
   int num_buffers() const { return num_buffers_; }
+  void set_padded_buffers(bool padded) { padded_buffers_ = padded; }
+
+  void DecodeTestVector(const std::string &filename) {
+    libvpx_test::CompressedVideoSource *video = NULL;
+
+    // Number of buffers equals #VP9_MAXIMUM_REF_BUFFERS +
+    // #VPX_MAXIMUM_WORK_BUFFERS + four jitter buffers.
+    const int jitter_buffers = 4;
+    const int num_buffers =
+        VP9_MAXIMUM_REF_BUFFERS + VPX_MAXIMUM_WORK_BUFFERS + jitter_buffers;
+    set_num_buffers(num_buffers);
+
+#if CONFIG_VP8_DECODER
+    // Tell compiler we are not using kVP8TestVectors.
+    (void)libvpx_test::kVP8TestVectors;
+#endif
+
+    // Open compressed video file.
+    if (filename.substr(filename.length() - 3, 3) == "ivf") {
+      video = new libvpx_test::IVFVideoSource(filename);
+    } else {
+      video = new libvpx_test::WebMVideoSource(filename);
+    }
+    ASSERT_TRUE(video != NULL);
+    video->Init();
+
+    // Construct md5 file name.
+    const std::string md5_filename = filename + ".md5";
+    OpenMD5File(md5_filename);
+
+    // Decode frame, and check the md5 matching.
+    ASSERT_NO_FATAL_FAILURE(RunLoop(video));
+    delete video;
+  }
 
  private:
   FILE *md5_file_;
   int num_buffers_;
+  bool padded_buffers_;
   ExternalFrameBufferList fb_list_;
 };
 
@@ -347,37 +409,15 @@ class ExternalFrameBufferTest : public ::testing::Test {
 // If md5 checksums match the correct md5 data, then the test is passed.
 // Otherwise, the test failed.
 TEST_P(ExternalFrameBufferMD5Test, ExtFBMD5Match) {
-  const std::string filename = GET_PARAM(kVideoNameParam);
-  libvpx_test::CompressedVideoSource *video = NULL;
-
-  // Number of buffers equals #VP9_MAXIMUM_REF_BUFFERS +
-  // #VPX_MAXIMUM_WORK_BUFFERS + four jitter buffers.
-  const int jitter_buffers = 4;
-  const int num_buffers =
-      VP9_MAXIMUM_REF_BUFFERS + VPX_MAXIMUM_WORK_BUFFERS + jitter_buffers;
-  set_num_buffers(num_buffers);
-
-#if CONFIG_VP8_DECODER
-  // Tell compiler we are not using kVP8TestVectors.
-  (void)libvpx_test::kVP8TestVectors;
-#endif
-
-  // Open compressed video file.
-  if (filename.substr(filename.length() - 3, 3) == "ivf") {
-    video = new libvpx_test::IVFVideoSource(filename);
-  } else {
-    video = new libvpx_test::WebMVideoSource(filename);
-  }
-  ASSERT_TRUE(video != NULL);
-  video->Init();
-
-  // Construct md5 file name.
-  const std::string md5_filename = filename + ".md5";
-  OpenMD5File(md5_filename);
+  DecodeTestVector(GET_PARAM(kVideoNameParam));
+}
 
-  // Decode frame, and check the md5 matching.
-  ASSERT_NO_FATAL_FAILURE(RunLoop(video));
-  delete video;
+// Same as above, but the frame buffers are laid out with a larger stride and
+// height than the decoder needs, so that an application can decode straight
+// into the buffers it displays from.
+TEST_P(ExternalFrameBufferMD5Test, ExtFBPaddedMD5Match) {
+  set_padded_buffers(true);
+  DecodeTestVector(GET_PARAM(kVideoNameParam));
 }
 
 TEST_F(ExternalFrameBufferTest, MinFrameBuffers) {
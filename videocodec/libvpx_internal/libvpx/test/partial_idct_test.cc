@@ -190,4 +190,92 @@ INSTANTIATE_TEST_CASE_P(
                    &vp9_idct4x4_1_add_sse2,
                    TX_4X4, 1)));
 #endif
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_CASE_P(
+    AVX2, PartialIDctTest,
+    ::testing::Values(
+        make_tuple(&vp9_idct32x32_1024_add_c,
+                   &vp9_idct32x32_1024_add_avx2,
+                   TX_32X32, 1024),
+        make_tuple(&vp9_idct32x32_1024_add_c,
+                   &vp9_idct32x32_34_add_avx2,
+                   TX_32X32, 34),
+        make_tuple(&vp9_idct32x32_1024_add_c,
+                   &vp9_idct32x32_1_add_avx2,
+                   TX_32X32, 1),
+        make_tuple(&vp9_idct16x16_256_add_c,
+                   &vp9_idct16x16_256_add_avx2,
+                   TX_16X16, 256)));
+#endif
+
+typedef void (*batched_itxfm_t)(int16_t *const *in, uint8_t *const *out,
+                                int stride);
+
+class BatchedIDctTest : public ::testing::TestWithParam<batched_itxfm_t> {
+ public:
+  virtual ~BatchedIDctTest() {}
+  virtual void SetUp() { batched_itxfm_ = GetParam(); }
+  virtual void TearDown() { libvpx_test::ClearSystemState(); }
+
+ protected:
+  batched_itxfm_t batched_itxfm_;
+};
+
+// Runs four 4x4 blocks through the batched kernel and one at a time through
+// the C transform; the coefficients and destinations are scattered to catch
+// mixed up blocks.
+TEST_P(BatchedIDctTest, MatchesSingleBlocks) {
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  const int kStride = 64;
+  const int kNumBlocks = 4;
+  DECLARE_ALIGNED_ARRAY(16, int16_t, coeff, kNumBlocks * 16);
+  DECLARE_ALIGNED_ARRAY(16, uint8_t, dst1, kStride * 16);
+  DECLARE_ALIGNED_ARRAY(16, uint8_t, dst2, kStride * 16);
+  const int count_test_block = 1000;
+  const int max_coeff = 32766 / 4;
+
+  for (int i = 0; i < count_test_block; ++i) {
+    int16_t *inputs[kNumBlocks];
+    uint8_t *dests[kNumBlocks];
+    for (int j = 0; j < kStride * 16; ++j)
+      dst1[j] = dst2[j] = rnd.Rand8();
+
+    for (int b = 0; b < kNumBlocks; ++b) {
+      int16_t *const block = coeff + 16 * b;
+      int max_energy_leftover = max_coeff * max_coeff;
+      memset(block, 0, 16 * sizeof(*block));
+      for (int j = 0; j < 16; ++j) {
+        int16_t coef = static_cast<int16_t>(sqrt(1.0 * max_energy_leftover) *
+                                            (rnd.Rand16() - 32768) / 65536);
+        max_energy_leftover -= coef * coef;
+        if (max_energy_leftover < 0) {
+          max_energy_leftover = 0;
+          coef = 0;
+        }
+        block[vp9_default_scan_orders[TX_4X4].scan[j]] = coef;
+      }
+      // Distinct 4x4 positions, not in order.
+      const int row = ((b * 3 + i) % 4) * 4;
+      const int col = ((b * 5 + i) % 16) * 4;
+      inputs[(b + i) % kNumBlocks] = block;
+      dests[b] = dst2 + row * kStride + col;
+    }
+
+    for (int b = 0; b < kNumBlocks; ++b)
+      vp9_idct4x4_16_add_c(inputs[b], dst1 + (dests[b] - dst2), kStride);
+    REGISTER_STATE_CHECK(batched_itxfm_(inputs, dests, kStride));
+
+    for (int j = 0; j < kStride * 16; ++j)
+      ASSERT_EQ(dst1[j], dst2[j]) << "Error: batched inverse transform "
+                                  << "differs at " << j << ", block " << i;
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(C, BatchedIDctTest,
+                        ::testing::Values(&vp9_idct4x4_16_add_x4_c));
+#if HAVE_SSE2
+INSTANTIATE_TEST_CASE_P(SSE2, BatchedIDctTest,
+                        ::testing::Values(&vp9_idct4x4_16_add_x4_sse2));
+#endif
 }  // namespace
@@ -36,6 +36,15 @@ typedef unsigned int (*sad_m_by_n_fn_t)(const unsigned char *source_ptr,
                                         unsigned int max_sad);
 typedef std::tr1::tuple<int, int, sad_m_by_n_fn_t> sad_m_by_n_test_param_t;
 
+typedef unsigned int (*sad_m_by_n_avg_fn_t)(const uint8_t *source_ptr,
+                                            int source_stride,
+                                            const uint8_t *reference_ptr,
+                                            int reference_stride,
+                                            const uint8_t *second_pred,
+                                            unsigned int max_sad);
+typedef std::tr1::tuple<int, int, sad_m_by_n_avg_fn_t>
+        sad_m_by_n_avg_test_param_t;
+
 typedef void (*sad_n_by_n_by_4_fn_t)(const uint8_t *src_ptr,
                                      int src_stride,
                                      const unsigned char * const ref_ptr[],
@@ -56,6 +65,8 @@ class SADTestBase : public ::testing::Test {
         vpx_memalign(kDataAlignment, kDataBlockSize));
     reference_data_ = reinterpret_cast<uint8_t*>(
         vpx_memalign(kDataAlignment, kDataBufferSize));
+    second_pred_ = reinterpret_cast<uint8_t*>(
+        vpx_memalign(kDataAlignment, 64 * 64));
   }
 
   static void TearDownTestCase() {
@@ -63,6 +74,8 @@ class SADTestBase : public ::testing::Test {
     source_data_ = NULL;
     vpx_free(reference_data_);
     reference_data_ = NULL;
+    vpx_free(second_pred_);
+    second_pred_ = NULL;
   }
 
   virtual void TearDown() {
@@ -123,6 +136,7 @@ class SADTestBase : public ::testing::Test {
   static uint8_t* source_data_;
   int source_stride_;
   static uint8_t* reference_data_;
+  static uint8_t* second_pred_;
   int reference_stride_;
 
   ACMRandom rnd_;
@@ -186,8 +200,53 @@ class SADx4Test : public SADTestBase,
   }
 };
 
+class SADavgTest : public SADTestBase,
+    public ::testing::WithParamInterface<sad_m_by_n_avg_test_param_t> {
+ public:
+  SADavgTest() : SADTestBase(GET_PARAM(0), GET_PARAM(1)) {}
+
+ protected:
+  // SAD against the rounded average of the reference and second_pred_, which
+  // is a width_ x height_ block without padding.
+  unsigned int ReferenceSADavg(unsigned int max_sad) {
+    unsigned int sad = 0;
+    for (int h = 0; h < height_; ++h) {
+      for (int w = 0; w < width_; ++w) {
+        const int comp_pred = (reference_data_[h * reference_stride_ + w] +
+                               second_pred_[h * width_ + w] + 1) >> 1;
+        sad += abs(source_data_[h * source_stride_ + w] - comp_pred);
+      }
+      if (sad > max_sad) {
+        break;
+      }
+    }
+    return sad;
+  }
+
+  unsigned int SADavg(unsigned int max_sad) {
+    unsigned int ret;
+    REGISTER_STATE_CHECK(ret = GET_PARAM(2)(source_data_, source_stride_,
+                                            reference_data_, reference_stride_,
+                                            second_pred_, max_sad));
+    return ret;
+  }
+
+  void CheckSadAvg(unsigned int max_sad) {
+    const unsigned int reference_sad = ReferenceSADavg(max_sad);
+    const unsigned int exp_sad = SADavg(max_sad);
+
+    if (reference_sad <= max_sad) {
+      ASSERT_EQ(exp_sad, reference_sad);
+    } else {
+      // Alternative implementations are not required to check max_sad
+      ASSERT_GE(exp_sad, reference_sad);
+    }
+  }
+};
+
 uint8_t* SADTestBase::source_data_ = NULL;
 uint8_t* SADTestBase::reference_data_ = NULL;
+uint8_t* SADTestBase::second_pred_ = NULL;
 
 TEST_P(SADTest, MaxRef) {
   FillConstant(source_data_, source_stride_, 0);
@@ -294,6 +353,75 @@ TEST_P(SADTest, MaxSAD) {
   CheckSad(128);
 }
 
+TEST_P(SADTest, MaxSADRandom) {
+  // Verify that an implementation stopping early on max_sad returns the SAD
+  // in full when it does not exceed max_sad, and no less than the reference
+  // when it does.
+  FillRandom(source_data_, source_stride_);
+  FillRandom(reference_data_, reference_stride_);
+  const unsigned int full_sad = ReferenceSAD(UINT_MAX);
+  CheckSad(full_sad / 4);
+  CheckSad(full_sad / 2);
+  CheckSad(full_sad - 1);
+  CheckSad(full_sad);
+}
+
+TEST_P(SADavgTest, MaxRef) {
+  FillConstant(source_data_, source_stride_, 0);
+  FillConstant(reference_data_, reference_stride_, 255);
+  FillConstant(second_pred_, width_, 255);
+  CheckSadAvg(UINT_MAX);
+}
+
+TEST_P(SADavgTest, MaxSrc) {
+  FillConstant(source_data_, source_stride_, 255);
+  FillConstant(reference_data_, reference_stride_, 0);
+  FillConstant(second_pred_, width_, 0);
+  CheckSadAvg(UINT_MAX);
+}
+
+TEST_P(SADavgTest, ShortRef) {
+  int tmp_stride = reference_stride_;
+  reference_stride_ >>= 1;
+  FillRandom(source_data_, source_stride_);
+  FillRandom(reference_data_, reference_stride_);
+  FillRandom(second_pred_, width_);
+  CheckSadAvg(UINT_MAX);
+  reference_stride_ = tmp_stride;
+}
+
+TEST_P(SADavgTest, UnalignedRef) {
+  // The reference frame, but not the source frame, may be unaligned for
+  // certain types of searches.
+  int tmp_stride = reference_stride_;
+  reference_stride_ -= 1;
+  FillRandom(source_data_, source_stride_);
+  FillRandom(reference_data_, reference_stride_);
+  FillRandom(second_pred_, width_);
+  CheckSadAvg(UINT_MAX);
+  reference_stride_ = tmp_stride;
+}
+
+TEST_P(SADavgTest, ShortSrc) {
+  int tmp_stride = source_stride_;
+  source_stride_ >>= 1;
+  FillRandom(source_data_, source_stride_);
+  FillRandom(reference_data_, reference_stride_);
+  FillRandom(second_pred_, width_);
+  CheckSadAvg(UINT_MAX);
+  source_stride_ = tmp_stride;
+}
+
+TEST_P(SADavgTest, MaxSAD) {
+  FillRandom(source_data_, source_stride_);
+  FillRandom(reference_data_, reference_stride_);
+  FillRandom(second_pred_, width_);
+  const unsigned int full_sad = ReferenceSADavg(UINT_MAX);
+  CheckSadAvg(full_sad / 4);
+  CheckSadAvg(full_sad / 2);
+  CheckSadAvg(full_sad);
+}
+
 using std::tr1::make_tuple;
 
 //------------------------------------------------------------------------------
@@ -368,6 +496,36 @@ INSTANTIATE_TEST_CASE_P(C, SADx4Test, ::testing::Values(
                         make_tuple(4, 4, sad_4x4x4d_c)));
 #endif  // CONFIG_VP9_ENCODER
 
+#if CONFIG_VP9_ENCODER
+const sad_m_by_n_avg_fn_t sad_64x64_avg_c = vp9_sad64x64_avg_c;
+const sad_m_by_n_avg_fn_t sad_64x32_avg_c = vp9_sad64x32_avg_c;
+const sad_m_by_n_avg_fn_t sad_32x64_avg_c = vp9_sad32x64_avg_c;
+const sad_m_by_n_avg_fn_t sad_32x32_avg_c = vp9_sad32x32_avg_c;
+const sad_m_by_n_avg_fn_t sad_32x16_avg_c = vp9_sad32x16_avg_c;
+const sad_m_by_n_avg_fn_t sad_16x32_avg_c = vp9_sad16x32_avg_c;
+const sad_m_by_n_avg_fn_t sad_16x16_avg_c = vp9_sad16x16_avg_c;
+const sad_m_by_n_avg_fn_t sad_16x8_avg_c = vp9_sad16x8_avg_c;
+const sad_m_by_n_avg_fn_t sad_8x16_avg_c = vp9_sad8x16_avg_c;
+const sad_m_by_n_avg_fn_t sad_8x8_avg_c = vp9_sad8x8_avg_c;
+const sad_m_by_n_avg_fn_t sad_8x4_avg_c = vp9_sad8x4_avg_c;
+const sad_m_by_n_avg_fn_t sad_4x8_avg_c = vp9_sad4x8_avg_c;
+const sad_m_by_n_avg_fn_t sad_4x4_avg_c = vp9_sad4x4_avg_c;
+INSTANTIATE_TEST_CASE_P(C, SADavgTest, ::testing::Values(
+                        make_tuple(64, 64, sad_64x64_avg_c),
+                        make_tuple(64, 32, sad_64x32_avg_c),
+                        make_tuple(32, 64, sad_32x64_avg_c),
+                        make_tuple(32, 32, sad_32x32_avg_c),
+                        make_tuple(32, 16, sad_32x16_avg_c),
+                        make_tuple(16, 32, sad_16x32_avg_c),
+                        make_tuple(16, 16, sad_16x16_avg_c),
+                        make_tuple(16, 8, sad_16x8_avg_c),
+                        make_tuple(8, 16, sad_8x16_avg_c),
+                        make_tuple(8, 8, sad_8x8_avg_c),
+                        make_tuple(8, 4, sad_8x4_avg_c),
+                        make_tuple(4, 8, sad_4x8_avg_c),
+                        make_tuple(4, 4, sad_4x4_avg_c)));
+#endif  // CONFIG_VP9_ENCODER
+
 //------------------------------------------------------------------------------
 // ARM functions
 #if HAVE_MEDIA
@@ -523,6 +681,30 @@ INSTANTIATE_TEST_CASE_P(SSE2, SADx4Test, ::testing::Values(
                         make_tuple(8, 16, sad_8x16x4d_sse2),
                         make_tuple(8, 8, sad_8x8x4d_sse2),
                         make_tuple(8, 4, sad_8x4x4d_sse2)));
+
+const sad_m_by_n_avg_fn_t sad_64x64_avg_sse2 = vp9_sad64x64_avg_sse2;
+const sad_m_by_n_avg_fn_t sad_64x32_avg_sse2 = vp9_sad64x32_avg_sse2;
+const sad_m_by_n_avg_fn_t sad_32x64_avg_sse2 = vp9_sad32x64_avg_sse2;
+const sad_m_by_n_avg_fn_t sad_32x32_avg_sse2 = vp9_sad32x32_avg_sse2;
+const sad_m_by_n_avg_fn_t sad_32x16_avg_sse2 = vp9_sad32x16_avg_sse2;
+const sad_m_by_n_avg_fn_t sad_16x32_avg_sse2 = vp9_sad16x32_avg_sse2;
+const sad_m_by_n_avg_fn_t sad_16x16_avg_sse2 = vp9_sad16x16_avg_sse2;
+const sad_m_by_n_avg_fn_t sad_16x8_avg_sse2 = vp9_sad16x8_avg_sse2;
+const sad_m_by_n_avg_fn_t sad_8x16_avg_sse2 = vp9_sad8x16_avg_sse2;
+const sad_m_by_n_avg_fn_t sad_8x8_avg_sse2 = vp9_sad8x8_avg_sse2;
+const sad_m_by_n_avg_fn_t sad_8x4_avg_sse2 = vp9_sad8x4_avg_sse2;
+INSTANTIATE_TEST_CASE_P(SSE2, SADavgTest, ::testing::Values(
+                        make_tuple(64, 64, sad_64x64_avg_sse2),
+                        make_tuple(64, 32, sad_64x32_avg_sse2),
+                        make_tuple(32, 64, sad_32x64_avg_sse2),
+                        make_tuple(32, 32, sad_32x32_avg_sse2),
+                        make_tuple(32, 16, sad_32x16_avg_sse2),
+                        make_tuple(16, 32, sad_16x32_avg_sse2),
+                        make_tuple(16, 16, sad_16x16_avg_sse2),
+                        make_tuple(16, 8, sad_16x8_avg_sse2),
+                        make_tuple(8, 16, sad_8x16_avg_sse2),
+                        make_tuple(8, 8, sad_8x8_avg_sse2),
+                        make_tuple(8, 4, sad_8x4_avg_sse2)));
 #endif
 #endif
 #endif
@@ -553,4 +735,56 @@ INSTANTIATE_TEST_CASE_P(SSE3, SADTest, ::testing::Values(
 #endif
 #endif
 
+#if HAVE_AVX2
+#if CONFIG_VP9_ENCODER
+const sad_m_by_n_fn_t sad_64x64_avx2 = vp9_sad64x64_avx2;
+const sad_m_by_n_fn_t sad_64x32_avx2 = vp9_sad64x32_avx2;
+const sad_m_by_n_fn_t sad_32x64_avx2 = vp9_sad32x64_avx2;
+const sad_m_by_n_fn_t sad_32x32_avx2 = vp9_sad32x32_avx2;
+const sad_m_by_n_fn_t sad_32x16_avx2 = vp9_sad32x16_avx2;
+const sad_m_by_n_fn_t sad_16x32_avx2 = vp9_sad16x32_avx2;
+const sad_m_by_n_fn_t sad_16x16_avx2 = vp9_sad16x16_avx2;
+const sad_m_by_n_fn_t sad_16x8_avx2 = vp9_sad16x8_avx2;
+const sad_m_by_n_fn_t sad_8x16_avx2 = vp9_sad8x16_avx2;
+const sad_m_by_n_fn_t sad_8x8_avx2 = vp9_sad8x8_avx2;
+const sad_m_by_n_fn_t sad_8x4_avx2 = vp9_sad8x4_avx2;
+INSTANTIATE_TEST_CASE_P(AVX2, SADTest, ::testing::Values(
+                        make_tuple(64, 64, sad_64x64_avx2),
+                        make_tuple(64, 32, sad_64x32_avx2),
+                        make_tuple(32, 64, sad_32x64_avx2),
+                        make_tuple(32, 32, sad_32x32_avx2),
+                        make_tuple(32, 16, sad_32x16_avx2),
+                        make_tuple(16, 32, sad_16x32_avx2),
+                        make_tuple(16, 16, sad_16x16_avx2),
+                        make_tuple(16, 8, sad_16x8_avx2),
+                        make_tuple(8, 16, sad_8x16_avx2),
+                        make_tuple(8, 8, sad_8x8_avx2),
+                        make_tuple(8, 4, sad_8x4_avx2)));
+
+const sad_m_by_n_avg_fn_t sad_64x64_avg_avx2 = vp9_sad64x64_avg_avx2;
+const sad_m_by_n_avg_fn_t sad_64x32_avg_avx2 = vp9_sad64x32_avg_avx2;
+const sad_m_by_n_avg_fn_t sad_32x64_avg_avx2 = vp9_sad32x64_avg_avx2;
+const sad_m_by_n_avg_fn_t sad_32x32_avg_avx2 = vp9_sad32x32_avg_avx2;
+const sad_m_by_n_avg_fn_t sad_32x16_avg_avx2 = vp9_sad32x16_avg_avx2;
+const sad_m_by_n_avg_fn_t sad_16x32_avg_avx2 = vp9_sad16x32_avg_avx2;
+const sad_m_by_n_avg_fn_t sad_16x16_avg_avx2 = vp9_sad16x16_avg_avx2;
+const sad_m_by_n_avg_fn_t sad_16x8_avg_avx2 = vp9_sad16x8_avg_avx2;
+const sad_m_by_n_avg_fn_t sad_8x16_avg_avx2 = vp9_sad8x16_avg_avx2;
+const sad_m_by_n_avg_fn_t sad_8x8_avg_avx2 = vp9_sad8x8_avg_avx2;
+const sad_m_by_n_avg_fn_t sad_8x4_avg_avx2 = vp9_sad8x4_avg_avx2;
+INSTANTIATE_TEST_CASE_P(AVX2, SADavgTest, ::testing::Values(
+                        make_tuple(64, 64, sad_64x64_avg_avx2),
+                        make_tuple(64, 32, sad_64x32_avg_avx2),
+                        make_tuple(32, 64, sad_32x64_avg_avx2),
+                        make_tuple(32, 32, sad_32x32_avg_avx2),
+                        make_tuple(32, 16, sad_32x16_avg_avx2),
+                        make_tuple(16, 32, sad_16x32_avg_avx2),
+                        make_tuple(16, 16, sad_16x16_avg_avx2),
+                        make_tuple(16, 8, sad_16x8_avg_avx2),
+                        make_tuple(8, 16, sad_8x16_avg_avx2),
+                        make_tuple(8, 8, sad_8x8_avg_avx2),
+                        make_tuple(8, 4, sad_8x4_avg_avx2)));
+#endif  // CONFIG_VP9_ENCODER
+#endif  // HAVE_AVX2
+
 }  // namespace
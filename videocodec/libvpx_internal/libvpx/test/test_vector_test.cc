@@ -59,6 +59,27 @@ class TestVectorTest : public ::libvpx_test::DecoderTest,
         << "Md5 checksums don't match: frame number = " << frame_number;
   }
 
+  void DecodeTestVector(const std::string &filename,
+                        const vpx_codec_dec_cfg_t &cfg) {
+    libvpx_test::CompressedVideoSource *video = NULL;
+
+    // Open compressed video file.
+    if (filename.substr(filename.length() - 3, 3) == "ivf") {
+      video = new libvpx_test::IVFVideoSource(filename);
+    } else if (filename.substr(filename.length() - 4, 4) == "webm") {
+      video = new libvpx_test::WebMVideoSource(filename);
+    }
+    video->Init();
+
+    // Construct md5 file name.
+    const std::string md5_filename = filename + ".md5";
+    OpenMD5File(md5_filename);
+
+    // Decode frame, and check the md5 matching.
+    ASSERT_NO_FATAL_FAILURE(RunLoop(video, cfg));
+    delete video;
+  }
+
  private:
   FILE *md5_file_;
 };
@@ -68,24 +89,52 @@ class TestVectorTest : public ::libvpx_test::DecoderTest,
 // checksums match the correct md5 data, then the test is passed. Otherwise,
 // the test failed.
 TEST_P(TestVectorTest, MD5Match) {
-  const std::string filename = GET_PARAM(1);
-  libvpx_test::CompressedVideoSource *video = NULL;
-
-  // Open compressed video file.
-  if (filename.substr(filename.length() - 3, 3) == "ivf") {
-    video = new libvpx_test::IVFVideoSource(filename);
-  } else if (filename.substr(filename.length() - 4, 4) == "webm") {
-    video = new libvpx_test::WebMVideoSource(filename);
+  const vpx_codec_dec_cfg_t cfg = {0};
+  DecodeTestVector(GET_PARAM(1), cfg);
+}
+
+// Multi-threaded decoding, row-based or with tiles, has to produce the same
+// frames as the serial decoder.
+class MultiThreadedTestVectorTest : public TestVectorTest {};
+
+TEST_P(MultiThreadedTestVectorTest, MD5Match) {
+  vpx_codec_dec_cfg_t cfg = {0};
+  cfg.threads = 4;
+  DecodeTestVector(GET_PARAM(1), cfg);
+}
+
+// Frame-based multi-threaded decoding has to produce the same frames, in the
+// same order, as the serial decoder.
+class FrameParallelTestVectorTest : public TestVectorTest {};
+
+TEST_P(FrameParallelTestVectorTest, MD5Match) {
+  vpx_codec_dec_cfg_t cfg = {0};
+  cfg.threads = 4;
+  set_flags(VPX_CODEC_USE_FRAME_THREADING);
+  DecodeTestVector(GET_PARAM(1), cfg);
+}
+
+// Two-stage decoding parses each frame completely before reconstructing it;
+// the output must not change, with or without threads.
+class TwoStageTestVectorTest : public TestVectorTest {
+ protected:
+  virtual void PreDecodeFrameHook(
+      const libvpx_test::CompressedVideoSource &video,
+      libvpx_test::Decoder *decoder) {
+    if (video.frame_number() == 0)
+      decoder->Control(VP9D_SET_TWO_STAGE_DECODE, 1);
   }
-  video->Init();
+};
 
-  // Construct md5 file name.
-  const std::string md5_filename = filename + ".md5";
-  OpenMD5File(md5_filename);
+TEST_P(TwoStageTestVectorTest, MD5Match) {
+  const vpx_codec_dec_cfg_t cfg = {0};
+  DecodeTestVector(GET_PARAM(1), cfg);
+}
 
-  // Decode frame, and check the md5 matching.
-  ASSERT_NO_FATAL_FAILURE(RunLoop(video));
-  delete video;
+TEST_P(TwoStageTestVectorTest, MultiThreadedMD5Match) {
+  vpx_codec_dec_cfg_t cfg = {0};
+  cfg.threads = 4;
+  DecodeTestVector(GET_PARAM(1), cfg);
 }
 
 VP8_INSTANTIATE_TEST_CASE(TestVectorTest,
@@ -96,5 +145,17 @@ VP9_INSTANTIATE_TEST_CASE(TestVectorTest,
                           ::testing::ValuesIn(libvpx_test::kVP9TestVectors,
                                               libvpx_test::kVP9TestVectors +
                                               libvpx_test::kNumVP9TestVectors));
+VP9_INSTANTIATE_TEST_CASE(MultiThreadedTestVectorTest,
+                          ::testing::ValuesIn(libvpx_test::kVP9TestVectors,
+                                              libvpx_test::kVP9TestVectors +
+                                              libvpx_test::kNumVP9TestVectors));
+VP9_INSTANTIATE_TEST_CASE(FrameParallelTestVectorTest,
+                          ::testing::ValuesIn(libvpx_test::kVP9TestVectors,
+                                              libvpx_test::kVP9TestVectors +
+                                              libvpx_test::kNumVP9TestVectors));
+VP9_INSTANTIATE_TEST_CASE(TwoStageTestVectorTest,
+                          ::testing::ValuesIn(libvpx_test::kVP9TestVectors,
+                                              libvpx_test::kVP9TestVectors +
+                                              libvpx_test::kNumVP9TestVectors));
 
 }  // namespace
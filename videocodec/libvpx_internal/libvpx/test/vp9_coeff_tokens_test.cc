@@ -0,0 +1,107 @@
+/*
+ *  Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <stdlib.h>
+
+#include "third_party/googletest/src/include/gtest/gtest.h"
+#include "test/acm_random.h"
+#include "test/clear_system_state.h"
+#include "test/register_state_check.h"
+#include "./vpx_config.h"
+#include "./vp9_rtcd.h"
+#include "vp9/common/vp9_entropy.h"
+#include "vp9/encoder/vp9_tokenize.h"
+#include "vpx_mem/vpx_mem.h"
+
+typedef void (*coeff_tokens_fn_t)(const int16_t *qcoeff, intptr_t n_coeffs,
+                                  uint8_t *tokens, uint8_t *token_cache);
+
+namespace vp9 {
+
+using libvpx_test::ACMRandom;
+
+// Token of a coefficient, following the categories of vp9_extra_bits.
+int ReferenceToken(int16_t coeff) {
+  const int magnitude = abs(coeff);
+  int token = CATEGORY6_TOKEN;
+
+  if (magnitude <= 4)
+    return magnitude;
+  while (vp9_extra_bits[token].base_val > magnitude)
+    --token;
+  return token;
+}
+
+class VP9CoeffTokensTest : public ::testing::TestWithParam<coeff_tokens_fn_t> {
+ public:
+  virtual void SetUp() {
+    // The C version looks the tokens up in the table this sets up.
+    vp9_tokenize_initialize();
+    qcoeff_ = reinterpret_cast<int16_t *>(
+        vpx_memalign(16, sizeof(*qcoeff_) * kMaxCoeffs));
+    tokens_ = reinterpret_cast<uint8_t *>(vpx_memalign(16, kMaxCoeffs));
+    token_cache_ = reinterpret_cast<uint8_t *>(vpx_memalign(16, kMaxCoeffs));
+  }
+
+  virtual void TearDown() {
+    vpx_free(qcoeff_);
+    vpx_free(tokens_);
+    vpx_free(token_cache_);
+    libvpx_test::ClearSystemState();
+  }
+
+ protected:
+  static const int kMaxCoeffs = 32 * 32;
+
+  void CheckTokens(int n_coeffs) {
+    REGISTER_STATE_CHECK(GetParam()(qcoeff_, n_coeffs, tokens_, token_cache_));
+    for (int i = 0; i < n_coeffs; ++i) {
+      const int token = ReferenceToken(qcoeff_[i]);
+      ASSERT_EQ(token, tokens_[i]) << "coeff = " << qcoeff_[i];
+      ASSERT_EQ(vp9_pt_energy_class[token], token_cache_[i])
+          << "coeff = " << qcoeff_[i];
+    }
+  }
+
+  int16_t *qcoeff_;
+  uint8_t *tokens_;
+  uint8_t *token_cache_;
+};
+
+TEST_P(VP9CoeffTokensTest, AllValues) {
+  for (int start = -DCT_MAX_VALUE + 1; start < DCT_MAX_VALUE;
+       start += kMaxCoeffs) {
+    for (int i = 0; i < kMaxCoeffs; ++i)
+      qcoeff_[i] = MIN(start + i, DCT_MAX_VALUE - 1);
+    CheckTokens(kMaxCoeffs);
+  }
+}
+
+TEST_P(VP9CoeffTokensTest, RandomValues) {
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+
+  for (int n = 0; n < 100; ++n) {
+    // Mostly small magnitudes, as quantized coefficients are.
+    const int range = n & 1 ? 16 : DCT_MAX_VALUE;
+    const int n_coeffs = n & 2 ? 16 * 16 : 32 * 32;
+    for (int i = 0; i < n_coeffs; ++i)
+      qcoeff_[i] = rnd(2 * range - 1) - (range - 1);
+    CheckTokens(n_coeffs);
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(C, VP9CoeffTokensTest,
+                        ::testing::Values(vp9_get_coeff_tokens_c));
+
+#if HAVE_SSE2
+INSTANTIATE_TEST_CASE_P(SSE2, VP9CoeffTokensTest,
+                        ::testing::Values(vp9_get_coeff_tokens_sse2));
+#endif
+}  // namespace vp9
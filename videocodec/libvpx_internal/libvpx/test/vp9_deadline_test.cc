@@ -0,0 +1,117 @@
+/*
+ *  Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <vector>
+#include "third_party/googletest/src/include/gtest/gtest.h"
+#include "test/codec_factory.h"
+#include "test/encode_test_driver.h"
+#include "test/i420_video_source.h"
+#include "test/util.h"
+
+namespace {
+
+const int kFrames = 10;
+
+class VP9DeadlineTest
+    : public ::libvpx_test::EncoderTest,
+      public ::libvpx_test::CodecTestWithParam<int> {
+ protected:
+  VP9DeadlineTest()
+      : EncoderTest(GET_PARAM(0)),
+        set_cpu_used_(GET_PARAM(1)),
+        deadline_aware_(1),
+        row_mt_(0),
+        frames_(0) {}
+
+  virtual ~VP9DeadlineTest() {}
+
+  virtual void SetUp() {
+    InitializeConfig();
+    SetMode(::libvpx_test::kRealTime);
+
+    cfg_.g_lag_in_frames = 0;
+    cfg_.rc_end_usage = VPX_VBR;
+    cfg_.rc_target_bitrate = 500;
+  }
+
+  virtual void PreEncodeFrameHook(::libvpx_test::VideoSource *video,
+                                  ::libvpx_test::Encoder *encoder) {
+    // The encoder is initialized with the first frame, so the deadline
+    // packets start with the second one.
+    if (video->frame() == 1) {
+      encoder->Control(VP8E_SET_CPUUSED, set_cpu_used_);
+      encoder->Control(VP9E_SET_ROW_MT, row_mt_);
+      encoder->Control(VP9E_SET_DEADLINE_AWARE, deadline_aware_);
+    }
+  }
+
+  virtual void FramePktHook(const vpx_codec_cx_pkt_t * /*pkt*/) {
+    ++frames_;
+  }
+
+  virtual void DeadlinePktHook(const vpx_codec_cx_pkt_t *pkt) {
+    EXPECT_EQ(deadline_, pkt->data.deadline.budget);
+    levels_.push_back(pkt->data.deadline.level);
+  }
+
+  void Encode(unsigned long deadline) {
+    ::libvpx_test::I420VideoSource video("hantro_collage_w352h288.yuv",
+                                         352, 288, 30, 1, 0, kFrames);
+    deadline_ = deadline;
+    frames_ = 0;
+    levels_.clear();
+    ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
+    ASSERT_EQ(kFrames, frames_);
+  }
+
+  int set_cpu_used_;
+  int deadline_aware_;
+  int row_mt_;
+  int frames_;
+  std::vector<int> levels_;
+};
+
+// Without deadline-aware encoding, the deadline only selects the mode.
+TEST_P(VP9DeadlineTest, NoDeadlinePackets) {
+  deadline_aware_ = 0;
+  Encode(VPX_DL_REALTIME);
+  EXPECT_TRUE(levels_.empty());
+}
+
+// A budget longer than the frame duration keeps the realtime mode, and
+// needs no degradation.
+TEST_P(VP9DeadlineTest, LongDeadline) {
+  Encode(10 * VPX_DL_GOOD_QUALITY);
+  ASSERT_EQ(static_cast<size_t>(kFrames - 1), levels_.size());
+  for (size_t i = 0; i < levels_.size(); ++i)
+    EXPECT_EQ(0, levels_[i]) << "frame " << i + 1;
+}
+
+// No frame fits in 1us: the search degrades from the second superblock row
+// of the first inter frame on, and the frames still decode as encoded.
+TEST_P(VP9DeadlineTest, ShortDeadline) {
+  Encode(VPX_DL_REALTIME);
+  ASSERT_EQ(static_cast<size_t>(kFrames - 1), levels_.size());
+  for (size_t i = 0; i < levels_.size(); ++i)
+    EXPECT_GT(levels_[i], 0) << "frame " << i + 1;
+}
+
+// The rows encoded in parallel share the timing of the frame.
+TEST_P(VP9DeadlineTest, ShortDeadlineRowMT) {
+  cfg_.g_threads = 2;
+  row_mt_ = 1;
+  Encode(VPX_DL_REALTIME);
+  ASSERT_EQ(static_cast<size_t>(kFrames - 1), levels_.size());
+  for (size_t i = 0; i < levels_.size(); ++i)
+    EXPECT_GT(levels_[i], 0) << "frame " << i + 1;
+}
+
+VP9_INSTANTIATE_TEST_CASE(VP9DeadlineTest, ::testing::Values(5, 6, 7));
+}  // namespace
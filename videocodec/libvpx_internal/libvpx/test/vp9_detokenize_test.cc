@@ -0,0 +1,313 @@
+/*
+ *  Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "third_party/googletest/src/include/gtest/gtest.h"
+
+#include "vp9/common/vp9_entropy.h"
+#include "vp9/common/vp9_onyxc_int.h"
+#include "vp9/common/vp9_scan.h"
+#include "vp9/decoder/vp9_detokenize.h"
+#include "vp9/decoder/vp9_reader.h"
+
+#include "test/acm_random.h"
+#include "vpx/vpx_integer.h"
+#include "vpx_ports/vpx_timer.h"
+
+using libvpx_test::ACMRandom;
+
+namespace {
+
+const int kBufferSize = 1 << 16;
+const int kBlocksPerTest = 2000;
+const int kSpeedTestRuns = 20;
+
+// The token tree walk vp9_decode_block_tokens() had before it kept the reader
+// state in registers, one vp9_read() per node.
+int ReferenceDecodeCoefs(const vp9_prob (*coef_probs)[COEFF_CONTEXTS]
+                                                     [UNCONSTRAINED_NODES],
+                         unsigned int (*coef_counts)[COEFF_CONTEXTS]
+                                                    [UNCONSTRAINED_NODES + 1],
+                         unsigned int (*eob_branch)[COEFF_CONTEXTS],
+                         int16_t *dqcoeff, TX_SIZE tx_size, const int16_t *dq,
+                         int ctx, const int16_t *scan, const int16_t *nb,
+                         vp9_reader *r) {
+  static const int kCatMinVal[] = { 5, 7, 11, 19, 35 };
+  static const vp9_prob kCatProbs[][6] = {
+    { 159, 0 },
+    { 165, 145, 0 },
+    { 173, 148, 140, 0 },
+    { 176, 155, 140, 135, 0 },
+    { 180, 157, 141, 134, 130, 0 },
+  };
+  static const vp9_prob kCat6Probs[] = {
+    254, 254, 254, 252, 249, 243, 230, 196, 177, 153, 140, 133, 130, 129, 0
+  };
+  const int max_eob = 16 << (tx_size << 1);
+  const uint8_t *band_translate = get_band_translate(tx_size);
+  const int dq_shift = (tx_size == TX_32X32);
+  uint8_t token_cache[32 * 32];
+  int16_t dqv = dq[0];
+  int c = 0;
+
+  while (c < max_eob) {
+    int band = *band_translate++;
+    const vp9_prob *prob = coef_probs[band][ctx];
+    int token, val;
+
+    ++eob_branch[band][ctx];
+    if (!vp9_read(r, prob[0])) {
+      ++coef_counts[band][ctx][EOB_MODEL_TOKEN];
+      break;
+    }
+    while (!vp9_read(r, prob[1])) {
+      ++coef_counts[band][ctx][ZERO_TOKEN];
+      dqv = dq[1];
+      token_cache[scan[c]] = 0;
+      if (++c >= max_eob)
+        return c;
+      ctx = get_coef_context(nb, token_cache, c);
+      band = *band_translate++;
+      prob = coef_probs[band][ctx];
+    }
+    if (!vp9_read(r, prob[2])) {
+      ++coef_counts[band][ctx][ONE_TOKEN];
+      token = ONE_TOKEN;
+      val = 1;
+    } else {
+      ++coef_counts[band][ctx][TWO_TOKEN];
+      prob = vp9_pareto8_full[prob[PIVOT_NODE] - 1];
+      if (!vp9_read(r, prob[0])) {
+        if (!vp9_read(r, prob[1]))
+          token = TWO_TOKEN;
+        else
+          token = vp9_read(r, prob[2]) ? FOUR_TOKEN : THREE_TOKEN;
+        val = token;
+      } else {
+        const vp9_prob *cat_prob;
+        if (!vp9_read(r, prob[3]))
+          token = vp9_read(r, prob[4]) ? CATEGORY2_TOKEN : CATEGORY1_TOKEN;
+        else if (!vp9_read(r, prob[5]))
+          token = vp9_read(r, prob[6]) ? CATEGORY4_TOKEN : CATEGORY3_TOKEN;
+        else
+          token = vp9_read(r, prob[7]) ? CATEGORY6_TOKEN : CATEGORY5_TOKEN;
+        cat_prob = token == CATEGORY6_TOKEN ? kCat6Probs
+                                            : kCatProbs[token - CATEGORY1_TOKEN];
+        val = 0;
+        while (*cat_prob)
+          val = (val << 1) | vp9_read(r, *cat_prob++);
+        val += token == CATEGORY6_TOKEN ? 67 : kCatMinVal[token -
+                                                          CATEGORY1_TOKEN];
+      }
+    }
+    const int v = (val * dqv) >> dq_shift;
+    dqcoeff[scan[c]] = vp9_read_bit(r) ? -v : v;
+    token_cache[scan[c]] = vp9_pt_energy_class[token];
+    ++c;
+    ctx = get_coef_context(nb, token_cache, c);
+    dqv = dq[1];
+  }
+  return c;
+}
+
+// The top |valid| bits of the reader window, which hold data; the rest of it
+// depends on how far ahead the reader was refilled.
+BD_VALUE ValidBits(const vp9_reader &r, int valid) {
+  if (valid >= BD_VALUE_SIZE)
+    return r.value;
+  return r.value & (~static_cast<BD_VALUE>(0) << (BD_VALUE_SIZE - valid));
+}
+
+class VP9DetokenizeTest : public ::testing::Test {
+ protected:
+  VP9DetokenizeTest() : rnd_(ACMRandom::DeterministicSeed()) {}
+
+  virtual void SetUp() {
+    vp9_init_neighbors();
+    cm_ = new VP9_COMMON;
+    memset(cm_, 0, sizeof(*cm_));
+    vp9_default_coef_probs(cm_);
+    memset(&xd_, 0, sizeof(xd_));
+    memset(&mi_, 0, sizeof(mi_));
+    mi_ptr_ = &mi_;
+    xd_.mi = &mi_ptr_;
+    for (int i = 0; i < kBufferSize; ++i)
+      buffer_[i] = rnd_.Rand8();
+  }
+
+  virtual void TearDown() {
+    delete cm_;
+  }
+
+  // Makes the coefficient model likely to produce big tokens, which the
+  // default model rarely does.
+  void RandomizeProbs() {
+    vp9_prob *const probs = &cm_->fc.coef_probs[0][0][0][0][0][0];
+    for (size_t i = 0; i < sizeof(cm_->fc.coef_probs); ++i)
+      probs[i] = 1 + rnd_(255);
+  }
+
+  // vp9_decode_block_tokens() on top of the reference tree walk.
+  int ReferenceDecodeBlockTokens(FRAME_COUNTS *counts, TX_SIZE tx_size,
+                                 vp9_reader *r) {
+    struct macroblockd_plane *const pd = &xd_.plane[0];
+    const PLANE_TYPE type = pd->plane_type;
+    const int ref = is_inter_block(&mi_.mbmi);
+    const int ctx = get_entropy_context(tx_size, pd->above_context,
+                                        pd->left_context);
+    const scan_order *const so = get_scan(&xd_, tx_size, type, 0);
+    const int eob = ReferenceDecodeCoefs(
+        cm_->fc.coef_probs[tx_size][type][ref], counts->coef[tx_size][type][ref],
+        counts->eob_branch[tx_size][type][ref], pd->dqcoeff, tx_size,
+        pd->dequant, ctx, so->scan, so->neighbors, r);
+    vp9_set_contexts(&xd_, pd, BLOCK_64X64, tx_size, eob > 0, 0, 0);
+    return eob;
+  }
+
+  void SetBlock(PLANE_TYPE type, int ref, MB_PREDICTION_MODE mode) {
+    mi_.mbmi.ref_frame[0] = ref ? LAST_FRAME : INTRA_FRAME;
+    mi_.mbmi.mode = mode;
+    mi_.mbmi.sb_type = BLOCK_64X64;
+    xd_.plane[0].plane_type = type;
+    xd_.plane[0].dqcoeff = dqcoeff_;
+    xd_.plane[0].dequant = dequant_;
+    xd_.plane[0].above_context = above_;
+    xd_.plane[0].left_context = left_;
+  }
+
+  VP9_COMMON *cm_;
+  MACROBLOCKD xd_;
+  MODE_INFO mi_;
+  MODE_INFO *mi_ptr_;
+  ACMRandom rnd_;
+  uint8_t buffer_[kBufferSize];
+  DECLARE_ALIGNED(16, int16_t, dqcoeff_[32 * 32]);
+  DECLARE_ALIGNED(16, int16_t, ref_dqcoeff_[32 * 32]);
+  int16_t dequant_[2];
+  ENTROPY_CONTEXT above_[16];
+  ENTROPY_CONTEXT left_[16];
+};
+
+TEST_F(VP9DetokenizeTest, MatchesReference) {
+  for (int probs = 0; probs < 2; ++probs) {
+    if (probs)
+      RandomizeProbs();
+    for (int fpd = 0; fpd < 2; ++fpd) {
+      FRAME_COUNTS ref_counts;
+      vp9_reader r, ref_r;
+      memset(&cm_->counts, 0, sizeof(cm_->counts));
+      memset(&ref_counts, 0, sizeof(ref_counts));
+      cm_->frame_parallel_decoding_mode = fpd;
+      // The stream runs out before the last blocks, which then decode the
+      // zeros past its end.
+      ASSERT_EQ(0, vp9_reader_init(&r, buffer_, kBufferSize / (1 + probs)));
+      ref_r = r;
+
+      for (int i = 0; i < kBlocksPerTest; ++i) {
+        const TX_SIZE tx_size = static_cast<TX_SIZE>(rnd_(TX_SIZES));
+        const PLANE_TYPE type = static_cast<PLANE_TYPE>(rnd_(PLANE_TYPES));
+        const int ref = rnd_(2);
+        SetBlock(type, ref, static_cast<MB_PREDICTION_MODE>(rnd_(TM_PRED + 1)));
+        dequant_[0] = 8 + rnd_(1000);
+        dequant_[1] = 8 + rnd_(1000);
+        for (int j = 0; j < 16; ++j) {
+          above_[j] = rnd_(2);
+          left_[j] = rnd_(2);
+        }
+        ENTROPY_CONTEXT above[16], left[16], ref_above[16], ref_left[16];
+        memcpy(above, above_, sizeof(above));
+        memcpy(left, left_, sizeof(left));
+        memset(dqcoeff_, 0, sizeof(dqcoeff_));
+        memset(ref_dqcoeff_, 0, sizeof(ref_dqcoeff_));
+
+        xd_.plane[0].dqcoeff = ref_dqcoeff_;
+        const int ref_eob = ReferenceDecodeBlockTokens(&ref_counts, tx_size,
+                                                       &ref_r);
+        memcpy(ref_above, above_, sizeof(ref_above));
+        memcpy(ref_left, left_, sizeof(ref_left));
+        memcpy(above_, above, sizeof(above_));
+        memcpy(left_, left, sizeof(left_));
+        xd_.plane[0].dqcoeff = dqcoeff_;
+        const int eob = vp9_decode_block_tokens(cm_, &xd_, 0, 0, BLOCK_64X64,
+                                                0, 0, tx_size, &r);
+
+        ASSERT_EQ(ref_eob, eob) << "block " << i;
+        ASSERT_EQ(0, memcmp(ref_dqcoeff_, dqcoeff_, sizeof(dqcoeff_)))
+            << "block " << i;
+        ASSERT_EQ(0, memcmp(ref_above, above_, sizeof(ref_above)));
+        ASSERT_EQ(0, memcmp(ref_left, left_, sizeof(ref_left)));
+        const int valid = CHAR_BIT + std::min(ref_r.count, r.count);
+        ASSERT_EQ(ValidBits(ref_r, valid), ValidBits(r, valid))
+            << "block " << i;
+        ASSERT_EQ(ref_r.range, r.range) << "block " << i;
+        // The reader may have loaded more bytes, but not consumed more bits.
+        ASSERT_EQ((ref_r.buffer - buffer_) * CHAR_BIT - ref_r.count,
+                  (r.buffer - buffer_) * CHAR_BIT - r.count) << "block " << i;
+        ASSERT_EQ(vp9_reader_has_error(&ref_r), vp9_reader_has_error(&r));
+      }
+      EXPECT_EQ(vp9_reader_find_end(&ref_r), vp9_reader_find_end(&r));
+      if (fpd) {
+        FRAME_COUNTS zero_counts;
+        memset(&zero_counts, 0, sizeof(zero_counts));
+        EXPECT_EQ(0, memcmp(&zero_counts, &cm_->counts, sizeof(zero_counts)));
+      } else {
+        EXPECT_EQ(0, memcmp(ref_counts.coef, cm_->counts.coef,
+                            sizeof(ref_counts.coef)));
+        EXPECT_EQ(0, memcmp(ref_counts.eob_branch, cm_->counts.eob_branch,
+                            sizeof(ref_counts.eob_branch)));
+      }
+    }
+  }
+}
+
+// Microbenchmark of the token reader against the reference tree walk, on the
+// default model with high quality dequantizers, as for intra heavy content.
+TEST_F(VP9DetokenizeTest, DISABLED_Speed) {
+  const TX_SIZE kTxSizes[] = { TX_4X4, TX_8X8, TX_16X16, TX_32X32 };
+  dequant_[0] = 8;
+  dequant_[1] = 8;
+
+  for (int t = 0; t < 4; ++t) {
+    const TX_SIZE tx_size = kTxSizes[t];
+    int64_t elapsed[2];
+
+    SetBlock(PLANE_TYPE_Y, 0, DC_PRED);
+    for (int impl = 0; impl < 2; ++impl) {
+      FRAME_COUNTS ref_counts;
+      vpx_usec_timer timer;
+      memset(&ref_counts, 0, sizeof(ref_counts));
+      vpx_usec_timer_start(&timer);
+      for (int run = 0; run < kSpeedTestRuns; ++run) {
+        vp9_reader r;
+        vp9_reader_init(&r, buffer_, kBufferSize);
+        while (!vp9_reader_has_error(&r)) {
+          memset(above_, 0, sizeof(above_));
+          memset(left_, 0, sizeof(left_));
+          if (impl)
+            vp9_decode_block_tokens(cm_, &xd_, 0, 0, BLOCK_64X64, 0, 0,
+                                    tx_size, &r);
+          else
+            ReferenceDecodeBlockTokens(&ref_counts, tx_size, &r);
+        }
+      }
+      vpx_usec_timer_mark(&timer);
+      elapsed[impl] = vpx_usec_timer_elapsed(&timer);
+    }
+    printf("tx_size %d: reference %6d us, vp9_decode_block_tokens %6d us\n",
+           tx_size, static_cast<int>(elapsed[0]),
+           static_cast<int>(elapsed[1]));
+  }
+}
+
+}  // namespace
@@ -0,0 +1,137 @@
+/*
+ *  Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <string>
+#include <vector>
+#include "third_party/googletest/src/include/gtest/gtest.h"
+#include "test/codec_factory.h"
+#include "test/encode_test_driver.h"
+#include "test/i420_video_source.h"
+#include "test/md5_helper.h"
+#include "test/util.h"
+
+namespace {
+class VP9EncoderThreadTest
+    : public ::libvpx_test::EncoderTest,
+      public ::libvpx_test::CodecTestWith2Params<libvpx_test::TestMode, int> {
+ protected:
+  VP9EncoderThreadTest()
+      : EncoderTest(GET_PARAM(0)),
+        encoding_mode_(GET_PARAM(1)),
+        set_cpu_used_(GET_PARAM(2)),
+        row_mt_(0),
+        lookahead_analysis_(0) {}
+
+  virtual ~VP9EncoderThreadTest() {}
+
+  virtual void SetUp() {
+    InitializeConfig();
+    SetMode(encoding_mode_);
+
+    cfg_.g_lag_in_frames = encoding_mode_ == ::libvpx_test::kRealTime ? 0 : 3;
+    cfg_.rc_end_usage = VPX_VBR;
+    cfg_.rc_target_bitrate = 500;
+  }
+
+  virtual void BeginPassHook(unsigned int /*pass*/) {
+    md5_.clear();
+  }
+
+  virtual void PreEncodeFrameHook(::libvpx_test::VideoSource *video,
+                                  ::libvpx_test::Encoder *encoder) {
+    if (video->frame() == 1) {
+      // 4 tile columns at 1056 wide.
+      encoder->Control(VP9E_SET_TILE_COLUMNS, 2);
+      encoder->Control(VP8E_SET_CPUUSED, set_cpu_used_);
+      encoder->Control(VP9E_SET_ROW_MT, row_mt_);
+      encoder->Control(VP9E_SET_LOOKAHEAD_ANALYSIS, lookahead_analysis_);
+      if (encoding_mode_ != ::libvpx_test::kRealTime) {
+        encoder->Control(VP8E_SET_ENABLEAUTOALTREF, 1);
+        encoder->Control(VP8E_SET_ARNR_MAXFRAMES, 7);
+        encoder->Control(VP8E_SET_ARNR_STRENGTH, 5);
+        encoder->Control(VP8E_SET_ARNR_TYPE, 3);
+      }
+    }
+  }
+
+  virtual void FramePktHook(const vpx_codec_cx_pkt_t *pkt) {
+    ::libvpx_test::MD5 md5;
+    md5.Add(static_cast<const uint8_t *>(pkt->data.frame.buf),
+            pkt->data.frame.sz);
+    md5_.push_back(md5.Get());
+  }
+
+  std::vector<std::string> Encode(unsigned int threads) {
+    // Without row_mt, the frames of hantro_collage_w352h288.yuv are read as
+    // 1056x96 for more tile columns. The height is kept a multiple of 16: at
+    // 1408x72 the two pass encodes with ARNR do not match the decoder, even
+    // on one thread.
+    ::libvpx_test::I420VideoSource video("hantro_collage_w352h288.yuv",
+                                         row_mt_ ? 352 : 1056,
+                                         row_mt_ ? 288 : 96, 30, 1, 0, 10);
+    cfg_.g_threads = threads;
+    init_flags_ = 0;
+    RunLoop(&video);
+    const vpx_fixed_buf_t stats = stats_.buf();
+    first_pass_stats_.assign(static_cast<const char *>(stats.buf), stats.sz);
+    return md5_;
+  }
+
+  ::libvpx_test::TestMode encoding_mode_;
+  int set_cpu_used_;
+  int row_mt_;
+  int lookahead_analysis_;
+  std::vector<std::string> md5_;
+  std::string first_pass_stats_;  // empty in one pass modes
+
+  // Encodes with 1 to 4 threads and checks that the first pass stats and the
+  // compressed frames are identical.
+  void CompareThreadCounts() {
+    const std::vector<std::string> single_thr_md5 = Encode(1);
+    const std::string single_thr_stats = first_pass_stats_;
+    ASSERT_FALSE(single_thr_md5.empty());
+
+    for (unsigned int threads = 2; threads <= 4; ++threads) {
+      const std::vector<std::string> multi_thr_md5 = Encode(threads);
+      ASSERT_FALSE(::testing::Test::HasFatalFailure());
+      EXPECT_TRUE(single_thr_stats == first_pass_stats_)
+          << "first pass stats differ with " << threads << " threads";
+      ASSERT_EQ(single_thr_md5.size(), multi_thr_md5.size());
+      for (size_t i = 0; i < single_thr_md5.size(); ++i)
+        EXPECT_EQ(single_thr_md5[i], multi_thr_md5[i])
+            << "frame " << i << " differs with " << threads << " threads";
+    }
+  }
+};
+
+// Tile columns encoded in parallel must give the same bitstream.
+TEST_P(VP9EncoderThreadTest, EncoderResultTest) {
+  CompareThreadCounts();
+}
+
+// So must the superblock rows of a single tile column with row_mt.
+TEST_P(VP9EncoderThreadTest, RowMTResultTest) {
+  row_mt_ = 1;
+  CompareThreadCounts();
+}
+
+// The lookahead analysis runs in the background with threads, and must not
+// change the decisions of the one pass rate control.
+TEST_P(VP9EncoderThreadTest, LookaheadAnalysisResultTest) {
+  lookahead_analysis_ = 1;
+  CompareThreadCounts();
+}
+
+VP9_INSTANTIATE_TEST_CASE(
+    VP9EncoderThreadTest,
+    ::testing::Values(::libvpx_test::kTwoPassGood, ::libvpx_test::kOnePassGood,
+                      ::libvpx_test::kRealTime),
+    ::testing::Values(2, 5, 7));
+}  // namespace
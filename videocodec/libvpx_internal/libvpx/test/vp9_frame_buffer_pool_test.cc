@@ -0,0 +1,216 @@
+/*
+ *  Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <string.h>
+
+#include "third_party/googletest/src/include/gtest/gtest.h"
+#include "vp9/common/vp9_frame_buffers.h"
+#include "vp9/common/vp9_thread.h"
+
+namespace {
+
+const int kNumThreads = 4;
+// Each thread holds at most one buffer for decoding and kMaxDisplayed for
+// display at a time, so a get never fails if the pool does not leak.
+const int kMaxDisplayed = 2;
+const int kNumBuffers = kNumThreads * (1 + kMaxDisplayed) + 4;
+const int kIterations = 20000;
+const size_t kBufferSize = 256;
+
+struct StressThreadData {
+  VP9FrameBufferPool *pool;
+  uint8_t stamp;
+  unsigned int rnd;
+  int failed_gets;
+  int corrupted;
+  int bad_releases;
+};
+
+bool CheckStamp(const uint8_t *data, uint8_t stamp) {
+  for (size_t i = 0; i < kBufferSize; ++i) {
+    if (data[i] != stamp)
+      return false;
+  }
+  return true;
+}
+
+// Plays both a decoder and an application displaying frames: decoded buffers
+// are sometimes kept for display past their release by the decoder. Every
+// buffer is stamped while owned, so a buffer handed out twice shows up as
+// corrupted.
+int StressHook(void *arg1, void *arg2) {
+  StressThreadData *const data = reinterpret_cast<StressThreadData *>(arg1);
+  vpx_codec_frame_buffer_t displayed[kMaxDisplayed];
+  int num_displayed = 0;
+  (void)arg2;
+
+  for (int i = 0; i < kIterations; ++i) {
+    vpx_codec_frame_buffer_t fb;
+    memset(&fb, 0, sizeof(fb));
+    if (vp9_get_frame_buffer(data->pool, kBufferSize, &fb)) {
+      ++data->failed_gets;
+      continue;
+    }
+    memset(fb.data, data->stamp, kBufferSize);
+
+    data->rnd = data->rnd * 1103515245 + 12345;
+    const bool display = ((data->rnd >> 16) & 1) != 0;
+    if (display && num_displayed < kMaxDisplayed) {
+      if (vp9_frame_buffer_pool_hold(data->pool, fb.fb_index,
+                                     VP9_FB_HELD_BY_APP))
+        ++data->bad_releases;
+      displayed[num_displayed++] = fb;
+    }
+    if (!CheckStamp(fb.data, data->stamp))
+      ++data->corrupted;
+    if (vp9_release_frame_buffer(data->pool, &fb))
+      ++data->bad_releases;
+
+    if (num_displayed > 0 && ((data->rnd >> 17) & 1) != 0) {
+      const vpx_codec_frame_buffer_t *const shown = &displayed[0];
+      if (!CheckStamp(shown->data, data->stamp))
+        ++data->corrupted;
+      if (vp9_frame_buffer_pool_unhold(data->pool, shown->fb_index,
+                                       VP9_FB_HELD_BY_APP))
+        ++data->bad_releases;
+      memmove(&displayed[0], &displayed[1],
+              --num_displayed * sizeof(displayed[0]));
+    }
+  }
+
+  while (num_displayed > 0) {
+    if (vp9_frame_buffer_pool_unhold(data->pool,
+                                     displayed[--num_displayed].fb_index,
+                                     VP9_FB_HELD_BY_APP))
+      ++data->bad_releases;
+  }
+  return 1;
+}
+
+class VP9FrameBufferPoolTest : public ::testing::Test {
+ protected:
+  VP9FrameBufferPoolTest() {
+    memset(&pool_, 0, sizeof(pool_));
+  }
+
+  virtual ~VP9FrameBufferPoolTest() {
+    vp9_frame_buffer_pool_free(&pool_);
+  }
+
+  VP9FrameBufferPool pool_;
+};
+
+TEST_F(VP9FrameBufferPoolTest, HoldersAndStats) {
+  ASSERT_EQ(0, vp9_frame_buffer_pool_init(&pool_, 2, 5));
+  EXPECT_EQ(5, vp9_frame_buffer_pool_add(&pool_, NULL, 0, 0, 0));
+  EXPECT_EQ(6, vp9_frame_buffer_pool_add(&pool_, NULL, 0, 0, 0));
+  EXPECT_EQ(-1, vp9_frame_buffer_pool_add(&pool_, NULL, 0, 0, 0));
+  EXPECT_EQ(2, pool_.num_free);
+
+  const int a = vp9_frame_buffer_pool_take(&pool_, VP9_FB_HELD_BY_DECODER);
+  const int b = vp9_frame_buffer_pool_take(&pool_, VP9_FB_HELD_BY_DECODER);
+  EXPECT_NE(a, b);
+  EXPECT_EQ(-1, vp9_frame_buffer_pool_take(&pool_, VP9_FB_HELD_BY_DECODER));
+  EXPECT_EQ(1, pool_.failed_gets);
+
+  // The buffer stays in use until both holders let go.
+  EXPECT_EQ(0, vp9_frame_buffer_pool_hold(&pool_, a, VP9_FB_HELD_BY_APP));
+  EXPECT_EQ(0, vp9_frame_buffer_pool_unhold(&pool_, a,
+                                            VP9_FB_HELD_BY_DECODER));
+  EXPECT_EQ(-1, vp9_frame_buffer_pool_unhold(&pool_, a,
+                                             VP9_FB_HELD_BY_DECODER));
+  EXPECT_EQ(0, pool_.num_free);
+  EXPECT_EQ(0, vp9_frame_buffer_pool_unhold(&pool_, a, VP9_FB_HELD_BY_APP));
+  EXPECT_EQ(1, pool_.num_free);
+  EXPECT_EQ(-1, vp9_frame_buffer_pool_hold(&pool_, a, VP9_FB_HELD_BY_APP));
+
+  EXPECT_EQ(a, vp9_frame_buffer_pool_take(&pool_, VP9_FB_HELD_BY_APP));
+  EXPECT_EQ(2, pool_.in_use);
+  EXPECT_EQ(2, pool_.peak_in_use);
+}
+
+TEST_F(VP9FrameBufferPoolTest, ExternalLayout) {
+  const int kStride = 64;
+  const int kHeightStride = 32;
+  const size_t kSize = kStride * kHeightStride * 3 / 2;
+  uint8_t memory[kSize];
+
+  ASSERT_EQ(0, vp9_frame_buffer_pool_init(&pool_, 1, 0));
+  ASSERT_EQ(0, vp9_frame_buffer_pool_add(&pool_, memory, kSize, kStride,
+                                         kHeightStride));
+
+  // Application memory is not available until the application returns it.
+  vpx_codec_frame_buffer_t fb;
+  memset(&fb, 0, sizeof(fb));
+  EXPECT_EQ(-1, vp9_get_frame_buffer(&pool_, kSize, &fb));
+  EXPECT_EQ(0, vp9_frame_buffer_pool_unhold(&pool_, 0, VP9_FB_HELD_BY_APP));
+
+  // A frame wider than the memory is laid out for is refused.
+  fb.fb_stride = kStride + 32;
+  fb.fb_height_stride = kHeightStride;
+  EXPECT_EQ(-1, vp9_get_frame_buffer(&pool_, kSize, &fb));
+  EXPECT_EQ(1, pool_.num_free);
+
+  // A smaller frame is decoded with the memory's layout.
+  fb.fb_stride = kStride / 2;
+  fb.fb_height_stride = kHeightStride / 2;
+  ASSERT_EQ(0, vp9_get_frame_buffer(&pool_, kSize / 4, &fb));
+  EXPECT_EQ(memory, fb.data);
+  EXPECT_EQ(kSize, fb.size);
+  EXPECT_EQ(kStride, fb.fb_stride);
+  EXPECT_EQ(kHeightStride, fb.fb_height_stride);
+  EXPECT_EQ(0, vp9_release_frame_buffer(&pool_, &fb));
+  EXPECT_EQ(1, pool_.num_free);
+}
+
+TEST_F(VP9FrameBufferPoolTest, Stress) {
+  ASSERT_EQ(0, vp9_frame_buffer_pool_init(&pool_, kNumBuffers, 0));
+  for (int i = 0; i < kNumBuffers; ++i)
+    ASSERT_EQ(i, vp9_frame_buffer_pool_add(&pool_, NULL, 0, 0, 0));
+
+  VP9Worker workers[kNumThreads];
+  StressThreadData data[kNumThreads];
+  for (int i = 0; i < kNumThreads; ++i) {
+    memset(&data[i], 0, sizeof(data[i]));
+    data[i].pool = &pool_;
+    data[i].stamp = static_cast<uint8_t>(i + 1);
+    data[i].rnd = i;
+
+    vp9_worker_init(&workers[i]);
+    ASSERT_NE(0, vp9_worker_reset(&workers[i]));
+    workers[i].hook = StressHook;
+    workers[i].data1 = &data[i];
+    workers[i].data2 = NULL;
+  }
+  for (int i = 0; i < kNumThreads; ++i)
+    vp9_worker_launch(&workers[i]);
+  for (int i = 0; i < kNumThreads; ++i) {
+    EXPECT_NE(0, vp9_worker_sync(&workers[i]));
+    vp9_worker_end(&workers[i]);
+  }
+
+  for (int i = 0; i < kNumThreads; ++i) {
+    EXPECT_EQ(0, data[i].failed_gets) << "thread " << i;
+    EXPECT_EQ(0, data[i].corrupted) << "thread " << i;
+    EXPECT_EQ(0, data[i].bad_releases) << "thread " << i;
+  }
+  EXPECT_EQ(0, pool_.failed_gets);
+  EXPECT_EQ(0, pool_.in_use);
+  EXPECT_EQ(kNumBuffers, pool_.num_free);
+  EXPECT_GT(pool_.peak_in_use, 0);
+  EXPECT_LE(pool_.peak_in_use, kNumThreads * (1 + kMaxDisplayed));
+
+  // Every buffer is still on the free list exactly once.
+  for (int i = 0; i < kNumBuffers; ++i)
+    EXPECT_GE(vp9_frame_buffer_pool_take(&pool_, VP9_FB_HELD_BY_DECODER), 0);
+  EXPECT_EQ(-1, vp9_frame_buffer_pool_take(&pool_, VP9_FB_HELD_BY_DECODER));
+}
+
+}  // namespace
@@ -0,0 +1,286 @@
+/*
+ *  Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "third_party/googletest/src/include/gtest/gtest.h"
+#include "test/acm_random.h"
+#include "test/clear_system_state.h"
+#include "test/register_state_check.h"
+#include "test/util.h"
+#include "./vpx_config.h"
+#include "./vp9_rtcd.h"
+#include "vp9/common/vp9_quant_common.h"
+#include "vp9/common/vp9_scan.h"
+#include "vpx/vpx_integer.h"
+#include "vpx_ports/mem.h"
+
+typedef void (*quantize_fn_t)(const int16_t *coeff_ptr, intptr_t n_coeffs,
+                              int skip_block, const int16_t *zbin_ptr,
+                              const int16_t *round_ptr,
+                              const int16_t *quant_ptr,
+                              const int16_t *quant_shift_ptr,
+                              int16_t *qcoeff_ptr, int16_t *dqcoeff_ptr,
+                              const int16_t *dequant_ptr, int zbin_oq_value,
+                              uint16_t *eob_ptr, const int16_t *scan,
+                              const int16_t *iscan);
+typedef void (*fdct_quant_fn_t)(const int16_t *input, int stride,
+                                int16_t *coeff_ptr, intptr_t n_coeffs,
+                                int skip_block, const int16_t *zbin_ptr,
+                                const int16_t *round_ptr,
+                                const int16_t *quant_ptr,
+                                const int16_t *quant_shift_ptr,
+                                int16_t *qcoeff_ptr, int16_t *dqcoeff_ptr,
+                                const int16_t *dequant_ptr, int zbin_oq_value,
+                                uint16_t *eob_ptr, const int16_t *scan,
+                                const int16_t *iscan);
+typedef std::tr1::tuple<quantize_fn_t, quantize_fn_t, TX_SIZE>
+    quantize_param_t;
+
+namespace vp9 {
+
+using libvpx_test::ACMRandom;
+
+// The luma quantizer of qindex q, set up as vp9_init_quantizer() does.
+struct Quantizer {
+  explicit Quantizer(int q) {
+    const int zbin_factor = q == 0 ? 64 : (vp9_dc_quant(q, 0) < 148 ? 84 : 80);
+    const int rounding_factor = q == 0 ? 64 : 48;
+
+    for (int i = 0; i < 8; ++i) {
+      const int d = i == 0 ? vp9_dc_quant(q, 0) : vp9_ac_quant(q, 0);
+      int l = 0;
+
+      for (int t = d; t > 1; t >>= 1)
+        ++l;
+      quant[i] = static_cast<int16_t>(1 + (1 << (16 + l)) / d - (1 << 16));
+      quant_shift[i] = 1 << (16 - l);
+      zbin[i] = ROUND_POWER_OF_TWO(zbin_factor * d, 7);
+      round[i] = (rounding_factor * d) >> 7;
+      dequant[i] = d;
+    }
+  }
+
+  DECLARE_ALIGNED(16, int16_t, zbin[8]);
+  DECLARE_ALIGNED(16, int16_t, round[8]);
+  DECLARE_ALIGNED(16, int16_t, quant[8]);
+  DECLARE_ALIGNED(16, int16_t, quant_shift[8]);
+  DECLARE_ALIGNED(16, int16_t, dequant[8]);
+};
+
+// A random zbin_oq_value in the range of the zero bin adjustments of the
+// encoder, which may also shrink the zero bin.
+int RandomZbinOq(ACMRandom *rnd, const Quantizer &quantizer) {
+  return rnd->Rand8() % 2 ? 0 : rnd->Rand16() % (quantizer.dequant[1] + 1) -
+                                quantizer.dequant[1] / 2;
+}
+
+class VP9QuantizeTest : public ::testing::TestWithParam<quantize_param_t> {
+ public:
+  virtual void SetUp() {
+    // The quantizers find eob from the iscan tables this sets up.
+    vp9_init_neighbors();
+    ref_quantize_ = GET_PARAM(0);
+    quantize_ = GET_PARAM(1);
+    tx_size_ = GET_PARAM(2);
+  }
+
+  virtual void TearDown() {
+    libvpx_test::ClearSystemState();
+  }
+
+ protected:
+  // Quantizes the first n_coeffs of coeff with both versions and compares
+  // their results.
+  void CheckQuantize(const int16_t *coeff, const Quantizer &quantizer,
+                     int zbin_oq_value, int skip_block) {
+    DECLARE_ALIGNED_ARRAY(16, int16_t, ref_qcoeff, 32 * 32);
+    DECLARE_ALIGNED_ARRAY(16, int16_t, ref_dqcoeff, 32 * 32);
+    DECLARE_ALIGNED_ARRAY(16, int16_t, qcoeff, 32 * 32);
+    DECLARE_ALIGNED_ARRAY(16, int16_t, dqcoeff, 32 * 32);
+    const scan_order *const so = &vp9_default_scan_orders[tx_size_];
+    const int n_coeffs = 16 << (tx_size_ << 1);
+    uint16_t ref_eob, eob;
+
+    // Both versions must write all of their outputs.
+    for (int i = 0; i < n_coeffs; ++i)
+      qcoeff[i] = dqcoeff[i] = -1;
+    ref_eob = eob = 0xffff;
+
+    ref_quantize_(coeff, n_coeffs, skip_block, quantizer.zbin,
+                  quantizer.round, quantizer.quant, quantizer.quant_shift,
+                  ref_qcoeff, ref_dqcoeff, quantizer.dequant, zbin_oq_value,
+                  &ref_eob, so->scan, so->iscan);
+    REGISTER_STATE_CHECK(quantize_(coeff, n_coeffs, skip_block,
+                                   quantizer.zbin, quantizer.round,
+                                   quantizer.quant, quantizer.quant_shift,
+                                   qcoeff, dqcoeff, quantizer.dequant,
+                                   zbin_oq_value, &eob, so->scan, so->iscan));
+
+    ASSERT_EQ(ref_eob, eob) << "dequant " << quantizer.dequant[1];
+    for (int i = 0; i < n_coeffs; ++i) {
+      ASSERT_EQ(ref_qcoeff[i], qcoeff[i])
+          << "dequant " << quantizer.dequant[1] << " coeff " << coeff[i]
+          << " at " << i;
+      ASSERT_EQ(ref_dqcoeff[i], dqcoeff[i])
+          << "dequant " << quantizer.dequant[1] << " coeff " << coeff[i]
+          << " at " << i;
+    }
+  }
+
+  quantize_fn_t ref_quantize_;
+  quantize_fn_t quantize_;
+  TX_SIZE tx_size_;
+};
+
+TEST_P(VP9QuantizeTest, RandomCoefficients) {
+  DECLARE_ALIGNED_ARRAY(16, int16_t, coeff, 32 * 32);
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+
+  for (int q = 0; q < QINDEX_RANGE; ++q) {
+    const Quantizer quantizer(q);
+
+    for (int n = 0; n < 6; ++n) {
+      // Magnitudes around the zero bin, those of the transforms and the
+      // full range of the coefficients.
+      const int range = n < 2 ? 4 * quantizer.dequant[1] :
+                                (n < 4 ? 1 << 14 : 1 << 16);
+      for (int i = 0; i < 32 * 32; ++i)
+        coeff[i] = static_cast<int16_t>(rnd(range) - range / 2);
+      CheckQuantize(coeff, quantizer, RandomZbinOq(&rnd, quantizer), 0);
+    }
+  }
+}
+
+TEST_P(VP9QuantizeTest, ExtremeCoefficients) {
+  DECLARE_ALIGNED_ARRAY(16, int16_t, coeff, 32 * 32);
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+
+  for (int q = 0; q < QINDEX_RANGE; q += 15) {
+    const Quantizer quantizer(q);
+
+    for (int i = 0; i < 32 * 32; ++i)
+      coeff[i] = rnd.Rand8() % 2 ? INT16_MIN : INT16_MAX;
+    CheckQuantize(coeff, quantizer, 0, 0);
+  }
+}
+
+TEST_P(VP9QuantizeTest, ZeroBin) {
+  DECLARE_ALIGNED_ARRAY(16, int16_t, coeff, 32 * 32);
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  const int n_coeffs = 16 << (tx_size_ << 1);
+
+  for (int q = 1; q < QINDEX_RANGE; q += 3) {
+    const Quantizer quantizer(q);
+
+    // All of the coefficients in the zero bin, then one of them out of it.
+    for (int i = 0; i < n_coeffs; ++i)
+      coeff[i] = rnd(quantizer.zbin[1] / 2) - quantizer.zbin[1] / 4;
+    CheckQuantize(coeff, quantizer, 0, 0);
+    coeff[rnd(n_coeffs)] = quantizer.dequant[1] * 3;
+    CheckQuantize(coeff, quantizer, 0, 0);
+  }
+}
+
+TEST_P(VP9QuantizeTest, SkipBlock) {
+  DECLARE_ALIGNED_ARRAY(16, int16_t, coeff, 32 * 32);
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  const Quantizer quantizer(100);
+
+  for (int i = 0; i < 32 * 32; ++i)
+    coeff[i] = rnd.Rand16();
+  CheckQuantize(coeff, quantizer, 0, 1);
+}
+
+class VP9FdctQuantTest : public ::testing::TestWithParam<fdct_quant_fn_t> {
+ public:
+  virtual void SetUp() {
+    vp9_init_neighbors();
+  }
+
+  virtual void TearDown() {
+    libvpx_test::ClearSystemState();
+  }
+
+ protected:
+  static const int kStride = 16;
+
+  // Transforms and quantizes an 8x8 block of residuals within max_diff of 0,
+  // and compares the results with those of vp9_fdct8x8_c() and
+  // vp9_quantize_b_c().
+  void CheckFdctQuant(ACMRandom *rnd, const Quantizer &quantizer,
+                      int max_diff) {
+    DECLARE_ALIGNED_ARRAY(16, int16_t, input, 8 * kStride);
+    DECLARE_ALIGNED_ARRAY(16, int16_t, ref_coeff, 64);
+    DECLARE_ALIGNED_ARRAY(16, int16_t, ref_qcoeff, 64);
+    DECLARE_ALIGNED_ARRAY(16, int16_t, ref_dqcoeff, 64);
+    DECLARE_ALIGNED_ARRAY(16, int16_t, coeff, 64);
+    DECLARE_ALIGNED_ARRAY(16, int16_t, qcoeff, 64);
+    DECLARE_ALIGNED_ARRAY(16, int16_t, dqcoeff, 64);
+    const scan_order *const so = &vp9_default_scan_orders[TX_8X8];
+    const int zbin_oq_value = RandomZbinOq(rnd, quantizer);
+    uint16_t ref_eob, eob;
+
+    for (int i = 0; i < 8 * kStride; ++i)
+      input[i] = rnd->Rand16() % (2 * max_diff + 1) - max_diff;
+    for (int i = 0; i < 64; ++i)
+      coeff[i] = qcoeff[i] = dqcoeff[i] = -1;
+    ref_eob = eob = 0xffff;
+
+    vp9_fdct8x8_c(input, ref_coeff, kStride);
+    vp9_quantize_b_c(ref_coeff, 64, 0, quantizer.zbin, quantizer.round,
+                     quantizer.quant, quantizer.quant_shift, ref_qcoeff,
+                     ref_dqcoeff, quantizer.dequant, zbin_oq_value, &ref_eob,
+                     so->scan, so->iscan);
+    REGISTER_STATE_CHECK(GetParam()(input, kStride, coeff, 64, 0,
+                                    quantizer.zbin, quantizer.round,
+                                    quantizer.quant, quantizer.quant_shift,
+                                    qcoeff, dqcoeff, quantizer.dequant,
+                                    zbin_oq_value, &eob, so->scan, so->iscan));
+
+    ASSERT_EQ(ref_eob, eob) << "dequant " << quantizer.dequant[1];
+    for (int i = 0; i < 64; ++i) {
+      ASSERT_EQ(ref_coeff[i], coeff[i]) << "coefficient " << i;
+      ASSERT_EQ(ref_qcoeff[i], qcoeff[i])
+          << "dequant " << quantizer.dequant[1] << " coefficient " << i;
+      ASSERT_EQ(ref_dqcoeff[i], dqcoeff[i])
+          << "dequant " << quantizer.dequant[1] << " coefficient " << i;
+    }
+  }
+};
+
+TEST_P(VP9FdctQuantTest, MatchesFdctAndQuantize) {
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+
+  for (int q = 0; q < QINDEX_RANGE; ++q) {
+    const Quantizer quantizer(q);
+
+    // Large residuals, and small ones of blocks that mostly quantize to 0.
+    for (int n = 0; n < 4; ++n)
+      CheckFdctQuant(&rnd, quantizer, n < 2 ? 255 : 1 + n % 3 * 4);
+  }
+}
+
+using std::tr1::make_tuple;
+
+INSTANTIATE_TEST_CASE_P(C, VP9FdctQuantTest,
+                        ::testing::Values(&vp9_fdct8x8_quant_c));
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_CASE_P(
+    AVX2, VP9QuantizeTest,
+    ::testing::Values(
+        make_tuple(&vp9_quantize_b_c, &vp9_quantize_b_avx2, TX_4X4),
+        make_tuple(&vp9_quantize_b_c, &vp9_quantize_b_avx2, TX_8X8),
+        make_tuple(&vp9_quantize_b_c, &vp9_quantize_b_avx2, TX_16X16),
+        make_tuple(&vp9_quantize_b_32x32_c, &vp9_quantize_b_32x32_avx2,
+                   TX_32X32)));
+INSTANTIATE_TEST_CASE_P(AVX2, VP9FdctQuantTest,
+                        ::testing::Values(&vp9_fdct8x8_quant_avx2));
+#endif
+}  // namespace vp9
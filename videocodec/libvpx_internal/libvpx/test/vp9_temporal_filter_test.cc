@@ -0,0 +1,106 @@
+/*
+ *  Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "third_party/googletest/src/include/gtest/gtest.h"
+#include "test/acm_random.h"
+#include "test/clear_system_state.h"
+#include "test/register_state_check.h"
+#include "./vpx_config.h"
+#include "./vp9_rtcd.h"
+#include "vpx/vpx_integer.h"
+#include "vpx_ports/mem.h"
+
+typedef void (*temporal_filter_apply_fn_t)(uint8_t *frame1,
+                                           unsigned int stride,
+                                           uint8_t *frame2,
+                                           unsigned int block_size,
+                                           int strength, int filter_weight,
+                                           unsigned int *accumulator,
+                                           uint16_t *count);
+
+namespace vp9 {
+
+using libvpx_test::ACMRandom;
+
+class VP9TemporalFilterApplyTest
+    : public ::testing::TestWithParam<temporal_filter_apply_fn_t> {
+ public:
+  virtual void TearDown() {
+    libvpx_test::ClearSystemState();
+  }
+
+ protected:
+  static const int kStride = 48;
+
+  // Filters a block_size x block_size block of random pixels, all of them
+  // within max_diff of the predictor, into random sums.
+  void CheckFilter(ACMRandom *rnd, unsigned int block_size, int strength,
+                   int filter_weight, int max_diff) {
+    DECLARE_ALIGNED_ARRAY(16, uint8_t, frame1, 16 * kStride);
+    DECLARE_ALIGNED_ARRAY(16, uint8_t, frame2, 16 * 16);
+    DECLARE_ALIGNED_ARRAY(16, unsigned int, ref_accumulator, 16 * 16);
+    DECLARE_ALIGNED_ARRAY(16, unsigned int, accumulator, 16 * 16);
+    DECLARE_ALIGNED_ARRAY(16, uint16_t, ref_count, 16 * 16);
+    DECLARE_ALIGNED_ARRAY(16, uint16_t, count, 16 * 16);
+    const unsigned int num_pels = block_size * block_size;
+
+    for (unsigned int i = 0; i < num_pels; ++i) {
+      const int diff = rnd->Rand8() % (2 * max_diff + 1) - max_diff;
+      frame2[i] = rnd->Rand8();
+      frame1[(i / block_size) * kStride + i % block_size] =
+          static_cast<uint8_t>(clamp(frame2[i] + diff, 0, 255));
+      ref_accumulator[i] = accumulator[i] = rnd->Rand16();
+      ref_count[i] = count[i] = rnd->Rand16();
+    }
+
+    vp9_temporal_filter_apply_c(frame1, kStride, frame2, block_size, strength,
+                                filter_weight, ref_accumulator, ref_count);
+    REGISTER_STATE_CHECK(GetParam()(frame1, kStride, frame2, block_size,
+                                    strength, filter_weight, accumulator,
+                                    count));
+
+    for (unsigned int i = 0; i < num_pels; ++i) {
+      ASSERT_EQ(ref_count[i], count[i])
+          << "block_size " << block_size << " strength " << strength
+          << " pixel " << i;
+      ASSERT_EQ(ref_accumulator[i], accumulator[i])
+          << "block_size " << block_size << " strength " << strength
+          << " pixel " << i;
+    }
+  }
+
+  static int clamp(int value, int low, int high) {
+    return value < low ? low : (value > high ? high : value);
+  }
+};
+
+TEST_P(VP9TemporalFilterApplyTest, MatchesReference) {
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  static const int kMaxDiffs[] = { 4, 16, 64, 255 };
+
+  for (unsigned int block_size = 8; block_size <= 16; block_size += 8)
+    for (int strength = 1; strength <= 6; ++strength)
+      for (int filter_weight = 0; filter_weight <= 2; ++filter_weight)
+        for (int i = 0; i < 4; ++i)
+          for (int n = 0; n < 10; ++n)
+            CheckFilter(&rnd, block_size, strength, filter_weight,
+                        kMaxDiffs[i]);
+}
+
+INSTANTIATE_TEST_CASE_P(C, VP9TemporalFilterApplyTest,
+                        ::testing::Values(vp9_temporal_filter_apply_c));
+
+// The SSE2 version computes 3 * diff * diff in 16 bits, so it only matches the
+// C version for small differences and is not tested here.
+#if HAVE_AVX2
+INSTANTIATE_TEST_CASE_P(AVX2, VP9TemporalFilterApplyTest,
+                        ::testing::Values(vp9_temporal_filter_apply_avx2));
+#endif
+}  // namespace vp9
@@ -15,7 +15,7 @@
 #include "test/decode_test_driver.h"
 #include "test/md5_helper.h"
 #include "test/webm_video_source.h"
-#include "vp9/decoder/vp9_thread.h"
+#include "vp9/common/vp9_thread.h"
 
 namespace {
 
@@ -127,7 +127,7 @@ string DecodeFile(const string& filename, int num_threads) {
 }
 
 TEST(VP9DecodeMTTest, MTDecode) {
-  // no tiles or frame parallel; this exercises loop filter threading.
+  // no tiles or frame parallel; this exercises row-based threading.
   EXPECT_STREQ("b35a1b707b28e82be025d960aba039bc",
                DecodeFile("vp90-2-03-size-226x226.webm", 2).c_str());
 }
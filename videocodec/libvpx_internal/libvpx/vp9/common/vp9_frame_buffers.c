@@ -10,72 +10,245 @@
 
 #include <assert.h>
 
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
 #include "vp9/common/vp9_frame_buffers.h"
 #include "vpx_mem/vpx_mem.h"
 
-int vp9_alloc_internal_frame_buffers(InternalFrameBufferList *list) {
-  assert(list != NULL);
-  vp9_free_internal_frame_buffers(list);
+#define FREE_LIST_INDEX_MASK 0xffff
+#define FREE_LIST_TAG_INC (FREE_LIST_INDEX_MASK + 1)
 
-  list->num_internal_frame_buffers =
-      VP9_MAXIMUM_REF_BUFFERS + VPX_MAXIMUM_WORK_BUFFERS;
-  list->int_fb =
-      (InternalFrameBuffer *)vpx_calloc(list->num_internal_frame_buffers,
-                                        sizeof(*list->int_fb));
-  return (list->int_fb == NULL);
+// Compare-and-swap and add with full barriers.
+#if defined(_WIN32)
+static int cas(volatile int *ptr, int old_val, int new_val) {
+  return InterlockedCompareExchange((volatile LONG *)ptr, new_val, old_val) ==
+         old_val;
 }
 
-void vp9_free_internal_frame_buffers(InternalFrameBufferList *list) {
+static int cas_unsigned(volatile unsigned int *ptr, unsigned int old_val,
+                        unsigned int new_val) {
+  return cas((volatile int *)ptr, (int)old_val, (int)new_val);
+}
+
+static void atomic_add(volatile int *ptr, int val) {
+  InterlockedExchangeAdd((volatile LONG *)ptr, val);
+}
+#else
+static int cas(volatile int *ptr, int old_val, int new_val) {
+  return __sync_bool_compare_and_swap(ptr, old_val, new_val);
+}
+
+static int cas_unsigned(volatile unsigned int *ptr, unsigned int old_val,
+                        unsigned int new_val) {
+  return __sync_bool_compare_and_swap(ptr, old_val, new_val);
+}
+
+static void atomic_add(volatile int *ptr, int val) {
+  __sync_fetch_and_add(ptr, val);
+}
+#endif
+
+static void push_free(VP9FrameBufferPool *pool, int i) {
+  unsigned int head;
+
+  do {
+    head = pool->free_list;
+    pool->fb[i].next = head & FREE_LIST_INDEX_MASK;
+  } while (!cas_unsigned(&pool->free_list, head,
+                         ((head & ~FREE_LIST_INDEX_MASK) + FREE_LIST_TAG_INC) |
+                         (i + 1)));
+  atomic_add(&pool->num_free, 1);
+  atomic_add(&pool->in_use, -1);
+}
+
+static int pop_free(VP9FrameBufferPool *pool) {
+  unsigned int head;
+  int i, peak;
+
+  do {
+    head = pool->free_list;
+    i = (int)(head & FREE_LIST_INDEX_MASK) - 1;
+    if (i < 0)
+      return -1;
+    // The tag makes the swap fail if |i| was taken and returned meanwhile, so
+    // a stale |next| is never installed.
+  } while (!cas_unsigned(&pool->free_list, head,
+                         ((head & ~FREE_LIST_INDEX_MASK) + FREE_LIST_TAG_INC) |
+                         pool->fb[i].next));
+  atomic_add(&pool->num_free, -1);
+  atomic_add(&pool->in_use, 1);
+
+  do {
+    peak = pool->peak_in_use;
+  } while (pool->in_use > peak && !cas(&pool->peak_in_use, peak, pool->in_use));
+  return i;
+}
+
+int vp9_frame_buffer_pool_init(VP9FrameBufferPool *pool, int max_buffers,
+                               int first_index) {
+  assert(pool != NULL);
+  assert(max_buffers < FREE_LIST_INDEX_MASK);
+  vpx_memset(pool, 0, sizeof(*pool));
+
+  pool->fb = (InternalFrameBuffer *)vpx_calloc(max_buffers, sizeof(*pool->fb));
+  if (pool->fb == NULL)
+    return 1;
+  pool->max_buffers = max_buffers;
+  pool->first_index = first_index;
+  return 0;
+}
+
+void vp9_frame_buffer_pool_free(VP9FrameBufferPool *pool) {
   int i;
 
-  assert(list != NULL);
+  assert(pool != NULL);
 
-  for (i = 0; i < list->num_internal_frame_buffers; ++i) {
-    vpx_free(list->int_fb[i].data);
-    list->int_fb[i].data = NULL;
+  for (i = 0; i < pool->num_buffers; ++i) {
+    if (!pool->fb[i].external)
+      vpx_free(pool->fb[i].data);
   }
-  vpx_free(list->int_fb);
-  list->int_fb = NULL;
+  vpx_free(pool->fb);
+  vpx_memset(pool, 0, sizeof(*pool));
 }
 
-int vp9_get_frame_buffer(void *cb_priv, size_t min_size,
-                         vpx_codec_frame_buffer_t *fb) {
-  int i;
-  InternalFrameBufferList *const int_fb_list =
-      (InternalFrameBufferList *)cb_priv;
-  if (int_fb_list == NULL)
+int vp9_frame_buffer_pool_add(VP9FrameBufferPool *pool, uint8_t *data,
+                              size_t size, int stride, int height_stride) {
+  InternalFrameBuffer *fb;
+  const int i = pool->num_buffers;
+
+  if (i == pool->max_buffers)
     return -1;
 
-  // Find a free frame buffer.
-  for (i = 0; i < int_fb_list->num_internal_frame_buffers; ++i) {
-    if (!int_fb_list->int_fb[i].in_use)
-      break;
-  }
+  fb = &pool->fb[i];
+  fb->data = data;
+  fb->size = data != NULL ? size : 0;
+  fb->stride = stride;
+  fb->height_stride = height_stride;
+  fb->external = data != NULL;
+  fb->pool = pool;
+  fb->holders = VP9_FB_HELD_BY_APP;
+  atomic_add(&pool->in_use, 1);
+  atomic_add(&pool->num_buffers, 1);
+
+  if (data == NULL)
+    vp9_frame_buffer_pool_unhold(pool, pool->first_index + i,
+                                 VP9_FB_HELD_BY_APP);
+  return pool->first_index + i;
+}
 
-  if (i == int_fb_list->num_internal_frame_buffers)
+int vp9_frame_buffer_pool_take(VP9FrameBufferPool *pool, int holder) {
+  const int i = pop_free(pool);
+
+  if (i < 0) {
+    atomic_add(&pool->failed_gets, 1);
     return -1;
+  }
+  assert(pool->fb[i].holders == 0);
+  pool->fb[i].holders = holder;
+  return pool->first_index + i;
+}
+
+int vp9_frame_buffer_pool_hold(VP9FrameBufferPool *pool, int fb_index,
+                               int holder) {
+  InternalFrameBuffer *const fb = &pool->fb[fb_index - pool->first_index];
+  int holders;
+
+  do {
+    holders = fb->holders;
+    if (holders == 0)
+      return -1;
+  } while (!cas(&fb->holders, holders, holders | holder));
+  return 0;
+}
+
+int vp9_frame_buffer_pool_unhold(VP9FrameBufferPool *pool, int fb_index,
+                                 int holder) {
+  const int i = fb_index - pool->first_index;
+  InternalFrameBuffer *const fb = &pool->fb[i];
+  int holders;
 
-  if (int_fb_list->int_fb[i].size < min_size) {
-    int_fb_list->int_fb[i].data =
-        (uint8_t *)vpx_realloc(int_fb_list->int_fb[i].data, min_size);
-    if (!int_fb_list->int_fb[i].data)
+  do {
+    holders = fb->holders;
+    if (!(holders & holder))
       return -1;
+  } while (!cas(&fb->holders, holders, holders & ~holder));
+
+  if ((holders & ~holder) == 0)
+    push_free(pool, i);
+  return 0;
+}
+
+int vp9_alloc_internal_frame_buffers(InternalFrameBufferList *list) {
+  const int num_buffers = VP9_MAXIMUM_REF_BUFFERS + VPX_MAXIMUM_WORK_BUFFERS +
+                          VPX_MAXIMUM_FRAME_THREADING_BUFFERS;
+  int i;
+
+  assert(list != NULL);
+  vp9_free_internal_frame_buffers(list);
 
-    int_fb_list->int_fb[i].size = min_size;
+  if (vp9_frame_buffer_pool_init(list, num_buffers, 0))
+    return 1;
+  for (i = 0; i < num_buffers; ++i)
+    vp9_frame_buffer_pool_add(list, NULL, 0, 0, 0);
+  return 0;
+}
+
+void vp9_free_internal_frame_buffers(InternalFrameBufferList *list) {
+  vp9_frame_buffer_pool_free(list);
+}
+
+int vp9_get_frame_buffer(void *cb_priv, size_t min_size,
+                         vpx_codec_frame_buffer_t *fb) {
+  VP9FrameBufferPool *const pool = (VP9FrameBufferPool *)cb_priv;
+  InternalFrameBuffer *int_fb;
+  int fb_index;
+  if (pool == NULL)
+    return -1;
+
+  fb_index = vp9_frame_buffer_pool_take(pool, VP9_FB_HELD_BY_DECODER);
+  if (fb_index < 0)
+    return -1;
+  int_fb = &pool->fb[fb_index - pool->first_index];
+
+  if (int_fb->external) {
+    // Application memory has a fixed layout.
+    if (int_fb->size < min_size ||
+        (int_fb->stride > 0 && (int_fb->stride < fb->fb_stride ||
+                                int_fb->height_stride < fb->fb_height_stride))) {
+      vp9_frame_buffer_pool_unhold(pool, fb_index, VP9_FB_HELD_BY_DECODER);
+      atomic_add(&pool->failed_gets, 1);
+      return -1;
+    }
+  } else if (int_fb->size < min_size) {
+    uint8_t *const data = (uint8_t *)vpx_realloc(int_fb->data, min_size);
+    if (!data) {
+      vp9_frame_buffer_pool_unhold(pool, fb_index, VP9_FB_HELD_BY_DECODER);
+      return -1;
+    }
+    int_fb->data = data;
+    int_fb->size = min_size;
   }
 
-  fb->data = int_fb_list->int_fb[i].data;
-  fb->size = int_fb_list->int_fb[i].size;
-  int_fb_list->int_fb[i].in_use = 1;
+  fb->data = int_fb->data;
+  fb->size = int_fb->size;
+  if (int_fb->stride > 0) {
+    fb->fb_stride = int_fb->stride;
+    fb->fb_height_stride = int_fb->height_stride;
+  }
+  fb->fb_index = fb_index;
 
   // Set the frame buffer's private data to point at the internal frame buffer.
-  fb->priv = &int_fb_list->int_fb[i];
+  fb->priv = int_fb;
   return 0;
 }
 
 int vp9_release_frame_buffer(void *cb_priv, vpx_codec_frame_buffer_t *fb) {
   InternalFrameBuffer *const int_fb = (InternalFrameBuffer *)fb->priv;
   (void)cb_priv;
-  int_fb->in_use = 0;
-  return 0;
+  return vp9_frame_buffer_pool_unhold(int_fb->pool,
+                                      int_fb->pool->first_index +
+                                      (int)(int_fb - int_fb->pool->fb),
+                                      VP9_FB_HELD_BY_DECODER);
 }
@@ -18,25 +18,87 @@
 extern "C" {
 #endif
 
+// Holders of a pooled frame buffer. A buffer goes back to the free list when
+// its last holder drops it.
+#define VP9_FB_HELD_BY_DECODER (1 << 0)
+#define VP9_FB_HELD_BY_APP     (1 << 1)
+
+struct VP9FrameBufferPool;
+
 typedef struct InternalFrameBuffer {
   uint8_t *data;
   size_t size;
-  int in_use;
+  // Layout of application memory; 0 uses the decoder's layout.
+  int stride;
+  int height_stride;
+  // The data is owned by the application and never reallocated.
+  int external;
+  volatile int holders;
+  // Free list link, index + 1 of the next free buffer or 0.
+  volatile int next;
+  struct VP9FrameBufferPool *pool;
 } InternalFrameBuffer;
 
-typedef struct InternalFrameBufferList {
-  int num_internal_frame_buffers;
-  InternalFrameBuffer *int_fb;
-} InternalFrameBufferList;
+// A pool of frame buffers for the get and release callbacks. Free buffers are
+// kept on a lock-free list, so the callbacks take constant time and may be
+// called from any thread, e.g. while the application returns a displayed
+// buffer on another one. A buffer's fb_index is first_index plus its position
+// in the pool.
+typedef struct VP9FrameBufferPool {
+  InternalFrameBuffer *fb;
+  int max_buffers;
+  volatile int num_buffers;
+  int first_index;
+  // Index + 1 of the first free buffer in the low 16 bits, a tag against ABA
+  // in the high ones.
+  volatile unsigned int free_list;
+  // Statistics.
+  volatile int num_free;
+  volatile int in_use;
+  volatile int peak_in_use;
+  volatile int failed_gets;
+} VP9FrameBufferPool;
+
+typedef VP9FrameBufferPool InternalFrameBufferList;
+
+// Initializes |pool| to hold up to |max_buffers| buffers. Returns 0 on
+// success.
+int vp9_frame_buffer_pool_init(VP9FrameBufferPool *pool, int max_buffers,
+                               int first_index);
+
+// Frees the pool and the data of the buffers it allocated.
+void vp9_frame_buffer_pool_free(VP9FrameBufferPool *pool);
+
+// Adds a buffer to |pool| and returns its fb_index, or -1 if the pool is full.
+// With |data| NULL the pool allocates the buffer when it is first used, and
+// the buffer starts out free. Otherwise |data| is application memory of
+// |size| bytes laid out with |stride| and |height_stride| (0 for the
+// decoder's layout); the buffer starts out held by the application.
+// Buffers must not be added concurrently with each other.
+int vp9_frame_buffer_pool_add(VP9FrameBufferPool *pool, uint8_t *data,
+                              size_t size, int stride, int height_stride);
+
+// Takes a free buffer for |holder| and returns its fb_index, or -1 if there
+// is none.
+int vp9_frame_buffer_pool_take(VP9FrameBufferPool *pool, int holder);
+
+// Adds |holder| to a buffer that is in use. Returns -1 if the buffer is free.
+int vp9_frame_buffer_pool_hold(VP9FrameBufferPool *pool, int fb_index,
+                               int holder);
+
+// Removes |holder| from a buffer, which becomes free if it has no holder left.
+// Returns -1 if |holder| did not hold the buffer.
+int vp9_frame_buffer_pool_unhold(VP9FrameBufferPool *pool, int fb_index,
+                                 int holder);
 
-// Initializes |list|. Returns 0 on success.
+// Initializes the decoder's own frame buffers. Returns 0 on success.
 int vp9_alloc_internal_frame_buffers(InternalFrameBufferList *list);
 
 // Free any data allocated to the frame buffers.
 void vp9_free_internal_frame_buffers(InternalFrameBufferList *list);
 
 // Callback used by libvpx to request an external frame buffer. |cb_priv|
-// Callback private data, which points to an InternalFrameBufferList.
+// Callback private data, which points to a VP9FrameBufferPool.
 // |min_size| is the minimum size in bytes needed to decode the next frame.
 // |fb| pointer to the frame buffer.
 int vp9_get_frame_buffer(void *cb_priv, size_t min_size,
@@ -140,6 +140,13 @@ void vp9_idct4x4_16_add_c(const int16_t *input, uint8_t *dest, int stride) {
   }
 }
 
+void vp9_idct4x4_16_add_x4_c(int16_t *const *input, uint8_t *const *dest,
+                             int stride) {
+  int i;
+  for (i = 0; i < 4; ++i)
+    vp9_idct4x4_16_add_c(input[i], dest[i], stride);
+}
+
 void vp9_idct4x4_1_add_c(const int16_t *input, uint8_t *dest, int dest_stride) {
   int i;
   int a1;
@@ -1191,36 +1191,39 @@ void vp9_filter_block_plane(VP9_COMMON *const cm,
   }
 }
 
-void vp9_loop_filter_rows(const YV12_BUFFER_CONFIG *frame_buffer,
-                          VP9_COMMON *cm, MACROBLOCKD *xd,
-                          int start, int stop, int y_only) {
+void vp9_loop_filter_sb(const YV12_BUFFER_CONFIG *frame_buffer,
+                        VP9_COMMON *cm, MACROBLOCKD *xd,
+                        int mi_row, int mi_col, int y_only) {
   const int num_planes = y_only ? 1 : MAX_MB_PLANE;
-  int mi_row, mi_col;
+  MODE_INFO **mi_8x8 = cm->mi_grid_visible + mi_row * cm->mi_stride + mi_col;
   LOOP_FILTER_MASK lfm;
   int use_420 = y_only || (xd->plane[1].subsampling_y == 1 &&
       xd->plane[1].subsampling_x == 1);
+  int plane;
 
-  for (mi_row = start; mi_row < stop; mi_row += MI_BLOCK_SIZE) {
-    MODE_INFO **mi_8x8 = cm->mi_grid_visible + mi_row * cm->mi_stride;
+  vp9_setup_dst_planes(xd, frame_buffer, mi_row, mi_col);
 
-    for (mi_col = 0; mi_col < cm->mi_cols; mi_col += MI_BLOCK_SIZE) {
-      int plane;
+  // TODO(JBB): Make setup_mask work for non 420.
+  if (use_420)
+    vp9_setup_mask(cm, mi_row, mi_col, mi_8x8, cm->mi_stride, &lfm);
 
-      vp9_setup_dst_planes(xd, frame_buffer, mi_row, mi_col);
+  for (plane = 0; plane < num_planes; ++plane) {
+    if (use_420)
+      vp9_filter_block_plane(cm, &xd->plane[plane], mi_row, &lfm);
+    else
+      filter_block_plane_non420(cm, &xd->plane[plane], mi_8x8,
+                                mi_row, mi_col);
+  }
+}
 
-      // TODO(JBB): Make setup_mask work for non 420.
-      if (use_420)
-        vp9_setup_mask(cm, mi_row, mi_col, mi_8x8 + mi_col, cm->mi_stride,
-                       &lfm);
+void vp9_loop_filter_rows(const YV12_BUFFER_CONFIG *frame_buffer,
+                          VP9_COMMON *cm, MACROBLOCKD *xd,
+                          int start, int stop, int y_only) {
+  int mi_row, mi_col;
 
-      for (plane = 0; plane < num_planes; ++plane) {
-        if (use_420)
-          vp9_filter_block_plane(cm, &xd->plane[plane], mi_row, &lfm);
-        else
-          filter_block_plane_non420(cm, &xd->plane[plane], mi_8x8 + mi_col,
-                                    mi_row, mi_col);
-      }
-    }
+  for (mi_row = start; mi_row < stop; mi_row += MI_BLOCK_SIZE) {
+    for (mi_col = 0; mi_col < cm->mi_cols; mi_col += MI_BLOCK_SIZE)
+      vp9_loop_filter_sb(frame_buffer, cm, xd, mi_row, mi_col, y_only);
   }
 }
 
@@ -109,6 +109,13 @@ void vp9_loop_filter_frame(struct VP9Common *cm,
                            int filter_level,
                            int y_only, int partial_frame);
 
+// Apply the loop filter to the 64x64 superblock at (mi_row, mi_col) in
+// frame_buffer. The superblocks to the left of, above and above-right of it
+// have to be filtered before.
+void vp9_loop_filter_sb(const YV12_BUFFER_CONFIG *frame_buffer,
+                        struct VP9Common *cm, struct macroblockd *xd,
+                        int mi_row, int mi_col, int y_only);
+
 // Apply the loop filter to [start, stop) macro block rows in frame_buffer.
 void vp9_loop_filter_rows(const YV12_BUFFER_CONFIG *frame_buffer,
                           struct VP9Common *cm, struct macroblockd *xd,
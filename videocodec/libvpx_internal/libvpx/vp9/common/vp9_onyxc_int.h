@@ -38,7 +38,11 @@ extern "C" {
 // 1 scratch frame for the new frame, 3 for scaled references on the encoder
 // TODO(jkoleszar): These 3 extra references could probably come from the
 // normal reference pool.
-#define FRAME_BUFFERS (REF_FRAMES + 4)
+#define ENC_FRAME_BUFFERS (REF_FRAMES + 4)
+
+// The decoder allocates its buffers on demand; the extra entries are only
+// used when decoding with frame-based threading.
+#define FRAME_BUFFERS (ENC_FRAME_BUFFERS + VPX_MAXIMUM_FRAME_THREADING_BUFFERS)
 
 #define FRAME_CONTEXTS_LOG2 2
 #define FRAME_CONTEXTS (1 << FRAME_CONTEXTS_LOG2)
@@ -14,8 +14,8 @@
 //  100644 blob 13a61a4c84194c3374080cbf03d881d3cd6af40d  src/utils/thread.h
 
 
-#ifndef VP9_DECODER_VP9_THREAD_H_
-#define VP9_DECODER_VP9_THREAD_H_
+#ifndef VP9_COMMON_VP9_THREAD_H_
+#define VP9_COMMON_VP9_THREAD_H_
 
 #include "./vpx_config.h"
 
@@ -204,4 +204,4 @@ void vp9_worker_end(VP9Worker* const worker);
 }    // extern "C"
 #endif
 
-#endif  // VP9_DECODER_VP9_THREAD_H_
+#endif  // VP9_COMMON_VP9_THREAD_H_
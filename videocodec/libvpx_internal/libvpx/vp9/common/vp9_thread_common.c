@@ -0,0 +1,306 @@
+/*
+ *  Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "./vpx_config.h"
+
+#include "vpx_mem/vpx_mem.h"
+
+#include "vp9/common/vp9_onyxc_int.h"
+#include "vp9/common/vp9_thread_common.h"
+
+// A worker lent to the loopfilter: its row data, and the data it is handed
+// back with.
+struct VP9LfWorker {
+  LFWorkerData lf_data;
+  VP9WorkerHook hook;
+  void *data1;
+  void *data2;
+};
+
+#if CONFIG_MULTITHREAD
+void vp9_mutex_lock(pthread_mutex_t *const mutex) {
+  const int kMaxTryLocks = 4000;
+  int locked = 0;
+  int i;
+
+  for (i = 0; i < kMaxTryLocks; ++i) {
+    if (!pthread_mutex_trylock(mutex)) {
+      locked = 1;
+      break;
+    }
+  }
+
+  if (!locked)
+    pthread_mutex_lock(mutex);
+}
+#endif  // CONFIG_MULTITHREAD
+
+static INLINE void sync_read(VP9LfSync *const lf_sync, int r, int c) {
+#if CONFIG_MULTITHREAD
+  const int nsync = lf_sync->sync_range;
+
+  if (r && !(c & (nsync - 1))) {
+    vp9_mutex_lock(&lf_sync->mutex_[r - 1]);
+
+    while (c > lf_sync->cur_sb_col[r - 1] - nsync) {
+      pthread_cond_wait(&lf_sync->cond_[r - 1],
+                        &lf_sync->mutex_[r - 1]);
+    }
+    pthread_mutex_unlock(&lf_sync->mutex_[r - 1]);
+  }
+#else
+  (void)lf_sync;
+  (void)r;
+  (void)c;
+#endif  // CONFIG_MULTITHREAD
+}
+
+static INLINE void sync_write(VP9LfSync *const lf_sync, int r, int c,
+                              const int sb_cols) {
+#if CONFIG_MULTITHREAD
+  const int nsync = lf_sync->sync_range;
+  int cur;
+  // Only signal when there are enough filtered SB for next row to run.
+  int sig = 1;
+
+  if (c < sb_cols - 1) {
+    cur = c;
+    if (c % nsync)
+      sig = 0;
+  } else {
+    cur = sb_cols + nsync;
+  }
+
+  if (sig) {
+    vp9_mutex_lock(&lf_sync->mutex_[r]);
+
+    lf_sync->cur_sb_col[r] = cur;
+
+    // The row decoder may have both the next row and the parser waiting.
+    pthread_cond_broadcast(&lf_sync->cond_[r]);
+    pthread_mutex_unlock(&lf_sync->mutex_[r]);
+  }
+#else
+  (void)lf_sync;
+  (void)r;
+  (void)c;
+  (void)sb_cols;
+#endif  // CONFIG_MULTITHREAD
+}
+
+void vp9_row_sync_read(VP9LfSync *const lf_sync, int r, int c) {
+  sync_read(lf_sync, r, c);
+}
+
+void vp9_row_sync_write(VP9LfSync *const lf_sync, int r, int c, int sb_cols) {
+  sync_write(lf_sync, r, c, sb_cols);
+}
+
+void vp9_row_sync_wait_row(VP9LfSync *const lf_sync, int r, int sb_cols) {
+#if CONFIG_MULTITHREAD
+  vp9_mutex_lock(&lf_sync->mutex_[r]);
+  while (lf_sync->cur_sb_col[r] < sb_cols)
+    pthread_cond_wait(&lf_sync->cond_[r], &lf_sync->mutex_[r]);
+  pthread_mutex_unlock(&lf_sync->mutex_[r]);
+#else
+  (void)lf_sync;
+  (void)r;
+  (void)sb_cols;
+#endif  // CONFIG_MULTITHREAD
+}
+
+// Implement row loopfiltering for each thread.
+static void loop_filter_rows_mt(const YV12_BUFFER_CONFIG *const frame_buffer,
+                                VP9_COMMON *const cm, MACROBLOCKD *const xd,
+                                int start, int stop, int y_only,
+                                VP9LfSync *const lf_sync, int num_lf_workers) {
+  int r, c;  // SB row and col
+  const int sb_cols = mi_cols_aligned_to_sb(cm->mi_cols) >> MI_BLOCK_SIZE_LOG2;
+
+  for (r = start; r < stop; r += num_lf_workers) {
+    const int mi_row = r << MI_BLOCK_SIZE_LOG2;
+
+    for (c = 0; c < sb_cols; ++c) {
+      sync_read(lf_sync, r, c);
+      vp9_loop_filter_sb(frame_buffer, cm, xd, mi_row, c << MI_BLOCK_SIZE_LOG2,
+                         y_only);
+      sync_write(lf_sync, r, c, sb_cols);
+    }
+  }
+}
+
+// Row-based multi-threaded loopfilter hook
+static int loop_filter_row_worker(struct VP9LfWorker *const lf_worker,
+                                  void *unused) {
+  LFWorkerData *const lf_data = &lf_worker->lf_data;
+  (void)unused;
+
+  loop_filter_rows_mt(lf_data->frame_buffer, lf_data->cm, &lf_data->xd,
+                      lf_data->start, lf_data->stop, lf_data->y_only,
+                      lf_data->lf_sync, lf_data->num_lf_workers);
+  return 1;
+}
+
+void vp9_loop_filter_frame_mt(const YV12_BUFFER_CONFIG *frame,
+                              VP9_COMMON *cm,
+                              MACROBLOCKD *xd,
+                              int frame_filter_level,
+                              int y_only, int partial_frame,
+                              VP9Worker *workers, int num_workers,
+                              VP9LfSync *lf_sync) {
+  // Number of superblock rows and cols
+  const int sb_rows = mi_cols_aligned_to_sb(cm->mi_rows) >> MI_BLOCK_SIZE_LOG2;
+  const int sb_cols = mi_cols_aligned_to_sb(cm->mi_cols) >> MI_BLOCK_SIZE_LOG2;
+  int start_mi_row = 0;
+  int end_mi_row = cm->mi_rows;
+  int start_sb_row, end_sb_row;
+  int i;
+
+  if (!frame_filter_level) return;
+
+  // The same rows as vp9_loop_filter_frame().
+  if (partial_frame && cm->mi_rows > 8) {
+    start_mi_row = (cm->mi_rows >> 1) & 0xfffffff8;
+    end_mi_row = start_mi_row + MAX(cm->mi_rows / 8, 8);
+  }
+  start_sb_row = start_mi_row >> MI_BLOCK_SIZE_LOG2;
+  end_sb_row = MIN((end_mi_row + MI_BLOCK_SIZE - 1) >> MI_BLOCK_SIZE_LOG2,
+                   sb_rows);
+
+  if (lf_sync->rows != sb_rows || lf_sync->num_lf_workers < num_workers) {
+    vp9_loop_filter_dealloc(lf_sync);
+    vp9_loop_filter_alloc(cm, lf_sync, sb_rows, cm->width);
+    CHECK_MEM_ERROR(cm, lf_sync->lf_workers,
+                    vpx_malloc(num_workers * sizeof(*lf_sync->lf_workers)));
+    lf_sync->num_lf_workers = num_workers;
+  }
+
+  vp9_loop_filter_frame_init(cm, frame_filter_level);
+
+  // Initialize cur_sb_col to -1 for the SB rows to filter. The rows above
+  // them are not waited for.
+  for (i = 0; i < sb_rows; ++i)
+    lf_sync->cur_sb_col[i] = i < start_sb_row ? sb_cols + lf_sync->sync_range
+                                              : -1;
+
+  // Set up loopfilter thread data.
+  for (i = 0; i < num_workers; ++i) {
+    VP9Worker *const worker = &workers[i];
+    struct VP9LfWorker *const lf_worker = &lf_sync->lf_workers[i];
+    LFWorkerData *const lf_data = &lf_worker->lf_data;
+
+    lf_worker->hook = worker->hook;
+    lf_worker->data1 = worker->data1;
+    lf_worker->data2 = worker->data2;
+    worker->hook = (VP9WorkerHook)loop_filter_row_worker;
+    worker->data1 = lf_worker;
+    worker->data2 = NULL;
+
+    // Loopfilter data
+    lf_data->frame_buffer = frame;
+    lf_data->cm = cm;
+    lf_data->xd = *xd;
+    lf_data->start = start_sb_row + i;
+    lf_data->stop = end_sb_row;
+    lf_data->y_only = y_only;
+
+    lf_data->lf_sync = lf_sync;
+    lf_data->num_lf_workers = num_workers;
+
+    // Start loopfiltering
+    if (i == num_workers - 1) {
+      vp9_worker_execute(worker);
+    } else {
+      vp9_worker_launch(worker);
+    }
+  }
+
+  // Wait till all rows are finished, and hand the workers back.
+  for (i = 0; i < num_workers; ++i) {
+    VP9Worker *const worker = &workers[i];
+    const struct VP9LfWorker *const lf_worker = &lf_sync->lf_workers[i];
+
+    vp9_worker_sync(worker);
+    worker->hook = lf_worker->hook;
+    worker->data1 = lf_worker->data1;
+    worker->data2 = lf_worker->data2;
+  }
+}
+
+// Set up nsync by width.
+static int get_sync_range(int width) {
+  // nsync numbers are picked by testing. For example, for 4k
+  // video, using 4 gives best performance.
+  if (width < 640)
+    return 1;
+  else if (width <= 1280)
+    return 2;
+  else if (width <= 4096)
+    return 4;
+  else
+    return 8;
+}
+
+// Allocate memory for lf row synchronization
+void vp9_loop_filter_alloc(VP9_COMMON *cm, VP9LfSync *lf_sync, int rows,
+                           int width) {
+  lf_sync->rows = rows;
+#if CONFIG_MULTITHREAD
+  {
+    int i;
+
+    CHECK_MEM_ERROR(cm, lf_sync->mutex_,
+                    vpx_malloc(sizeof(*lf_sync->mutex_) * rows));
+    for (i = 0; i < rows; ++i) {
+      pthread_mutex_init(&lf_sync->mutex_[i], NULL);
+    }
+
+    CHECK_MEM_ERROR(cm, lf_sync->cond_,
+                    vpx_malloc(sizeof(*lf_sync->cond_) * rows));
+    for (i = 0; i < rows; ++i) {
+      pthread_cond_init(&lf_sync->cond_[i], NULL);
+    }
+  }
+#endif  // CONFIG_MULTITHREAD
+
+  CHECK_MEM_ERROR(cm, lf_sync->cur_sb_col,
+                  vpx_malloc(sizeof(*lf_sync->cur_sb_col) * rows));
+
+  // Set up nsync.
+  lf_sync->sync_range = get_sync_range(width);
+}
+
+// Deallocate lf synchronization related mutex and data
+void vp9_loop_filter_dealloc(VP9LfSync *lf_sync) {
+  if (lf_sync != NULL) {
+#if CONFIG_MULTITHREAD
+    int i;
+
+    if (lf_sync->mutex_ != NULL) {
+      for (i = 0; i < lf_sync->rows; ++i) {
+        pthread_mutex_destroy(&lf_sync->mutex_[i]);
+      }
+      vpx_free(lf_sync->mutex_);
+    }
+    if (lf_sync->cond_ != NULL) {
+      for (i = 0; i < lf_sync->rows; ++i) {
+        pthread_cond_destroy(&lf_sync->cond_[i]);
+      }
+      vpx_free(lf_sync->cond_);
+    }
+#endif  // CONFIG_MULTITHREAD
+
+    vpx_free(lf_sync->cur_sb_col);
+    vpx_free(lf_sync->lf_workers);
+    // clear the structure as the source of this call may be a resize in which
+    // case this call will be followed by an _alloc() which may fail.
+    vpx_memset(lf_sync, 0, sizeof(*lf_sync));
+  }
+}
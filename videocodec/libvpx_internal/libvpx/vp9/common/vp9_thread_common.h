@@ -0,0 +1,83 @@
+/*
+ *  Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef VP9_COMMON_VP9_THREAD_COMMON_H_
+#define VP9_COMMON_VP9_THREAD_COMMON_H_
+
+#include "./vpx_config.h"
+#include "vp9/common/vp9_loopfilter.h"
+#include "vp9/common/vp9_thread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct macroblockd;
+struct VP9Common;
+struct VP9LfWorker;
+
+// Loopfilter row synchronization
+typedef struct VP9LfSyncData {
+#if CONFIG_MULTITHREAD
+  pthread_mutex_t *mutex_;
+  pthread_cond_t *cond_;
+#endif
+  // Allocate memory to store the loop-filtered superblock index in each row.
+  int *cur_sb_col;
+  // The optimal sync_range for different resolution and platform should be
+  // determined by testing. Currently, it is chosen to be a power-of-2 number.
+  int sync_range;
+  int rows;
+
+  // Row data of the workers lent to vp9_loop_filter_frame_mt(), and the data
+  // they are handed back with.
+  struct VP9LfWorker *lf_workers;
+  int num_lf_workers;
+} VP9LfSync;
+
+// Allocate memory for loopfilter row synchronization.
+void vp9_loop_filter_alloc(struct VP9Common *cm, VP9LfSync *lf_sync,
+                           int rows, int width);
+
+// Deallocate loopfilter synchronization related mutex and data.
+void vp9_loop_filter_dealloc(VP9LfSync *lf_sync);
+
+// Row based multi-threaded loopfilter of frame with the given workers, the
+// last one of which runs on the calling thread. The hook and data of the
+// workers are restored once the frame is done. lf_sync is (re)allocated for
+// the frame size as needed. The result is identical to vp9_loop_filter_frame()
+// on frame.
+void vp9_loop_filter_frame_mt(const YV12_BUFFER_CONFIG *frame,
+                              struct VP9Common *cm,
+                              struct macroblockd *xd,
+                              int frame_filter_level,
+                              int y_only, int partial_frame,
+                              VP9Worker *workers, int num_workers,
+                              VP9LfSync *lf_sync);
+
+// Row synchronization shared by the loopfilter and the row-based
+// multi-threaded decoder: blocks until superblock c of row r - 1 is done, and
+// marks superblock c of row r as done.
+void vp9_row_sync_read(VP9LfSync *const lf_sync, int r, int c);
+void vp9_row_sync_write(VP9LfSync *const lf_sync, int r, int c, int sb_cols);
+
+// Blocks until all superblocks of row r are done.
+void vp9_row_sync_wait_row(VP9LfSync *const lf_sync, int r, int sb_cols);
+
+#if CONFIG_MULTITHREAD
+// Locks mutex, spinning on it for a while before blocking.
+void vp9_mutex_lock(pthread_mutex_t *const mutex);
+#endif
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // VP9_COMMON_VP9_THREAD_COMMON_H_
@@ -0,0 +1,744 @@
+/*
+ *  Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <immintrin.h>  // AVX2
+#include "./vpx_config.h"
+#include "vpx/vpx_integer.h"
+#include "vpx_ports/mem.h"
+#include "vp9/common/vp9_common.h"
+#include "vp9/common/vp9_idct.h"
+
+// Each register holds one coefficient of 16 rows or columns, so the 1-D
+// transforms below follow the C code of vp9_idct.c stage by stage.
+
+#define pair256_set_epi16(a, b) \
+  _mm256_set_epi16(b, a, b, a, b, a, b, a, b, a, b, a, b, a, b, a)
+
+typedef void (*transform_1d_avx2)(const __m256i *in, __m256i *out);
+
+static INLINE __m256i round_shift_pack(__m256i lo, __m256i hi) {
+  const __m256i rounding = _mm256_set1_epi32(DCT_CONST_ROUNDING);
+  lo = _mm256_srai_epi32(_mm256_add_epi32(lo, rounding), DCT_CONST_BITS);
+  hi = _mm256_srai_epi32(_mm256_add_epi32(hi, rounding), DCT_CONST_BITS);
+  return _mm256_packs_epi32(lo, hi);
+}
+
+// x * c0 + y * c1 in 32 bits, with k = pair256_set_epi16(c0, c1).
+static INLINE void mult_add(__m256i x, __m256i y, __m256i k,
+                            __m256i *lo, __m256i *hi) {
+  *lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(x, y), k);
+  *hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(x, y), k);
+}
+
+// dct_const_round_shift(x * c0 + y * c1)
+static INLINE __m256i mult_round(__m256i x, __m256i y, __m256i k) {
+  __m256i lo, hi;
+  mult_add(x, y, k, &lo, &hi);
+  return round_shift_pack(lo, hi);
+}
+
+// dct_const_round_shift(x * c), exact as 2 * c fits in 16 bits.
+static INLINE __m256i mult_round_1(__m256i x, int c) {
+  return _mm256_mulhrs_epi16(x, _mm256_set1_epi16(2 * c));
+}
+
+static INLINE void butterfly(__m256i x, __m256i y, __m256i k0, __m256i k1,
+                             __m256i *out0, __m256i *out1) {
+  const __m256i lo = _mm256_unpacklo_epi16(x, y);
+  const __m256i hi = _mm256_unpackhi_epi16(x, y);
+  *out0 = round_shift_pack(_mm256_madd_epi16(lo, k0),
+                           _mm256_madd_epi16(hi, k0));
+  *out1 = round_shift_pack(_mm256_madd_epi16(lo, k1),
+                           _mm256_madd_epi16(hi, k1));
+}
+
+// Transposes the 8x8 blocks in each 128-bit lane of in[0..7].
+static INLINE void transpose_8x8_lanes(const __m256i *in, __m256i *out) {
+  const __m256i a0 = _mm256_unpacklo_epi16(in[0], in[1]);
+  const __m256i a1 = _mm256_unpacklo_epi16(in[2], in[3]);
+  const __m256i a2 = _mm256_unpacklo_epi16(in[4], in[5]);
+  const __m256i a3 = _mm256_unpacklo_epi16(in[6], in[7]);
+  const __m256i a4 = _mm256_unpackhi_epi16(in[0], in[1]);
+  const __m256i a5 = _mm256_unpackhi_epi16(in[2], in[3]);
+  const __m256i a6 = _mm256_unpackhi_epi16(in[4], in[5]);
+  const __m256i a7 = _mm256_unpackhi_epi16(in[6], in[7]);
+  const __m256i b0 = _mm256_unpacklo_epi32(a0, a1);
+  const __m256i b1 = _mm256_unpacklo_epi32(a2, a3);
+  const __m256i b2 = _mm256_unpacklo_epi32(a4, a5);
+  const __m256i b3 = _mm256_unpacklo_epi32(a6, a7);
+  const __m256i b4 = _mm256_unpackhi_epi32(a0, a1);
+  const __m256i b5 = _mm256_unpackhi_epi32(a2, a3);
+  const __m256i b6 = _mm256_unpackhi_epi32(a4, a5);
+  const __m256i b7 = _mm256_unpackhi_epi32(a6, a7);
+  out[0] = _mm256_unpacklo_epi64(b0, b1);
+  out[1] = _mm256_unpackhi_epi64(b0, b1);
+  out[2] = _mm256_unpacklo_epi64(b4, b5);
+  out[3] = _mm256_unpackhi_epi64(b4, b5);
+  out[4] = _mm256_unpacklo_epi64(b2, b3);
+  out[5] = _mm256_unpackhi_epi64(b2, b3);
+  out[6] = _mm256_unpacklo_epi64(b6, b7);
+  out[7] = _mm256_unpackhi_epi64(b6, b7);
+}
+
+static INLINE void transpose_16x16(const __m256i *in, __m256i *out) {
+  __m256i t[16];
+  int i;
+  transpose_8x8_lanes(in, t);
+  transpose_8x8_lanes(in + 8, t + 8);
+  for (i = 0; i < 8; ++i) {
+    out[i] = _mm256_permute2x128_si256(t[i], t[i + 8], 0x20);
+    out[i + 8] = _mm256_permute2x128_si256(t[i], t[i + 8], 0x31);
+  }
+}
+
+static INLINE void load_rows_16(const int16_t *input, int stride, int rows,
+                                __m256i *out) {
+  int i;
+  for (i = 0; i < rows; ++i)
+    out[i] = _mm256_loadu_si256((const __m256i *)(input + i * stride));
+  for (; i < 16; ++i)
+    out[i] = _mm256_setzero_si256();
+}
+
+// Final round and shift, reconstruction and store of 16 pixels.
+static INLINE void recon_and_store_16(uint8_t *dest, __m256i in) {
+  const __m256i final_rounding = _mm256_set1_epi16(1 << 5);
+  __m256i d = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)dest));
+  in = _mm256_srai_epi16(_mm256_adds_epi16(in, final_rounding), 6);
+  d = _mm256_packus_epi16(_mm256_add_epi16(d, in), d);
+  d = _mm256_permute4x64_epi64(d, 0xd8);
+  _mm_storeu_si128((__m128i *)dest, _mm256_castsi256_si128(d));
+}
+
+// Stages 5 to 7 of the 16-point idct, from the stage 4 output in step2.
+static INLINE void idct16_stages_5_7(const __m256i *step2_in, __m256i *out) {
+  const __m256i k__cospi_p16_p16 = pair256_set_epi16(cospi_16_64, cospi_16_64);
+  const __m256i k__cospi_m16_p16 = pair256_set_epi16(-cospi_16_64,
+                                                     cospi_16_64);
+  __m256i step1[16], step2[16];
+  int i;
+
+  for (i = 0; i < 16; ++i)
+    step2[i] = step2_in[i];
+
+  // stage 5
+  step1[0] = _mm256_add_epi16(step2[0], step2[3]);
+  step1[1] = _mm256_add_epi16(step2[1], step2[2]);
+  step1[2] = _mm256_sub_epi16(step2[1], step2[2]);
+  step1[3] = _mm256_sub_epi16(step2[0], step2[3]);
+  step1[4] = step2[4];
+  butterfly(step2[5], step2[6], k__cospi_m16_p16, k__cospi_p16_p16,
+            &step1[5], &step1[6]);
+  step1[7] = step2[7];
+  step1[8] = _mm256_add_epi16(step2[8], step2[11]);
+  step1[9] = _mm256_add_epi16(step2[9], step2[10]);
+  step1[10] = _mm256_sub_epi16(step2[9], step2[10]);
+  step1[11] = _mm256_sub_epi16(step2[8], step2[11]);
+  step1[12] = _mm256_sub_epi16(step2[15], step2[12]);
+  step1[13] = _mm256_sub_epi16(step2[14], step2[13]);
+  step1[14] = _mm256_add_epi16(step2[13], step2[14]);
+  step1[15] = _mm256_add_epi16(step2[12], step2[15]);
+
+  // stage 6
+  for (i = 0; i < 4; ++i) {
+    step2[i] = _mm256_add_epi16(step1[i], step1[7 - i]);
+    step2[7 - i] = _mm256_sub_epi16(step1[i], step1[7 - i]);
+  }
+  step2[8] = step1[8];
+  step2[9] = step1[9];
+  butterfly(step1[10], step1[13], k__cospi_m16_p16, k__cospi_p16_p16,
+            &step2[10], &step2[13]);
+  butterfly(step1[11], step1[12], k__cospi_m16_p16, k__cospi_p16_p16,
+            &step2[11], &step2[12]);
+  step2[14] = step1[14];
+  step2[15] = step1[15];
+
+  // stage 7
+  for (i = 0; i < 8; ++i) {
+    out[i] = _mm256_add_epi16(step2[i], step2[15 - i]);
+    out[15 - i] = _mm256_sub_epi16(step2[i], step2[15 - i]);
+  }
+}
+
+static void idct16_avx2(const __m256i *in, __m256i *out) {
+  const __m256i k__cospi_p30_m02 = pair256_set_epi16(cospi_30_64, -cospi_2_64);
+  const __m256i k__cospi_p02_p30 = pair256_set_epi16(cospi_2_64, cospi_30_64);
+  const __m256i k__cospi_p14_m18 = pair256_set_epi16(cospi_14_64,
+                                                     -cospi_18_64);
+  const __m256i k__cospi_p18_p14 = pair256_set_epi16(cospi_18_64, cospi_14_64);
+  const __m256i k__cospi_p22_m10 = pair256_set_epi16(cospi_22_64,
+                                                     -cospi_10_64);
+  const __m256i k__cospi_p10_p22 = pair256_set_epi16(cospi_10_64, cospi_22_64);
+  const __m256i k__cospi_p06_m26 = pair256_set_epi16(cospi_6_64, -cospi_26_64);
+  const __m256i k__cospi_p26_p06 = pair256_set_epi16(cospi_26_64, cospi_6_64);
+  const __m256i k__cospi_p28_m04 = pair256_set_epi16(cospi_28_64, -cospi_4_64);
+  const __m256i k__cospi_p04_p28 = pair256_set_epi16(cospi_4_64, cospi_28_64);
+  const __m256i k__cospi_p12_m20 = pair256_set_epi16(cospi_12_64,
+                                                     -cospi_20_64);
+  const __m256i k__cospi_p20_p12 = pair256_set_epi16(cospi_20_64, cospi_12_64);
+  const __m256i k__cospi_p16_p16 = pair256_set_epi16(cospi_16_64, cospi_16_64);
+  const __m256i k__cospi_p16_m16 = pair256_set_epi16(cospi_16_64,
+                                                     -cospi_16_64);
+  const __m256i k__cospi_p24_m08 = pair256_set_epi16(cospi_24_64, -cospi_8_64);
+  const __m256i k__cospi_p08_p24 = pair256_set_epi16(cospi_8_64, cospi_24_64);
+  const __m256i k__cospi_m08_p24 = pair256_set_epi16(-cospi_8_64, cospi_24_64);
+  const __m256i k__cospi_p24_p08 = pair256_set_epi16(cospi_24_64, cospi_8_64);
+  const __m256i k__cospi_m24_m08 = pair256_set_epi16(-cospi_24_64,
+                                                     -cospi_8_64);
+  __m256i step1[16], step2[16];
+  int i;
+
+  // stage 1
+  step1[0] = in[0];
+  step1[1] = in[8];
+  step1[2] = in[4];
+  step1[3] = in[12];
+  step1[4] = in[2];
+  step1[5] = in[10];
+  step1[6] = in[6];
+  step1[7] = in[14];
+  step1[8] = in[1];
+  step1[9] = in[9];
+  step1[10] = in[5];
+  step1[11] = in[13];
+  step1[12] = in[3];
+  step1[13] = in[11];
+  step1[14] = in[7];
+  step1[15] = in[15];
+
+  // stage 2
+  for (i = 0; i < 8; ++i)
+    step2[i] = step1[i];
+  butterfly(step1[8], step1[15], k__cospi_p30_m02, k__cospi_p02_p30,
+            &step2[8], &step2[15]);
+  butterfly(step1[9], step1[14], k__cospi_p14_m18, k__cospi_p18_p14,
+            &step2[9], &step2[14]);
+  butterfly(step1[10], step1[13], k__cospi_p22_m10, k__cospi_p10_p22,
+            &step2[10], &step2[13]);
+  butterfly(step1[11], step1[12], k__cospi_p06_m26, k__cospi_p26_p06,
+            &step2[11], &step2[12]);
+
+  // stage 3
+  step1[0] = step2[0];
+  step1[1] = step2[1];
+  step1[2] = step2[2];
+  step1[3] = step2[3];
+  butterfly(step2[4], step2[7], k__cospi_p28_m04, k__cospi_p04_p28,
+            &step1[4], &step1[7]);
+  butterfly(step2[5], step2[6], k__cospi_p12_m20, k__cospi_p20_p12,
+            &step1[5], &step1[6]);
+  step1[8] = _mm256_add_epi16(step2[8], step2[9]);
+  step1[9] = _mm256_sub_epi16(step2[8], step2[9]);
+  step1[10] = _mm256_sub_epi16(step2[11], step2[10]);
+  step1[11] = _mm256_add_epi16(step2[10], step2[11]);
+  step1[12] = _mm256_add_epi16(step2[12], step2[13]);
+  step1[13] = _mm256_sub_epi16(step2[12], step2[13]);
+  step1[14] = _mm256_sub_epi16(step2[15], step2[14]);
+  step1[15] = _mm256_add_epi16(step2[14], step2[15]);
+
+  // stage 4
+  butterfly(step1[0], step1[1], k__cospi_p16_p16, k__cospi_p16_m16,
+            &step2[0], &step2[1]);
+  butterfly(step1[2], step1[3], k__cospi_p24_m08, k__cospi_p08_p24,
+            &step2[2], &step2[3]);
+  step2[4] = _mm256_add_epi16(step1[4], step1[5]);
+  step2[5] = _mm256_sub_epi16(step1[4], step1[5]);
+  step2[6] = _mm256_sub_epi16(step1[7], step1[6]);
+  step2[7] = _mm256_add_epi16(step1[6], step1[7]);
+  step2[8] = step1[8];
+  step2[15] = step1[15];
+  butterfly(step1[9], step1[14], k__cospi_m08_p24, k__cospi_p24_p08,
+            &step2[9], &step2[14]);
+  butterfly(step1[10], step1[13], k__cospi_m24_m08, k__cospi_m08_p24,
+            &step2[10], &step2[13]);
+  step2[11] = step1[11];
+  step2[12] = step1[12];
+
+  idct16_stages_5_7(step2, out);
+}
+
+// idct16_avx2() with only in[0..3] non-zero.
+static INLINE void idct16_4_avx2(const __m256i *in, __m256i *out) {
+  const __m256i k__cospi_m08_p24 = pair256_set_epi16(-cospi_8_64, cospi_24_64);
+  const __m256i k__cospi_p24_p08 = pair256_set_epi16(cospi_24_64, cospi_8_64);
+  const __m256i k__cospi_m24_m08 = pair256_set_epi16(-cospi_24_64,
+                                                     -cospi_8_64);
+  __m256i step1[16], step2[16];
+
+  // stages 2 and 3
+  step1[8] = mult_round_1(in[1], cospi_30_64);
+  step1[9] = step1[8];
+  step1[15] = mult_round_1(in[1], cospi_2_64);
+  step1[14] = step1[15];
+  step1[11] = mult_round_1(in[3], -cospi_26_64);
+  step1[10] = step1[11];
+  step1[12] = mult_round_1(in[3], cospi_6_64);
+  step1[13] = step1[12];
+  step1[4] = mult_round_1(in[2], cospi_28_64);
+  step1[7] = mult_round_1(in[2], cospi_4_64);
+
+  // stage 4
+  step2[0] = mult_round_1(in[0], cospi_16_64);
+  step2[1] = step2[0];
+  step2[2] = _mm256_setzero_si256();
+  step2[3] = step2[2];
+  step2[4] = step1[4];
+  step2[5] = step1[4];
+  step2[6] = step1[7];
+  step2[7] = step1[7];
+  step2[8] = step1[8];
+  step2[15] = step1[15];
+  butterfly(step1[9], step1[14], k__cospi_m08_p24, k__cospi_p24_p08,
+            &step2[9], &step2[14]);
+  butterfly(step1[10], step1[13], k__cospi_m24_m08, k__cospi_m08_p24,
+            &step2[10], &step2[13]);
+  step2[11] = step1[11];
+  step2[12] = step1[12];
+
+  idct16_stages_5_7(step2, out);
+}
+
+static void iadst16_avx2(const __m256i *in, __m256i *out) {
+  static const int cospi_pairs[8][2] = {
+    { cospi_1_64, cospi_31_64 }, { cospi_5_64, cospi_27_64 },
+    { cospi_9_64, cospi_23_64 }, { cospi_13_64, cospi_19_64 },
+    { cospi_17_64, cospi_15_64 }, { cospi_21_64, cospi_11_64 },
+    { cospi_25_64, cospi_7_64 }, { cospi_29_64, cospi_3_64 }
+  };
+  const __m256i k__cospi_p04_p28 = pair256_set_epi16(cospi_4_64, cospi_28_64);
+  const __m256i k__cospi_p28_m04 = pair256_set_epi16(cospi_28_64, -cospi_4_64);
+  const __m256i k__cospi_p20_p12 = pair256_set_epi16(cospi_20_64, cospi_12_64);
+  const __m256i k__cospi_p12_m20 = pair256_set_epi16(cospi_12_64,
+                                                     -cospi_20_64);
+  const __m256i k__cospi_m28_p04 = pair256_set_epi16(-cospi_28_64, cospi_4_64);
+  const __m256i k__cospi_m12_p20 = pair256_set_epi16(-cospi_12_64,
+                                                     cospi_20_64);
+  const __m256i k__cospi_p08_p24 = pair256_set_epi16(cospi_8_64, cospi_24_64);
+  const __m256i k__cospi_p24_m08 = pair256_set_epi16(cospi_24_64, -cospi_8_64);
+  const __m256i k__cospi_m24_p08 = pair256_set_epi16(-cospi_24_64, cospi_8_64);
+  const __m256i k__cospi_p16_p16 = pair256_set_epi16(cospi_16_64, cospi_16_64);
+  const __m256i k__cospi_p16_m16 = pair256_set_epi16(cospi_16_64,
+                                                     -cospi_16_64);
+  const __m256i k__cospi_m16_p16 = pair256_set_epi16(-cospi_16_64,
+                                                     cospi_16_64);
+  const __m256i k__cospi_m16_m16 = pair256_set_epi16(-cospi_16_64,
+                                                     -cospi_16_64);
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i x[16], lo[16], hi[16], t[4];
+  int i;
+
+  x[0] = in[15];
+  x[1] = in[0];
+  x[2] = in[13];
+  x[3] = in[2];
+  x[4] = in[11];
+  x[5] = in[4];
+  x[6] = in[9];
+  x[7] = in[6];
+  x[8] = in[7];
+  x[9] = in[8];
+  x[10] = in[5];
+  x[11] = in[10];
+  x[12] = in[3];
+  x[13] = in[12];
+  x[14] = in[1];
+  x[15] = in[14];
+
+  // stage 1
+  for (i = 0; i < 8; ++i) {
+    const int c0 = cospi_pairs[i][0];
+    const int c1 = cospi_pairs[i][1];
+    mult_add(x[2 * i], x[2 * i + 1], pair256_set_epi16(c0, c1),
+             &lo[2 * i], &hi[2 * i]);
+    mult_add(x[2 * i], x[2 * i + 1], pair256_set_epi16(c1, -c0),
+             &lo[2 * i + 1], &hi[2 * i + 1]);
+  }
+  for (i = 0; i < 8; ++i) {
+    x[i] = round_shift_pack(_mm256_add_epi32(lo[i], lo[i + 8]),
+                            _mm256_add_epi32(hi[i], hi[i + 8]));
+    x[i + 8] = round_shift_pack(_mm256_sub_epi32(lo[i], lo[i + 8]),
+                                _mm256_sub_epi32(hi[i], hi[i + 8]));
+  }
+
+  // stage 2
+  mult_add(x[8], x[9], k__cospi_p04_p28, &lo[8], &hi[8]);
+  mult_add(x[8], x[9], k__cospi_p28_m04, &lo[9], &hi[9]);
+  mult_add(x[10], x[11], k__cospi_p20_p12, &lo[10], &hi[10]);
+  mult_add(x[10], x[11], k__cospi_p12_m20, &lo[11], &hi[11]);
+  mult_add(x[12], x[13], k__cospi_m28_p04, &lo[12], &hi[12]);
+  mult_add(x[12], x[13], k__cospi_p04_p28, &lo[13], &hi[13]);
+  mult_add(x[14], x[15], k__cospi_m12_p20, &lo[14], &hi[14]);
+  mult_add(x[14], x[15], k__cospi_p20_p12, &lo[15], &hi[15]);
+  for (i = 0; i < 4; ++i) {
+    t[i] = x[i];
+    x[i] = _mm256_add_epi16(t[i], x[i + 4]);
+    x[i + 4] = _mm256_sub_epi16(t[i], x[i + 4]);
+  }
+  for (i = 8; i < 12; ++i) {
+    x[i] = round_shift_pack(_mm256_add_epi32(lo[i], lo[i + 4]),
+                            _mm256_add_epi32(hi[i], hi[i + 4]));
+    x[i + 4] = round_shift_pack(_mm256_sub_epi32(lo[i], lo[i + 4]),
+                                _mm256_sub_epi32(hi[i], hi[i + 4]));
+  }
+
+  // stage 3
+  for (i = 4; i < 16; i += 8) {
+    mult_add(x[i], x[i + 1], k__cospi_p08_p24, &lo[i], &hi[i]);
+    mult_add(x[i], x[i + 1], k__cospi_p24_m08, &lo[i + 1], &hi[i + 1]);
+    mult_add(x[i + 2], x[i + 3], k__cospi_m24_p08, &lo[i + 2], &hi[i + 2]);
+    mult_add(x[i + 2], x[i + 3], k__cospi_p08_p24, &lo[i + 3], &hi[i + 3]);
+  }
+  for (i = 0; i < 16; i += 8) {
+    t[0] = x[i];
+    t[1] = x[i + 1];
+    x[i] = _mm256_add_epi16(t[0], x[i + 2]);
+    x[i + 1] = _mm256_add_epi16(t[1], x[i + 3]);
+    x[i + 2] = _mm256_sub_epi16(t[0], x[i + 2]);
+    x[i + 3] = _mm256_sub_epi16(t[1], x[i + 3]);
+    x[i + 4] = round_shift_pack(_mm256_add_epi32(lo[i + 4], lo[i + 6]),
+                                _mm256_add_epi32(hi[i + 4], hi[i + 6]));
+    x[i + 5] = round_shift_pack(_mm256_add_epi32(lo[i + 5], lo[i + 7]),
+                                _mm256_add_epi32(hi[i + 5], hi[i + 7]));
+    x[i + 6] = round_shift_pack(_mm256_sub_epi32(lo[i + 4], lo[i + 6]),
+                                _mm256_sub_epi32(hi[i + 4], hi[i + 6]));
+    x[i + 7] = round_shift_pack(_mm256_sub_epi32(lo[i + 5], lo[i + 7]),
+                                _mm256_sub_epi32(hi[i + 5], hi[i + 7]));
+  }
+
+  // stage 4
+  butterfly(x[2], x[3], k__cospi_m16_m16, k__cospi_p16_m16, &x[2], &x[3]);
+  butterfly(x[6], x[7], k__cospi_p16_p16, k__cospi_m16_p16, &x[6], &x[7]);
+  butterfly(x[10], x[11], k__cospi_p16_p16, k__cospi_m16_p16, &x[10], &x[11]);
+  butterfly(x[14], x[15], k__cospi_m16_m16, k__cospi_p16_m16, &x[14], &x[15]);
+
+  out[0] = x[0];
+  out[1] = _mm256_sub_epi16(zero, x[8]);
+  out[2] = x[12];
+  out[3] = _mm256_sub_epi16(zero, x[4]);
+  out[4] = x[6];
+  out[5] = x[14];
+  out[6] = x[10];
+  out[7] = x[2];
+  out[8] = x[3];
+  out[9] = x[11];
+  out[10] = x[15];
+  out[11] = x[7];
+  out[12] = x[5];
+  out[13] = _mm256_sub_epi16(zero, x[13]);
+  out[14] = x[9];
+  out[15] = _mm256_sub_epi16(zero, x[1]);
+}
+
+// The rows of a 16x16 block are in in[0..15].
+static void inverse_16x16_add(const __m256i *in, uint8_t *dest, int stride,
+                              transform_1d_avx2 rows,
+                              transform_1d_avx2 cols) {
+  __m256i a[16], b[16];
+  int i;
+
+  transpose_16x16(in, a);
+  rows(a, b);
+  transpose_16x16(b, a);
+  cols(a, b);
+
+  for (i = 0; i < 16; ++i)
+    recon_and_store_16(dest + i * stride, b[i]);
+}
+
+void vp9_idct16x16_256_add_avx2(const int16_t *input, uint8_t *dest,
+                                int stride) {
+  __m256i in[16];
+  load_rows_16(input, 16, 16, in);
+  inverse_16x16_add(in, dest, stride, idct16_avx2, idct16_avx2);
+}
+
+void vp9_iht16x16_256_add_avx2(const int16_t *input, uint8_t *dest,
+                               int stride, int tx_type) {
+  __m256i in[16];
+  load_rows_16(input, 16, 16, in);
+  // Same pairing as IHT_16[] in vp9_idct.c.
+  inverse_16x16_add(in, dest, stride,
+                    (tx_type == DCT_DCT || tx_type == ADST_DCT) ?
+                        idct16_avx2 : iadst16_avx2,
+                    (tx_type == DCT_DCT || tx_type == DCT_ADST) ?
+                        idct16_avx2 : iadst16_avx2);
+}
+
+// Stages 2 to 7 of the 32-point idct. step1[0..15] holds the 16-point idct of
+// the even coefficients and step2[16..31] the stage 1 output.
+static INLINE void idct32_stages_2_7(__m256i *step1, __m256i *step2,
+                                     __m256i *out) {
+  const __m256i k__cospi_m04_p28 = pair256_set_epi16(-cospi_4_64, cospi_28_64);
+  const __m256i k__cospi_p28_p04 = pair256_set_epi16(cospi_28_64, cospi_4_64);
+  const __m256i k__cospi_m28_m04 = pair256_set_epi16(-cospi_28_64,
+                                                     -cospi_4_64);
+  const __m256i k__cospi_m20_p12 = pair256_set_epi16(-cospi_20_64,
+                                                     cospi_12_64);
+  const __m256i k__cospi_p12_p20 = pair256_set_epi16(cospi_12_64, cospi_20_64);
+  const __m256i k__cospi_m12_m20 = pair256_set_epi16(-cospi_12_64,
+                                                     -cospi_20_64);
+  const __m256i k__cospi_m08_p24 = pair256_set_epi16(-cospi_8_64, cospi_24_64);
+  const __m256i k__cospi_p24_p08 = pair256_set_epi16(cospi_24_64, cospi_8_64);
+  const __m256i k__cospi_m24_m08 = pair256_set_epi16(-cospi_24_64,
+                                                     -cospi_8_64);
+  const __m256i k__cospi_m16_p16 = pair256_set_epi16(-cospi_16_64,
+                                                     cospi_16_64);
+  const __m256i k__cospi_p16_p16 = pair256_set_epi16(cospi_16_64, cospi_16_64);
+  int i;
+
+  // stage 2
+  for (i = 16; i < 32; i += 4) {
+    step1[i] = _mm256_add_epi16(step2[i], step2[i + 1]);
+    step1[i + 1] = _mm256_sub_epi16(step2[i], step2[i + 1]);
+    step1[i + 2] = _mm256_sub_epi16(step2[i + 3], step2[i + 2]);
+    step1[i + 3] = _mm256_add_epi16(step2[i + 2], step2[i + 3]);
+  }
+
+  // stage 3
+  step2[16] = step1[16];
+  step2[31] = step1[31];
+  butterfly(step1[17], step1[30], k__cospi_m04_p28, k__cospi_p28_p04,
+            &step2[17], &step2[30]);
+  butterfly(step1[18], step1[29], k__cospi_m28_m04, k__cospi_m04_p28,
+            &step2[18], &step2[29]);
+  step2[19] = step1[19];
+  step2[20] = step1[20];
+  butterfly(step1[21], step1[26], k__cospi_m20_p12, k__cospi_p12_p20,
+            &step2[21], &step2[26]);
+  butterfly(step1[22], step1[25], k__cospi_m12_m20, k__cospi_m20_p12,
+            &step2[22], &step2[25]);
+  step2[23] = step1[23];
+  step2[24] = step1[24];
+  step2[27] = step1[27];
+  step2[28] = step1[28];
+
+  // stage 4
+  for (i = 16; i < 32; i += 8) {
+    step1[i] = _mm256_add_epi16(step2[i], step2[i + 3]);
+    step1[i + 1] = _mm256_add_epi16(step2[i + 1], step2[i + 2]);
+    step1[i + 2] = _mm256_sub_epi16(step2[i + 1], step2[i + 2]);
+    step1[i + 3] = _mm256_sub_epi16(step2[i], step2[i + 3]);
+    step1[i + 4] = _mm256_sub_epi16(step2[i + 7], step2[i + 4]);
+    step1[i + 5] = _mm256_sub_epi16(step2[i + 6], step2[i + 5]);
+    step1[i + 6] = _mm256_add_epi16(step2[i + 5], step2[i + 6]);
+    step1[i + 7] = _mm256_add_epi16(step2[i + 4], step2[i + 7]);
+  }
+
+  // stage 5
+  step2[16] = step1[16];
+  step2[17] = step1[17];
+  butterfly(step1[18], step1[29], k__cospi_m08_p24, k__cospi_p24_p08,
+            &step2[18], &step2[29]);
+  butterfly(step1[19], step1[28], k__cospi_m08_p24, k__cospi_p24_p08,
+            &step2[19], &step2[28]);
+  butterfly(step1[20], step1[27], k__cospi_m24_m08, k__cospi_m08_p24,
+            &step2[20], &step2[27]);
+  butterfly(step1[21], step1[26], k__cospi_m24_m08, k__cospi_m08_p24,
+            &step2[21], &step2[26]);
+  step2[22] = step1[22];
+  step2[23] = step1[23];
+  step2[24] = step1[24];
+  step2[25] = step1[25];
+  step2[30] = step1[30];
+  step2[31] = step1[31];
+
+  // stage 6
+  for (i = 0; i < 4; ++i) {
+    step1[16 + i] = _mm256_add_epi16(step2[16 + i], step2[23 - i]);
+    step1[23 - i] = _mm256_sub_epi16(step2[16 + i], step2[23 - i]);
+    step1[24 + i] = _mm256_sub_epi16(step2[31 - i], step2[24 + i]);
+    step1[31 - i] = _mm256_add_epi16(step2[24 + i], step2[31 - i]);
+  }
+
+  // stage 7
+  for (i = 16; i < 20; ++i) {
+    step2[i] = step1[i];
+    step2[i + 12] = step1[i + 12];
+  }
+  for (i = 20; i < 24; ++i)
+    butterfly(step1[i], step1[47 - i], k__cospi_m16_p16, k__cospi_p16_p16,
+              &step2[i], &step2[47 - i]);
+
+  // final stage
+  for (i = 0; i < 16; ++i) {
+    out[i] = _mm256_add_epi16(step1[i], step2[31 - i]);
+    out[31 - i] = _mm256_sub_epi16(step1[i], step2[31 - i]);
+  }
+}
+
+static void idct32_avx2(const __m256i *in, __m256i *out) {
+  static const int cospi_pairs[8][2] = {
+    { cospi_31_64, cospi_1_64 }, { cospi_15_64, cospi_17_64 },
+    { cospi_23_64, cospi_9_64 }, { cospi_7_64, cospi_25_64 },
+    { cospi_27_64, cospi_5_64 }, { cospi_11_64, cospi_21_64 },
+    { cospi_19_64, cospi_13_64 }, { cospi_3_64, cospi_29_64 }
+  };
+  // Input pairs of the stage 1 rotations, producing step1[16 + i] and
+  // step1[31 - i].
+  static const int in_pairs[8][2] = {
+    { 1, 31 }, { 17, 15 }, { 9, 23 }, { 25, 7 },
+    { 5, 27 }, { 21, 11 }, { 13, 19 }, { 29, 3 }
+  };
+  __m256i even[16], step1[32], step2[32];
+  int i;
+
+  // The even coefficients go through a 16-point idct, which gives step1[0..15]
+  // of the final stage.
+  for (i = 0; i < 16; ++i)
+    even[i] = in[2 * i];
+  idct16_avx2(even, step1);
+
+  // stage 1
+  for (i = 0; i < 8; ++i) {
+    const int c0 = cospi_pairs[i][0];
+    const int c1 = cospi_pairs[i][1];
+    butterfly(in[in_pairs[i][0]], in[in_pairs[i][1]],
+              pair256_set_epi16(c0, -c1), pair256_set_epi16(c1, c0),
+              &step2[16 + i], &step2[31 - i]);
+  }
+
+  idct32_stages_2_7(step1, step2, out);
+}
+
+// idct32_avx2() with only in[0..7] non-zero.
+static void idct32_8_avx2(const __m256i *in, __m256i *out) {
+  __m256i even[16], step1[32], step2[32];
+  int i;
+
+  for (i = 0; i < 4; ++i)
+    even[i] = in[2 * i];
+  idct16_4_avx2(even, step1);
+
+  // stage 1
+  for (i = 16; i < 32; ++i)
+    step2[i] = _mm256_setzero_si256();
+  step2[16] = mult_round_1(in[1], cospi_31_64);
+  step2[31] = mult_round_1(in[1], cospi_1_64);
+  step2[19] = mult_round_1(in[7], -cospi_25_64);
+  step2[28] = mult_round_1(in[7], cospi_7_64);
+  step2[20] = mult_round_1(in[5], cospi_27_64);
+  step2[27] = mult_round_1(in[5], cospi_5_64);
+  step2[23] = mult_round_1(in[3], -cospi_29_64);
+  step2[24] = mult_round_1(in[3], cospi_3_64);
+
+  idct32_stages_2_7(step1, step2, out);
+}
+
+// Transposes the 32 transformed columns of 16 rows back into output.
+static void store_rows_16(const __m256i *out, int16_t *output) {
+  __m256i t[16];
+  int i;
+
+  transpose_16x16(out, t);
+  for (i = 0; i < 16; ++i)
+    _mm256_store_si256((__m256i *)(output + i * 32), t[i]);
+  transpose_16x16(out + 16, t);
+  for (i = 0; i < 16; ++i)
+    _mm256_store_si256((__m256i *)(output + i * 32 + 16), t[i]);
+}
+
+// Transforms 16 rows of 32 coefficients, in_left and in_right holding the
+// left and right halves of the rows, into output.
+static void idct32_rows_16(const __m256i *in_left, const __m256i *in_right,
+                           int16_t *output) {
+  __m256i in[32], out[32];
+
+  transpose_16x16(in_left, in);
+  transpose_16x16(in_right, in + 16);
+  idct32_avx2(in, out);
+  store_rows_16(out, output);
+}
+
+// Only the first rows of input are read, the others being zero.
+static void idct32_cols_add(const int16_t *input, uint8_t *dest, int stride,
+                            int rows, transform_1d_avx2 cols) {
+  __m256i in[32], out[32];
+  int i, j;
+
+  for (i = 0; i < 32; i += 16) {
+    for (j = 0; j < rows; ++j)
+      in[j] = _mm256_load_si256((const __m256i *)(input + j * 32 + i));
+    for (; j < 32; ++j)
+      in[j] = _mm256_setzero_si256();
+    cols(in, out);
+    for (j = 0; j < 32; ++j)
+      recon_and_store_16(dest + j * stride + i, out[j]);
+  }
+}
+
+void vp9_idct32x32_1024_add_avx2(const int16_t *input, uint8_t *dest,
+                                 int stride) {
+  DECLARE_ALIGNED(32, int16_t, out[32 * 32]);
+  __m256i left[16], right[16];
+  int i, j;
+
+  // Rows
+  for (i = 0; i < 32; i += 16) {
+    __m256i zero_coeff = _mm256_setzero_si256();
+    load_rows_16(input + i * 32, 32, 16, left);
+    load_rows_16(input + i * 32 + 16, 32, 16, right);
+    for (j = 0; j < 16; ++j)
+      zero_coeff = _mm256_or_si256(zero_coeff,
+                                   _mm256_or_si256(left[j], right[j]));
+
+    if (_mm256_testz_si256(zero_coeff, zero_coeff)) {
+      for (j = 0; j < 32 * 16; j += 16)
+        _mm256_store_si256((__m256i *)(out + i * 32 + j), zero_coeff);
+    } else {
+      idct32_rows_16(left, right, out + i * 32);
+    }
+  }
+
+  // Columns
+  idct32_cols_add(out, dest, stride, 32, idct32_avx2);
+}
+
+void vp9_idct32x32_34_add_avx2(const int16_t *input, uint8_t *dest,
+                               int stride) {
+  DECLARE_ALIGNED(32, int16_t, out[32 * 16]);
+  __m256i rows[16], in[32], t[32];
+
+  // Rows
+  // Only the upper-left 8x8 coefficients are non-zero, so the right halves of
+  // the rows and the lower 16 rows are skipped.
+  load_rows_16(input, 32, 8, rows);
+  transpose_16x16(rows, in);
+  idct32_8_avx2(in, t);
+  store_rows_16(t, out);
+
+  // Columns
+  idct32_cols_add(out, dest, stride, 8, idct32_8_avx2);
+}
+
+void vp9_idct32x32_1_add_avx2(const int16_t *input, uint8_t *dest,
+                              int stride) {
+  __m256i dc_value;
+  int a, i;
+
+  a = dct_const_round_shift(input[0] * cospi_16_64);
+  a = dct_const_round_shift(a * cospi_16_64);
+  a = ROUND_POWER_OF_TWO(a, 6);
+
+  if (a >= 0) {
+    dc_value = _mm256_set1_epi8(MIN(a, 255));
+    for (i = 0; i < 32; ++i) {
+      const __m256i d = _mm256_loadu_si256((const __m256i *)dest);
+      _mm256_storeu_si256((__m256i *)dest, _mm256_adds_epu8(d, dc_value));
+      dest += stride;
+    }
+  } else {
+    dc_value = _mm256_set1_epi8(MIN(-a, 255));
+    for (i = 0; i < 32; ++i) {
+      const __m256i d = _mm256_loadu_si256((const __m256i *)dest);
+      _mm256_storeu_si256((__m256i *)dest, _mm256_subs_epu8(d, dc_value));
+      dest += stride;
+    }
+  }
+}
@@ -155,6 +155,117 @@ void vp9_idct4x4_16_add_sse2(const int16_t *input, uint8_t *dest, int stride) {
   }
 }
 
+// One idct4 across all 8 lanes: in[k] holds coefficient k of 8 rows or
+// columns.
+static INLINE void idct4_8col(const __m128i *in, __m128i *out) {
+  const __m128i k__cospi_p16_p16 = pair_set_epi16(cospi_16_64, cospi_16_64);
+  const __m128i k__cospi_p16_m16 = pair_set_epi16(cospi_16_64, -cospi_16_64);
+  const __m128i k__cospi_p24_m08 = pair_set_epi16(cospi_24_64, -cospi_8_64);
+  const __m128i k__cospi_p08_p24 = pair_set_epi16(cospi_8_64, cospi_24_64);
+  const __m128i rounding = _mm_set1_epi32(DCT_CONST_ROUNDING);
+  const __m128i lo_02 = _mm_unpacklo_epi16(in[0], in[2]);
+  const __m128i hi_02 = _mm_unpackhi_epi16(in[0], in[2]);
+  const __m128i lo_13 = _mm_unpacklo_epi16(in[1], in[3]);
+  const __m128i hi_13 = _mm_unpackhi_epi16(in[1], in[3]);
+  __m128i u[8], step[4];
+
+  u[0] = _mm_madd_epi16(lo_02, k__cospi_p16_p16);
+  u[1] = _mm_madd_epi16(hi_02, k__cospi_p16_p16);
+  u[2] = _mm_madd_epi16(lo_02, k__cospi_p16_m16);
+  u[3] = _mm_madd_epi16(hi_02, k__cospi_p16_m16);
+  u[4] = _mm_madd_epi16(lo_13, k__cospi_p24_m08);
+  u[5] = _mm_madd_epi16(hi_13, k__cospi_p24_m08);
+  u[6] = _mm_madd_epi16(lo_13, k__cospi_p08_p24);
+  u[7] = _mm_madd_epi16(hi_13, k__cospi_p08_p24);
+
+  u[0] = _mm_srai_epi32(_mm_add_epi32(u[0], rounding), DCT_CONST_BITS);
+  u[1] = _mm_srai_epi32(_mm_add_epi32(u[1], rounding), DCT_CONST_BITS);
+  u[2] = _mm_srai_epi32(_mm_add_epi32(u[2], rounding), DCT_CONST_BITS);
+  u[3] = _mm_srai_epi32(_mm_add_epi32(u[3], rounding), DCT_CONST_BITS);
+  u[4] = _mm_srai_epi32(_mm_add_epi32(u[4], rounding), DCT_CONST_BITS);
+  u[5] = _mm_srai_epi32(_mm_add_epi32(u[5], rounding), DCT_CONST_BITS);
+  u[6] = _mm_srai_epi32(_mm_add_epi32(u[6], rounding), DCT_CONST_BITS);
+  u[7] = _mm_srai_epi32(_mm_add_epi32(u[7], rounding), DCT_CONST_BITS);
+
+  step[0] = _mm_packs_epi32(u[0], u[1]);
+  step[1] = _mm_packs_epi32(u[2], u[3]);
+  step[2] = _mm_packs_epi32(u[4], u[5]);
+  step[3] = _mm_packs_epi32(u[6], u[7]);
+
+  out[0] = _mm_add_epi16(step[0], step[3]);
+  out[1] = _mm_add_epi16(step[1], step[2]);
+  out[2] = _mm_sub_epi16(step[1], step[2]);
+  out[3] = _mm_sub_epi16(step[0], step[3]);
+}
+
+// Two 4x4 inverse transforms per pass: the low half of each register works
+// on the first block and the high half on the second.
+static INLINE void idct4x4_16_add_x2(const int16_t *input_a,
+                                     const int16_t *input_b,
+                                     uint8_t *dest_a, uint8_t *dest_b,
+                                     int stride) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i eight = _mm_set1_epi16(8);
+  __m128i in[4], out[4], t[4];
+  int j;
+
+  // Gather coefficient k of every row of both blocks into in[k].
+  in[0] = _mm_load_si128((const __m128i *)input_a);
+  in[1] = _mm_load_si128((const __m128i *)(input_a + 8));
+  in[2] = _mm_load_si128((const __m128i *)input_b);
+  in[3] = _mm_load_si128((const __m128i *)(input_b + 8));
+  t[0] = _mm_unpacklo_epi16(in[0], in[1]);
+  t[1] = _mm_unpackhi_epi16(in[0], in[1]);
+  t[2] = _mm_unpacklo_epi16(in[2], in[3]);
+  t[3] = _mm_unpackhi_epi16(in[2], in[3]);
+  in[0] = _mm_unpacklo_epi16(t[0], t[1]);
+  in[1] = _mm_unpackhi_epi16(t[0], t[1]);
+  in[2] = _mm_unpacklo_epi16(t[2], t[3]);
+  in[3] = _mm_unpackhi_epi16(t[2], t[3]);
+  t[0] = _mm_unpacklo_epi64(in[0], in[2]);
+  t[1] = _mm_unpackhi_epi64(in[0], in[2]);
+  t[2] = _mm_unpacklo_epi64(in[1], in[3]);
+  t[3] = _mm_unpackhi_epi64(in[1], in[3]);
+
+  // Rows
+  idct4_8col(t, out);
+
+  // Transpose each half so in[j] holds row j of both blocks.
+  t[0] = _mm_unpacklo_epi16(out[0], out[1]);
+  t[1] = _mm_unpacklo_epi16(out[2], out[3]);
+  t[2] = _mm_unpackhi_epi16(out[0], out[1]);
+  t[3] = _mm_unpackhi_epi16(out[2], out[3]);
+  out[0] = _mm_unpacklo_epi32(t[0], t[1]);
+  out[1] = _mm_unpackhi_epi32(t[0], t[1]);
+  out[2] = _mm_unpacklo_epi32(t[2], t[3]);
+  out[3] = _mm_unpackhi_epi32(t[2], t[3]);
+  in[0] = _mm_unpacklo_epi64(out[0], out[2]);
+  in[1] = _mm_unpackhi_epi64(out[0], out[2]);
+  in[2] = _mm_unpacklo_epi64(out[1], out[3]);
+  in[3] = _mm_unpackhi_epi64(out[1], out[3]);
+
+  // Columns
+  idct4_8col(in, out);
+
+  // Final round and shift, reconstruction and store
+  for (j = 0; j < 4; ++j) {
+    __m128i d = _mm_unpacklo_epi32(
+        _mm_cvtsi32_si128(*(const int *)(dest_a + j * stride)),
+        _mm_cvtsi32_si128(*(const int *)(dest_b + j * stride)));
+    out[j] = _mm_srai_epi16(_mm_add_epi16(out[j], eight), 4);
+    d = _mm_add_epi16(_mm_unpacklo_epi8(d, zero), out[j]);
+    d = _mm_packus_epi16(d, d);
+    *(int *)(dest_a + j * stride) = _mm_cvtsi128_si32(d);
+    *(int *)(dest_b + j * stride) = _mm_cvtsi128_si32(_mm_srli_si128(d, 4));
+  }
+}
+
+void vp9_idct4x4_16_add_x4_sse2(int16_t *const *input, uint8_t *const *dest,
+                                int stride) {
+  idct4x4_16_add_x2(input[0], input[1], dest[0], dest[1], stride);
+  idct4x4_16_add_x2(input[2], input[3], dest[2], dest[3], stride);
+}
+
 void vp9_idct4x4_1_add_sse2(const int16_t *input, uint8_t *dest, int stride) {
   __m128i dc_value;
   const __m128i zero = _mm_setzero_si128();
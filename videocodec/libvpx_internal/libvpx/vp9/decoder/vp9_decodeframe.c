@@ -9,6 +9,7 @@
  */
 
 #include <assert.h>
+#include <limits.h>
 #include <stdlib.h>  // qsort()
 
 #include "./vp9_rtcd.h"
@@ -16,6 +17,7 @@
 
 #include "vpx_mem/vpx_mem.h"
 #include "vpx_ports/mem_ops.h"
+#include "vpx_ports/vpx_timer.h"
 #include "vpx_scale/vpx_scale.h"
 
 #include "vp9/common/vp9_alloccommon.h"
@@ -28,6 +30,7 @@
 #include "vp9/common/vp9_reconintra.h"
 #include "vp9/common/vp9_reconinter.h"
 #include "vp9/common/vp9_seg_common.h"
+#include "vp9/common/vp9_thread.h"
 #include "vp9/common/vp9_tile_common.h"
 
 #include "vp9/decoder/vp9_decodeframe.h"
@@ -38,7 +41,6 @@
 #include "vp9/decoder/vp9_dthread.h"
 #include "vp9/decoder/vp9_read_bit_buffer.h"
 #include "vp9/decoder/vp9_reader.h"
-#include "vp9/decoder/vp9_thread.h"
 
 #include "trace_conf.h"
 
@@ -189,9 +191,50 @@ static void setup_plane_dequants(VP9_COMMON *cm, MACROBLOCKD *xd, int q_index) {
     xd->plane[i].dequant = cm->uv_dequant[q_index];
 }
 
+// Inter 4x4 transforms are queued and run in batches where a multi-block
+// kernel exists.
+#define BATCH_IDCT4X4 HAVE_SSE2
+
+static void flush_idct4x4_batch(VP9Idct4x4Batch *const batch) {
+  int i;
+  for (i = 0; i < batch->count; ++i) {
+    vp9_idct4x4_16_add(batch->coeff[i], batch->dst[i], batch->stride);
+    vpx_memset(batch->coeff[i], 0, 16 * sizeof(batch->coeff[i][0]));
+  }
+  batch->count = 0;
+}
+
+static void flush_idct4x4_batches(VP9Idct4x4Batch *const batches) {
+  int plane;
+  for (plane = 0; plane < MAX_MB_PLANE; ++plane)
+    flush_idct4x4_batch(&batches[plane]);
+}
+
+// The coefficients are zeroed once the batch has run, as
+// inverse_transform_block() does.
+static void add_to_idct4x4_batch(VP9Idct4x4Batch *const batch,
+                                 int16_t *dqcoeff, uint8_t *dst, int stride) {
+  if (batch->stride != stride)
+    flush_idct4x4_batch(batch);
+
+  batch->coeff[batch->count] = dqcoeff;
+  batch->dst[batch->count++] = dst;
+  batch->stride = stride;
+
+  if (batch->count == 4) {
+    int i;
+    vp9_idct4x4_16_add_x4(batch->coeff, batch->dst, stride);
+    for (i = 0; i < 4; ++i)
+      vpx_memset(batch->coeff[i], 0, 16 * sizeof(batch->coeff[i][0]));
+    batch->count = 0;
+  }
+}
+
+// With a batch, full 4x4 DCT blocks are queued in it instead of being
+// inverse transformed right away.
 static void inverse_transform_block(MACROBLOCKD* xd, int plane, int block,
                                     TX_SIZE tx_size, uint8_t *dst, int stride,
-                                    int eob) {
+                                    int eob, VP9Idct4x4Batch *batch) {
   struct macroblockd_plane *const pd = &xd->plane[plane];
   if (eob > 0) {
     TX_TYPE tx_type;
@@ -200,6 +243,10 @@ static void inverse_transform_block(MACROBLOCKD* xd, int plane, int block,
     switch (tx_size) {
       case TX_4X4:
         tx_type = get_tx_type_4x4(plane_type, xd, block);
+        if (tx_type == DCT_DCT && batch != NULL && eob > 1 && !xd->lossless) {
+          add_to_idct4x4_batch(batch, dqcoeff, dst, stride);
+          return;
+        }
         if (tx_type == DCT_DCT)
           xd->itxm_add(dqcoeff, dst, stride, eob);
         else
@@ -234,10 +281,13 @@ static void inverse_transform_block(MACROBLOCKD* xd, int plane, int block,
   }
 }
 
+// The tokens are read from r, or in two-stage decoding have already been
+// parsed into blk.
 struct intra_args {
   VP9_COMMON *cm;
   MACROBLOCKD *xd;
   vp9_reader *r;
+  const VP9DecBlock *blk;
 };
 
 static void predict_and_reconstruct_intra_block(int plane, int block,
@@ -261,11 +311,12 @@ static void predict_and_reconstruct_intra_block(int plane, int block,
                           x, y, plane);
 
   if (!mi->mbmi.skip) {
-    const int eob = vp9_decode_block_tokens(cm, xd, plane, block,
+    const int eob = args->blk != NULL ? args->blk->eobs[plane][block] :
+                    vp9_decode_block_tokens(cm, xd, plane, block,
                                             plane_bsize, x, y, tx_size,
                                             args->r);
     inverse_transform_block(xd, plane, block, tx_size, dst, pd->dst.stride,
-                            eob);
+                            eob, NULL);
   }
 }
 
@@ -273,7 +324,9 @@ struct inter_args {
   VP9_COMMON *cm;
   MACROBLOCKD *xd;
   vp9_reader *r;
+  const VP9DecBlock *blk;
   int *eobtotal;
+  VP9Idct4x4Batch *idct_batch;  // one per plane, may be NULL
 };
 
 static void reconstruct_inter_block(int plane, int block,
@@ -285,11 +338,27 @@ static void reconstruct_inter_block(int plane, int block,
   struct macroblockd_plane *const pd = &xd->plane[plane];
   int x, y, eob;
   txfrm_block_to_raster_xy(plane_bsize, tx_size, block, &x, &y);
-  eob = vp9_decode_block_tokens(cm, xd, plane, block, plane_bsize, x, y,
+  eob = args->blk != NULL ? args->blk->eobs[plane][block] :
+        vp9_decode_block_tokens(cm, xd, plane, block, plane_bsize, x, y,
                                 tx_size, args->r);
   inverse_transform_block(xd, plane, block, tx_size,
                           &pd->dst.buf[4 * y * pd->dst.stride + 4 * x],
-                          pd->dst.stride, eob);
+                          pd->dst.stride, eob,
+                          args->idct_batch != NULL ? &args->idct_batch[plane]
+                                                   : NULL);
+  *args->eobtotal += eob;
+}
+
+// Stage one of the decoding: reads the tokens of a transform block into the
+// coefficients of the parsed block.
+static void parse_block_tokens(int plane, int block, BLOCK_SIZE plane_bsize,
+                               TX_SIZE tx_size, void *arg) {
+  struct inter_args *const args = (struct inter_args *)arg;
+  int x, y, eob;
+  txfrm_block_to_raster_xy(plane_bsize, tx_size, block, &x, &y);
+  eob = vp9_decode_block_tokens(args->cm, args->xd, plane, block, plane_bsize,
+                                x, y, tx_size, args->r);
+  args->blk->eobs[plane][block] = eob;
   *args->eobtotal += eob;
 }
 
@@ -333,7 +402,134 @@ static void set_ref(VP9_COMMON *const cm, MACROBLOCKD *const xd,
   xd->corrupted |= ref_buffer->buf->corrupted;
 }
 
+// Frame-based multi-threading: blocks until the reference rows the motion
+// vectors of the current block point to have been decoded. The margin covers
+// the interpolation filter taps and the chroma rounding.
+static void wait_for_ref_rows(FrameWorkerData *const fwd,
+                              const VP9_COMMON *const cm,
+                              const MODE_INFO *const mi,
+                              int mi_row, BLOCK_SIZE bsize) {
+  const MB_MODE_INFO *const mbmi = &mi->mbmi;
+  const int bottom = (mi_row + num_8x8_blocks_high_lookup[bsize]) * MI_SIZE;
+  int ref;
+
+  for (ref = 0; ref < 1 + has_second_ref(mbmi); ++ref) {
+    const RefBuffer *const ref_buf =
+        &cm->frame_refs[mbmi->ref_frame[ref] - LAST_FRAME];
+    int mv_row = mbmi->mv[ref].as_mv.row;
+
+    if (mbmi->sb_type < BLOCK_8X8) {
+      int i;
+      for (i = 0; i < 4; ++i)
+        mv_row = MAX(mv_row, mi->bmi[i].as_mv[ref].as_mv.row);
+    }
+
+    if (vp9_is_scaled(&ref_buf->sf))
+      vp9_frame_sync_wait(fwd->frame_sync, ref_buf->idx, INT_MAX - 1);
+    else
+      vp9_frame_sync_wait(fwd->frame_sync, ref_buf->idx,
+                          bottom + (mv_row >> 3) + 4 * VP9_INTERP_EXTEND);
+  }
+}
+
+// Stage one of the decoding: records a block whose mode info has been read
+// in the row buffer and reads its tokens into the buffer's coefficients. The
+// reconstruction is left to reconstruct_block().
+static void parse_block(VP9_COMMON *const cm, MACROBLOCKD *const xd,
+                        VP9DecRowBuffer *const row_buf,
+                        const TileInfo *const tile,
+                        int mi_row, int mi_col,
+                        vp9_reader *r, BLOCK_SIZE bsize) {
+  MB_MODE_INFO *const mbmi = &xd->mi[0]->mbmi;
+  VP9DecBlock *const blk = &row_buf->blocks[row_buf->num_blocks++];
+  int plane;
+
+  blk->tile = tile;
+  blk->mi_row = mi_row;
+  blk->mi_col = mi_col;
+  blk->bsize = bsize;
+
+  if (is_inter_block(mbmi)) {
+    // Validates the scale factors and inherits the reference corruption.
+    set_ref(cm, xd, 0, mi_row, mi_col);
+    if (has_second_ref(mbmi))
+      set_ref(cm, xd, 1, mi_row, mi_col);
+  }
+
+  if (!mbmi->skip) {
+    int eobtotal = 0;
+    struct inter_args arg = { cm, xd, r, blk, &eobtotal, NULL };
+
+    for (plane = 0; plane < MAX_MB_PLANE; ++plane) {
+      struct macroblockd_plane *const pd = &xd->plane[plane];
+      const BLOCK_SIZE plane_bsize = get_plane_block_size(bsize, pd);
+      const int num_4x4 = num_4x4_blocks_wide_lookup[plane_bsize] *
+                          num_4x4_blocks_high_lookup[plane_bsize];
+      blk->dqcoeff[plane] = row_buf->dqcoeff + row_buf->num_dqcoeff;
+      blk->eobs[plane] = row_buf->eobs + row_buf->num_eobs;
+      row_buf->num_dqcoeff += 16 * num_4x4;
+      row_buf->num_eobs += num_4x4;
+      pd->dqcoeff = blk->dqcoeff[plane];
+    }
+
+    vp9_foreach_transformed_block(xd, bsize, parse_block_tokens, &arg);
+    if (is_inter_block(mbmi) && mbmi->sb_type >= BLOCK_8X8 && eobtotal == 0)
+      mbmi->skip = 1;  // skip loopfilter
+  }
+}
+
+// Stage two of the decoding: predicts and reconstructs a block parsed by
+// parse_block(). The 4x4 transforms of inter blocks may be left queued in
+// idct_batch, which has to be flushed before the pixels are used.
+static void reconstruct_block(VP9_COMMON *const cm, MACROBLOCKD *const xd,
+                              VP9Idct4x4Batch *const idct_batch,
+                              const VP9DecBlock *const blk) {
+  const int bw = num_8x8_blocks_wide_lookup[blk->bsize];
+  const int bh = num_8x8_blocks_high_lookup[blk->bsize];
+  const int mi_row = blk->mi_row;
+  const int mi_col = blk->mi_col;
+  const MB_MODE_INFO *mbmi;
+  int plane;
+
+  xd->mi = cm->mi_grid_visible + mi_row * cm->mi_stride + mi_col;
+  mbmi = &xd->mi[0]->mbmi;
+  set_mi_row_col(xd, blk->tile, mi_row, bh, mi_col, bw,
+                 cm->mi_rows, cm->mi_cols);
+  vp9_setup_dst_planes(xd, get_frame_new_buffer(cm), mi_row, mi_col);
+  for (plane = 0; plane < MAX_MB_PLANE; ++plane)
+    xd->plane[plane].dqcoeff = blk->dqcoeff[plane];
+
+  if (!is_inter_block(mbmi)) {
+    struct intra_args arg = { cm, xd, NULL, blk };
+    // Intra prediction reads the neighbouring pixels.
+    if (idct_batch != NULL)
+      flush_idct4x4_batches(idct_batch);
+    vp9_foreach_transformed_block(xd, blk->bsize,
+                                  predict_and_reconstruct_intra_block, &arg);
+  } else {
+    int ref;
+    for (ref = 0; ref < 1 + has_second_ref(mbmi); ++ref) {
+      RefBuffer *const ref_buf =
+          &cm->frame_refs[mbmi->ref_frame[ref] - LAST_FRAME];
+      xd->block_refs[ref] = ref_buf;
+      vp9_setup_pre_planes(xd, ref, ref_buf->buf, mi_row, mi_col,
+                           &ref_buf->sf);
+    }
+
+    vp9_dec_build_inter_predictors_sb(xd, mi_row, mi_col, blk->bsize);
+
+    if (!mbmi->skip) {
+      int eobtotal = 0;
+      struct inter_args arg = { cm, xd, NULL, blk, &eobtotal, idct_batch };
+      vp9_foreach_transformed_block(xd, blk->bsize, reconstruct_inter_block,
+                                    &arg);
+    }
+  }
+}
+
 static void decode_block(VP9_COMMON *const cm, MACROBLOCKD *const xd,
+                         FrameWorkerData *const fwd,
+                         VP9DecRowBuffer *const row_buf,
                          const TileInfo *const tile,
                          int mi_row, int mi_col,
                          vp9_reader *r, BLOCK_SIZE bsize) {
@@ -352,8 +548,10 @@ static void decode_block(VP9_COMMON *const cm, MACROBLOCKD *const xd,
                                                   cm->base_qindex));
   }
 
-  if (!is_inter_block(mbmi)) {
-    struct intra_args arg = { cm, xd, r };
+  if (row_buf != NULL) {
+    parse_block(cm, xd, row_buf, tile, mi_row, mi_col, r, bsize);
+  } else if (!is_inter_block(mbmi)) {
+    struct intra_args arg = { cm, xd, r, NULL };
     vp9_foreach_transformed_block(xd, bsize,
                                   predict_and_reconstruct_intra_block, &arg);
   } else {
@@ -362,14 +560,21 @@ static void decode_block(VP9_COMMON *const cm, MACROBLOCKD *const xd,
     if (has_second_ref(mbmi))
       set_ref(cm, xd, 1, mi_row, mi_col);
 
+    if (fwd != NULL)
+      wait_for_ref_rows(fwd, cm, xd->mi[0], mi_row, bsize);
+
     // Prediction
     vp9_dec_build_inter_predictors_sb(xd, mi_row, mi_col, bsize);
 
     // Reconstruction
     if (!mbmi->skip) {
       int eobtotal = 0;
-      struct inter_args arg = { cm, xd, r, &eobtotal };
+      VP9Idct4x4Batch idct_batch[MAX_MB_PLANE];
+      struct inter_args arg = { cm, xd, r, NULL, &eobtotal,
+                                BATCH_IDCT4X4 ? idct_batch : NULL };
+      vp9_zero(idct_batch);
       vp9_foreach_transformed_block(xd, bsize, reconstruct_inter_block, &arg);
+      flush_idct4x4_batches(idct_batch);
       if (!less8x8 && eobtotal == 0)
         mbmi->skip = 1;  // skip loopfilter
     }
@@ -403,6 +608,8 @@ static PARTITION_TYPE read_partition(VP9_COMMON *cm, MACROBLOCKD *xd, int hbs,
 }
 
 static void decode_partition(VP9_COMMON *const cm, MACROBLOCKD *const xd,
+                             FrameWorkerData *const fwd,
+                             VP9DecRowBuffer *const row_buf,
                              const TileInfo *const tile,
                              int mi_row, int mi_col,
                              vp9_reader* r, BLOCK_SIZE bsize) {
@@ -416,27 +623,33 @@ static void decode_partition(VP9_COMMON *const cm, MACROBLOCKD *const xd,
   partition = read_partition(cm, xd, hbs, mi_row, mi_col, bsize, r);
   subsize = get_subsize(bsize, partition);
   if (subsize < BLOCK_8X8) {
-    decode_block(cm, xd, tile, mi_row, mi_col, r, subsize);
+    decode_block(cm, xd, fwd, row_buf, tile, mi_row, mi_col, r, subsize);
   } else {
     switch (partition) {
       case PARTITION_NONE:
-        decode_block(cm, xd, tile, mi_row, mi_col, r, subsize);
+        decode_block(cm, xd, fwd, row_buf, tile, mi_row, mi_col, r, subsize);
         break;
       case PARTITION_HORZ:
-        decode_block(cm, xd, tile, mi_row, mi_col, r, subsize);
+        decode_block(cm, xd, fwd, row_buf, tile, mi_row, mi_col, r, subsize);
         if (mi_row + hbs < cm->mi_rows)
-          decode_block(cm, xd, tile, mi_row + hbs, mi_col, r, subsize);
+          decode_block(cm, xd, fwd, row_buf, tile, mi_row + hbs, mi_col, r,
+                       subsize);
         break;
       case PARTITION_VERT:
-        decode_block(cm, xd, tile, mi_row, mi_col, r, subsize);
+        decode_block(cm, xd, fwd, row_buf, tile, mi_row, mi_col, r, subsize);
         if (mi_col + hbs < cm->mi_cols)
-          decode_block(cm, xd, tile, mi_row, mi_col + hbs, r, subsize);
+          decode_block(cm, xd, fwd, row_buf, tile, mi_row, mi_col + hbs, r,
+                       subsize);
         break;
       case PARTITION_SPLIT:
-        decode_partition(cm, xd, tile, mi_row,       mi_col,       r, subsize);
-        decode_partition(cm, xd, tile, mi_row,       mi_col + hbs, r, subsize);
-        decode_partition(cm, xd, tile, mi_row + hbs, mi_col,       r, subsize);
-        decode_partition(cm, xd, tile, mi_row + hbs, mi_col + hbs, r, subsize);
+        decode_partition(cm, xd, fwd, row_buf, tile, mi_row, mi_col, r,
+                         subsize);
+        decode_partition(cm, xd, fwd, row_buf, tile, mi_row, mi_col + hbs, r,
+                         subsize);
+        decode_partition(cm, xd, fwd, row_buf, tile, mi_row + hbs, mi_col, r,
+                         subsize);
+        decode_partition(cm, xd, fwd, row_buf, tile, mi_row + hbs,
+                         mi_col + hbs, r, subsize);
         break;
       default:
         assert(0 && "Invalid partition type");
@@ -614,8 +827,44 @@ static void setup_display_size(VP9_COMMON *cm, struct vp9_read_bit_buffer *rb) {
     read_frame_size(rb, &cm->display_width, &cm->display_height);
 }
 
-static void apply_frame_size(VP9_COMMON *cm, int width, int height) {
+// Returns the frame worker data of the i-th oldest frame in flight.
+static FrameWorkerData *get_frame_in_flight(const VP9D_COMP *pbi, int i) {
+  const int n = (pbi->oldest_frame_worker + i) % pbi->num_frame_workers;
+  return (FrameWorkerData *)pbi->frame_workers[n].data1;
+}
+
+// Returns 1 if a frame in flight reads or writes the segmentation map.
+static int seg_map_in_use(const VP9D_COMP *pbi) {
+  int i;
+  for (i = 0; i < pbi->frames_in_flight; ++i)
+    if (get_frame_in_flight(pbi, i)->cm.seg.enabled)
+      return 1;
+  return 0;
+}
+
+// Returns 1 if a frame in flight has yet to write back its adapted context.
+static int frame_context_pending(const VP9D_COMP *pbi) {
+  int i;
+  for (i = 0; i < pbi->frames_in_flight; ++i)
+    if (get_frame_in_flight(pbi, i)->refresh_frame_context)
+      return 1;
+  return 0;
+}
+
+// Retires all frames in flight. Their errors are reported once the current
+// frame has been decoded.
+static void wait_frame_workers(VP9D_COMP *pbi) {
+  while (pbi->frames_in_flight > 0)
+    vp9_retire_frame_worker(pbi);
+}
+
+static void apply_frame_size(VP9D_COMP *pbi, int width, int height) {
+  VP9_COMMON *const cm = &pbi->common;
   if (cm->width != width || cm->height != height) {
+    // The segmentation map is shared with the frames in flight.
+    if (pbi->oxcf.frame_parallel_decode && seg_map_in_use(pbi))
+      wait_frame_workers(pbi);
+
     // Change in frame size.
     // TODO(agrange) Don't test width/height, check overall size.
     if (width > cm->width || height > cm->height) {
@@ -641,15 +890,16 @@ static void apply_frame_size(VP9_COMMON *cm, int width, int height) {
   }
 }
 
-static void setup_frame_size(VP9_COMMON *cm, struct vp9_read_bit_buffer *rb) {
+static void setup_frame_size(VP9D_COMP *pbi, struct vp9_read_bit_buffer *rb) {
   int width, height;
   read_frame_size(rb, &width, &height);
-  apply_frame_size(cm, width, height);
-  setup_display_size(cm, rb);
+  apply_frame_size(pbi, width, height);
+  setup_display_size(&pbi->common, rb);
 }
 
-static void setup_frame_size_with_refs(VP9_COMMON *cm,
+static void setup_frame_size_with_refs(VP9D_COMP *pbi,
                                        struct vp9_read_bit_buffer *rb) {
+  VP9_COMMON *const cm = &pbi->common;
   int width, height;
   int found = 0, i;
   for (i = 0; i < REFS_PER_FRAME; ++i) {
@@ -669,7 +919,7 @@ static void setup_frame_size_with_refs(VP9_COMMON *cm,
     vpx_internal_error(&cm->error, VPX_CODEC_CORRUPT_FRAME,
                        "Referenced frame with invalid size");
 
-  apply_frame_size(cm, width, height);
+  apply_frame_size(pbi, width, height);
   setup_display_size(cm, rb);
 }
 
@@ -697,7 +947,8 @@ static void decode_tile(VP9D_COMP *pbi, const TileInfo *const tile,
     vp9_zero(xd->left_seg_context);
     for (mi_col = tile->mi_col_start; mi_col < tile->mi_col_end;
          mi_col += MI_BLOCK_SIZE) {
-      decode_partition(cm, xd, tile, mi_row, mi_col, r, BLOCK_64X64);
+      decode_partition(cm, xd, NULL, NULL, tile, mi_row, mi_col, r,
+                       BLOCK_64X64);
     }
 
     if (pbi->do_loopfilter_inline) {
@@ -847,7 +1098,7 @@ static int tile_worker_hook(void *arg1, void *arg2) {
     vp9_zero(tile_data->xd.left_seg_context);
     for (mi_col = tile->mi_col_start; mi_col < tile->mi_col_end;
          mi_col += MI_BLOCK_SIZE) {
-      decode_partition(tile_data->cm, &tile_data->xd, tile,
+      decode_partition(tile_data->cm, &tile_data->xd, NULL, NULL, tile,
                        mi_row, mi_col, &tile_data->bit_reader, BLOCK_64X64);
     }
   }
@@ -993,6 +1244,424 @@ static const uint8_t *decode_tiles_mt(VP9D_COMP *pbi,
   return bit_reader_end;
 }
 
+// Stage two of the decoding: reconstructs the superblock rows start,
+// start + step, ... Superblock c of a row is reconstructed once it has been
+// parsed and the row above is done up to c + 1. The row above is loop
+// filtered one superblock behind, which keeps the pixels used by intra
+// prediction unfiltered and filters the superblocks in a valid order.
+static int row_worker_hook(void *arg1, void *arg2) {
+  RowWorkerData *const row_data = (RowWorkerData *)arg1;
+  VP9_COMMON *const cm = &row_data->pbi->common;
+  VP9RowMTData *const row_mt = &row_data->pbi->row_mt;
+  LFWorkerData *const lf_data = &row_data->lfdata;
+  const int do_loopfilter = cm->lf.filter_level != 0;
+  const int sb_rows = row_mt->sb_rows;
+  const int sb_cols = row_mt->sb_cols;
+  int sb_row, sb_col;
+  (void)arg2;
+
+  for (sb_row = row_data->start; sb_row < sb_rows;
+       sb_row += row_data->step) {
+    const VP9DecRowBuffer *const row_buf =
+        &row_mt->rows[sb_row % row_mt->num_rows];
+    const int mi_row = sb_row << MI_BLOCK_SIZE_LOG2;
+    int i = 0;
+
+    for (sb_col = 0; sb_col < sb_cols; ++sb_col) {
+      vp9_row_sync_read(&row_mt->parse_sync, sb_row + 1, sb_col);
+      vp9_row_sync_read(&row_mt->recon_sync, sb_row, sb_col);
+
+      if (!row_mt->abort) {
+        for (; i < row_buf->sb_block_end[sb_col]; ++i)
+          reconstruct_block(cm, &row_data->xd,
+                            BATCH_IDCT4X4 ? row_data->idct_batch : NULL,
+                            &row_buf->blocks[i]);
+        if (BATCH_IDCT4X4)
+          flush_idct4x4_batches(row_data->idct_batch);
+
+        if (do_loopfilter && sb_row > 0) {
+          if (sb_col > 0)
+            vp9_loop_filter_sb(lf_data->frame_buffer, cm, &lf_data->xd,
+                               mi_row - MI_BLOCK_SIZE,
+                               (sb_col - 1) << MI_BLOCK_SIZE_LOG2, 0);
+          if (sb_col == sb_cols - 1)
+            vp9_loop_filter_sb(lf_data->frame_buffer, cm, &lf_data->xd,
+                               mi_row - MI_BLOCK_SIZE,
+                               sb_col << MI_BLOCK_SIZE_LOG2, 0);
+        }
+      }
+
+      vp9_row_sync_write(&row_mt->recon_sync, sb_row, sb_col, sb_cols);
+    }
+
+    // Nothing is left to wait for before filtering the last row.
+    if (do_loopfilter && sb_row == sb_rows - 1 && !row_mt->abort)
+      vp9_loop_filter_rows(lf_data->frame_buffer, cm, &lf_data->xd,
+                           mi_row, cm->mi_rows, 0);
+  }
+  return 1;
+}
+
+// Decodes the tiles in two stages. Stage one parses the tiles on the calling
+// thread one superblock row at a time, across all tile columns, into the row
+// buffers. Stage two reconstructs and loop filters the parsed rows. With
+// row-based multi-threading it runs on the row workers while the following
+// rows are parsed, using a ring of a few row buffers. In two-stage mode the
+// whole frame is buffered and, without worker threads, stage two runs on the
+// calling thread once the frame has been parsed.
+static const uint8_t *decode_tiles_two_stage(VP9D_COMP *pbi,
+                                             const uint8_t *data,
+                                             const uint8_t *data_end,
+                                             int whole_frame) {
+  VP9_COMMON *const cm = &pbi->common;
+  MACROBLOCKD *const xd = &pbi->mb;
+  VP9RowMTData *const row_mt = &pbi->row_mt;
+  const int aligned_cols = mi_cols_aligned_to_sb(cm->mi_cols);
+  const int tile_cols = 1 << cm->log2_tile_cols;
+  const int tile_rows = 1 << cm->log2_tile_rows;
+  const int sb_rows = mi_cols_aligned_to_sb(cm->mi_rows) >> MI_BLOCK_SIZE_LOG2;
+  const int num_workers = CONFIG_MULTITHREAD && pbi->oxcf.max_threads > 1 ?
+                          MIN(pbi->oxcf.max_threads - 1, sb_rows) : 0;
+  TileInfo tiles[1 << 6];
+  vp9_reader tile_readers[1 << 6];
+  int tile_row, tile_col, mi_row, mi_col, i;
+  const uint8_t *end = NULL;
+
+  assert(tile_rows <= 4);
+  assert(tile_cols <= (1 << 6));
+
+  // Without threads a single worker runs stage two on the calling thread.
+  if (MAX(num_workers, 1) > pbi->num_row_workers) {
+    const int total_workers = MAX(num_workers, 1);
+    CHECK_MEM_ERROR(cm, pbi->row_workers,
+                    vpx_realloc(pbi->row_workers,
+                                total_workers * sizeof(*pbi->row_workers)));
+    for (i = pbi->num_row_workers; i < total_workers; ++i) {
+      VP9Worker *const worker = &pbi->row_workers[i];
+      ++pbi->num_row_workers;
+
+      vp9_worker_init(worker);
+      CHECK_MEM_ERROR(cm, worker->data1,
+                      vpx_memalign(32, sizeof(RowWorkerData)));
+      worker->hook = (VP9WorkerHook)row_worker_hook;
+      if (num_workers > 0 && !vp9_worker_reset(worker)) {
+        vpx_internal_error(&cm->error, VPX_CODEC_ERROR,
+                           "Row decoder thread creation failed");
+      }
+    }
+  }
+
+  // One row being parsed and one spare for each row being reconstructed.
+  vp9_row_mt_alloc(cm, row_mt, whole_frame ? sb_rows :
+                                   MIN(2 * num_workers + 1, sb_rows));
+
+  // Note: this memset assumes above_context[0], [1] and [2]
+  // are allocated as part of the same buffer.
+  vpx_memset(cm->above_context, 0,
+             sizeof(*cm->above_context) * MAX_MB_PLANE * 2 * aligned_cols);
+  vpx_memset(cm->above_seg_context, 0,
+             sizeof(*cm->above_seg_context) * aligned_cols);
+
+  vpx_memset(row_mt->parse_sync.cur_sb_col, -1,
+             sizeof(*row_mt->parse_sync.cur_sb_col) * sb_rows);
+  vpx_memset(row_mt->recon_sync.cur_sb_col, -1,
+             sizeof(*row_mt->recon_sync.cur_sb_col) * sb_rows);
+
+  if (cm->lf.filter_level)
+    vp9_loop_filter_frame_init(cm, cm->lf.filter_level);
+
+  for (i = 0; i < MAX(num_workers, 1); ++i) {
+    VP9Worker *const worker = &pbi->row_workers[i];
+    RowWorkerData *const row_data = (RowWorkerData *)worker->data1;
+    LFWorkerData *const lf_data = &row_data->lfdata;
+
+    row_data->pbi = pbi;
+    row_data->xd = pbi->mb;
+    row_data->start = i;
+    row_data->step = MAX(num_workers, 1);
+    vp9_zero(row_data->idct_batch);
+    lf_data->frame_buffer = get_frame_new_buffer(cm);
+    lf_data->cm = cm;
+    lf_data->xd = pbi->mb;
+    lf_data->y_only = 0;
+
+    worker->had_error = 0;
+    if (num_workers > 0)
+      vp9_worker_launch(worker);
+  }
+  row_mt->active = 1;
+
+  for (tile_row = 0; tile_row < tile_rows; ++tile_row) {
+    for (tile_col = 0; tile_col < tile_cols; ++tile_col) {
+      const int last_tile = tile_row == tile_rows - 1 &&
+                            tile_col == tile_cols - 1;
+      const size_t size = get_tile(data_end, last_tile, &cm->error, &data);
+      vp9_tile_init(&tiles[tile_col], cm, tile_row, tile_col);
+      setup_token_decoder(data, data_end, size, &cm->error,
+                          &tile_readers[tile_col]);
+      data += size;
+    }
+
+    for (mi_row = tiles[0].mi_row_start; mi_row < tiles[0].mi_row_end;
+         mi_row += MI_BLOCK_SIZE) {
+      const int sb_row = mi_row >> MI_BLOCK_SIZE_LOG2;
+      VP9DecRowBuffer *const row_buf =
+          &row_mt->rows[sb_row % row_mt->num_rows];
+
+      // Wait for the row that used the buffer before to be reconstructed.
+      if (sb_row >= row_mt->num_rows)
+        vp9_row_sync_wait_row(&row_mt->recon_sync,
+                              sb_row - row_mt->num_rows, row_mt->sb_cols);
+
+      vpx_memcpy(row_buf->tiles, tiles, tile_cols * sizeof(tiles[0]));
+      row_buf->num_blocks = 0;
+      row_buf->num_dqcoeff = 0;
+      row_buf->num_eobs = 0;
+
+      for (tile_col = 0; tile_col < tile_cols; ++tile_col) {
+        const TileInfo *const tile = &row_buf->tiles[tile_col];
+        vp9_zero(xd->left_context);
+        vp9_zero(xd->left_seg_context);
+        for (mi_col = tile->mi_col_start; mi_col < tile->mi_col_end;
+             mi_col += MI_BLOCK_SIZE) {
+          const int sb_col = mi_col >> MI_BLOCK_SIZE_LOG2;
+          decode_partition(cm, xd, NULL, row_buf, tile, mi_row, mi_col,
+                           &tile_readers[tile_col], BLOCK_64X64);
+          row_buf->sb_block_end[sb_col] = row_buf->num_blocks;
+          vp9_row_sync_write(&row_mt->parse_sync, sb_row, sb_col,
+                             row_mt->sb_cols);
+        }
+      }
+    }
+  }
+  end = vp9_reader_find_end(&tile_readers[tile_cols - 1]);
+
+  if (num_workers > 0) {
+    for (i = 0; i < num_workers; ++i)
+      vp9_worker_sync(&pbi->row_workers[i]);
+  } else {
+    vp9_worker_execute(&pbi->row_workers[0]);
+  }
+  row_mt->active = 0;
+
+  return end;
+}
+
+// Frame-based multi-threading: decodes the tiles of a frame on a frame
+// worker. The tile columns are decoded one superblock row at a time and the
+// loop filter follows one row behind, so that the progress of the frame can
+// be published to the frames that use it as a reference.
+static void decode_tiles_fp(FrameWorkerData *const fwd) {
+  VP9_COMMON *const cm = &fwd->cm;
+  MACROBLOCKD *const xd = &fwd->xd;
+  LFWorkerData *const lf_data = &fwd->lfdata;
+  const uint8_t *data = fwd->data;
+  const uint8_t *const data_end = fwd->data + fwd->data_size;
+  const int aligned_cols = mi_cols_aligned_to_sb(cm->mi_cols);
+  const int tile_cols = 1 << cm->log2_tile_cols;
+  const int tile_rows = 1 << cm->log2_tile_rows;
+  const int fb_idx = cm->new_fb_idx;
+  TileInfo tiles[1 << 6];
+  vp9_reader tile_readers[1 << 6];
+  int tile_row, tile_col, mi_row, mi_col;
+
+  assert(tile_rows <= 4);
+  assert(tile_cols <= (1 << 6));
+
+  vpx_memset(cm->above_context, 0,
+             sizeof(*cm->above_context) * MAX_MB_PLANE * 2 * aligned_cols);
+  vpx_memset(cm->above_seg_context, 0,
+             sizeof(*cm->above_seg_context) * aligned_cols);
+
+  if (cm->lf.filter_level) {
+    lf_data->frame_buffer = get_frame_new_buffer(cm);
+    lf_data->cm = cm;
+    lf_data->xd = *xd;
+    lf_data->y_only = 0;
+    vp9_loop_filter_frame_init(cm, cm->lf.filter_level);
+  }
+
+  for (tile_row = 0; tile_row < tile_rows; ++tile_row) {
+    for (tile_col = 0; tile_col < tile_cols; ++tile_col) {
+      const int last_tile = tile_row == tile_rows - 1 &&
+                            tile_col == tile_cols - 1;
+      const size_t size = get_tile(data_end, last_tile, &cm->error, &data);
+      vp9_tile_init(&tiles[tile_col], cm, tile_row, tile_col);
+      setup_token_decoder(data, data_end, size, &cm->error,
+                          &tile_readers[tile_col]);
+      data += size;
+    }
+
+    for (mi_row = tiles[0].mi_row_start; mi_row < tiles[0].mi_row_end;
+         mi_row += MI_BLOCK_SIZE) {
+      const int sb_row = mi_row >> MI_BLOCK_SIZE_LOG2;
+
+      // The previous frame has parsed this row (it updated its segmentation
+      // map and mode info) once it published the row below it.
+      if (fwd->prev_fb_idx >= 0)
+        vp9_frame_sync_wait(fwd->frame_sync, fwd->prev_fb_idx,
+                            ((sb_row + 1) << 6) - 17);
+
+      for (tile_col = 0; tile_col < tile_cols; ++tile_col) {
+        const TileInfo *const tile = &tiles[tile_col];
+        vp9_zero(xd->left_context);
+        vp9_zero(xd->left_seg_context);
+        for (mi_col = tile->mi_col_start; mi_col < tile->mi_col_end;
+             mi_col += MI_BLOCK_SIZE)
+          decode_partition(cm, xd, fwd, NULL, tile, mi_row, mi_col,
+                           &tile_readers[tile_col], BLOCK_64X64);
+      }
+
+      if (cm->lf.filter_level) {
+        // Filtering a row changes at most the 8 luma (16 in luma units for
+        // chroma) rows above it.
+        if (mi_row > 0) {
+          lf_data->start = mi_row - MI_BLOCK_SIZE;
+          lf_data->stop = mi_row;
+          vp9_loop_filter_worker(lf_data, NULL);
+          vp9_frame_sync_signal(fwd->frame_sync, fb_idx, (sb_row << 6) - 16);
+        }
+      } else {
+        vp9_frame_sync_signal(fwd->frame_sync, fb_idx, (sb_row + 1) << 6);
+      }
+    }
+  }
+
+  if (cm->lf.filter_level) {
+    lf_data->start = ((cm->mi_rows - 1) >> MI_BLOCK_SIZE_LOG2) <<
+                     MI_BLOCK_SIZE_LOG2;
+    lf_data->stop = cm->mi_rows;
+    vp9_loop_filter_worker(lf_data, NULL);
+  }
+}
+
+static int frame_worker_hook(void *arg1, void *arg2) {
+  FrameWorkerData *const fwd = (FrameWorkerData *)arg1;
+  VP9_COMMON *const cm = &fwd->cm;
+  YV12_BUFFER_CONFIG *const new_fb = get_frame_new_buffer(cm);
+  (void)arg2;
+
+  if (setjmp(cm->error.jmp)) {
+    cm->error.setjmp = 0;
+    new_fb->corrupted = 1;
+    vp9_frame_sync_signal(fwd->frame_sync, cm->new_fb_idx, INT_MAX);
+    return 0;
+  }
+
+  cm->error.setjmp = 1;
+  decode_tiles_fp(fwd);
+  new_fb->corrupted |= fwd->xd.corrupted;
+  vp9_frame_sync_signal(fwd->frame_sync, cm->new_fb_idx, INT_MAX);
+
+  if (!cm->error_resilient_mode && !cm->frame_parallel_decoding_mode) {
+    vp9_adapt_coef_probs(cm);
+
+    if (!frame_is_intra_only(cm)) {
+      vp9_adapt_mode_probs(cm);
+      vp9_adapt_mv_probs(cm, cm->allow_high_precision_mv);
+    }
+  }
+
+  cm->error.setjmp = 0;
+  return 1;
+}
+
+// Hands the tiles of the current frame over to the next frame worker. The
+// worker gets a copy of the decoder state and its own mode info; the frame
+// buffers it uses are held until it is retired.
+static void launch_frame_worker(VP9D_COMP *pbi, const uint8_t *data,
+                                const uint8_t *data_end) {
+  VP9_COMMON *const cm = &pbi->common;
+  const size_t size = data_end - data;
+  const FrameWorkerData *prev_fwd = NULL;
+  VP9Worker *worker;
+  FrameWorkerData *fwd;
+  VP9_COMMON *frame_cm;
+  int worker_idx, i;
+
+  // A worker's mode info is read by the frame decoded after it, so both have
+  // to be retired before the worker can be reused.
+  while (pbi->frames_in_flight > pbi->num_frame_workers - 2)
+    vp9_retire_frame_worker(pbi);
+
+  worker_idx = (pbi->oldest_frame_worker + pbi->frames_in_flight) %
+               pbi->num_frame_workers;
+  worker = &pbi->frame_workers[worker_idx];
+  fwd = (FrameWorkerData *)worker->data1;
+  frame_cm = &fwd->cm;
+
+  if (size > fwd->data_alloc_size) {
+    vpx_free(fwd->data);
+    fwd->data_alloc_size = 0;
+    CHECK_MEM_ERROR(cm, fwd->data, (uint8_t *)vpx_malloc(size));
+    fwd->data_alloc_size = size;
+  }
+  vpx_memcpy(fwd->data, data, size);
+  fwd->data_size = size;
+
+  vp9_frame_worker_alloc(cm, fwd);
+
+  if (pbi->last_frame_worker >= 0)
+    prev_fwd = (const FrameWorkerData *)
+        pbi->frame_workers[pbi->last_frame_worker].data1;
+
+  *frame_cm = *cm;
+  frame_cm->error.setjmp = 0;
+  frame_cm->mip = fwd->mip;
+  frame_cm->mi = fwd->mip + cm->mi_stride + 1;
+  frame_cm->mi_grid_base = fwd->mi_grid_base;
+  frame_cm->mi_grid_visible = fwd->mi_grid_base + cm->mi_stride + 1;
+  frame_cm->above_context = fwd->above_context;
+  frame_cm->above_seg_context = fwd->above_seg_context;
+
+  frame_cm->prev_mip = NULL;
+  frame_cm->prev_mi = NULL;
+  frame_cm->prev_mi_grid_base = NULL;
+  frame_cm->prev_mi_grid_visible = NULL;
+  if (cm->coding_use_prev_mi && prev_fwd != NULL) {
+    set_prev_mi(cm);
+    if (cm->prev_mi != NULL) {
+      frame_cm->prev_mip = prev_fwd->mip;
+      frame_cm->prev_mi = prev_fwd->mip + cm->mi_stride + 1;
+      frame_cm->prev_mi_grid_base = prev_fwd->mi_grid_base;
+      frame_cm->prev_mi_grid_visible =
+          prev_fwd->mi_grid_base + cm->mi_stride + 1;
+    }
+  }
+
+  fwd->xd = pbi->mb;
+  init_macroblockd(frame_cm, &fwd->xd);
+  setup_plane_dequants(frame_cm, &fwd->xd, frame_cm->base_qindex);
+  fwd->xd.cur_buf = get_frame_new_buffer(frame_cm);
+  fwd->xd.corrupted = 0;
+
+  fwd->refresh_frame_context = cm->refresh_frame_context &&
+                               !cm->error_resilient_mode &&
+                               !cm->frame_parallel_decoding_mode;
+
+  fwd->prev_fb_idx = pbi->frames_in_flight > 0 && prev_fwd != NULL ?
+                     prev_fwd->cm.new_fb_idx : -1;
+
+  fwd->num_held_fbs = 0;
+  fwd->held_fb_idx[fwd->num_held_fbs++] = cm->new_fb_idx;
+  if (fwd->prev_fb_idx >= 0)
+    fwd->held_fb_idx[fwd->num_held_fbs++] = fwd->prev_fb_idx;
+  if (!frame_is_intra_only(cm))
+    for (i = 0; i < REFS_PER_FRAME; ++i)
+      fwd->held_fb_idx[fwd->num_held_fbs++] = cm->frame_refs[i].idx;
+  for (i = 0; i < fwd->num_held_fbs; ++i)
+    vp9_ref_frame_buffer(pbi, fwd->held_fb_idx[i]);
+
+  vp9_frame_sync_signal(&pbi->frame_sync, cm->new_fb_idx, 0);
+
+  worker->hook = (VP9WorkerHook)frame_worker_hook;
+  worker->had_error = 0;
+  vp9_worker_launch(worker);
+
+  pbi->last_frame_worker = worker_idx;
+  ++pbi->frames_in_flight;
+}
+
 static void check_sync_code(VP9_COMMON *cm, struct vp9_read_bit_buffer *rb) {
   if (vp9_rb_read_literal(rb, 8) != VP9_SYNC_CODE_0 ||
       vp9_rb_read_literal(rb, 8) != VP9_SYNC_CODE_1 ||
@@ -1078,7 +1747,7 @@ static size_t read_uncompressed_header(VP9D_COMP *pbi,
       cm->frame_refs[i].buf = get_frame_new_buffer(cm);
     }
 
-    setup_frame_size(cm, rb);
+    setup_frame_size(pbi, rb);
   } else {
     cm->intra_only = cm->show_frame ? 0 : vp9_rb_read_bit(rb);
 
@@ -1089,7 +1758,7 @@ static size_t read_uncompressed_header(VP9D_COMP *pbi,
       check_sync_code(cm, rb);
 
       pbi->refresh_frame_flags = vp9_rb_read_literal(rb, REF_FRAMES);
-      setup_frame_size(cm, rb);
+      setup_frame_size(pbi, rb);
     } else {
       pbi->refresh_frame_flags = vp9_rb_read_literal(rb, REF_FRAMES);
 
@@ -1101,7 +1770,7 @@ static size_t read_uncompressed_header(VP9D_COMP *pbi,
         cm->ref_frame_sign_bias[LAST_FRAME + i] = vp9_rb_read_bit(rb);
       }
 
-      setup_frame_size_with_refs(cm, rb);
+      setup_frame_size_with_refs(pbi, rb);
 
       cm->allow_high_precision_mv = vp9_rb_read_bit(rb);
       cm->interp_filter = read_interp_filter(rb);
@@ -1112,8 +1781,12 @@ static size_t read_uncompressed_header(VP9D_COMP *pbi,
                                           ref_buf->buf->y_crop_width,
                                           ref_buf->buf->y_crop_height,
                                           cm->width, cm->height);
-        if (vp9_is_scaled(&ref_buf->sf))
+        if (vp9_is_scaled(&ref_buf->sf)) {
+          // The reference may still be decoded by a frame in flight.
+          if (pbi->oxcf.frame_parallel_decode)
+            vp9_frame_sync_wait(&pbi->frame_sync, ref_buf->idx, INT_MAX - 1);
           vp9_extend_frame_borders(ref_buf->buf);
+        }
       }
     }
   }
@@ -1132,8 +1805,11 @@ static size_t read_uncompressed_header(VP9D_COMP *pbi,
   // below, forcing the use of context 0 for those frame types.
   cm->frame_context_idx = vp9_rb_read_literal(rb, FRAME_CONTEXTS_LOG2);
 
-  if (frame_is_intra_only(cm) || cm->error_resilient_mode)
+  if (frame_is_intra_only(cm) || cm->error_resilient_mode) {
+    if (pbi->oxcf.frame_parallel_decode && seg_map_in_use(pbi))
+      wait_frame_workers(pbi);
     vp9_setup_past_independence(cm);
+  }
 
   setup_loopfilter(&cm->lf, rb);
   setup_quantization(cm, &pbi->mb, rb);
@@ -1254,18 +1930,31 @@ int vp9_decode_frame(VP9D_COMP *pbi,
                      const uint8_t **p_data_end) {
   VP9_COMMON *const cm = &pbi->common;
   MACROBLOCKD *const xd = &pbi->mb;
-
   struct vp9_read_bit_buffer rb = { data, data_end, 0, cm, error_handler };
-  const size_t first_partition_size = read_uncompressed_header(pbi, &rb);
-  const int keyframe = cm->frame_type == KEY_FRAME;
-  const int tile_rows = 1 << cm->log2_tile_rows;
-  const int tile_cols = 1 << cm->log2_tile_cols;
-  YV12_BUFFER_CONFIG *const new_fb = get_frame_new_buffer(cm);
+  size_t first_partition_size;
+  int keyframe, tile_rows, tile_cols, use_tile_mt, use_row_mt, two_stage;
+  YV12_BUFFER_CONFIG *new_fb;
+  struct vpx_usec_timer timer;
+
+  vpx_usec_timer_start(&timer);
+
+  // The frame header depends on the frame contexts adapted by the previous
+  // frame.
+  if (pbi->oxcf.frame_parallel_decode && frame_context_pending(pbi))
+    wait_frame_workers(pbi);
+
+  first_partition_size = read_uncompressed_header(pbi, &rb);
+  keyframe = cm->frame_type == KEY_FRAME;
+  tile_rows = 1 << cm->log2_tile_rows;
+  tile_cols = 1 << cm->log2_tile_cols;
+  new_fb = get_frame_new_buffer(cm);
   xd->cur_buf = new_fb;
 
   if (!first_partition_size) {
       // showing a frame directly
       *p_data_end = data + 1;
+      vpx_usec_timer_mark(&timer);
+      pbi->stage_times.header_us += vpx_usec_timer_elapsed(&timer);
       return 0;
   }
 
@@ -1277,9 +1966,21 @@ int vp9_decode_frame(VP9D_COMP *pbi,
     vpx_internal_error(&cm->error, VPX_CODEC_CORRUPT_FRAME,
                        "Truncated packet or corrupt header length");
 
-  pbi->do_loopfilter_inline =
-      (cm->log2_tile_rows | cm->log2_tile_cols) == 0 && cm->lf.filter_level;
-  if (pbi->do_loopfilter_inline && pbi->lf_worker.data1 == NULL) {
+  // TODO(jzern): remove frame_parallel_decoding_mode restriction for
+  // single-frame tile decoding.
+  use_tile_mt = pbi->oxcf.max_threads > 1 && tile_rows == 1 &&
+                tile_cols > 1 && cm->frame_parallel_decoding_mode;
+  use_row_mt = CONFIG_MULTITHREAD && pbi->oxcf.max_threads > 1 &&
+               !pbi->oxcf.frame_parallel_decode && !use_tile_mt;
+  two_stage = pbi->oxcf.two_stage_decode && !pbi->oxcf.frame_parallel_decode &&
+              !use_tile_mt;
+
+  // The loop filter is part of stage two.
+  pbi->do_loopfilter_inline = !pbi->oxcf.frame_parallel_decode &&
+      ((cm->log2_tile_rows | cm->log2_tile_cols) == 0 || use_row_mt ||
+       two_stage) && cm->lf.filter_level;
+  if (pbi->do_loopfilter_inline && !use_row_mt && !two_stage &&
+      pbi->lf_worker.data1 == NULL) {
     CHECK_MEM_ERROR(cm, pbi->lf_worker.data1,
                     vpx_memalign(32, sizeof(LFWorkerData)));
     pbi->lf_worker.hook = (VP9WorkerHook)vp9_loop_filter_worker;
@@ -1306,15 +2007,38 @@ int vp9_decode_frame(VP9D_COMP *pbi,
   xd->corrupted = 0;
   new_fb->corrupted = read_compressed_header(pbi, data, first_partition_size);
 
-  // TODO(jzern): remove frame_parallel_decoding_mode restriction for
-  // single-frame tile decoding.
-  if (pbi->oxcf.max_threads > 1 && tile_rows == 1 && tile_cols > 1 &&
-      cm->frame_parallel_decoding_mode) {
+  vpx_usec_timer_mark(&timer);
+  pbi->stage_times.header_us += vpx_usec_timer_elapsed(&timer);
+  vpx_usec_timer_start(&timer);
+
+  if (pbi->oxcf.frame_parallel_decode) {
+    launch_frame_worker(pbi, data + first_partition_size, data_end);
+    *p_data_end = data_end;
+    vpx_usec_timer_mark(&timer);
+    pbi->stage_times.tiles_us += vpx_usec_timer_elapsed(&timer);
+
+    // Corruption of the frame is only known once it has been retired.
+    if (keyframe)
+      pbi->decoded_key_frame = 1;
+
+    // Contexts adapted by the frame worker are written back on retirement.
+    if (cm->refresh_frame_context && cm->frame_parallel_decoding_mode)
+      cm->frame_contexts[cm->frame_context_idx] = cm->fc;
+    return 0;
+  }
+
+  if (use_tile_mt) {
     *p_data_end = decode_tiles_mt(pbi, data + first_partition_size, data_end);
+  } else if (use_row_mt || two_stage) {
+    *p_data_end = decode_tiles_two_stage(pbi, data + first_partition_size,
+                                         data_end, two_stage);
   } else {
     *p_data_end = decode_tiles(pbi, data + first_partition_size, data_end);
   }
 
+  vpx_usec_timer_mark(&timer);
+  pbi->stage_times.tiles_us += vpx_usec_timer_elapsed(&timer);
+
   new_fb->corrupted |= xd->corrupted;
 
   if (!pbi->decoded_key_frame) {
@@ -11,6 +11,7 @@
 #include <assert.h>
 #include <limits.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "./vpx_scale_rtcd.h"
 
@@ -124,6 +125,9 @@ VP9D_COMP *vp9_create_decompressor(const VP9D_CONFIG *oxcf) {
 
   if (setjmp(cm->error.jmp)) {
     cm->error.setjmp = 0;
+
+    // The row workers may still be reconstructing the rows parsed so far.
+    vp9_row_mt_abort(pbi);
     vp9_remove_decompressor(pbi);
     return NULL;
   }
@@ -144,11 +148,39 @@ VP9D_COMP *vp9_create_decompressor(const VP9D_CONFIG *oxcf) {
 
   vp9_loop_filter_init(cm);
 
-  cm->error.setjmp = 0;
   pbi->decoded_key_frame = 0;
 
   vp9_worker_init(&pbi->lf_worker);
 
+  pbi->last_frame_worker = -1;
+  if (pbi->oxcf.frame_parallel_decode) {
+    int i;
+
+    // The mode info of a worker is read by the frame decoded after it, so one
+    // more worker than frames in flight is needed.
+    pbi->num_frame_workers = MIN(pbi->oxcf.max_threads, MAX_FRAME_THREADS) + 1;
+    vp9_frame_sync_init(&pbi->frame_sync);
+    CHECK_MEM_ERROR(cm, pbi->frame_workers,
+                    vpx_calloc(pbi->num_frame_workers,
+                               sizeof(*pbi->frame_workers)));
+    for (i = 0; i < pbi->num_frame_workers; ++i) {
+      VP9Worker *const worker = &pbi->frame_workers[i];
+      FrameWorkerData *fwd;
+
+      vp9_worker_init(worker);
+      CHECK_MEM_ERROR(cm, worker->data1,
+                      vpx_memalign(32, sizeof(FrameWorkerData)));
+      fwd = (FrameWorkerData *)worker->data1;
+      vp9_zero(*fwd);
+      fwd->pbi = pbi;
+      fwd->frame_sync = &pbi->frame_sync;
+      if (!vp9_worker_reset(worker))
+        vpx_internal_error(&cm->error, VPX_CODEC_ERROR,
+                           "Frame decoder thread creation failed");
+    }
+  }
+
+  cm->error.setjmp = 0;
   return pbi;
 }
 
@@ -156,6 +188,21 @@ void vp9_remove_decompressor(VP9D_COMP *pbi) {
   VP9_COMMON *const cm = &pbi->common;
   int i;
 
+  // Frame workers may still be reading the frame buffers.
+  for (i = 0; i < pbi->num_frame_workers; ++i) {
+    VP9Worker *const worker = &pbi->frame_workers[i];
+    FrameWorkerData *const fwd = (FrameWorkerData *)worker->data1;
+    vp9_worker_end(worker);
+    if (fwd != NULL) {
+      vp9_frame_worker_dealloc(fwd);
+      vpx_free(fwd->data);
+    }
+    vpx_free(fwd);
+  }
+  vpx_free(pbi->frame_workers);
+  if (pbi->num_frame_workers)
+    vp9_frame_sync_destroy(&pbi->frame_sync);
+
   vp9_remove_common(cm);
   vp9_worker_end(&pbi->lf_worker);
   vpx_free(pbi->lf_worker.data1);
@@ -166,12 +213,15 @@ void vp9_remove_decompressor(VP9D_COMP *pbi) {
     vpx_free(worker->data2);
   }
   vpx_free(pbi->tile_workers);
-
-  if (pbi->num_tile_workers) {
-    const int sb_rows =
-        mi_cols_aligned_to_sb(cm->mi_rows) >> MI_BLOCK_SIZE_LOG2;
-    vp9_loop_filter_dealloc(&pbi->lf_row_sync, sb_rows);
+  for (i = 0; i < pbi->num_row_workers; ++i) {
+    VP9Worker *const worker = &pbi->row_workers[i];
+    vp9_worker_end(worker);
+    vpx_free(worker->data1);
   }
+  vpx_free(pbi->row_workers);
+  vp9_row_mt_dealloc(&pbi->row_mt);
+
+  vp9_loop_filter_dealloc(&pbi->lf_row_sync);
 
   vpx_free(pbi);
 }
@@ -262,6 +312,90 @@ int vp9_get_reference_dec(VP9D_COMP *pbi, int index, YV12_BUFFER_CONFIG **fb) {
   return 0;
 }
 
+static void release_fb(VP9_COMMON *cm, int fb_idx) {
+  RefCntBuffer *const buf = &cm->frame_bufs[fb_idx];
+  assert(buf->ref_count > 0);
+  if (--buf->ref_count == 0)
+    cm->release_fb_cb(cm->cb_priv, &buf->raw_frame_buffer);
+}
+
+static int has_free_fb(const VP9_COMMON *cm) {
+  int i;
+  for (i = 0; i < FRAME_BUFFERS; ++i)
+    if (cm->frame_bufs[i].ref_count == 0)
+      return 1;
+  return 0;
+}
+
+void vp9_retire_frame_worker(VP9D_COMP *pbi) {
+  VP9_COMMON *const cm = &pbi->common;
+  VP9Worker *const worker = &pbi->frame_workers[pbi->oldest_frame_worker];
+  FrameWorkerData *const fwd = (FrameWorkerData *)worker->data1;
+  VP9_COMMON *const frame_cm = &fwd->cm;
+  int i;
+
+  assert(pbi->frames_in_flight > 0);
+
+  if (!vp9_worker_sync(worker) && !pbi->frame_worker_error.error_code)
+    pbi->frame_worker_error = frame_cm->error;
+
+  cm->frame_bufs[frame_cm->new_fb_idx].buf.corrupted =
+      get_frame_new_buffer(frame_cm)->corrupted;
+
+  if (fwd->refresh_frame_context)
+    cm->frame_contexts[frame_cm->frame_context_idx] = frame_cm->fc;
+
+  for (i = 0; i < fwd->num_held_fbs; ++i)
+    release_fb(cm, fwd->held_fb_idx[i]);
+  fwd->num_held_fbs = 0;
+
+  pbi->oldest_frame_worker =
+      (pbi->oldest_frame_worker + 1) % pbi->num_frame_workers;
+  --pbi->frames_in_flight;
+}
+
+// Moves the first error of a retired frame into common.error.
+static int report_frame_worker_error(VP9D_COMP *pbi) {
+  VP9_COMMON *const cm = &pbi->common;
+
+  if (!pbi->frame_worker_error.error_code)
+    return 0;
+
+  cm->error.error_code = pbi->frame_worker_error.error_code;
+  cm->error.has_detail = pbi->frame_worker_error.has_detail;
+  memcpy(cm->error.detail, pbi->frame_worker_error.detail,
+         sizeof(cm->error.detail));
+  pbi->frame_worker_error.error_code = VPX_CODEC_OK;
+  return -1;
+}
+
+int vp9_sync_frame_workers(VP9D_COMP *pbi) {
+  while (pbi->frames_in_flight > 0)
+    vp9_retire_frame_worker(pbi);
+
+  return report_frame_worker_error(pbi);
+}
+
+int vp9_frame_worker_busy(const VP9D_COMP *pbi, int fb_idx) {
+  int i;
+  for (i = 0; i < pbi->frames_in_flight; ++i) {
+    const int n = (pbi->oldest_frame_worker + i) % pbi->num_frame_workers;
+    const FrameWorkerData *const fwd =
+        (const FrameWorkerData *)pbi->frame_workers[n].data1;
+    if (fwd->cm.new_fb_idx == fb_idx)
+      return 1;
+  }
+  return 0;
+}
+
+void vp9_ref_frame_buffer(VP9D_COMP *pbi, int fb_idx) {
+  ++pbi->common.frame_bufs[fb_idx].ref_count;
+}
+
+void vp9_unref_frame_buffer(VP9D_COMP *pbi, int fb_idx) {
+  release_fb(&pbi->common, fb_idx);
+}
+
 /* If any buffer updating is signaled it should be done here. */
 static void swap_frame_buffers(VP9D_COMP *pbi) {
   int ref_index = 0, mask;
@@ -309,15 +443,29 @@ int vp9_receive_compressed_data(VP9D_COMP *pbi,
       cm->frame_refs[0].buf->corrupted = 1;
   }
 
-  // Check if the previous frame was a frame without any references to it.
-  if (cm->new_fb_idx >= 0 && cm->frame_bufs[cm->new_fb_idx].ref_count == 0)
+  if (pbi->oxcf.frame_parallel_decode) {
+    // Buffers are released as soon as their last reference is dropped, but
+    // they may all be held by frames in flight.
+    while (pbi->frames_in_flight > 0 && !has_free_fb(cm))
+      vp9_retire_frame_worker(pbi);
+    if (!has_free_fb(cm)) {
+      cm->error.error_code = VPX_CODEC_MEM_ERROR;
+      return -1;
+    }
+  } else if (cm->new_fb_idx >= 0 &&
+             cm->frame_bufs[cm->new_fb_idx].ref_count == 0) {
+    // Check if the previous frame was a frame without any references to it.
     cm->release_fb_cb(cm->cb_priv,
                       &cm->frame_bufs[cm->new_fb_idx].raw_frame_buffer);
+  }
   cm->new_fb_idx = get_free_fb(cm);
 
   if (setjmp(cm->error.jmp)) {
     cm->error.setjmp = 0;
 
+    // The row workers may still be reconstructing the rows parsed so far.
+    vp9_row_mt_abort(pbi);
+
     // We do not know if the missing frame(s) was supposed to update
     // any of the reference buffers, but we act conservative and
     // mark only the last buffer as corrupted.
@@ -328,8 +476,12 @@ int vp9_receive_compressed_data(VP9D_COMP *pbi,
     if (cm->frame_refs[0].idx != INT_MAX)
       cm->frame_refs[0].buf->corrupted = 1;
 
-    if (cm->frame_bufs[cm->new_fb_idx].ref_count > 0)
-      cm->frame_bufs[cm->new_fb_idx].ref_count--;
+    if (cm->frame_bufs[cm->new_fb_idx].ref_count > 0) {
+      if (pbi->oxcf.frame_parallel_decode)
+        release_fb(cm, cm->new_fb_idx);
+      else
+        cm->frame_bufs[cm->new_fb_idx].ref_count--;
+    }
 
     return -1;
   }
@@ -341,8 +493,12 @@ int vp9_receive_compressed_data(VP9D_COMP *pbi,
   if (retcode < 0) {
     cm->error.error_code = VPX_CODEC_ERROR;
     cm->error.setjmp = 0;
-    if (cm->frame_bufs[cm->new_fb_idx].ref_count > 0)
-      cm->frame_bufs[cm->new_fb_idx].ref_count--;
+    if (cm->frame_bufs[cm->new_fb_idx].ref_count > 0) {
+      if (pbi->oxcf.frame_parallel_decode)
+        release_fb(cm, cm->new_fb_idx);
+      else
+        cm->frame_bufs[cm->new_fb_idx].ref_count--;
+    }
     return retcode;
   }
 
@@ -357,14 +513,22 @@ int vp9_receive_compressed_data(VP9D_COMP *pbi,
                            cm->current_video_frame + 1000);
 #endif
 
-  if (!pbi->do_loopfilter_inline) {
+  // Frame workers apply the loop filter themselves.
+  if (!pbi->do_loopfilter_inline && !pbi->oxcf.frame_parallel_decode) {
+    struct vpx_usec_timer timer;
+
+    vpx_usec_timer_start(&timer);
     // If multiple threads are used to decode tiles, then we use those threads
     // to do parallel loopfiltering.
     if (pbi->num_tile_workers) {
-      vp9_loop_filter_frame_mt(pbi, cm, &pbi->mb, cm->lf.filter_level, 0, 0);
+      vp9_loop_filter_frame_mt(get_frame_new_buffer(cm), cm, &pbi->mb,
+                               cm->lf.filter_level, 0, 0, pbi->tile_workers,
+                               pbi->num_tile_workers, &pbi->lf_row_sync);
     } else {
       vp9_loop_filter_frame(cm, &pbi->mb, cm->lf.filter_level, 0, 0);
     }
+    vpx_usec_timer_mark(&timer);
+    pbi->stage_times.loop_filter_us += vpx_usec_timer_elapsed(&timer);
   }
 
 #if WRITE_RECON_BUFFER == 2
@@ -390,7 +554,8 @@ int vp9_receive_compressed_data(VP9D_COMP *pbi,
   if (!cm->show_existing_frame)
     cm->last_show_frame = cm->show_frame;
   if (cm->show_frame) {
-    if (!cm->show_existing_frame)
+    // Frame workers keep their own mode info.
+    if (!cm->show_existing_frame && !pbi->oxcf.frame_parallel_decode)
       vp9_swap_mi_and_prev_mi(cm);
 
     cm->current_video_frame++;
@@ -400,6 +565,10 @@ int vp9_receive_compressed_data(VP9D_COMP *pbi,
   pbi->last_time_stamp = time_stamp;
 
   cm->error.setjmp = 0;
+
+  // Report errors of frames decoded in the background since the last call.
+  if (report_frame_worker_error(pbi))
+    retcode = -1;
   return retcode;
 }
 
@@ -420,7 +589,14 @@ int vp9_get_raw_frame(VP9D_COMP *pbi, YV12_BUFFER_CONFIG *sd,
   *time_end_stamp = 0;
 
 #if CONFIG_VP9_POSTPROC
-  ret = vp9_post_proc_frame(&pbi->common, sd, flags);
+  {
+    struct vpx_usec_timer timer;
+
+    vpx_usec_timer_start(&timer);
+    ret = vp9_post_proc_frame(&pbi->common, sd, flags);
+    vpx_usec_timer_mark(&timer);
+    pbi->stage_times.postproc_us += vpx_usec_timer_elapsed(&timer);
+  }
 #else
 
   if (pbi->common.frame_to_show) {
@@ -13,15 +13,16 @@
 
 #include "./vpx_config.h"
 
+#include "vpx/vp8dx.h"
 #include "vpx/vpx_codec.h"
 #include "vpx_scale/yv12config.h"
 
 #include "vp9/common/vp9_onyxc_int.h"
 #include "vp9/common/vp9_ppflags.h"
+#include "vp9/common/vp9_thread.h"
 
 #include "vp9/decoder/vp9_decoder.h"
 #include "vp9/decoder/vp9_dthread.h"
-#include "vp9/decoder/vp9_thread.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -33,8 +34,14 @@ typedef struct {
   int version;
   int max_threads;
   int inv_tile_order;
+  int frame_parallel_decode;  // decode up to max_threads frames in parallel
+  int two_stage_decode;  // parse whole frames before reconstructing them
 } VP9D_CONFIG;
 
+// Maximum number of frames in flight with frame-based threading. Each of them
+// may hold a frame buffer and so may each decoded frame waiting to be output.
+#define MAX_FRAME_THREADS (VPX_MAXIMUM_FRAME_THREADING_BUFFERS / 2)
+
 typedef struct VP9Decompressor {
   DECLARE_ALIGNED(16, MACROBLOCKD, mb);
 
@@ -59,6 +66,28 @@ typedef struct VP9Decompressor {
   int num_tile_workers;
 
   VP9LfSync lf_row_sync;
+
+  // Two-stage decoding and row-based multi-threading within tiles. Superblock
+  // rows are parsed on the calling thread while the row workers reconstruct
+  // and loop filter the rows parsed before, each row running two superblocks
+  // behind the one above.
+  VP9Worker *row_workers;
+  int num_row_workers;
+  VP9RowMTData row_mt;
+
+  // Frame-based multi-threading. Frames are handed to the workers in decode
+  // order and retired in the same order; the ones in flight are
+  // frame_workers[oldest_frame_worker] and the frames_in_flight - 1 after it.
+  VP9Worker *frame_workers;
+  int num_frame_workers;
+  int oldest_frame_worker;
+  int frames_in_flight;
+  int last_frame_worker;  // worker of the last frame handed out, or -1
+  VP9FrameSync frame_sync;
+  struct vpx_internal_error_info frame_worker_error;
+
+  // Accumulated until read with VP9D_GET_STAGE_TIMES.
+  vp9_decode_stage_times_t stage_times;
 } VP9D_COMP;
 
 void vp9_initialize_dec();
@@ -84,6 +113,22 @@ int vp9_get_reference_dec(struct VP9Decompressor *pbi,
                           int index, YV12_BUFFER_CONFIG **fb);
 
 
+// Frame-based multi-threading: waits for the oldest frame in flight and
+// releases the frame buffers it held. Errors are kept in frame_worker_error.
+void vp9_retire_frame_worker(struct VP9Decompressor *pbi);
+
+// Retires all frames in flight. Returns -1 and sets common.error if one of
+// them failed since the last call.
+int vp9_sync_frame_workers(struct VP9Decompressor *pbi);
+
+// Returns 1 if frame buffer fb_idx is still being decoded by a frame worker.
+int vp9_frame_worker_busy(const struct VP9Decompressor *pbi, int fb_idx);
+
+// Takes and drops an extra reference on a frame buffer, e.g. while a decoded
+// frame is waiting to be output.
+void vp9_ref_frame_buffer(struct VP9Decompressor *pbi, int fb_idx);
+void vp9_unref_frame_buffer(struct VP9Decompressor *pbi, int fb_idx);
+
 struct VP9Decompressor *vp9_create_decompressor(const VP9D_CONFIG *oxcf);
 
 void vp9_remove_decompressor(struct VP9Decompressor *pbi);
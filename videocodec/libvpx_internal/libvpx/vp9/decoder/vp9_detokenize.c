@@ -59,14 +59,16 @@ static const vp9_prob cat6_prob[15] = {
 
 #define INCREMENT_COUNT(token)                              \
   do {                                                      \
-     if (!cm->frame_parallel_decoding_mode)                 \
+     if (update_counts)                                     \
        ++coef_counts[band][ctx][token];                     \
   } while (0)
 
+#define READ_BOOL(prob) read_bool(r, prob, &value, &count, &range)
+
 #define WRITE_COEF_CONTINUE(val, token)                  \
   {                                                      \
     v = (val * dqv) >> dq_shift;                         \
-    dqcoeff[scan[c]] = vp9_read_bit(r) ? -v : v;         \
+    dqcoeff[scan[c]] = READ_BOOL(128) ? -v : v;          \
     token_cache[scan[c]] = vp9_pt_energy_class[token];   \
     ++c;                                                 \
     ctx = get_coef_context(nb, token_cache, c);          \
@@ -76,9 +78,64 @@ static const vp9_prob cat6_prob[15] = {
 
 #define ADJUST_COEF(prob, bits_count)                   \
   do {                                                  \
-    val += (vp9_read(r, prob) << bits_count);           \
+    val += (READ_BOOL(prob) << bits_count);             \
   } while (0)
 
+// Refills the reader window like vp9_reader_fill() does, but inline and from
+// one whole window read of the buffer. Only done while a whole window of
+// data is left, so the end of buffer handling that vp9_reader_find_end() and
+// vp9_reader_has_error() rely on stays with vp9_reader_fill().
+static INLINE void fill_window(vp9_reader *r, BD_VALUE *value, int *count) {
+  const int bytes = (BD_VALUE_SIZE - CHAR_BIT - *count) / CHAR_BIT;
+
+  if (bytes <= 0)
+    return;
+
+  if (r->buffer_end - r->buffer >= (ptrdiff_t)sizeof(BD_VALUE)) {
+    BD_VALUE window = 0;
+    size_t i;
+    for (i = 0; i < sizeof(BD_VALUE); ++i)
+      window = (window << CHAR_BIT) | r->buffer[i];
+    window &= ~(BD_VALUE)0 << (BD_VALUE_SIZE - bytes * CHAR_BIT);
+    *value |= window >> (*count + CHAR_BIT);
+    *count += bytes * CHAR_BIT;
+    r->buffer += bytes;
+  } else if (*count < 0) {
+    r->value = *value;
+    r->count = *count;
+    vp9_reader_fill(r);
+    *value = r->value;
+    *count = r->count;
+  }
+}
+
+// Same as vp9_read(), but on a copy of the reader state that the caller keeps
+// in registers for the whole block.
+static INLINE int read_bool(vp9_reader *r, int prob, BD_VALUE *value,
+                            int *count, unsigned int *range) {
+  const unsigned int split = (*range * prob + (256 - prob)) >> CHAR_BIT;
+  const BD_VALUE bigsplit = (BD_VALUE)split << (BD_VALUE_SIZE - CHAR_BIT);
+  int bit = 0;
+  int shift;
+
+  if (*count < 0)
+    fill_window(r, value, count);
+
+  if (*value >= bigsplit) {
+    *range = *range - split;
+    *value = *value - bigsplit;
+    bit = 1;
+  } else {
+    *range = split;
+  }
+
+  shift = vp9_norm[*range];
+  *range <<= shift;
+  *value <<= shift;
+  *count -= shift;
+  return bit;
+}
+
 static int decode_coefs(VP9_COMMON *cm, const MACROBLOCKD *xd, PLANE_TYPE type,
                        int16_t *dqcoeff, TX_SIZE tx_size, const int16_t *dq,
                        int ctx, const int16_t *scan, const int16_t *nb,
@@ -87,6 +144,7 @@ static int decode_coefs(VP9_COMMON *cm, const MACROBLOCKD *xd, PLANE_TYPE type,
   const FRAME_CONTEXT *const fc = &cm->fc;
   FRAME_COUNTS *const counts = &cm->counts;
   const int ref = is_inter_block(&xd->mi[0]->mbmi);
+  const int update_counts = !cm->frame_parallel_decoding_mode;
   int band, c = 0;
   const vp9_prob (*coef_probs)[COEFF_CONTEXTS][UNCONSTRAINED_NODES] =
       fc->coef_probs[tx_size][type][ref];
@@ -101,52 +159,72 @@ static int decode_coefs(VP9_COMMON *cm, const MACROBLOCKD *xd, PLANE_TYPE type,
   const int dq_shift = (tx_size == TX_32X32);
   int v;
   int16_t dqv = dq[0];
+  BD_VALUE value;
+  int count;
+  unsigned int range;
+
+  value = r->value;
+  count = r->count;
+  range = r->range;
+  // Most blocks are decoded without another refill.
+  if (count < BD_VALUE_SIZE / 2)
+    fill_window(r, &value, &count);
 
   while (c < max_eob) {
     int val;
     band = *band_translate++;
     prob = coef_probs[band][ctx];
-    if (!cm->frame_parallel_decoding_mode)
+    if (update_counts)
       ++eob_branch_count[band][ctx];
-    if (!vp9_read(r, prob[EOB_CONTEXT_NODE])) {
+    if (!READ_BOOL(prob[EOB_CONTEXT_NODE])) {
       INCREMENT_COUNT(EOB_MODEL_TOKEN);
       break;
     }
 
-    while (!vp9_read(r, prob[ZERO_CONTEXT_NODE])) {
+    // ZERO and ONE tokens make up most of the coefficients; they are decoded
+    // from the first model nodes without going through the pareto table.
+    while (!READ_BOOL(prob[ZERO_CONTEXT_NODE])) {
       INCREMENT_COUNT(ZERO_TOKEN);
       dqv = dq[1];
       token_cache[scan[c]] = 0;
       ++c;
       if (c >= max_eob)
-        return c;  // zero tokens at the end (no eob token)
+        break;  // zero tokens at the end (no eob token)
       ctx = get_coef_context(nb, token_cache, c);
       band = *band_translate++;
       prob = coef_probs[band][ctx];
     }
+    if (c >= max_eob)
+      break;
 
     // ONE_CONTEXT_NODE_0_
-    if (!vp9_read(r, prob[ONE_CONTEXT_NODE])) {
+    if (!READ_BOOL(prob[ONE_CONTEXT_NODE])) {
       INCREMENT_COUNT(ONE_TOKEN);
-      WRITE_COEF_CONTINUE(1, ONE_TOKEN);
+      v = dqv >> dq_shift;
+      dqcoeff[scan[c]] = READ_BOOL(128) ? -v : v;
+      token_cache[scan[c]] = 1;  // vp9_pt_energy_class[ONE_TOKEN]
+      ++c;
+      ctx = get_coef_context(nb, token_cache, c);
+      dqv = dq[1];
+      continue;
     }
 
     INCREMENT_COUNT(TWO_TOKEN);
 
     prob = vp9_pareto8_full[prob[PIVOT_NODE] - 1];
 
-    if (!vp9_read(r, prob[LOW_VAL_CONTEXT_NODE])) {
-      if (!vp9_read(r, prob[TWO_CONTEXT_NODE])) {
+    if (!READ_BOOL(prob[LOW_VAL_CONTEXT_NODE])) {
+      if (!READ_BOOL(prob[TWO_CONTEXT_NODE])) {
         WRITE_COEF_CONTINUE(2, TWO_TOKEN);
       }
-      if (!vp9_read(r, prob[THREE_CONTEXT_NODE])) {
+      if (!READ_BOOL(prob[THREE_CONTEXT_NODE])) {
         WRITE_COEF_CONTINUE(3, THREE_TOKEN);
       }
       WRITE_COEF_CONTINUE(4, FOUR_TOKEN);
     }
 
-    if (!vp9_read(r, prob[HIGH_LOW_CONTEXT_NODE])) {
-      if (!vp9_read(r, prob[CAT_ONE_CONTEXT_NODE])) {
+    if (!READ_BOOL(prob[HIGH_LOW_CONTEXT_NODE])) {
+      if (!READ_BOOL(prob[CAT_ONE_CONTEXT_NODE])) {
         val = CAT1_MIN_VAL;
         ADJUST_COEF(CAT1_PROB0, 0);
         WRITE_COEF_CONTINUE(val, CATEGORY1_TOKEN);
@@ -157,8 +235,8 @@ static int decode_coefs(VP9_COMMON *cm, const MACROBLOCKD *xd, PLANE_TYPE type,
       WRITE_COEF_CONTINUE(val, CATEGORY2_TOKEN);
     }
 
-    if (!vp9_read(r, prob[CAT_THREEFOUR_CONTEXT_NODE])) {
-      if (!vp9_read(r, prob[CAT_THREE_CONTEXT_NODE])) {
+    if (!READ_BOOL(prob[CAT_THREEFOUR_CONTEXT_NODE])) {
+      if (!READ_BOOL(prob[CAT_THREE_CONTEXT_NODE])) {
         val = CAT3_MIN_VAL;
         ADJUST_COEF(CAT3_PROB2, 2);
         ADJUST_COEF(CAT3_PROB1, 1);
@@ -173,7 +251,7 @@ static int decode_coefs(VP9_COMMON *cm, const MACROBLOCKD *xd, PLANE_TYPE type,
       WRITE_COEF_CONTINUE(val, CATEGORY4_TOKEN);
     }
 
-    if (!vp9_read(r, prob[CAT_FIVE_CONTEXT_NODE])) {
+    if (!READ_BOOL(prob[CAT_FIVE_CONTEXT_NODE])) {
       val = CAT5_MIN_VAL;
       ADJUST_COEF(CAT5_PROB4, 4);
       ADJUST_COEF(CAT5_PROB3, 3);
@@ -185,12 +263,15 @@ static int decode_coefs(VP9_COMMON *cm, const MACROBLOCKD *xd, PLANE_TYPE type,
     val = 0;
     cat6 = cat6_prob;
     while (*cat6)
-      val = (val << 1) | vp9_read(r, *cat6++);
+      val = (val << 1) | READ_BOOL(*cat6++);
     val += CAT6_MIN_VAL;
 
     WRITE_COEF_CONTINUE(val, CATEGORY6_TOKEN);
   }
 
+  r->value = value;
+  r->count = count;
+  r->range = range;
   return c;
 }
 
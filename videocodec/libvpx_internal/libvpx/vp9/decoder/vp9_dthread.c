@@ -8,6 +8,8 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <limits.h>
+
 #include "./vpx_config.h"
 
 #include "vpx_mem/vpx_mem.h"
@@ -17,258 +19,162 @@
 #include "vp9/decoder/vp9_dthread.h"
 #include "vp9/decoder/vp9_decoder.h"
 
-#if CONFIG_MULTITHREAD
-static INLINE void mutex_lock(pthread_mutex_t *const mutex) {
-  const int kMaxTryLocks = 4000;
-  int locked = 0;
+void vp9_row_mt_alloc(VP9_COMMON *cm, VP9RowMTData *row_mt, int num_rows) {
+  const int sb_rows = mi_cols_aligned_to_sb(cm->mi_rows) >> MI_BLOCK_SIZE_LOG2;
+  const int sb_cols = mi_cols_aligned_to_sb(cm->mi_cols) >> MI_BLOCK_SIZE_LOG2;
+  const int sb_4x4s = 256 + 2 * (256 >> (cm->subsampling_x +
+                                         cm->subsampling_y));
   int i;
 
-  for (i = 0; i < kMaxTryLocks; ++i) {
-    if (!pthread_mutex_trylock(mutex)) {
-      locked = 1;
-      break;
-    }
+  if (row_mt->rows != NULL && row_mt->num_rows == num_rows &&
+      row_mt->sb_rows == sb_rows && row_mt->sb_cols == sb_cols &&
+      row_mt->sb_coeffs == 16 * sb_4x4s)
+    return;
+
+  vp9_row_mt_dealloc(row_mt);
+
+  vp9_loop_filter_alloc(cm, &row_mt->parse_sync, sb_rows, cm->width);
+  vp9_loop_filter_alloc(cm, &row_mt->recon_sync, sb_rows, cm->width);
+  row_mt->sb_rows = sb_rows;
+
+  CHECK_MEM_ERROR(cm, row_mt->rows,
+                  vpx_calloc(num_rows, sizeof(*row_mt->rows)));
+  row_mt->num_rows = num_rows;
+  row_mt->sb_cols = sb_cols;
+  row_mt->sb_coeffs = 16 * sb_4x4s;
+
+  for (i = 0; i < num_rows; ++i) {
+    VP9DecRowBuffer *const buf = &row_mt->rows[i];
+    CHECK_MEM_ERROR(cm, buf->blocks,
+                    vpx_malloc(sb_cols * 64 * sizeof(*buf->blocks)));
+    CHECK_MEM_ERROR(cm, buf->sb_block_end,
+                    vpx_malloc(sb_cols * sizeof(*buf->sb_block_end)));
+    CHECK_MEM_ERROR(cm, buf->dqcoeff,
+                    vpx_memalign(32, sb_cols * row_mt->sb_coeffs *
+                                     sizeof(*buf->dqcoeff)));
+    vpx_memset(buf->dqcoeff, 0,
+               sb_cols * row_mt->sb_coeffs * sizeof(*buf->dqcoeff));
+    CHECK_MEM_ERROR(cm, buf->eobs,
+                    vpx_malloc(sb_cols * sb_4x4s * sizeof(*buf->eobs)));
   }
-
-  if (!locked)
-    pthread_mutex_lock(mutex);
 }
-#endif  // CONFIG_MULTITHREAD
 
-static INLINE void sync_read(VP9LfSync *const lf_sync, int r, int c) {
-#if CONFIG_MULTITHREAD
-  const int nsync = lf_sync->sync_range;
-
-  if (r && !(c & (nsync - 1))) {
-    mutex_lock(&lf_sync->mutex_[r - 1]);
+void vp9_row_mt_dealloc(VP9RowMTData *row_mt) {
+  int i;
 
-    while (c > lf_sync->cur_sb_col[r - 1] - nsync) {
-      pthread_cond_wait(&lf_sync->cond_[r - 1],
-                        &lf_sync->mutex_[r - 1]);
+  if (row_mt->rows != NULL) {
+    for (i = 0; i < row_mt->num_rows; ++i) {
+      VP9DecRowBuffer *const buf = &row_mt->rows[i];
+      vpx_free(buf->blocks);
+      vpx_free(buf->sb_block_end);
+      vpx_free(buf->dqcoeff);
+      vpx_free(buf->eobs);
     }
-    pthread_mutex_unlock(&lf_sync->mutex_[r - 1]);
+    vpx_free(row_mt->rows);
   }
-#else
-  (void)lf_sync;
-  (void)r;
-  (void)c;
-#endif  // CONFIG_MULTITHREAD
+  vp9_loop_filter_dealloc(&row_mt->parse_sync);
+  vp9_loop_filter_dealloc(&row_mt->recon_sync);
+  vpx_memset(row_mt, 0, sizeof(*row_mt));
 }
 
-static INLINE void sync_write(VP9LfSync *const lf_sync, int r, int c,
-                              const int sb_cols) {
-#if CONFIG_MULTITHREAD
-  const int nsync = lf_sync->sync_range;
-  int cur;
-  // Only signal when there are enough filtered SB for next row to run.
-  int sig = 1;
-
-  if (c < sb_cols - 1) {
-    cur = c;
-    if (c % nsync)
-      sig = 0;
-  } else {
-    cur = sb_cols + nsync;
-  }
-
-  if (sig) {
-    mutex_lock(&lf_sync->mutex_[r]);
-
-    lf_sync->cur_sb_col[r] = cur;
-
-    pthread_cond_signal(&lf_sync->cond_[r]);
-    pthread_mutex_unlock(&lf_sync->mutex_[r]);
-  }
-#else
-  (void)lf_sync;
-  (void)r;
-  (void)c;
-  (void)sb_cols;
-#endif  // CONFIG_MULTITHREAD
-}
-
-// Implement row loopfiltering for each thread.
-static void loop_filter_rows_mt(const YV12_BUFFER_CONFIG *const frame_buffer,
-                                VP9_COMMON *const cm, MACROBLOCKD *const xd,
-                                int start, int stop, int y_only,
-                                VP9LfSync *const lf_sync, int num_lf_workers) {
-  const int num_planes = y_only ? 1 : MAX_MB_PLANE;
-  int r, c;  // SB row and col
-  LOOP_FILTER_MASK lfm;
-  const int sb_cols = mi_cols_aligned_to_sb(cm->mi_cols) >> MI_BLOCK_SIZE_LOG2;
-
-  for (r = start; r < stop; r += num_lf_workers) {
-    const int mi_row = r << MI_BLOCK_SIZE_LOG2;
-    MODE_INFO **mi_8x8 = cm->mi_grid_visible + mi_row * cm->mi_stride;
-
-    for (c = 0; c < sb_cols; ++c) {
-      const int mi_col = c << MI_BLOCK_SIZE_LOG2;
-      int plane;
-
-      sync_read(lf_sync, r, c);
+void vp9_row_mt_abort(VP9D_COMP *pbi) {
+  VP9RowMTData *const row_mt = &pbi->row_mt;
+  int i;
 
-      vp9_setup_dst_planes(xd, frame_buffer, mi_row, mi_col);
-      vp9_setup_mask(cm, mi_row, mi_col, mi_8x8 + mi_col, cm->mi_stride, &lfm);
+  if (!row_mt->active)
+    return;
 
-      for (plane = 0; plane < num_planes; ++plane) {
-        vp9_filter_block_plane(cm, &xd->plane[plane], mi_row, &lfm);
-      }
+  // Release the workers waiting for rows that will not be parsed.
+  row_mt->abort = 1;
+  for (i = 0; i < row_mt->sb_rows; ++i)
+    vp9_row_sync_write(&row_mt->parse_sync, i, row_mt->sb_cols - 1, row_mt->sb_cols);
 
-      sync_write(lf_sync, r, c, sb_cols);
-    }
-  }
-}
+  for (i = 0; i < pbi->num_row_workers; ++i)
+    vp9_worker_sync(&pbi->row_workers[i]);
 
-// Row-based multi-threaded loopfilter hook
-static int loop_filter_row_worker(void *arg1, void *arg2) {
-  TileWorkerData *const tile_data = (TileWorkerData*)arg1;
-  LFWorkerData *const lf_data = &tile_data->lfdata;
+  for (i = 0; i < row_mt->num_rows; ++i)
+    vpx_memset(row_mt->rows[i].dqcoeff, 0,
+               row_mt->sb_cols * row_mt->sb_coeffs *
+               sizeof(*row_mt->rows[i].dqcoeff));
 
-  loop_filter_rows_mt(lf_data->frame_buffer, lf_data->cm, &lf_data->xd,
-                      lf_data->start, lf_data->stop, lf_data->y_only,
-                      lf_data->lf_sync, lf_data->num_lf_workers);
-  return 1;
+  row_mt->abort = 0;
+  row_mt->active = 0;
 }
 
-// VP9 decoder: Implement multi-threaded loopfilter that uses the tile
-// threads.
-void vp9_loop_filter_frame_mt(VP9D_COMP *pbi,
-                              VP9_COMMON *cm,
-                              MACROBLOCKD *xd,
-                              int frame_filter_level,
-                              int y_only, int partial_frame) {
-  // Number of superblock rows and cols
-  const int sb_rows = mi_cols_aligned_to_sb(cm->mi_rows) >> MI_BLOCK_SIZE_LOG2;
+void vp9_frame_sync_init(VP9FrameSync *frame_sync) {
   int i;
-
-  // Allocate memory used in thread synchronization.
-  // This always needs to be done even if frame_filter_level is 0.
-  if (!cm->current_video_frame || cm->last_height != cm->height) {
-    VP9LfSync *const lf_sync = &pbi->lf_row_sync;
-
-    if (cm->last_height != cm->height) {
-      const int aligned_last_height =
-          ALIGN_POWER_OF_TWO(cm->last_height, MI_SIZE_LOG2);
-      const int last_sb_rows =
-          mi_cols_aligned_to_sb(aligned_last_height >> MI_SIZE_LOG2) >>
-          MI_BLOCK_SIZE_LOG2;
-
-      vp9_loop_filter_dealloc(lf_sync, last_sb_rows);
-    }
-
-    vp9_loop_filter_alloc(cm, lf_sync, sb_rows, cm->width);
-  }
-
-  if (!frame_filter_level) return;
-
-  vp9_loop_filter_frame_init(cm, frame_filter_level);
-
-  // Initialize cur_sb_col to -1 for all SB rows.
-  vpx_memset(pbi->lf_row_sync.cur_sb_col, -1,
-             sizeof(*pbi->lf_row_sync.cur_sb_col) * sb_rows);
-
-  // Set up loopfilter thread data.
-  for (i = 0; i < pbi->num_tile_workers; ++i) {
-    VP9Worker *const worker = &pbi->tile_workers[i];
-    TileWorkerData *const tile_data = (TileWorkerData*)worker->data1;
-    LFWorkerData *const lf_data = &tile_data->lfdata;
-
-    worker->hook = (VP9WorkerHook)loop_filter_row_worker;
-
-    // Loopfilter data
-    lf_data->frame_buffer = get_frame_new_buffer(cm);
-    lf_data->cm = cm;
-    lf_data->xd = pbi->mb;
-    lf_data->start = i;
-    lf_data->stop = sb_rows;
-    lf_data->y_only = y_only;   // always do all planes in decoder
-
-    lf_data->lf_sync = &pbi->lf_row_sync;
-    lf_data->num_lf_workers = pbi->num_tile_workers;
-
-    // Start loopfiltering
-    if (i == pbi->num_tile_workers - 1) {
-      vp9_worker_execute(worker);
-    } else {
-      vp9_worker_launch(worker);
-    }
-  }
-
-  // Wait till all rows are finished
-  for (i = 0; i < pbi->num_tile_workers; ++i) {
-    vp9_worker_sync(&pbi->tile_workers[i]);
-  }
+#if CONFIG_MULTITHREAD
+  pthread_mutex_init(&frame_sync->mutex_, NULL);
+  pthread_cond_init(&frame_sync->cond_, NULL);
+#endif  // CONFIG_MULTITHREAD
+  for (i = 0; i < FRAME_BUFFERS; ++i)
+    frame_sync->progress[i] = INT_MAX;
 }
 
-// Set up nsync by width.
-static int get_sync_range(int width) {
-  // nsync numbers are picked by testing. For example, for 4k
-  // video, using 4 gives best performance.
-  if (width < 640)
-    return 1;
-  else if (width <= 1280)
-    return 2;
-  else if (width <= 4096)
-    return 4;
-  else
-    return 8;
+void vp9_frame_sync_destroy(VP9FrameSync *frame_sync) {
+#if CONFIG_MULTITHREAD
+  pthread_mutex_destroy(&frame_sync->mutex_);
+  pthread_cond_destroy(&frame_sync->cond_);
+#else
+  (void)frame_sync;
+#endif  // CONFIG_MULTITHREAD
 }
 
-// Allocate memory for lf row synchronization
-void vp9_loop_filter_alloc(VP9_COMMON *cm, VP9LfSync *lf_sync, int rows,
-                           int width) {
+void vp9_frame_sync_signal(VP9FrameSync *frame_sync, int fb_idx, int row) {
 #if CONFIG_MULTITHREAD
-  int i;
-
-  CHECK_MEM_ERROR(cm, lf_sync->mutex_,
-                  vpx_malloc(sizeof(*lf_sync->mutex_) * rows));
-  for (i = 0; i < rows; ++i) {
-    pthread_mutex_init(&lf_sync->mutex_[i], NULL);
-  }
-
-  CHECK_MEM_ERROR(cm, lf_sync->cond_,
-                  vpx_malloc(sizeof(*lf_sync->cond_) * rows));
-  for (i = 0; i < rows; ++i) {
-    pthread_cond_init(&lf_sync->cond_[i], NULL);
-  }
+  vp9_mutex_lock(&frame_sync->mutex_);
+  frame_sync->progress[fb_idx] = row;
+  pthread_cond_broadcast(&frame_sync->cond_);
+  pthread_mutex_unlock(&frame_sync->mutex_);
+#else
+  frame_sync->progress[fb_idx] = row;
 #endif  // CONFIG_MULTITHREAD
-
-  CHECK_MEM_ERROR(cm, lf_sync->cur_sb_col,
-                  vpx_malloc(sizeof(*lf_sync->cur_sb_col) * rows));
-
-  // Set up nsync.
-  lf_sync->sync_range = get_sync_range(width);
 }
 
-// Deallocate lf synchronization related mutex and data
-void vp9_loop_filter_dealloc(VP9LfSync *lf_sync, int rows) {
+void vp9_frame_sync_wait(VP9FrameSync *frame_sync, int fb_idx, int row) {
 #if CONFIG_MULTITHREAD
-  if (lf_sync != NULL) {
-    int i;
-
-    if (lf_sync->mutex_ != NULL) {
-      for (i = 0; i < rows; ++i) {
-        pthread_mutex_destroy(&lf_sync->mutex_[i]);
-      }
-      vpx_free(lf_sync->mutex_);
-    }
-    if (lf_sync->cond_ != NULL) {
-      for (i = 0; i < rows; ++i) {
-        pthread_cond_destroy(&lf_sync->cond_[i]);
-      }
-      vpx_free(lf_sync->cond_);
-    }
-
-    vpx_free(lf_sync->cur_sb_col);
-    // clear the structure as the source of this call may be a resize in which
-    // case this call will be followed by an _alloc() which may fail.
-    vpx_memset(lf_sync, 0, sizeof(*lf_sync));
-  }
+  vp9_mutex_lock(&frame_sync->mutex_);
+  while (frame_sync->progress[fb_idx] <= row)
+    pthread_cond_wait(&frame_sync->cond_, &frame_sync->mutex_);
+  pthread_mutex_unlock(&frame_sync->mutex_);
 #else
-  (void)rows;
-  if (lf_sync != NULL) {
-    vpx_free(lf_sync->cur_sb_col);
-    vpx_memset(lf_sync, 0, sizeof(*lf_sync));
-  }
+  // Frames are decoded one after the other without threads.
+  (void)frame_sync;
+  (void)fb_idx;
+  (void)row;
 #endif  // CONFIG_MULTITHREAD
 }
+
+void vp9_frame_worker_alloc(VP9_COMMON *cm, FrameWorkerData *fwd) {
+  const int mi_size = cm->mi_stride * (cm->mi_rows + MI_BLOCK_SIZE);
+  const int aligned_mi_cols = mi_cols_aligned_to_sb(cm->mi_cols);
+
+  if (fwd->mip != NULL && fwd->mi_rows == cm->mi_rows &&
+      fwd->mi_cols == cm->mi_cols)
+    return;
+
+  vp9_frame_worker_dealloc(fwd);
+
+  CHECK_MEM_ERROR(cm, fwd->mip, vpx_calloc(mi_size, sizeof(*fwd->mip)));
+  CHECK_MEM_ERROR(cm, fwd->mi_grid_base,
+                  vpx_calloc(mi_size, sizeof(*fwd->mi_grid_base)));
+  CHECK_MEM_ERROR(cm, fwd->above_context,
+                  vpx_calloc(2 * aligned_mi_cols * MAX_MB_PLANE,
+                             sizeof(*fwd->above_context)));
+  CHECK_MEM_ERROR(cm, fwd->above_seg_context,
+                  vpx_calloc(aligned_mi_cols, sizeof(*fwd->above_seg_context)));
+  fwd->mi_rows = cm->mi_rows;
+  fwd->mi_cols = cm->mi_cols;
+}
+
+void vp9_frame_worker_dealloc(FrameWorkerData *fwd) {
+  vpx_free(fwd->mip);
+  fwd->mip = NULL;
+  vpx_free(fwd->mi_grid_base);
+  fwd->mi_grid_base = NULL;
+  vpx_free(fwd->above_context);
+  fwd->above_context = NULL;
+  vpx_free(fwd->above_seg_context);
+  fwd->above_seg_context = NULL;
+  fwd->mi_rows = fwd->mi_cols = 0;
+}
@@ -13,8 +13,11 @@
 
 #include "./vpx_config.h"
 #include "vp9/common/vp9_loopfilter.h"
+#include "vp9/common/vp9_onyxc_int.h"
+#include "vp9/common/vp9_thread.h"
+#include "vp9/common/vp9_thread_common.h"
+#include "vp9/common/vp9_tile_common.h"
 #include "vp9/decoder/vp9_reader.h"
-#include "vp9/decoder/vp9_thread.h"
 
 struct macroblockd;
 struct VP9Common;
@@ -24,36 +27,146 @@ typedef struct TileWorkerData {
   struct VP9Common *cm;
   vp9_reader bit_reader;
   DECLARE_ALIGNED(16, struct macroblockd, xd);
+} TileWorkerData;
+
+// Two-stage decoding: a block parsed ahead of its reconstruction. Its
+// mode info is in the mode info grid of the frame, its dequantized
+// coefficients and end of block positions in the buffer of its superblock row.
+typedef struct VP9DecBlock {
+  const TileInfo *tile;
+  int mi_row;
+  int mi_col;
+  BLOCK_SIZE bsize;  // at least BLOCK_8X8
+  int16_t *dqcoeff[MAX_MB_PLANE];
+  uint16_t *eobs[MAX_MB_PLANE];
+} VP9DecBlock;
+
+// The parsed blocks of one superblock row, in decoding order.
+typedef struct VP9DecRowBuffer {
+  TileInfo tiles[1 << 6];
+  VP9DecBlock *blocks;
+  int num_blocks;
+  // Index in blocks one past the last block of each superblock.
+  int *sb_block_end;
+  // Coefficients are zeroed again once they have been inverse transformed.
+  int16_t *dqcoeff;
+  int num_dqcoeff;
+  uint16_t *eobs;
+  int num_eobs;
+} VP9DecRowBuffer;
+
+typedef struct VP9RowMTData {
+  // Ring of row buffers: superblock row r is parsed into
+  // rows[r % num_rows] once row r - num_rows has been reconstructed.
+  VP9DecRowBuffer *rows;
+  int num_rows;
+  int sb_rows;
+  int sb_cols;
+  int sb_coeffs;  // number of coefficients of a superblock, all planes
+
+  // Parsed superblocks of each row. Row r is waited for as the row above
+  // r + 1, i.e. with sync_read(&parse_sync, r + 1, c).
+  VP9LfSync parse_sync;
+  // Reconstructed superblocks of each row. Superblock c of row r is marked
+  // done once the loop filter of superblock c - 1 of the row above has run.
+  VP9LfSync recon_sync;
+
+  int active;  // set while the row workers are running
+  int abort;   // set on a parse error, the row workers skip the rest
+} VP9RowMTData;
+
+// 4x4 inverse transforms of one plane queued to be run four at a time by
+// vp9_idct4x4_16_add_x4(). The coefficients stay where they were decoded
+// until the batch is run.
+typedef struct VP9Idct4x4Batch {
+  int16_t *coeff[4];
+  uint8_t *dst[4];
+  int stride;
+  int count;
+} VP9Idct4x4Batch;
 
-  // Row-based parallel loopfilter data
+typedef struct RowWorkerData {
+  struct VP9Decompressor *pbi;
+  DECLARE_ALIGNED(16, struct macroblockd, xd);
   LFWorkerData lfdata;
-} TileWorkerData;
+  VP9Idct4x4Batch idct_batch[MAX_MB_PLANE];
+  int start;  // first superblock row of this worker
+  int step;   // number of row workers
+} RowWorkerData;
 
-// Loopfilter row synchronization
-typedef struct VP9LfSyncData {
+// Frame-based multi-threading: tracks how many luma rows of each frame
+// buffer have been reconstructed and loop filtered, so that a frame worker
+// can start motion compensation from a reference that is still being decoded.
+typedef struct VP9FrameSyncData {
 #if CONFIG_MULTITHREAD
-  pthread_mutex_t *mutex_;
-  pthread_cond_t *cond_;
+  pthread_mutex_t mutex_;
+  pthread_cond_t cond_;
 #endif
-  // Allocate memory to store the loop-filtered superblock index in each row.
-  int *cur_sb_col;
-  // The optimal sync_range for different resolution and platform should be
-  // determined by testing. Currently, it is chosen to be a power-of-2 number.
-  int sync_range;
-} VP9LfSync;
-
-// Allocate memory for loopfilter row synchronization.
-void vp9_loop_filter_alloc(struct VP9Common *cm, struct VP9LfSyncData *lf_sync,
-                           int rows, int width);
-
-// Deallocate loopfilter synchronization related mutex and data.
-void vp9_loop_filter_dealloc(struct VP9LfSyncData *lf_sync, int rows);
-
-// Multi-threaded loopfilter that uses the tile threads.
-void vp9_loop_filter_frame_mt(struct VP9Decompressor *pbi,
-                              struct VP9Common *cm,
-                              struct macroblockd *xd,
-                              int frame_filter_level,
-                              int y_only, int partial_frame);
+  // Rows [0, progress) are final. INT_MAX once the whole frame is done.
+  int progress[FRAME_BUFFERS];
+} VP9FrameSync;
+
+typedef struct FrameWorkerData {
+  struct VP9Decompressor *pbi;
+  VP9FrameSync *frame_sync;
+
+  // Private copy of the decoder state taken after the frame headers have been
+  // read on the calling thread.
+  DECLARE_ALIGNED(16, struct VP9Common, cm);
+  DECLARE_ALIGNED(16, struct macroblockd, xd);
+  LFWorkerData lfdata;
+
+  // Tile data, copied as the caller's buffer is not kept after decoding.
+  uint8_t *data;
+  size_t data_size;
+  size_t data_alloc_size;
+
+  // Buffer of the previously decoded frame if it is still in flight, whose
+  // mode info and segmentation map rows this frame has to wait for, or -1.
+  int prev_fb_idx;
+
+  // Frame buffers referenced by this frame, released once it is retired.
+  int held_fb_idx[REFS_PER_FRAME + 2];
+  int num_held_fbs;
+
+  // Set when the frame context has to be copied back to the decoder once the
+  // backward adaptation on this worker is done.
+  int refresh_frame_context;
+
+  // Mode info and above context storage, sized for (mi_rows, mi_cols).
+  MODE_INFO *mip;
+  MODE_INFO **mi_grid_base;
+  ENTROPY_CONTEXT *above_context;
+  PARTITION_CONTEXT *above_seg_context;
+  int mi_rows;
+  int mi_cols;
+} FrameWorkerData;
+
+// (Re)allocates the row buffers and synchronization for the frame size in cm
+// and num_rows rows in flight.
+void vp9_row_mt_alloc(struct VP9Common *cm, VP9RowMTData *row_mt,
+                      int num_rows);
+
+void vp9_row_mt_dealloc(VP9RowMTData *row_mt);
+
+// Stops the row workers after an error on the parsing thread and clears the
+// coefficients they did not consume.
+void vp9_row_mt_abort(struct VP9Decompressor *pbi);
+
+void vp9_frame_sync_init(VP9FrameSync *frame_sync);
+
+void vp9_frame_sync_destroy(VP9FrameSync *frame_sync);
+
+// Marks rows [0, row) of frame buffer fb_idx as final and wakes up waiters.
+void vp9_frame_sync_signal(VP9FrameSync *frame_sync, int fb_idx, int row);
+
+// Blocks until rows [0, row] of frame buffer fb_idx are final.
+void vp9_frame_sync_wait(VP9FrameSync *frame_sync, int fb_idx, int row);
+
+// (Re)allocates the mode info and above context of a frame worker for the
+// frame size in cm.
+void vp9_frame_worker_alloc(struct VP9Common *cm, FrameWorkerData *fwd);
+
+void vp9_frame_worker_dealloc(FrameWorkerData *fwd);
 
 #endif  // VP9_DECODER_VP9_DTHREAD_H_
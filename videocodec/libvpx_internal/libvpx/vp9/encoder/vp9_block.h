@@ -15,11 +15,15 @@
 #include "vp9/common/vp9_entropy.h"
 #include "vpx_ports/mem.h"
 #include "vp9/common/vp9_onyxc_int.h"
+#include "vp9/encoder/vp9_motion_field.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define MAX_MODES 30
+#define MAX_REFS  6
+
 // motion search site
 typedef struct {
   MV mv;
@@ -99,6 +103,9 @@ struct macroblock {
   search_site *ss;
   int ss_count;
   int searches_per_step;
+  // If not NULL, the SAD evaluations of the full pel motion searches at full
+  // resolution are added to it.
+  unsigned int *sad_count;
 
   int errorperbit;
   int sadperbit16;
@@ -167,6 +174,34 @@ struct macroblock {
   // Used to store sub partition's choices.
   int_mv pred_mv[MAX_REF_FRAMES];
 
+  int partition_cost[PARTITION_CONTEXTS][PARTITION_TYPES];
+
+  BLOCK_SIZE b_partitioning[4][4][4];
+  BLOCK_SIZE mb_partitioning[4][4];
+  BLOCK_SIZE sb_partitioning[4];
+  BLOCK_SIZE sb64_partitioning;
+
+  // Partition size limits of the current superblock.
+  BLOCK_SIZE min_partition_size;
+  BLOCK_SIZE max_partition_size;
+
+  // Adaptive rd thresholds of the tile being encoded.
+  int (*thresh_freq_fact)[MAX_MODES];
+  int (*thresh_freq_sub8x8)[MAX_REFS];
+
+  // Motion field cache statistics of the thread encoding the block.
+  MOTION_FIELD_STATS *mv_field_stats;
+
+  // Degradation of the non-RD search of the superblock row, to encode the
+  // frame within its deadline. See vp9_deadline.h.
+  int deadline_level;
+
+  int zbin_mode_boost;
+
+  void (*fwd_txm4x4)(const int16_t *input, int16_t *output, int stride);
+
+  // The mode contexts own their coefficient buffers, so they must stay last:
+  // tile encoding threads copy everything before them from the main thread.
   // TODO(jingning): Need to refactor the structure arrays that buffers the
   // coding mode decisions of each partition type.
   PICK_MODE_CONTEXT ab4x4_context[4][4][4];
@@ -183,14 +218,6 @@ struct macroblock {
   PICK_MODE_CONTEXT sb32x64_context[2];
   PICK_MODE_CONTEXT sb64x32_context[2];
   PICK_MODE_CONTEXT sb64_context;
-  int partition_cost[PARTITION_CONTEXTS][PARTITION_TYPES];
-
-  BLOCK_SIZE b_partitioning[4][4][4];
-  BLOCK_SIZE mb_partitioning[4][4];
-  BLOCK_SIZE sb_partitioning[4];
-  BLOCK_SIZE sb64_partitioning;
-
-  void (*fwd_txm4x4)(const int16_t *input, int16_t *output, int stride);
 };
 
 // TODO(jingning): the variables used here are little complicated. need further
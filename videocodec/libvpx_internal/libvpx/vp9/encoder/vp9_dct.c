@@ -311,6 +311,22 @@ void vp9_fdct8x8_c(const int16_t *input, int16_t *final_output, int stride) {
   }
 }
 
+void vp9_fdct8x8_quant_c(const int16_t *input, int stride,
+                         int16_t *coeff_ptr, intptr_t n_coeffs,
+                         int skip_block, const int16_t *zbin_ptr,
+                         const int16_t *round_ptr, const int16_t *quant_ptr,
+                         const int16_t *quant_shift_ptr, int16_t *qcoeff_ptr,
+                         int16_t *dqcoeff_ptr, const int16_t *dequant_ptr,
+                         int zbin_oq_value, uint16_t *eob_ptr,
+                         const int16_t *scan, const int16_t *iscan) {
+  // Without a fused version, the best transform and quantizer of the CPU
+  // run one after the other.
+  vp9_fdct8x8(input, coeff_ptr, stride);
+  vp9_quantize_b(coeff_ptr, n_coeffs, skip_block, zbin_ptr, round_ptr,
+                 quant_ptr, quant_shift_ptr, qcoeff_ptr, dqcoeff_ptr,
+                 dequant_ptr, zbin_oq_value, eob_ptr, scan, iscan);
+}
+
 void vp9_fdct16x16_c(const int16_t *input, int16_t *output, int stride) {
   // The 2D transform is done with two passes which are actually pretty
   // similar. In the first one, we transform the columns and transpose
@@ -0,0 +1,140 @@
+/*
+ *  Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "./vpx_config.h"
+#include "vpx_mem/vpx_mem.h"
+#include "vpx_ports/vpx_timer.h"
+
+#include "vp9/common/vp9_common.h"
+#include "vp9/common/vp9_thread.h"
+
+#include "vp9/encoder/vp9_deadline.h"
+
+struct FRAME_DEADLINE {
+#if CONFIG_MULTITHREAD
+  // The rows of a frame may be encoded by several threads.
+  pthread_mutex_t mutex;
+#endif
+  int64_t budget;
+  struct vpx_usec_timer timer;  // started with the frame
+  int64_t rows_start;           // times since the start of the frame
+  int64_t rows_end;
+  // Time the last frame took after its superblock rows, for the loop filter
+  // and the bitstream, which the rows of this frame leave to it.
+  int64_t tail;
+  int rows;
+  int rows_done;
+  int level;
+  int max_level;  // of the rows of the frame
+};
+
+static int64_t frame_time(const FRAME_DEADLINE *dl) {
+  struct vpx_usec_timer timer = dl->timer;
+  vpx_usec_timer_mark(&timer);
+  return vpx_usec_timer_elapsed(&timer);
+}
+
+FRAME_DEADLINE *vp9_deadline_alloc(void) {
+  FRAME_DEADLINE *const dl = vpx_calloc(1, sizeof(*dl));
+  if (dl == NULL)
+    return NULL;
+
+#if CONFIG_MULTITHREAD
+  pthread_mutex_init(&dl->mutex, NULL);
+#endif
+  return dl;
+}
+
+void vp9_deadline_free(FRAME_DEADLINE *dl) {
+  if (dl == NULL)
+    return;
+
+#if CONFIG_MULTITHREAD
+  pthread_mutex_destroy(&dl->mutex);
+#endif
+  vpx_free(dl);
+}
+
+void vp9_deadline_start_frame(FRAME_DEADLINE *dl, int64_t budget) {
+  vpx_usec_timer_start(&dl->timer);
+  if (budget == 0) {
+    dl->tail = 0;
+    dl->level = 0;
+  }
+  dl->budget = budget;
+  dl->rows = 0;
+  dl->rows_done = 0;
+  dl->rows_start = 0;
+  dl->rows_end = 0;
+  dl->max_level = 0;
+}
+
+void vp9_deadline_start_rows(FRAME_DEADLINE *dl, int rows) {
+  dl->rows = rows;
+  dl->rows_done = 0;
+  dl->rows_start = frame_time(dl);
+}
+
+int vp9_deadline_row_level(FRAME_DEADLINE *dl) {
+  int level;
+
+  if (dl->budget == 0)
+    return 0;
+
+#if CONFIG_MULTITHREAD
+  pthread_mutex_lock(&dl->mutex);
+#endif
+  level = dl->level;
+  dl->max_level = MAX(dl->max_level, level);
+#if CONFIG_MULTITHREAD
+  pthread_mutex_unlock(&dl->mutex);
+#endif
+  return level;
+}
+
+void vp9_deadline_row_done(FRAME_DEADLINE *dl) {
+  int64_t now, rows_time, limit;
+
+  if (dl->budget == 0)
+    return;
+
+  now = frame_time(dl);
+#if CONFIG_MULTITHREAD
+  pthread_mutex_lock(&dl->mutex);
+#endif
+  ++dl->rows_done;
+  // The time the rows of the frame would take at the pace of those done, and
+  // the time they have.
+  rows_time = (now - dl->rows_start) * dl->rows / dl->rows_done;
+  limit = dl->budget - dl->tail - dl->rows_start;
+  if (rows_time > limit) {
+    dl->level = MIN(dl->level + 1, DEADLINE_LEVELS - 1);
+  } else if (4 * rows_time < 3 * limit) {
+    dl->level = MAX(dl->level - 1, 0);
+  }
+#if CONFIG_MULTITHREAD
+  pthread_mutex_unlock(&dl->mutex);
+#endif
+}
+
+void vp9_deadline_end_rows(FRAME_DEADLINE *dl) {
+  dl->rows_end = frame_time(dl);
+}
+
+void vp9_deadline_end_frame(FRAME_DEADLINE *dl, int64_t *elapsed, int *level) {
+  const int64_t now = frame_time(dl);
+
+  // Frames encoded without rows to time, as the ones dropped by the rate
+  // control, leave the tail as it was.
+  if (dl->rows_done > 0)
+    dl->tail = now - dl->rows_end;
+  *elapsed = now;
+  *level = dl->max_level;
+}
@@ -0,0 +1,62 @@
+/*
+ *  Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef VP9_ENCODER_VP9_DEADLINE_H_
+#define VP9_ENCODER_VP9_DEADLINE_H_
+
+#include "vpx/vpx_integer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Levels of degradation of the non-RD search of realtime frames, to encode
+// them within a time budget. Each level also degrades as the ones below it:
+// 0: the search of the speed features.
+// 1: new motion vectors searched within 64 pixels, to quarter pel.
+// 2: within 16 pixels, to half pel, with neither NEARMV nor intra modes, and
+//    partitions set from the source variance instead of searched.
+// 3: no new motion vectors, and 32x32 partitions.
+#define DEADLINE_LEVELS 4
+
+struct FRAME_DEADLINE;
+typedef struct FRAME_DEADLINE FRAME_DEADLINE;
+
+FRAME_DEADLINE *vp9_deadline_alloc(void);
+
+void vp9_deadline_free(FRAME_DEADLINE *dl);
+
+// Starts the timing of a frame, to be encoded in budget microseconds, or
+// without a budget if budget is 0.
+void vp9_deadline_start_frame(FRAME_DEADLINE *dl, int64_t budget);
+
+// Called before the superblock rows of the frame, rows of them in all of its
+// tile columns, are encoded.
+void vp9_deadline_start_rows(FRAME_DEADLINE *dl, int rows);
+
+// Returns the level of the superblock row about to be encoded.
+int vp9_deadline_row_level(FRAME_DEADLINE *dl);
+
+// Called as a superblock row is done. Raises the level if the rows left would
+// not be done in time at the pace of the rows done so far, and lowers it if
+// they would be done well in time.
+void vp9_deadline_row_done(FRAME_DEADLINE *dl);
+
+void vp9_deadline_end_rows(FRAME_DEADLINE *dl);
+
+// Ends the frame, returning its encode time in microseconds and the highest
+// level of its rows. The next frame starts at the level this one ended at.
+void vp9_deadline_end_frame(FRAME_DEADLINE *dl, int64_t *elapsed, int *level);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // VP9_ENCODER_VP9_DEADLINE_H_
@@ -19,6 +19,8 @@ extern "C" {
 struct macroblock;
 struct yv12_buffer_config;
 struct VP9_COMP;
+struct ThreadData;
+struct VP9RowMTSync;
 
 void vp9_setup_src_planes(struct macroblock *x,
                           const struct yv12_buffer_config *src,
@@ -26,6 +28,17 @@ void vp9_setup_src_planes(struct macroblock *x,
 
 void vp9_encode_frame(struct VP9_COMP *cpi);
 
+// Encodes the superblocks of one tile with the thread's own macroblock and
+// counts, writing the tokens of each superblock row to its cpi->row_data.
+void vp9_encode_tile(struct VP9_COMP *cpi, struct ThreadData *td,
+                     int tile_row, int tile_col);
+
+// Encodes one superblock row of a tile. With row_sync, each superblock
+// waits for the row above it and is signaled to the row below it once done.
+void vp9_encode_sb_row(struct VP9_COMP *cpi, struct ThreadData *td,
+                       int tile_row, int tile_col, int mi_row,
+                       struct VP9RowMTSync *row_sync);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -346,11 +346,10 @@ void vp9_xform_quant(MACROBLOCK *x, int plane, int block,
                      scan_order->scan, scan_order->iscan);
       break;
     case TX_8X8:
-      vp9_fdct8x8(src_diff, coeff, diff_stride);
-      vp9_quantize_b(coeff, 64, x->skip_block, p->zbin, p->round,
-                     p->quant, p->quant_shift, qcoeff, dqcoeff,
-                     pd->dequant, p->zbin_extra, eob,
-                     scan_order->scan, scan_order->iscan);
+      vp9_fdct8x8_quant(src_diff, diff_stride, coeff, 64, x->skip_block,
+                        p->zbin, p->round, p->quant, p->quant_shift, qcoeff,
+                        dqcoeff, pd->dequant, p->zbin_extra, eob,
+                        scan_order->scan, scan_order->iscan);
       break;
     case TX_4X4:
       x->fwd_txm4x4(src_diff, coeff, diff_stride);
@@ -550,11 +549,18 @@ static void encode_block_intra(int plane, int block, BLOCK_SIZE plane_bsize,
       if (!x->skip_recode) {
         vp9_subtract_block(8, 8, src_diff, diff_stride,
                            src, src_stride, dst, dst_stride);
-        vp9_fht8x8(src_diff, coeff, diff_stride, tx_type);
-        vp9_quantize_b(coeff, 64, x->skip_block, p->zbin, p->round, p->quant,
-                       p->quant_shift, qcoeff, dqcoeff,
-                       pd->dequant, p->zbin_extra, eob, scan_order->scan,
-                       scan_order->iscan);
+        if (tx_type == DCT_DCT) {
+          vp9_fdct8x8_quant(src_diff, diff_stride, coeff, 64, x->skip_block,
+                            p->zbin, p->round, p->quant, p->quant_shift,
+                            qcoeff, dqcoeff, pd->dequant, p->zbin_extra, eob,
+                            scan_order->scan, scan_order->iscan);
+        } else {
+          vp9_fht8x8(src_diff, coeff, diff_stride, tx_type);
+          vp9_quantize_b(coeff, 64, x->skip_block, p->zbin, p->round,
+                         p->quant, p->quant_shift, qcoeff, dqcoeff,
+                         pd->dequant, p->zbin_extra, eob, scan_order->scan,
+                         scan_order->iscan);
+        }
       }
       if (!x->skip_encode && *eob)
         vp9_iht8x8_add(tx_type, dqcoeff, dst, dst_stride, *eob);
@@ -0,0 +1,420 @@
+/*
+ *  Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <limits.h>
+#include <stddef.h>
+
+#include "vpx_mem/vpx_mem.h"
+
+#include "vp9/common/vp9_thread_common.h"
+
+#include "vp9/encoder/vp9_encodeframe.h"
+#include "vp9/encoder/vp9_ethread.h"
+#include "vp9/encoder/vp9_firstpass.h"
+#include "vp9/encoder/vp9_onyx_int.h"
+#include "vp9/encoder/vp9_temporal_filter.h"
+
+static void accumulate_frame_counts(FRAME_COUNTS *dst,
+                                    const FRAME_COUNTS *src) {
+  unsigned int *const d = (unsigned int *)dst;
+  const unsigned int *const s = (const unsigned int *)src;
+  size_t i;
+
+  for (i = 0; i < sizeof(*dst) / sizeof(*d); ++i)
+    d[i] += s[i];
+}
+
+static void accumulate_rd_counts(RD_COUNTS *dst, const RD_COUNTS *src) {
+  unsigned int *const d = (unsigned int *)dst->coef_counts;
+  const unsigned int *const s = (const unsigned int *)src->coef_counts;
+  size_t i;
+
+  for (i = 0; i < sizeof(dst->coef_counts) / sizeof(*d); ++i)
+    d[i] += s[i];
+
+  for (i = 0; i < REFERENCE_MODES; ++i)
+    dst->comp_pred_diff[i] += src->comp_pred_diff[i];
+
+  for (i = 0; i < TX_MODES; ++i)
+    dst->tx_select_diff[i] += src->tx_select_diff[i];
+
+  for (i = 0; i < SWITCHABLE_FILTER_CONTEXTS; ++i)
+    dst->filter_diff[i] += src->filter_diff[i];
+
+#if CONFIG_INTERNAL_STATS
+  for (i = 0; i < MAX_MODES; ++i)
+    dst->mode_chosen_counts[i] += src->mode_chosen_counts[i];
+#endif
+
+  vp9_accumulate_motion_field_stats(&dst->mv_field_stats,
+                                    &src->mv_field_stats);
+}
+
+static int enc_worker_hook(EncWorkerData *const thread_data, void *unused) {
+  VP9_COMP *const cpi = thread_data->cpi;
+  const VP9_COMMON *const cm = &cpi->common;
+  const int tile_cols = 1 << cm->log2_tile_cols;
+  const int tile_rows = 1 << cm->log2_tile_rows;
+  const int num_workers = MIN(cpi->num_workers, tile_cols);
+  int tile_col, tile_row;
+  (void)unused;
+
+  // Tiles of a column depend on the ones above them, so each worker takes
+  // whole columns and encodes them top to bottom.
+  for (tile_col = thread_data->start; tile_col < tile_cols;
+       tile_col += num_workers)
+    for (tile_row = 0; tile_row < tile_rows; ++tile_row)
+      vp9_encode_tile(cpi, thread_data->td, tile_row, tile_col);
+
+  return 1;
+}
+
+// Hands out the rows in order, so the row a worker waits for has always been
+// handed out before.
+static int get_next_job(VP9RowMTInfo *const row_mt_info) {
+  int job;
+#if CONFIG_MULTITHREAD
+  pthread_mutex_lock(&row_mt_info->job_mutex_);
+#endif
+  job = row_mt_info->next_job++;
+#if CONFIG_MULTITHREAD
+  pthread_mutex_unlock(&row_mt_info->job_mutex_);
+#endif
+  return job;
+}
+
+static int enc_row_mt_worker_hook(EncWorkerData *const thread_data,
+                                  void *unused) {
+  VP9_COMP *const cpi = thread_data->cpi;
+  const VP9_COMMON *const cm = &cpi->common;
+  VP9RowMTInfo *const row_mt_info = &cpi->row_mt_info;
+  const int tile_cols = 1 << cm->log2_tile_cols;
+  const int sb_rows = mi_cols_aligned_to_sb(cm->mi_rows) >> MI_BLOCK_SIZE_LOG2;
+  int job;
+  (void)unused;
+
+  while ((job = get_next_job(row_mt_info)) < tile_cols * sb_rows) {
+    const int tile_col = job / sb_rows;
+    const int mi_row = (job % sb_rows) << MI_BLOCK_SIZE_LOG2;
+    int tile_row = 0;
+
+    while (mi_row >=
+           cpi->tile_data[tile_row * tile_cols + tile_col].tile_info.mi_row_end)
+      ++tile_row;
+
+    vp9_encode_sb_row(cpi, thread_data->td, tile_row, tile_col, mi_row,
+                      &row_mt_info->row_sync[tile_col]);
+  }
+
+  return 1;
+}
+
+static int fp_row_mt_worker_hook(EncWorkerData *const thread_data,
+                                 void *unused) {
+  VP9_COMP *const cpi = thread_data->cpi;
+  VP9RowMTInfo *const row_mt_info = &cpi->row_mt_info;
+  int mb_row;
+  (void)unused;
+
+  while ((mb_row = get_next_job(row_mt_info)) < cpi->common.mb_rows)
+    vp9_first_pass_encode_mb_row(cpi, thread_data->td, mb_row,
+                                 &row_mt_info->row_sync[0]);
+
+  return 1;
+}
+
+static int tf_row_mt_worker_hook(EncWorkerData *const thread_data,
+                                 void *unused) {
+  VP9_COMP *const cpi = thread_data->cpi;
+  VP9RowMTInfo *const row_mt_info = &cpi->row_mt_info;
+  int mb_row;
+  (void)unused;
+
+  while ((mb_row = get_next_job(row_mt_info)) < cpi->common.mb_rows)
+    vp9_temporal_filter_iterate_row(cpi, thread_data->td, mb_row);
+
+  return 1;
+}
+
+static void create_enc_workers(VP9_COMP *cpi, int num_workers) {
+  VP9_COMMON *const cm = &cpi->common;
+  int i;
+
+  CHECK_MEM_ERROR(cm, cpi->workers,
+                  vpx_malloc(num_workers * sizeof(*cpi->workers)));
+  CHECK_MEM_ERROR(cm, cpi->tile_thr_data,
+                  vpx_calloc(num_workers, sizeof(*cpi->tile_thr_data)));
+
+  for (i = 0; i < num_workers; ++i) {
+    VP9Worker *const worker = &cpi->workers[i];
+    EncWorkerData *const thread_data = &cpi->tile_thr_data[i];
+
+    ++cpi->num_workers;
+    vp9_worker_init(worker);
+    thread_data->cpi = cpi;
+
+    if (i < num_workers - 1) {
+      // Each thread has its own macroblock, mode contexts and counts.
+      CHECK_MEM_ERROR(cm, thread_data->td,
+                      vpx_memalign(32, sizeof(*thread_data->td)));
+      vp9_zero(*thread_data->td);
+      vp9_alloc_pick_mode_context(cm, &thread_data->td->mb);
+      CHECK_MEM_ERROR(cm, thread_data->td->counts,
+                      vpx_calloc(1, sizeof(*thread_data->td->counts)));
+
+      if (!vp9_worker_reset(worker))
+        vpx_internal_error(&cm->error, VPX_CODEC_ERROR,
+                           "Tile encoder thread creation failed");
+    } else {
+      // The main thread encodes with cpi->td.
+      thread_data->td = &cpi->td;
+    }
+
+    worker->data1 = thread_data;
+    worker->data2 = NULL;
+  }
+}
+
+// Runs hook on the first num_workers workers and merges their counts into the
+// ones of the main thread.
+static void launch_enc_workers(VP9_COMP *cpi, VP9WorkerHook hook,
+                               int num_workers) {
+  VP9_COMMON *const cm = &cpi->common;
+  int i;
+
+  for (i = 0; i < num_workers; ++i) {
+    VP9Worker *const worker = &cpi->workers[i];
+    EncWorkerData *const thread_data = (EncWorkerData *)worker->data1;
+    ThreadData *const td = thread_data->td;
+
+    worker->hook = hook;
+    thread_data->start = i;
+
+    if (td != &cpi->td) {
+      MACROBLOCK *const x = &td->mb;
+      // Take the frame level state of the main thread's macroblock, but
+      // not its mode contexts and their buffers.
+      vpx_memcpy(x, &cpi->td.mb, offsetof(MACROBLOCK, ab4x4_context));
+      vp9_zero(td->rd_counts);
+      vp9_zero(*td->counts);
+
+      if (cpi->sf.use_nonrd_pick_mode) {
+        struct macroblock_plane *const p = x->plane;
+        struct macroblockd_plane *const pd = x->e_mbd.plane;
+        PICK_MODE_CONTEXT *const ctx = &x->sb64_context;
+        int j;
+
+        for (j = 0; j < MAX_MB_PLANE; ++j) {
+          p[j].coeff = ctx->coeff_pbuf[j][0];
+          p[j].qcoeff = ctx->qcoeff_pbuf[j][0];
+          pd[j].dqcoeff = ctx->dqcoeff_pbuf[j][0];
+          p[j].eobs = ctx->eobs_pbuf[j][0];
+        }
+        vp9_zero(x->zcoeff_blk);
+      }
+    }
+  }
+
+  // The last worker runs on the calling thread.
+  for (i = 0; i < num_workers; ++i) {
+    VP9Worker *const worker = &cpi->workers[i];
+    worker->had_error = 0;
+    if (i == num_workers - 1)
+      vp9_worker_execute(worker);
+    else
+      vp9_worker_launch(worker);
+  }
+
+  for (i = 0; i < num_workers; ++i)
+    vp9_worker_sync(&cpi->workers[i]);
+
+  for (i = 0; i < num_workers; ++i) {
+    const ThreadData *const td = cpi->tile_thr_data[i].td;
+    if (td != &cpi->td) {
+      accumulate_frame_counts(&cm->counts, td->counts);
+      accumulate_rd_counts(&cpi->td.rd_counts, &td->rd_counts);
+    }
+  }
+}
+
+void vp9_encode_tiles_mt(VP9_COMP *cpi) {
+  const VP9_COMMON *const cm = &cpi->common;
+  const int tile_cols = 1 << cm->log2_tile_cols;
+
+  if (cpi->num_workers == 0)
+    create_enc_workers(cpi, MIN(cpi->oxcf.max_threads, tile_cols));
+
+  launch_enc_workers(cpi, (VP9WorkerHook)enc_worker_hook,
+                     MIN(cpi->num_workers, tile_cols));
+}
+
+void vp9_row_mt_sync_read(VP9RowMTSync *const row_sync, int r, int c) {
+#if CONFIG_MULTITHREAD
+  if (r > 0) {
+    pthread_mutex_lock(&row_sync->mutex_[r - 1]);
+    while (c >= row_sync->cur_col[r - 1])
+      pthread_cond_wait(&row_sync->cond_[r - 1], &row_sync->mutex_[r - 1]);
+    pthread_mutex_unlock(&row_sync->mutex_[r - 1]);
+  }
+#else
+  (void)row_sync;
+  (void)r;
+  (void)c;
+#endif  // CONFIG_MULTITHREAD
+}
+
+void vp9_row_mt_sync_write(VP9RowMTSync *const row_sync, int r, int c,
+                           int sb_cols) {
+#if CONFIG_MULTITHREAD
+  pthread_mutex_lock(&row_sync->mutex_[r]);
+  // Once the row is done, the row below can run to its end.
+  row_sync->cur_col[r] = c < sb_cols - 1 ? c : INT_MAX;
+  // Only the row below waits for this one.
+  pthread_cond_signal(&row_sync->cond_[r]);
+  pthread_mutex_unlock(&row_sync->mutex_[r]);
+#else
+  (void)row_sync;
+  (void)r;
+  (void)c;
+  (void)sb_cols;
+#endif  // CONFIG_MULTITHREAD
+}
+
+static void row_mt_alloc(VP9_COMMON *cm, VP9RowMTInfo *row_mt_info,
+                         int tile_cols, int rows) {
+  int i;
+
+  if (row_mt_info->row_sync != NULL && row_mt_info->tile_cols == tile_cols &&
+      row_mt_info->rows == rows)
+    return;
+
+  vp9_enc_row_mt_dealloc(row_mt_info);
+
+  CHECK_MEM_ERROR(cm, row_mt_info->row_sync,
+                  vpx_calloc(tile_cols, sizeof(*row_mt_info->row_sync)));
+  row_mt_info->tile_cols = tile_cols;
+  row_mt_info->rows = rows;
+#if CONFIG_MULTITHREAD
+  pthread_mutex_init(&row_mt_info->job_mutex_, NULL);
+#endif
+
+  for (i = 0; i < tile_cols; ++i) {
+    VP9RowMTSync *const row_sync = &row_mt_info->row_sync[i];
+#if CONFIG_MULTITHREAD
+    int r;
+
+    CHECK_MEM_ERROR(cm, row_sync->mutex_,
+                    vpx_malloc(sizeof(*row_sync->mutex_) * rows));
+    CHECK_MEM_ERROR(cm, row_sync->cond_,
+                    vpx_malloc(sizeof(*row_sync->cond_) * rows));
+    for (r = 0; r < rows; ++r) {
+      pthread_mutex_init(&row_sync->mutex_[r], NULL);
+      pthread_cond_init(&row_sync->cond_[r], NULL);
+    }
+#endif  // CONFIG_MULTITHREAD
+
+    CHECK_MEM_ERROR(cm, row_sync->cur_col,
+                    vpx_malloc(sizeof(*row_sync->cur_col) * rows));
+  }
+}
+
+// Sets up the synchronization of rows rows in each of tile_cols columns, none
+// of them started.
+static void row_mt_prepare(VP9_COMP *cpi, int tile_cols, int rows) {
+  VP9RowMTInfo *const row_mt_info = &cpi->row_mt_info;
+  int i;
+
+  row_mt_alloc(&cpi->common, row_mt_info, tile_cols, rows);
+  for (i = 0; i < tile_cols; ++i)
+    vpx_memset(row_mt_info->row_sync[i].cur_col, -1,
+               sizeof(*row_mt_info->row_sync[i].cur_col) * rows);
+  row_mt_info->next_job = 0;
+}
+
+void vp9_enc_row_mt_dealloc(VP9RowMTInfo *row_mt_info) {
+  int i;
+
+  if (row_mt_info->row_sync == NULL)
+    return;
+
+  for (i = 0; i < row_mt_info->tile_cols; ++i) {
+    VP9RowMTSync *const row_sync = &row_mt_info->row_sync[i];
+#if CONFIG_MULTITHREAD
+    int r;
+
+    // The allocation stops at the first failure, so the rows of a column are
+    // either all initialized or none of them are.
+    if (row_sync->mutex_ != NULL && row_sync->cond_ != NULL) {
+      for (r = 0; r < row_mt_info->rows; ++r) {
+        pthread_mutex_destroy(&row_sync->mutex_[r]);
+        pthread_cond_destroy(&row_sync->cond_[r]);
+      }
+    }
+    vpx_free(row_sync->mutex_);
+    vpx_free(row_sync->cond_);
+#endif  // CONFIG_MULTITHREAD
+    vpx_free(row_sync->cur_col);
+  }
+#if CONFIG_MULTITHREAD
+  pthread_mutex_destroy(&row_mt_info->job_mutex_);
+#endif
+  vpx_free(row_mt_info->row_sync);
+  vp9_zero(*row_mt_info);
+}
+
+void vp9_encode_tiles_row_mt(VP9_COMP *cpi) {
+  const VP9_COMMON *const cm = &cpi->common;
+  const int tile_cols = 1 << cm->log2_tile_cols;
+  const int sb_rows = mi_cols_aligned_to_sb(cm->mi_rows) >> MI_BLOCK_SIZE_LOG2;
+
+  if (cpi->num_workers == 0)
+    create_enc_workers(cpi, cpi->oxcf.max_threads);
+
+  row_mt_prepare(cpi, tile_cols, sb_rows);
+  launch_enc_workers(cpi, (VP9WorkerHook)enc_row_mt_worker_hook,
+                     MIN(cpi->num_workers, tile_cols * sb_rows));
+}
+
+void vp9_first_pass_row_mt(VP9_COMP *cpi) {
+  const VP9_COMMON *const cm = &cpi->common;
+
+  if (cpi->num_workers == 0)
+    create_enc_workers(cpi, cpi->oxcf.max_threads);
+
+  // The first pass ignores tiling, so all macroblock rows are in one column.
+  row_mt_prepare(cpi, 1, cm->mb_rows);
+  launch_enc_workers(cpi, (VP9WorkerHook)fp_row_mt_worker_hook,
+                     MIN(cpi->num_workers, cm->mb_rows));
+}
+
+void vp9_temporal_filter_row_mt(VP9_COMP *cpi) {
+  const VP9_COMMON *const cm = &cpi->common;
+
+  if (cpi->num_workers == 0)
+    create_enc_workers(cpi, cpi->oxcf.max_threads);
+
+  // The rows do not wait for each other, so only the job counter of the
+  // synchronization is used.
+  row_mt_prepare(cpi, 1, cm->mb_rows);
+  launch_enc_workers(cpi, (VP9WorkerHook)tf_row_mt_worker_hook,
+                     MIN(cpi->num_workers, cm->mb_rows));
+}
+
+void vp9_loop_filter_row_mt(VP9_COMP *cpi, int frame_filter_level, int y_only,
+                            int partial_frame) {
+  VP9_COMMON *const cm = &cpi->common;
+
+  if (cpi->num_workers == 0)
+    create_enc_workers(cpi, cpi->oxcf.max_threads);
+
+  vp9_loop_filter_frame_mt(cm->frame_to_show, cm, &cpi->td.mb.e_mbd,
+                           frame_filter_level, y_only, partial_frame,
+                           cpi->workers, cpi->num_workers, &cpi->lf_row_sync);
+}
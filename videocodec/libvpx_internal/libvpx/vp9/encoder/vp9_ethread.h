@@ -0,0 +1,94 @@
+/*
+ *  Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef VP9_ENCODER_VP9_ETHREAD_H_
+#define VP9_ENCODER_VP9_ETHREAD_H_
+
+#include "./vpx_config.h"
+#include "vp9/common/vp9_thread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct ThreadData;
+struct VP9_COMP;
+
+typedef struct EncWorkerData {
+  struct VP9_COMP *cpi;
+  struct ThreadData *td;
+  int start;  // first tile column of the worker
+} EncWorkerData;
+
+// Superblock row synchronization of a tile column, or macroblock row
+// synchronization of the frame in the first pass.
+typedef struct VP9RowMTSync {
+#if CONFIG_MULTITHREAD
+  pthread_mutex_t *mutex_;
+  pthread_cond_t *cond_;
+#endif
+  // Index in the tile of the last superblock encoded in each superblock row
+  // of the frame, INT_MAX once the row is done. A row stays one superblock
+  // behind the one above it, whose above right pixels its intra prediction
+  // reads.
+  int *cur_col;
+} VP9RowMTSync;
+
+typedef struct VP9RowMTInfo {
+#if CONFIG_MULTITHREAD
+  pthread_mutex_t job_mutex_;
+#endif
+  // Rows are handed out in the order of tile_col * rows + row, so the row a
+  // worker waits for has always been handed out before.
+  int next_job;
+  VP9RowMTSync *row_sync;  // one per tile column
+  int tile_cols;
+  int rows;  // superblock rows, or macroblock rows in the first pass
+} VP9RowMTInfo;
+
+// Encodes the tiles of the frame with up to oxcf.max_threads threads, each
+// taking every num_workers-th tile column. The frame counts and rd statistics
+// of the threads are summed into cm->counts and cpi->td.rd_counts, so the
+// result is identical to encoding the tiles in order on one thread.
+void vp9_encode_tiles_mt(struct VP9_COMP *cpi);
+
+// Encodes the superblock rows of all tile columns with up to
+// oxcf.max_threads threads. Each row starts as soon as the row above it is
+// far enough ahead.
+void vp9_encode_tiles_row_mt(struct VP9_COMP *cpi);
+
+// Runs the first pass over the macroblock rows of the frame with up to
+// oxcf.max_threads threads. Each row starts as soon as the row above it is
+// far enough ahead.
+void vp9_first_pass_row_mt(struct VP9_COMP *cpi);
+
+// Builds the alt-ref frame with the temporal filter over the macroblock rows
+// of the frame with up to oxcf.max_threads threads.
+void vp9_temporal_filter_row_mt(struct VP9_COMP *cpi);
+
+// Loop filters cm->frame_to_show like vp9_loop_filter_frame() with up to
+// oxcf.max_threads threads, each taking every num_workers-th superblock row.
+void vp9_loop_filter_row_mt(struct VP9_COMP *cpi, int frame_filter_level,
+                            int y_only, int partial_frame);
+
+// Blocks until row r - 1 is far enough ahead to encode superblock c of row
+// r, and marks superblock c of row r as done. sb_cols is the width of the
+// tile in superblocks.
+void vp9_row_mt_sync_read(VP9RowMTSync *const row_sync, int r, int c);
+void vp9_row_mt_sync_write(VP9RowMTSync *const row_sync, int r, int c,
+                           int sb_cols);
+
+void vp9_enc_row_mt_dealloc(VP9RowMTInfo *row_mt_info);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // VP9_ENCODER_VP9_ETHREAD_H_
@@ -468,9 +468,10 @@ static BLOCK_SIZE get_bsize(const VP9_COMMON *cm, int mb_row, int mb_col) {
   }
 }
 
-void vp9_first_pass(VP9_COMP *cpi) {
-  int mb_row, mb_col;
-  MACROBLOCK *const x = &cpi->mb;
+void vp9_first_pass_encode_mb_row(VP9_COMP *cpi, ThreadData *td, int mb_row,
+                                  VP9RowMTSync *row_sync) {
+  int mb_col;
+  MACROBLOCK *const x = &td->mb;
   VP9_COMMON *const cm = &cpi->common;
   MACROBLOCKD *const xd = &x->e_mbd;
   TileInfo tile;
@@ -479,13 +480,272 @@ void vp9_first_pass(VP9_COMP *cpi) {
   const PICK_MODE_CONTEXT *ctx = &x->sb64_context;
   int i;
 
-  int recon_yoffset, recon_uvoffset;
+  const YV12_BUFFER_CONFIG *const first_ref_buf = cpi->fp_first_ref_buf;
+  const YV12_BUFFER_CONFIG *const gld_yv12 = cpi->fp_gld_buf;
+  YV12_BUFFER_CONFIG *const new_yv12 = get_frame_new_buffer(cm);
+  const int uv_mb_height =
+      16 >> (first_ref_buf->y_height > first_ref_buf->uv_height);
+  int recon_yoffset = mb_row * first_ref_buf->y_stride * 16;
+  int recon_uvoffset = mb_row * first_ref_buf->uv_stride * uv_mb_height;
+  FIRSTPASS_ROW_STATS *const stats = &cpi->fp_row_stats[mb_row];
+  const int intrapenalty = 256;
+  uint32_t lastmv_as_int = 0;
+  const MV zero_mv = {0, 0};
+  int_mv best_ref_mv;
+
+  vp9_zero(*stats);
+
+  vp9_setup_src_planes(x, cpi->Source, 0, 0);
+  x->plane[0].src.buf += mb_row * 16 * x->plane[0].src.stride;
+  x->plane[1].src.buf += mb_row * uv_mb_height * x->plane[1].src.stride;
+  x->plane[2].src.buf += mb_row * uv_mb_height * x->plane[1].src.stride;
+
+  for (i = 0; i < MAX_MB_PLANE; ++i) {
+    p[i].coeff = ctx->coeff_pbuf[i][1];
+    p[i].qcoeff = ctx->qcoeff_pbuf[i][1];
+    pd[i].dqcoeff = ctx->dqcoeff_pbuf[i][1];
+    p[i].eobs = ctx->eobs_pbuf[i][1];
+  }
+
+  // Tiling is ignored in the first pass.
+  vp9_tile_init(&tile, cm, 0, 0);
+
+  best_ref_mv.as_int = 0;
+
+  // Reset above block coeffs.
+  xd->up_available = (mb_row != 0);
+
+  // Set up limit values for motion vectors to prevent them extending
+  // outside the UMV borders.
+  x->mv_row_min = -((mb_row * 16) + BORDER_MV_PIXELS_B16);
+  x->mv_row_max = ((cm->mb_rows - 1 - mb_row) * 16)
+                  + BORDER_MV_PIXELS_B16;
+
+  for (mb_col = 0; mb_col < cm->mb_cols; ++mb_col) {
+    int this_error;
+    const int use_dc_pred = (mb_col || mb_row) && (!mb_col || !mb_row);
+    double error_weight = 1.0;
+    const BLOCK_SIZE bsize = get_bsize(cm, mb_row, mb_col);
+    const int mi_offset = (mb_row << 1) * cm->mi_stride + (mb_col << 1);
+
+    // The intra prediction reads the reconstruction of the row above.
+    if (row_sync != NULL)
+      vp9_row_mt_sync_read(row_sync, mb_row, mb_col);
+
+    vp9_clear_system_state();
+
+    xd->plane[0].dst.buf = new_yv12->y_buffer + recon_yoffset;
+    xd->plane[1].dst.buf = new_yv12->u_buffer + recon_uvoffset;
+    xd->plane[2].dst.buf = new_yv12->v_buffer + recon_uvoffset;
+    xd->left_available = (mb_col != 0);
+    // Each macroblock has its own mode info, so threads do not share any.
+    xd->mi = cm->mi_grid_visible + mi_offset;
+    xd->mi[0] = cm->mi + mi_offset;
+    xd->mi[0]->mbmi.sb_type = bsize;
+    xd->mi[0]->mbmi.ref_frame[0] = INTRA_FRAME;
+    set_mi_row_col(xd, &tile,
+                   mb_row << 1, num_8x8_blocks_high_lookup[bsize],
+                   mb_col << 1, num_8x8_blocks_wide_lookup[bsize],
+                   cm->mi_rows, cm->mi_cols);
+
+    if (cpi->oxcf.aq_mode == VARIANCE_AQ) {
+      const int energy = vp9_block_energy(cpi, x, bsize);
+      error_weight = vp9_vaq_inv_q_ratio(energy);
+    }
+
+    // Do intra 16x16 prediction.
+    this_error = vp9_encode_intra(x, use_dc_pred);
+    if (cpi->oxcf.aq_mode == VARIANCE_AQ) {
+      vp9_clear_system_state();
+      this_error = (int)(this_error * error_weight);
+    }
+
+    // Intrapenalty below deals with situations where the intra and inter
+    // error scores are very low (e.g. a plain black frame).
+    // We do not have special cases in first pass for 0,0 and nearest etc so
+    // all inter modes carry an overhead cost estimate for the mv.
+    // When the error score is very low this causes us to pick all or lots of
+    // INTRA modes and throw lots of key frames.
+    // This penalty adds a cost matching that of a 0,0 mv to the intra case.
+    this_error += intrapenalty;
+
+    // Accumulate the intra error.
+    stats->intra_error += (int64_t)this_error;
+
+    // Set up limit values for motion vectors to prevent them extending
+    // outside the UMV borders.
+    x->mv_col_min = -((mb_col * 16) + BORDER_MV_PIXELS_B16);
+    x->mv_col_max = ((cm->mb_cols - 1 - mb_col) * 16) + BORDER_MV_PIXELS_B16;
+
+    // Other than for the first frame do a motion search.
+    if (cm->current_video_frame > 0) {
+      int tmp_err, motion_error;
+      int_mv mv, tmp_mv;
+
+      xd->plane[0].pre[0].buf = first_ref_buf->y_buffer + recon_yoffset;
+      motion_error = zz_motion_search(x);
+      // Assume 0,0 motion with no mv overhead.
+      mv.as_int = tmp_mv.as_int = 0;
+
+      // Test last reference frame using the previous best mv as the
+      // starting point (best reference) for the search.
+      first_pass_motion_search(cpi, x, &best_ref_mv.as_mv, &mv.as_mv,
+                               &motion_error);
+      if (cpi->oxcf.aq_mode == VARIANCE_AQ) {
+        vp9_clear_system_state();
+        motion_error = (int)(motion_error * error_weight);
+      }
+
+      // If the current best reference mv is not centered on 0,0 then do a 0,0
+      // based search as well.
+      if (best_ref_mv.as_int) {
+        tmp_err = INT_MAX;
+        first_pass_motion_search(cpi, x, &zero_mv, &tmp_mv.as_mv,
+                                 &tmp_err);
+        if (cpi->oxcf.aq_mode == VARIANCE_AQ) {
+          vp9_clear_system_state();
+          tmp_err = (int)(tmp_err * error_weight);
+        }
+
+        if (tmp_err < motion_error) {
+          motion_error = tmp_err;
+          mv.as_int = tmp_mv.as_int;
+        }
+      }
+
+      // Search in an older reference frame.
+      if (cm->current_video_frame > 1 && gld_yv12 != NULL) {
+        // Assume 0,0 motion with no mv overhead.
+        int gf_motion_error;
+
+        xd->plane[0].pre[0].buf = gld_yv12->y_buffer + recon_yoffset;
+        gf_motion_error = zz_motion_search(x);
+
+        first_pass_motion_search(cpi, x, &zero_mv, &tmp_mv.as_mv,
+                                 &gf_motion_error);
+        if (cpi->oxcf.aq_mode == VARIANCE_AQ) {
+          vp9_clear_system_state();
+          gf_motion_error = (int)(gf_motion_error * error_weight);
+        }
+
+        if (gf_motion_error < motion_error && gf_motion_error < this_error)
+          ++stats->second_ref_count;
+
+        // Reset to last frame as reference buffer.
+        xd->plane[0].pre[0].buf = first_ref_buf->y_buffer + recon_yoffset;
+        xd->plane[1].pre[0].buf = first_ref_buf->u_buffer + recon_uvoffset;
+        xd->plane[2].pre[0].buf = first_ref_buf->v_buffer + recon_uvoffset;
+
+        // In accumulating a score for the older reference frame take the
+        // best of the motion predicted score and the intra coded error
+        // (just as will be done for) accumulation of "coded_error" for
+        // the last frame.
+        if (gf_motion_error < this_error)
+          stats->sr_coded_error += gf_motion_error;
+        else
+          stats->sr_coded_error += this_error;
+      } else {
+        stats->sr_coded_error += motion_error;
+      }
+      // Start by assuming that intra mode is best.
+      best_ref_mv.as_int = 0;
+
+      if (motion_error <= this_error) {
+        // Keep a count of cases where the inter and intra were very close
+        // and very low. This helps with scene cut detection for example in
+        // cropped clips with black bars at the sides or top and bottom.
+        if (((this_error - intrapenalty) * 9 <= motion_error * 10) &&
+            this_error < 2 * intrapenalty)
+          ++stats->neutral_count;
+
+        mv.as_mv.row *= 8;
+        mv.as_mv.col *= 8;
+        this_error = motion_error;
+        xd->mi[0]->mbmi.mode = NEWMV;
+        xd->mi[0]->mbmi.mv[0] = mv;
+        xd->mi[0]->mbmi.tx_size = TX_4X4;
+        xd->mi[0]->mbmi.ref_frame[0] = LAST_FRAME;
+        xd->mi[0]->mbmi.ref_frame[1] = NONE;
+        vp9_build_inter_predictors_sby(xd, mb_row << 1, mb_col << 1, bsize);
+        vp9_encode_sby_pass1(x, bsize);
+        stats->sum_mvr += mv.as_mv.row;
+        stats->sum_mvr_abs += abs(mv.as_mv.row);
+        stats->sum_mvc += mv.as_mv.col;
+        stats->sum_mvc_abs += abs(mv.as_mv.col);
+        stats->sum_mvrs += mv.as_mv.row * mv.as_mv.row;
+        stats->sum_mvcs += mv.as_mv.col * mv.as_mv.col;
+        ++stats->intercount;
+
+        best_ref_mv.as_int = mv.as_int;
+
+        if (mv.as_int) {
+          ++stats->mvcount;
+
+          // Non-zero vector, was it different from the last non zero vector?
+          // The first one of the row is compared once all rows are done.
+          if (stats->first_mv_as_int == 0)
+            stats->first_mv_as_int = mv.as_int;
+          else if (mv.as_int != lastmv_as_int)
+            ++stats->new_mv_count;
+          lastmv_as_int = mv.as_int;
+
+          // Does the row vector point inwards or outwards?
+          if (mb_row < cm->mb_rows / 2) {
+            if (mv.as_mv.row > 0)
+              --stats->sum_in_vectors;
+            else if (mv.as_mv.row < 0)
+              ++stats->sum_in_vectors;
+          } else if (mb_row > cm->mb_rows / 2) {
+            if (mv.as_mv.row > 0)
+              ++stats->sum_in_vectors;
+            else if (mv.as_mv.row < 0)
+              --stats->sum_in_vectors;
+          }
+
+          // Does the col vector point inwards or outwards?
+          if (mb_col < cm->mb_cols / 2) {
+            if (mv.as_mv.col > 0)
+              --stats->sum_in_vectors;
+            else if (mv.as_mv.col < 0)
+              ++stats->sum_in_vectors;
+          } else if (mb_col > cm->mb_cols / 2) {
+            if (mv.as_mv.col > 0)
+              ++stats->sum_in_vectors;
+            else if (mv.as_mv.col < 0)
+              --stats->sum_in_vectors;
+          }
+        }
+      }
+    } else {
+      stats->sr_coded_error += (int64_t)this_error;
+    }
+    stats->coded_error += (int64_t)this_error;
+
+    if (row_sync != NULL)
+      vp9_row_mt_sync_write(row_sync, mb_row, mb_col, cm->mb_cols);
+
+    // Adjust to the next column of MBs.
+    x->plane[0].src.buf += 16;
+    x->plane[1].src.buf += uv_mb_height;
+    x->plane[2].src.buf += uv_mb_height;
+
+    recon_yoffset += 16;
+    recon_uvoffset += uv_mb_height;
+  }
+  stats->last_mv_as_int = lastmv_as_int;
+
+  vp9_clear_system_state();
+}
+
+void vp9_first_pass(VP9_COMP *cpi) {
+  int mb_row;
+  MACROBLOCK *const x = &cpi->td.mb;
+  VP9_COMMON *const cm = &cpi->common;
+  MACROBLOCKD *const xd = &x->e_mbd;
+
   YV12_BUFFER_CONFIG *const lst_yv12 = get_ref_frame_buffer(cpi, LAST_FRAME);
   YV12_BUFFER_CONFIG *gld_yv12 = get_ref_frame_buffer(cpi, GOLDEN_FRAME);
   YV12_BUFFER_CONFIG *const new_yv12 = get_frame_new_buffer(cm);
-  int recon_y_stride = lst_yv12->y_stride;
-  int recon_uv_stride = lst_yv12->uv_stride;
-  int uv_mb_height = 16 >> (lst_yv12->y_height > lst_yv12->uv_height);
   int64_t intra_error = 0;
   int64_t coded_error = 0;
   int64_t sr_coded_error = 0;
@@ -496,13 +756,11 @@ void vp9_first_pass(VP9_COMP *cpi) {
   int mvcount = 0;
   int intercount = 0;
   int second_ref_count = 0;
-  int intrapenalty = 256;
   int neutral_count = 0;
   int new_mv_count = 0;
   int sum_in_vectors = 0;
   uint32_t lastmv_as_int = 0;
   struct twopass_rc *twopass = &cpi->twopass;
-  const MV zero_mv = {0, 0};
   const YV12_BUFFER_CONFIG *first_ref_buf = lst_yv12;
 
   vp9_clear_system_state();
@@ -523,20 +781,15 @@ void vp9_first_pass(VP9_COMP *cpi) {
       ref_frame = ALTREF_FRAME;
     }
 
-    if (scaled_ref_buf != NULL) {
-      // Update the stride since we are using scaled reference buffer
+    // The strides of the scaled reference buffer are used from here on.
+    if (scaled_ref_buf != NULL)
       first_ref_buf = scaled_ref_buf;
-      recon_y_stride = first_ref_buf->y_stride;
-      recon_uv_stride = first_ref_buf->uv_stride;
-      uv_mb_height = 16 >> (first_ref_buf->y_height > first_ref_buf->uv_height);
-    }
 
     // Disable golden frame for svc first pass for now.
     gld_yv12 = NULL;
     set_ref_ptrs(cm, xd, ref_frame, NONE);
   }
 
-  vp9_setup_src_planes(x, cpi->Source, 0, 0);
   vp9_setup_pre_planes(xd, 0, first_ref_buf, 0, 0, NULL);
   vp9_setup_dst_planes(xd, new_yv12, 0, 0);
 
@@ -547,242 +800,58 @@ void vp9_first_pass(VP9_COMP *cpi) {
 
   vp9_frame_init_quantizer(cpi);
 
-  for (i = 0; i < MAX_MB_PLANE; ++i) {
-    p[i].coeff = ctx->coeff_pbuf[i][1];
-    p[i].qcoeff = ctx->qcoeff_pbuf[i][1];
-    pd[i].dqcoeff = ctx->dqcoeff_pbuf[i][1];
-    p[i].eobs = ctx->eobs_pbuf[i][1];
-  }
   x->skip_recode = 0;
 
   vp9_init_mv_probs(cm);
   vp9_initialize_rd_consts(cpi);
 
-  // Tiling is ignored in the first pass.
-  vp9_tile_init(&tile, cm, 0, 0);
-
-  for (mb_row = 0; mb_row < cm->mb_rows; ++mb_row) {
-    int_mv best_ref_mv;
-
-    best_ref_mv.as_int = 0;
-
-    // Reset above block coeffs.
-    xd->up_available = (mb_row != 0);
-    recon_yoffset = (mb_row * recon_y_stride * 16);
-    recon_uvoffset = (mb_row * recon_uv_stride * uv_mb_height);
-
-    // Set up limit values for motion vectors to prevent them extending
-    // outside the UMV borders.
-    x->mv_row_min = -((mb_row * 16) + BORDER_MV_PIXELS_B16);
-    x->mv_row_max = ((cm->mb_rows - 1 - mb_row) * 16)
-                    + BORDER_MV_PIXELS_B16;
-
-    for (mb_col = 0; mb_col < cm->mb_cols; ++mb_col) {
-      int this_error;
-      const int use_dc_pred = (mb_col || mb_row) && (!mb_col || !mb_row);
-      double error_weight = 1.0;
-      const BLOCK_SIZE bsize = get_bsize(cm, mb_row, mb_col);
-
-      vp9_clear_system_state();
-
-      xd->plane[0].dst.buf = new_yv12->y_buffer + recon_yoffset;
-      xd->plane[1].dst.buf = new_yv12->u_buffer + recon_uvoffset;
-      xd->plane[2].dst.buf = new_yv12->v_buffer + recon_uvoffset;
-      xd->left_available = (mb_col != 0);
-      xd->mi[0]->mbmi.sb_type = bsize;
-      xd->mi[0]->mbmi.ref_frame[0] = INTRA_FRAME;
-      set_mi_row_col(xd, &tile,
-                     mb_row << 1, num_8x8_blocks_high_lookup[bsize],
-                     mb_col << 1, num_8x8_blocks_wide_lookup[bsize],
-                     cm->mi_rows, cm->mi_cols);
-
-      if (cpi->oxcf.aq_mode == VARIANCE_AQ) {
-        const int energy = vp9_block_energy(cpi, x, bsize);
-        error_weight = vp9_vaq_inv_q_ratio(energy);
-      }
-
-      // Do intra 16x16 prediction.
-      this_error = vp9_encode_intra(x, use_dc_pred);
-      if (cpi->oxcf.aq_mode == VARIANCE_AQ) {
-        vp9_clear_system_state();
-        this_error = (int)(this_error * error_weight);
-      }
-
-      // Intrapenalty below deals with situations where the intra and inter
-      // error scores are very low (e.g. a plain black frame).
-      // We do not have special cases in first pass for 0,0 and nearest etc so
-      // all inter modes carry an overhead cost estimate for the mv.
-      // When the error score is very low this causes us to pick all or lots of
-      // INTRA modes and throw lots of key frames.
-      // This penalty adds a cost matching that of a 0,0 mv to the intra case.
-      this_error += intrapenalty;
-
-      // Accumulate the intra error.
-      intra_error += (int64_t)this_error;
-
-      // Set up limit values for motion vectors to prevent them extending
-      // outside the UMV borders.
-      x->mv_col_min = -((mb_col * 16) + BORDER_MV_PIXELS_B16);
-      x->mv_col_max = ((cm->mb_cols - 1 - mb_col) * 16) + BORDER_MV_PIXELS_B16;
-
-      // Other than for the first frame do a motion search.
-      if (cm->current_video_frame > 0) {
-        int tmp_err, motion_error;
-        int_mv mv, tmp_mv;
-
-        xd->plane[0].pre[0].buf = first_ref_buf->y_buffer + recon_yoffset;
-        motion_error = zz_motion_search(x);
-        // Assume 0,0 motion with no mv overhead.
-        mv.as_int = tmp_mv.as_int = 0;
-
-        // Test last reference frame using the previous best mv as the
-        // starting point (best reference) for the search.
-        first_pass_motion_search(cpi, x, &best_ref_mv.as_mv, &mv.as_mv,
-                                 &motion_error);
-        if (cpi->oxcf.aq_mode == VARIANCE_AQ) {
-          vp9_clear_system_state();
-          motion_error = (int)(motion_error * error_weight);
-        }
-
-        // If the current best reference mv is not centered on 0,0 then do a 0,0
-        // based search as well.
-        if (best_ref_mv.as_int) {
-          tmp_err = INT_MAX;
-          first_pass_motion_search(cpi, x, &zero_mv, &tmp_mv.as_mv,
-                                   &tmp_err);
-          if (cpi->oxcf.aq_mode == VARIANCE_AQ) {
-            vp9_clear_system_state();
-            tmp_err = (int)(tmp_err * error_weight);
-          }
-
-          if (tmp_err < motion_error) {
-            motion_error = tmp_err;
-            mv.as_int = tmp_mv.as_int;
-          }
-        }
-
-        // Search in an older reference frame.
-        if (cm->current_video_frame > 1 && gld_yv12 != NULL) {
-          // Assume 0,0 motion with no mv overhead.
-          int gf_motion_error;
-
-          xd->plane[0].pre[0].buf = gld_yv12->y_buffer + recon_yoffset;
-          gf_motion_error = zz_motion_search(x);
-
-          first_pass_motion_search(cpi, x, &zero_mv, &tmp_mv.as_mv,
-                                   &gf_motion_error);
-          if (cpi->oxcf.aq_mode == VARIANCE_AQ) {
-            vp9_clear_system_state();
-            gf_motion_error = (int)(gf_motion_error * error_weight);
-          }
-
-          if (gf_motion_error < motion_error && gf_motion_error < this_error)
-            ++second_ref_count;
-
-          // Reset to last frame as reference buffer.
-          xd->plane[0].pre[0].buf = first_ref_buf->y_buffer + recon_yoffset;
-          xd->plane[1].pre[0].buf = first_ref_buf->u_buffer + recon_uvoffset;
-          xd->plane[2].pre[0].buf = first_ref_buf->v_buffer + recon_uvoffset;
-
-          // In accumulating a score for the older reference frame take the
-          // best of the motion predicted score and the intra coded error
-          // (just as will be done for) accumulation of "coded_error" for
-          // the last frame.
-          if (gf_motion_error < this_error)
-            sr_coded_error += gf_motion_error;
-          else
-            sr_coded_error += this_error;
-        } else {
-          sr_coded_error += motion_error;
-        }
-        // Start by assuming that intra mode is best.
-        best_ref_mv.as_int = 0;
-
-        if (motion_error <= this_error) {
-          // Keep a count of cases where the inter and intra were very close
-          // and very low. This helps with scene cut detection for example in
-          // cropped clips with black bars at the sides or top and bottom.
-          if (((this_error - intrapenalty) * 9 <= motion_error * 10) &&
-              this_error < 2 * intrapenalty)
-            ++neutral_count;
-
-          mv.as_mv.row *= 8;
-          mv.as_mv.col *= 8;
-          this_error = motion_error;
-          xd->mi[0]->mbmi.mode = NEWMV;
-          xd->mi[0]->mbmi.mv[0] = mv;
-          xd->mi[0]->mbmi.tx_size = TX_4X4;
-          xd->mi[0]->mbmi.ref_frame[0] = LAST_FRAME;
-          xd->mi[0]->mbmi.ref_frame[1] = NONE;
-          vp9_build_inter_predictors_sby(xd, mb_row << 1, mb_col << 1, bsize);
-          vp9_encode_sby_pass1(x, bsize);
-          sum_mvr += mv.as_mv.row;
-          sum_mvr_abs += abs(mv.as_mv.row);
-          sum_mvc += mv.as_mv.col;
-          sum_mvc_abs += abs(mv.as_mv.col);
-          sum_mvrs += mv.as_mv.row * mv.as_mv.row;
-          sum_mvcs += mv.as_mv.col * mv.as_mv.col;
-          ++intercount;
-
-          best_ref_mv.as_int = mv.as_int;
-
-          if (mv.as_int) {
-            ++mvcount;
-
-            // Non-zero vector, was it different from the last non zero vector?
-            if (mv.as_int != lastmv_as_int)
-              ++new_mv_count;
-            lastmv_as_int = mv.as_int;
-
-            // Does the row vector point inwards or outwards?
-            if (mb_row < cm->mb_rows / 2) {
-              if (mv.as_mv.row > 0)
-                --sum_in_vectors;
-              else if (mv.as_mv.row < 0)
-                ++sum_in_vectors;
-            } else if (mb_row > cm->mb_rows / 2) {
-              if (mv.as_mv.row > 0)
-                ++sum_in_vectors;
-              else if (mv.as_mv.row < 0)
-                --sum_in_vectors;
-            }
-
-            // Does the col vector point inwards or outwards?
-            if (mb_col < cm->mb_cols / 2) {
-              if (mv.as_mv.col > 0)
-                --sum_in_vectors;
-              else if (mv.as_mv.col < 0)
-                ++sum_in_vectors;
-            } else if (mb_col > cm->mb_cols / 2) {
-              if (mv.as_mv.col > 0)
-                ++sum_in_vectors;
-              else if (mv.as_mv.col < 0)
-                --sum_in_vectors;
-            }
-          }
-        }
-      } else {
-        sr_coded_error += (int64_t)this_error;
-      }
-      coded_error += (int64_t)this_error;
+  if (cpi->fp_row_stats_rows < cm->mb_rows) {
+    vpx_free(cpi->fp_row_stats);
+    cpi->fp_row_stats_rows = 0;
+    CHECK_MEM_ERROR(cm, cpi->fp_row_stats,
+                    vpx_malloc(cm->mb_rows * sizeof(*cpi->fp_row_stats)));
+    cpi->fp_row_stats_rows = cm->mb_rows;
+  }
+  cpi->fp_first_ref_buf = first_ref_buf;
+  cpi->fp_gld_buf = gld_yv12;
 
-      // Adjust to the next column of MBs.
-      x->plane[0].src.buf += 16;
-      x->plane[1].src.buf += uv_mb_height;
-      x->plane[2].src.buf += uv_mb_height;
+  // The rows of the main thread and the workers start from the frame level
+  // state of cpi->td.mb set up above.
+  if (cpi->oxcf.max_threads > 1) {
+    vp9_first_pass_row_mt(cpi);
+  } else {
+    for (mb_row = 0; mb_row < cm->mb_rows; ++mb_row)
+      vp9_first_pass_encode_mb_row(cpi, &cpi->td, mb_row, NULL);
+  }
 
-      recon_yoffset += 16;
-      recon_uvoffset += uv_mb_height;
+  // Add up the rows in raster order, so the stats do not depend on the
+  // number of threads.
+  for (mb_row = 0; mb_row < cm->mb_rows; ++mb_row) {
+    const FIRSTPASS_ROW_STATS *const stats = &cpi->fp_row_stats[mb_row];
+
+    intra_error += stats->intra_error;
+    coded_error += stats->coded_error;
+    sr_coded_error += stats->sr_coded_error;
+    sum_mvr += stats->sum_mvr;
+    sum_mvc += stats->sum_mvc;
+    sum_mvr_abs += stats->sum_mvr_abs;
+    sum_mvc_abs += stats->sum_mvc_abs;
+    sum_mvrs += stats->sum_mvrs;
+    sum_mvcs += stats->sum_mvcs;
+    mvcount += stats->mvcount;
+    intercount += stats->intercount;
+    second_ref_count += stats->second_ref_count;
+    neutral_count += stats->neutral_count;
+    sum_in_vectors += stats->sum_in_vectors;
+
+    // The first non zero vector of the row is a new one if it differs from
+    // the last one of the rows above.
+    if (stats->first_mv_as_int != 0) {
+      if (stats->first_mv_as_int != lastmv_as_int)
+        ++new_mv_count;
+      lastmv_as_int = stats->last_mv_as_int;
     }
-
-    // Adjust to the next row of MBs.
-    x->plane[0].src.buf += 16 * x->plane[0].src.stride - 16 * cm->mb_cols;
-    x->plane[1].src.buf += uv_mb_height * x->plane[1].src.stride -
-                           uv_mb_height * cm->mb_cols;
-    x->plane[2].src.buf += uv_mb_height * x->plane[1].src.stride -
-                           uv_mb_height * cm->mb_cols;
-
-    vp9_clear_system_state();
+    new_mv_count += stats->new_mv_count;
   }
 
   vp9_clear_system_state();
@@ -936,11 +1005,59 @@ int vp9_twopass_worst_quality(VP9_COMP *cpi, FIRSTPASS_STATS *fpstats,
   return q;
 }
 
+// Scans the first pass stats from stats_in to stats_in_end for the average
+// intra / inter error ratio and the modified errors of the frames.
+static void scan_second_pass_stats(const VP9_COMP *cpi,
+                                   struct twopass_rc *twopass) {
+  const VP9_CONFIG *const oxcf = &cpi->oxcf;
+  FIRSTPASS_STATS this_frame;
+  const FIRSTPASS_STATS *start_pos;
+
+  // Scan the first pass file and calculate an average Intra / Inter error
+  // score ratio for the sequence.
+  {
+    double sum_iiratio = 0.0;
+    start_pos = twopass->stats_in;
+
+    while (input_stats(twopass, &this_frame) != EOF) {
+      const double iiratio = this_frame.intra_error /
+                                 DOUBLE_DIVIDE_CHECK(this_frame.coded_error);
+      sum_iiratio += fclamp(iiratio, 1.0, 20.0);
+    }
+
+    twopass->avg_iiratio = sum_iiratio /
+        DOUBLE_DIVIDE_CHECK((double)twopass->total_stats.count);
+
+    reset_fpf_position(twopass, start_pos);
+  }
+
+  // Scan the first pass file and calculate a modified total error based upon
+  // the bias/power function used to allocate bits.
+  {
+    double av_error = twopass->total_stats.ssim_weighted_pred_err /
+                      DOUBLE_DIVIDE_CHECK(twopass->total_stats.count);
+
+    start_pos = twopass->stats_in;
+
+    twopass->modified_error_total = 0.0;
+    twopass->modified_error_min =
+      (av_error * oxcf->two_pass_vbrmin_section) / 100;
+    twopass->modified_error_max =
+      (av_error * oxcf->two_pass_vbrmax_section) / 100;
+
+    while (input_stats(twopass, &this_frame) != EOF) {
+      twopass->modified_error_total +=
+          calculate_modified_err(cpi, &this_frame);
+    }
+    twopass->modified_error_left = twopass->modified_error_total;
+
+    reset_fpf_position(twopass, start_pos);
+  }
+}
+
 extern void vp9_new_framerate(VP9_COMP *cpi, double framerate);
 
 void vp9_init_second_pass(VP9_COMP *cpi) {
-  FIRSTPASS_STATS this_frame;
-  const FIRSTPASS_STATS *start_pos;
   struct twopass_rc *twopass = &cpi->twopass;
   const VP9_CONFIG *const oxcf = &cpi->oxcf;
   const int is_spatial_svc = (cpi->svc.number_spatial_layers > 1) &&
@@ -996,46 +1113,43 @@ void vp9_init_second_pass(VP9_COMP *cpi) {
   // This variable monitors how far behind the second ref update is lagging.
   twopass->sr_update_lag = 1;
 
-  // Scan the first pass file and calculate an average Intra / Inter error
-  // score ratio for the sequence.
-  {
-    double sum_iiratio = 0.0;
-    start_pos = twopass->stats_in;
-
-    while (input_stats(twopass, &this_frame) != EOF) {
-      const double iiratio = this_frame.intra_error /
-                                 DOUBLE_DIVIDE_CHECK(this_frame.coded_error);
-      sum_iiratio += fclamp(iiratio, 1.0, 20.0);
-    }
-
-    twopass->avg_iiratio = sum_iiratio /
-        DOUBLE_DIVIDE_CHECK((double)twopass->total_stats.count);
-
-    reset_fpf_position(twopass, start_pos);
-  }
-
-  // Scan the first pass file and calculate a modified total error based upon
-  // the bias/power function used to allocate bits.
-  {
-    double av_error = twopass->total_stats.ssim_weighted_pred_err /
-                      DOUBLE_DIVIDE_CHECK(twopass->total_stats.count);
+  scan_second_pass_stats(cpi, twopass);
+}
 
-    start_pos = twopass->stats_in;
+int vp9_twopass_set_range(VP9_COMP *cpi, int first_frame, int num_frames) {
+  struct twopass_rc *const twopass = &cpi->twopass;
+  const FIRSTPASS_STATS *range_start, *range_end, *fps;
+  double range_error = 0.0;
+
+  if (cpi->pass != 2 || cpi->use_svc || twopass->stats_in_end == NULL ||
+      cpi->common.current_video_frame > 0 ||
+      twopass->stats_in != twopass->stats_in_start ||
+      first_frame < 0 || num_frames <= 0 ||
+      num_frames > twopass->stats_in_end - twopass->stats_in_start -
+                   first_frame)
+    return -1;
+
+  range_start = twopass->stats_in_start + first_frame;
+  range_end = range_start + num_frames;
+  vp9_clear_system_state();
 
-    twopass->modified_error_total = 0.0;
-    twopass->modified_error_min =
-      (av_error * oxcf->two_pass_vbrmin_section) / 100;
-    twopass->modified_error_max =
-      (av_error * oxcf->two_pass_vbrmax_section) / 100;
+  // The range gets the bits a single encode of the clip would give its
+  // frames, in proportion to their modified error.
+  for (fps = range_start; fps < range_end; ++fps)
+    range_error += calculate_modified_err(cpi, fps);
+  twopass->bits_left = (int64_t)(twopass->bits_left * range_error /
+      DOUBLE_DIVIDE_CHECK(twopass->modified_error_total));
 
-    while (input_stats(twopass, &this_frame) != EOF) {
-      twopass->modified_error_total +=
-          calculate_modified_err(cpi, &this_frame);
-    }
-    twopass->modified_error_left = twopass->modified_error_total;
+  zero_stats(&twopass->total_stats);
+  for (fps = range_start; fps < range_end; ++fps)
+    accumulate_stats(&twopass->total_stats, fps);
+  twopass->total_left_stats = twopass->total_stats;
 
-    reset_fpf_position(twopass, start_pos);
-  }
+  twopass->stats_in_start = range_start;
+  twopass->stats_in = range_start;
+  twopass->stats_in_end = range_end;
+  scan_second_pass_stats(cpi, twopass);
+  return 0;
 }
 
 // This function gives an estimate of how badly we believe the prediction
@@ -11,6 +11,8 @@
 #ifndef VP9_ENCODER_VP9_FIRSTPASS_H_
 #define VP9_ENCODER_VP9_FIRSTPASS_H_
 
+#include "vpx/vpx_integer.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -38,6 +40,30 @@ typedef struct {
   int64_t spatial_layer_id;
 } FIRSTPASS_STATS;
 
+// Sums over one macroblock row, which the first pass threads fill in
+// independently and which are added up in raster order once the frame is done.
+typedef struct {
+  int64_t intra_error;
+  int64_t coded_error;
+  int64_t sr_coded_error;
+  int64_t sum_mvrs;
+  int64_t sum_mvcs;
+  int sum_mvr;
+  int sum_mvc;
+  int sum_mvr_abs;
+  int sum_mvc_abs;
+  int mvcount;
+  int intercount;
+  int second_ref_count;
+  int neutral_count;
+  int sum_in_vectors;
+  // Changes between the non zero vectors of the row, not counting the first
+  // one, whose change depends on the rows above.
+  int new_mv_count;
+  uint32_t first_mv_as_int;  // first and last non zero vectors of the row
+  uint32_t last_mv_as_int;
+} FIRSTPASS_ROW_STATS;
+
 struct twopass_rc {
   unsigned int section_intra_rating;
   unsigned int next_iiratio;
@@ -82,14 +108,26 @@ struct twopass_rc {
   int active_worst_quality;
 };
 
+struct ThreadData;
 struct VP9_COMP;
+struct VP9RowMTSync;
 
 void vp9_init_first_pass(struct VP9_COMP *cpi);
 void vp9_rc_get_first_pass_params(struct VP9_COMP *cpi);
 void vp9_first_pass(struct VP9_COMP *cpi);
+// Runs the first pass over one macroblock row, writing its sums to
+// cpi->fp_row_stats[mb_row]. With row_sync, each macroblock waits for the row
+// above it and is signaled to the row below it once done.
+void vp9_first_pass_encode_mb_row(struct VP9_COMP *cpi, struct ThreadData *td,
+                                  int mb_row, struct VP9RowMTSync *row_sync);
 void vp9_end_first_pass(struct VP9_COMP *cpi);
 
 void vp9_init_second_pass(struct VP9_COMP *cpi);
+// Restricts the second pass to num_frames frames of the stats from
+// first_frame, with their share of the bits of the whole clip. Returns -1 if
+// not in the second pass, or if a frame has been encoded already.
+int vp9_twopass_set_range(struct VP9_COMP *cpi, int first_frame,
+                          int num_frames);
 void vp9_rc_get_second_pass_params(struct VP9_COMP *cpi);
 int vp9_twopass_worst_quality(struct VP9_COMP *cpi, FIRSTPASS_STATS *fpstats,
                               int section_target_bandwitdh);
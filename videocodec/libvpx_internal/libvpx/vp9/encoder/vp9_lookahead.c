@@ -8,24 +8,47 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 #include <assert.h>
+#include <limits.h>
 #include <stdlib.h>
 
 #include "./vpx_config.h"
+#include "./vp9_rtcd.h"
 
 #include "vp9/common/vp9_common.h"
+#include "vp9/common/vp9_mv.h"
+#include "vp9/common/vp9_systemdependent.h"
+#include "vp9/common/vp9_thread.h"
 
 #include "vp9/encoder/vp9_extend.h"
 #include "vp9/encoder/vp9_lookahead.h"
 #include "vp9/encoder/vp9_onyx_int.h"
 
+// Largest full pel motion found by the analysis of the pushed frames.
+#define ANALYSIS_SEARCH_RANGE 15
+
+// Added to the inter error of a moving block, so that a static one is
+// preferred at an equal error.
+#define ANALYSIS_MV_PENALTY 256
+
 struct lookahead_ctx {
   unsigned int max_sz;         /* Absolute size of the queue */
   unsigned int sz;             /* Number of buffers currently in the queue */
   unsigned int read_idx;       /* Read index */
   unsigned int write_idx;      /* Write index */
   struct lookahead_entry *buf; /* Buffer list */
+  unsigned int last_id;        /* Id of the frame pushed last */
+
+  /* Analysis of the pushed frames */
+  int analyze;                       /* Analyze the frames pushed from now on */
+  int has_thread;                    /* The worker runs in its own thread */
+  VP9Worker worker;
+  struct lookahead_entry *last_push; /* Frame pushed last, NULL if none */
+  struct lookahead_entry *analyzing; /* Frame the worker may still analyze */
+  struct lookahead_entry *analysis_ref;  /* Frame pushed before it */
 };
 
+DECLARE_ALIGNED(16, static const uint8_t, zeros[16]) = {0};
+
 
 /* Return the buffer at the given absolute index and increment the index */
 static struct lookahead_entry *pop(struct lookahead_ctx *ctx,
@@ -41,13 +64,121 @@ static struct lookahead_entry *pop(struct lookahead_ctx *ctx,
 }
 
 
+// Three step search of the 16x16 block at src around the zero vector, on the
+// SAD.
+static void block_motion_search(const uint8_t *src, int src_stride,
+                                const uint8_t *ref, int ref_stride, MV *mv) {
+  static const MV neighbors[8] = {
+    {-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}
+  };
+  unsigned int best_sad = vp9_sad16x16(src, src_stride, ref, ref_stride,
+                                       UINT_MAX);
+  int step, i;
+
+  mv->row = mv->col = 0;
+  for (step = (ANALYSIS_SEARCH_RANGE + 1) >> 1; step > 0; step >>= 1) {
+    const MV center = *mv;
+
+    for (i = 0; i < 8; ++i) {
+      const MV this_mv = {center.row + neighbors[i].row * step,
+                          center.col + neighbors[i].col * step};
+      const unsigned int sad = vp9_sad16x16(src, src_stride,
+                                            ref + this_mv.row * ref_stride +
+                                                this_mv.col,
+                                            ref_stride, best_sad);
+      if (sad < best_sad) {
+        best_sad = sad;
+        *mv = this_mv;
+      }
+    }
+  }
+}
+
+// Fills in the stats of entry against last, or intra only if last is NULL.
+// The frames are extended, so the blocks of the last row and column may read
+// past the visible area, as may the motion search.
+static void analyze_frame(struct lookahead_entry *entry,
+                          const struct lookahead_entry *last) {
+  const YV12_BUFFER_CONFIG *const src = &entry->img;
+  const int mb_rows = (src->y_crop_height + 15) >> 4;
+  const int mb_cols = (src->y_crop_width + 15) >> 4;
+  const double mbs = mb_rows * mb_cols;
+  struct lookahead_stats *const stats = &entry->stats;
+  int64_t intra_error = 0, coded_error = 0, sum_mv = 0;
+  int intercount = 0, mvcount = 0;
+  int mb_row, mb_col;
+
+  for (mb_row = 0; mb_row < mb_rows; ++mb_row) {
+    for (mb_col = 0; mb_col < mb_cols; ++mb_col) {
+      const uint8_t *const s = src->y_buffer +
+                               16 * (mb_row * src->y_stride + mb_col);
+      unsigned int sse;
+      const unsigned int this_error = vp9_variance16x16(s, src->y_stride,
+                                                        zeros, 0, &sse);
+      unsigned int error = this_error;
+
+      if (last != NULL) {
+        const int ref_stride = last->img.y_stride;
+        const uint8_t *const ref = last->img.y_buffer +
+                                   16 * (mb_row * ref_stride + mb_col);
+        unsigned int motion_error;
+        MV mv;
+
+        block_motion_search(s, src->y_stride, ref, ref_stride, &mv);
+        motion_error = vp9_mse16x16(s, src->y_stride,
+                                    ref + mv.row * ref_stride + mv.col,
+                                    ref_stride, &sse);
+        if (mv.row || mv.col)
+          motion_error += ANALYSIS_MV_PENALTY;
+
+        if (motion_error <= this_error) {
+          error = motion_error;
+          ++intercount;
+          if (mv.row || mv.col) {
+            ++mvcount;
+            sum_mv += abs(mv.row) + abs(mv.col);
+          }
+        }
+      }
+
+      intra_error += this_error;
+      coded_error += error;
+    }
+  }
+
+  vp9_clear_system_state();
+  stats->intra_error = intra_error / mbs;
+  stats->coded_error = coded_error / mbs;
+  stats->pcnt_inter = intercount / mbs;
+  stats->pcnt_motion = mvcount / mbs;
+  stats->pcnt_zero_motion = (intercount - mvcount) / mbs;
+  stats->mv_abs = mvcount > 0 ? (double)sum_mv / mvcount : 0.0;
+}
+
+static int analysis_hook(void *arg1, void *unused) {
+  struct lookahead_ctx *const ctx = (struct lookahead_ctx *)arg1;
+  (void)unused;
+  analyze_frame(ctx->analyzing, ctx->analysis_ref);
+  return 1;
+}
+
+static void wait_for_analysis(struct lookahead_ctx *ctx) {
+  if (ctx->analyzing != NULL) {
+    vp9_worker_sync(&ctx->worker);
+    ctx->analyzing = NULL;
+  }
+}
+
 void vp9_lookahead_destroy(struct lookahead_ctx *ctx) {
   if (ctx) {
+    vp9_worker_end(&ctx->worker);
     if (ctx->buf) {
       unsigned int i;
 
-      for (i = 0; i < ctx->max_sz; i++)
+      for (i = 0; i < ctx->max_sz; i++) {
         vp9_free_frame_buffer(&ctx->buf[i].img);
+        vp9_free_pyramid(&ctx->buf[i].pyramid);
+      }
       free(ctx->buf);
     }
     free(ctx);
@@ -73,6 +204,9 @@ struct lookahead_ctx *vp9_lookahead_init(unsigned int width,
   if (ctx) {
     unsigned int i;
     ctx->max_sz = depth;
+    vp9_worker_init(&ctx->worker);
+    ctx->worker.hook = analysis_hook;
+    ctx->worker.data1 = ctx;
     ctx->buf = calloc(depth, sizeof(*ctx->buf));
     if (!ctx->buf)
       goto bail;
@@ -88,6 +222,14 @@ struct lookahead_ctx *vp9_lookahead_init(unsigned int width,
   return NULL;
 }
 
+void vp9_lookahead_set_analysis(struct lookahead_ctx *ctx, int enable,
+                                int use_thread) {
+  ctx->analyze = enable;
+  // A worker without a thread runs the analysis on push.
+  if (enable && use_thread && !ctx->has_thread)
+    ctx->has_thread = vp9_worker_reset(&ctx->worker);
+}
+
 #define USE_PARTIAL_COPY 0
 
 int vp9_lookahead_push(struct lookahead_ctx *ctx, YV12_BUFFER_CONFIG   *src,
@@ -101,6 +243,8 @@ int vp9_lookahead_push(struct lookahead_ctx *ctx, YV12_BUFFER_CONFIG   *src,
 
   if (ctx->sz + 1  + MAX_PRE_FRAMES > ctx->max_sz)
     return 1;
+  // The buffer about to be overwritten may be the reference of the analysis.
+  wait_for_analysis(ctx);
   ctx->sz++;
   buf = pop(ctx, &ctx->write_idx);
 
@@ -158,6 +302,21 @@ int vp9_lookahead_push(struct lookahead_ctx *ctx, YV12_BUFFER_CONFIG   *src,
   buf->ts_start = ts_start;
   buf->ts_end = ts_end;
   buf->flags = flags;
+  buf->pyramid.valid = 0;
+  buf->id = ++ctx->last_id;
+
+  buf->has_stats = ctx->analyze;
+  if (ctx->analyze) {
+    ctx->analyzing = buf;
+    ctx->analysis_ref = ctx->last_push;
+    if (ctx->has_thread) {
+      vp9_worker_launch(&ctx->worker);
+    } else {
+      vp9_worker_execute(&ctx->worker);
+      ctx->analyzing = NULL;
+    }
+  }
+  ctx->last_push = buf;
   return 0;
 }
 
@@ -199,6 +358,17 @@ struct lookahead_entry *vp9_lookahead_peek(struct lookahead_ctx *ctx,
   return buf;
 }
 
+const struct lookahead_stats *vp9_lookahead_peek_stats(
+    struct lookahead_ctx *ctx, int index) {
+  const struct lookahead_entry *const buf = vp9_lookahead_peek(ctx, index);
+
+  if (buf == NULL || !buf->has_stats)
+    return NULL;
+  if (buf == ctx->analyzing)
+    wait_for_analysis(ctx);
+  return &buf->stats;
+}
+
 unsigned int vp9_lookahead_depth(struct lookahead_ctx *ctx) {
   return ctx->sz;
 }
@@ -13,6 +13,7 @@
 
 #include "vpx_scale/yv12config.h"
 #include "vpx/vpx_integer.h"
+#include "vp9/encoder/vp9_pyramid.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -23,11 +24,28 @@ extern "C" {
 // The max of past frames we want to keep in the queue.
 #define MAX_PRE_FRAMES 1
 
+// Cheap first pass like statistics of a source frame, taken on its 16x16
+// blocks against the frame pushed before it. The errors are averages per
+// block.
+struct lookahead_stats {
+  double intra_error;       // error of a DC prediction
+  double coded_error;       // smaller of the intra and inter errors
+  double pcnt_inter;        // share of blocks predicted better from the
+                            // previous frame than intra
+  double pcnt_motion;       // share of inter blocks with a non zero vector
+  double pcnt_zero_motion;  // share of inter blocks with a zero vector
+  double mv_abs;            // average full pel motion of the moving blocks
+};
+
 struct lookahead_entry {
   YV12_BUFFER_CONFIG  img;
   int64_t             ts_start;
   int64_t             ts_end;
   unsigned int        flags;
+  int                 has_stats;  // stats was filled in on push
+  struct lookahead_stats stats;
+  MV_PYRAMID          pyramid;    // built on demand, invalid after a push
+  unsigned int        id;         // unique among the frames pushed, not 0
 };
 
 
@@ -50,6 +68,21 @@ struct lookahead_ctx *vp9_lookahead_init(unsigned int width,
 void vp9_lookahead_destroy(struct lookahead_ctx *ctx);
 
 
+/**\brief Turns the analysis of the pushed frames on or off
+ *
+ * When on, each frame pushed afterwards is analyzed against the frame pushed
+ * before it, in a background thread if use_thread is set and one could be
+ * created. The analysis of a frame then runs while the frames before it are
+ * encoded. The statistics are read with vp9_lookahead_peek_stats().
+ *
+ * \param[in] ctx         Pointer to the lookahead context
+ * \param[in] enable      Flag to analyze the pushed frames
+ * \param[in] use_thread  Flag to analyze them in a background thread
+ */
+void vp9_lookahead_set_analysis(struct lookahead_ctx *ctx, int enable,
+                                int use_thread);
+
+
 /**\brief Enqueue a source buffer
  *
  * This function will copy the source image into a new framebuffer with
@@ -94,6 +127,20 @@ struct lookahead_entry *vp9_lookahead_peek(struct lookahead_ctx *ctx,
                                            int index);
 
 
+/**\brief Get the analysis of a source buffer
+ *
+ * Waits for the background analysis of the buffer to finish if needed.
+ *
+ * \param[in] ctx       Pointer to the lookahead context
+ * \param[in] index     Index of the frame, as for vp9_lookahead_peek()
+ *
+ * \retval NULL, if no buffer exists at the specified index or it was pushed
+ *         with the analysis off
+ */
+const struct lookahead_stats *vp9_lookahead_peek_stats(
+    struct lookahead_ctx *ctx, int index);
+
+
 /**\brief Get the number of frames currently in the lookahead queue
  *
  * \param[in] ctx       Pointer to the lookahead context
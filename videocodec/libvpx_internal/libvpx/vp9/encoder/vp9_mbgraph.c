@@ -14,6 +14,7 @@
 #include "vp9/encoder/vp9_rdopt.h"
 #include "vp9/encoder/vp9_segmentation.h"
 #include "vp9/encoder/vp9_mcomp.h"
+#include "vp9/encoder/vp9_motion_field.h"
 #include "vp9/common/vp9_blockd.h"
 #include "vp9/common/vp9_reconinter.h"
 #include "vp9/common/vp9_reconintra.h"
@@ -26,7 +27,7 @@ static unsigned int do_16x16_motion_iteration(VP9_COMP *cpi,
                                               MV *dst_mv,
                                               int mb_row,
                                               int mb_col) {
-  MACROBLOCK   *const x  = &cpi->mb;
+  MACROBLOCK   *const x  = &cpi->td.mb;
   MACROBLOCKD *const xd = &x->e_mbd;
   vp9_variance_fn_ptr_t v_fn_ptr = cpi->fn_ptr[BLOCK_16X16];
 
@@ -79,7 +80,7 @@ static unsigned int do_16x16_motion_iteration(VP9_COMP *cpi,
 
 static int do_16x16_motion_search(VP9_COMP *cpi, const int_mv *ref_mv,
                                   int_mv *dst_mv, int mb_row, int mb_col) {
-  MACROBLOCK *const x = &cpi->mb;
+  MACROBLOCK *const x = &cpi->td.mb;
   MACROBLOCKD *const xd = &x->e_mbd;
   unsigned int err, tmp_err;
   int_mv tmp_mv;
@@ -119,7 +120,7 @@ static int do_16x16_motion_search(VP9_COMP *cpi, const int_mv *ref_mv,
 }
 
 static int do_16x16_zerozero_search(VP9_COMP *cpi, int_mv *dst_mv) {
-  MACROBLOCK *const x = &cpi->mb;
+  MACROBLOCK *const x = &cpi->td.mb;
   MACROBLOCKD *const xd = &x->e_mbd;
   unsigned int err;
 
@@ -135,7 +136,7 @@ static int do_16x16_zerozero_search(VP9_COMP *cpi, int_mv *dst_mv) {
 }
 static int find_best_16x16_intra(VP9_COMP *cpi,
                                  MB_PREDICTION_MODE *pbest_mode) {
-  MACROBLOCK   *const x  = &cpi->mb;
+  MACROBLOCK   *const x  = &cpi->td.mb;
   MACROBLOCKD *const xd = &x->e_mbd;
   MB_PREDICTION_MODE best_mode = -1, mode;
   unsigned int best_err = INT_MAX;
@@ -173,12 +174,13 @@ static void update_mbgraph_mb_stats
   YV12_BUFFER_CONFIG *buf,
   int mb_y_offset,
   YV12_BUFFER_CONFIG *golden_ref,
+  MOTION_FIELD *golden_mv_field,
   int_mv *prev_golden_ref_mv,
   YV12_BUFFER_CONFIG *alt_ref,
   int mb_row,
   int mb_col
 ) {
-  MACROBLOCK *const x = &cpi->mb;
+  MACROBLOCK *const x = &cpi->td.mb;
   MACROBLOCKD *const xd = &x->e_mbd;
   int intra_error;
   VP9_COMMON *cm = &cpi->common;
@@ -200,13 +202,28 @@ static void update_mbgraph_mb_stats
   // Golden frame MV search, if it exists and is different than last frame
   if (golden_ref) {
     int g_motion_error;
+    unsigned int sad_count = 0;
     xd->plane[0].pre[0].buf = golden_ref->y_buffer + mb_y_offset;
     xd->plane[0].pre[0].stride = golden_ref->y_stride;
+    if (golden_mv_field != NULL)
+      x->sad_count = &sad_count;
     g_motion_error = do_16x16_motion_search(cpi,
                                             prev_golden_ref_mv,
                                             &stats->ref[GOLDEN_FRAME].m.mv,
                                             mb_row, mb_col);
     stats->ref[GOLDEN_FRAME].err = g_motion_error;
+    if (golden_mv_field != NULL) {
+      MOTION_FIELD_BLOCK *const block =
+          vp9_motion_field_block(golden_mv_field, BLOCK_16X16,
+                                 2 * mb_row, 2 * mb_col);
+      const MV *const mv = &stats->ref[GOLDEN_FRAME].m.mv.as_mv;
+
+      x->sad_count = NULL;
+      block->mv.row = mv->row >> 3;
+      block->mv.col = mv->col >> 3;
+      // And the SAD of the zero vector.
+      block->sad_count = sad_count + 1;
+    }
   } else {
     stats->ref[GOLDEN_FRAME].err = INT_MAX;
     stats->ref[GOLDEN_FRAME].m.mv.as_int = 0;
@@ -232,8 +249,9 @@ static void update_mbgraph_frame_stats(VP9_COMP *cpi,
                                        MBGRAPH_FRAME_STATS *stats,
                                        YV12_BUFFER_CONFIG *buf,
                                        YV12_BUFFER_CONFIG *golden_ref,
+                                       MOTION_FIELD *golden_mv_field,
                                        YV12_BUFFER_CONFIG *alt_ref) {
-  MACROBLOCK *const x = &cpi->mb;
+  MACROBLOCK *const x = &cpi->td.mb;
   MACROBLOCKD *const xd = &x->e_mbd;
   VP9_COMMON *const cm = &cpi->common;
 
@@ -275,8 +293,8 @@ static void update_mbgraph_frame_stats(VP9_COMP *cpi,
       MBGRAPH_MB_STATS *mb_stats = &stats->mb_stats[offset + mb_col];
 
       update_mbgraph_mb_stats(cpi, mb_stats, buf, mb_y_in_offset,
-                              golden_ref, &gld_left_mv, alt_ref,
-                              mb_row, mb_col);
+                              golden_ref, golden_mv_field, &gld_left_mv,
+                              alt_ref, mb_row, mb_col);
       arf_left_mv.as_int = mb_stats->ref[ALTREF_FRAME].m.mv.as_int;
       gld_left_mv.as_int = mb_stats->ref[GOLDEN_FRAME].m.mv.as_int;
       if (mb_col == 0) {
@@ -370,7 +388,6 @@ static void separate_arf_mbs(VP9_COMP *cpi) {
     else
       cpi->static_mb_pct = 0;
 
-    cpi->seg0_cnt = ncnt[0];
     vp9_enable_segmentation(&cm->seg);
   } else {
     cpi->static_mb_pct = 0;
@@ -385,6 +402,8 @@ void vp9_update_mbgraph_stats(VP9_COMP *cpi) {
   VP9_COMMON *const cm = &cpi->common;
   int i, n_frames = vp9_lookahead_depth(cpi->lookahead);
   YV12_BUFFER_CONFIG *golden_ref = get_ref_frame_buffer(cpi, GOLDEN_FRAME);
+  const unsigned int golden_id =
+      cpi->frame_ids[cm->ref_frame_map[get_ref_frame_idx(cpi, GOLDEN_FRAME)]];
 
   // we need to look ahead beyond where the ARF transitions into
   // being a GF - so exit if we don't look ahead beyond that
@@ -409,11 +428,24 @@ void vp9_update_mbgraph_stats(VP9_COMP *cpi) {
   for (i = 0; i < n_frames; i++) {
     MBGRAPH_FRAME_STATS *frame_stats = &cpi->mbgraph_stats[i];
     struct lookahead_entry *q_cur = vp9_lookahead_peek(cpi->lookahead, i);
+    MOTION_FIELD *golden_mv_field = NULL;
 
     assert(q_cur != NULL);
 
+    // Keep the vectors of the frames up to the alt-ref in the golden frame,
+    // which they will reference.
+    if (cpi->sf.mv_field_mode != MV_FIELD_OFF && golden_id != 0 &&
+        q_cur->id != golden_id && i <= cpi->rc.frames_till_gf_update_due) {
+      golden_mv_field = vp9_get_motion_field(&cpi->mv_field_cache,
+                                             q_cur->id, golden_id,
+                                             cm->mi_rows, cm->mi_cols);
+      if (golden_mv_field == NULL)
+        vpx_internal_error(&cm->error, VPX_CODEC_MEM_ERROR,
+                           "Failed to allocate motion field");
+    }
+
     update_mbgraph_frame_stats(cpi, frame_stats, &q_cur->img,
-                               golden_ref, cpi->Source);
+                               golden_ref, golden_mv_field, cpi->Source);
   }
 
   vp9_clear_system_state();
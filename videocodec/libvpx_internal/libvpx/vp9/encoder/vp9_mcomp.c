@@ -475,8 +475,15 @@ static INLINE int is_mv_in(const MACROBLOCK *x, const MV *mv) {
          (mv->row >= x->mv_row_min) && (mv->row <= x->mv_row_max);
 }
 
+static INLINE void count_sads(const MACROBLOCK *x, unsigned int n) {
+  if (x->sad_count != NULL)
+    *x->sad_count += n;
+}
+
+// Every check follows the evaluation of thissad.
 #define CHECK_BETTER \
   {\
+    count_sads(x, 1);\
     if (thissad < bestsad) {\
       if (use_mvcost) \
         thissad += mvsad_err_cost(&this_mv, &fcenter_mv, \
@@ -533,6 +540,7 @@ static int vp9_pattern_search(const MACROBLOCK *x,
                      get_buf_from_mv(in_what, ref_mv), in_what->stride,
                      0x7fffffff) + mvsad_err_cost(ref_mv, &fcenter_mv,
                          mvjsadcost, mvsadcost, sad_per_bit);
+  count_sads(x, 1);
 
   // Search all possible scales upto the search param around the center point
   // pick the scale of the point that is best as the starting scale of
@@ -1023,6 +1031,7 @@ int vp9_diamond_search_sad_c(const MACROBLOCK *x,
   bestsad = fn_ptr->sdf(what, what_stride, in_what, in_what_stride, 0x7fffffff)
                 + mvsad_err_cost(best_mv, &fcenter_mv,
                                  mvjsadcost, mvsadcost, sad_per_bit);
+  count_sads(x, 1);
 
   i = 1;
 
@@ -1034,6 +1043,7 @@ int vp9_diamond_search_sad_c(const MACROBLOCK *x,
         const uint8_t *const check_here = ss[i].offset + best_address;
         int thissad = fn_ptr->sdf(what, what_stride, check_here, in_what_stride,
                               bestsad);
+        count_sads(x, 1);
 
         if (thissad < bestsad) {
           thissad += mvsad_err_cost(&this_mv, &fcenter_mv,
@@ -1062,6 +1072,7 @@ int vp9_diamond_search_sad_c(const MACROBLOCK *x,
           const uint8_t *const check_here = ss[best_site].offset + best_address;
           int thissad = fn_ptr->sdf(what, what_stride, check_here,
                                     in_what_stride, bestsad);
+          count_sads(x, 1);
           if (thissad < bestsad) {
             thissad += mvsad_err_cost(&this_mv, &fcenter_mv,
                                       mvjsadcost, mvsadcost, sad_per_bit);
@@ -1134,6 +1145,7 @@ int vp9_diamond_search_sadx4(const MACROBLOCK *x,
   bestsad = fn_ptr->sdf(what, what_stride, in_what, in_what_stride, 0x7fffffff)
                 + mvsad_err_cost(best_mv, &fcenter_mv,
                                  mvjsadcost, mvsadcost, sad_per_bit);
+  count_sads(x, 1);
 
   i = 1;
 
@@ -1161,6 +1173,7 @@ int vp9_diamond_search_sadx4(const MACROBLOCK *x,
 
         fn_ptr->sdx4df(what, what_stride, block_offset, in_what_stride,
                        sad_array);
+        count_sads(x, 4);
 
         for (t = 0; t < 4; t++, i++) {
           if (sad_array[t] < bestsad) {
@@ -1186,6 +1199,7 @@ int vp9_diamond_search_sadx4(const MACROBLOCK *x,
           const uint8_t *const check_here = ss[i].offset + best_address;
           unsigned int thissad = fn_ptr->sdf(what, what_stride, check_here,
                                              in_what_stride, bestsad);
+          count_sads(x, 1);
 
           if (thissad < bestsad) {
             thissad += mvsad_err_cost(&this_mv, &fcenter_mv,
@@ -1213,6 +1227,7 @@ int vp9_diamond_search_sadx4(const MACROBLOCK *x,
           const uint8_t *const check_here = ss[best_site].offset + best_address;
           unsigned int thissad = fn_ptr->sdf(what, what_stride, check_here,
                                              in_what_stride, bestsad);
+          count_sads(x, 1);
           if (thissad < bestsad) {
             thissad += mvsad_err_cost(&this_mv, &fcenter_mv,
                                       mvjsadcost, mvsadcost, sad_per_bit);
@@ -1569,6 +1584,7 @@ int vp9_refining_search_sad_c(const MACROBLOCK *x,
       mvsad_err_cost(ref_mv, &fcenter_mv, mvjsadcost, mvsadcost, error_per_bit);
   int i, j;
 
+  count_sads(x, 1);
   for (i = 0; i < search_range; i++) {
     int best_site = -1;
 
@@ -1578,6 +1594,7 @@ int vp9_refining_search_sad_c(const MACROBLOCK *x,
       if (is_mv_in(x, &mv)) {
         unsigned int sad = fn_ptr->sdf(what->buf, what->stride,
             get_buf_from_mv(in_what, &mv), in_what->stride, best_sad);
+        count_sads(x, 1);
         if (sad < best_sad) {
           sad += mvsad_err_cost(&mv, &fcenter_mv, mvjsadcost, mvsadcost,
                                 error_per_bit);
@@ -1625,6 +1642,7 @@ int vp9_refining_search_sadx4(const MACROBLOCK *x,
                                     in_what_stride, 0x7fffffff) +
       mvsad_err_cost(ref_mv, &fcenter_mv, mvjsadcost, mvsadcost, error_per_bit);
 
+  count_sads(x, 1);
   for (i = 0; i < search_range; i++) {
     int best_site = -1;
     int all_in = ((ref_mv->row - 1) > x->mv_row_min) &
@@ -1643,6 +1661,7 @@ int vp9_refining_search_sadx4(const MACROBLOCK *x,
 
       fn_ptr->sdx4df(what, what_stride, block_offset, in_what_stride,
                      sad_array);
+      count_sads(x, 4);
 
       for (j = 0; j < 4; j++) {
         if (sad_array[j] < bestsad) {
@@ -1668,6 +1687,7 @@ int vp9_refining_search_sadx4(const MACROBLOCK *x,
           unsigned int thissad = fn_ptr->sdf(what, what_stride,
                                              check_here, in_what_stride,
                                              bestsad);
+          count_sads(x, 1);
 
           if (thissad < bestsad) {
             thissad += mvsad_err_cost(&this_mv, &fcenter_mv,
@@ -0,0 +1,104 @@
+/*
+ *  Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "vpx_mem/vpx_mem.h"
+
+#include "vp9/encoder/vp9_motion_field.h"
+
+static void free_motion_field(MOTION_FIELD *field) {
+  vpx_free(field->blocks);
+  vpx_memset(field, 0, sizeof(*field));
+}
+
+void vp9_free_motion_field_cache(MOTION_FIELD_CACHE *cache) {
+  int i;
+
+  for (i = 0; i < MOTION_FIELD_CACHE_SIZE; ++i)
+    free_motion_field(&cache->fields[i]);
+}
+
+static int alloc_motion_field(MOTION_FIELD *field, int mi_rows, int mi_cols) {
+  int size = 0;
+  BLOCK_SIZE bsize;
+
+  free_motion_field(field);
+  for (bsize = BLOCK_8X8; bsize < BLOCK_SIZES; ++bsize) {
+    const int bw = num_8x8_blocks_wide_lookup[bsize];
+    const int bh = num_8x8_blocks_high_lookup[bsize];
+
+    field->offset[bsize] = size;
+    size += ((mi_rows + bh - 1) / bh) * ((mi_cols + bw - 1) / bw);
+  }
+
+  field->blocks = (MOTION_FIELD_BLOCK *)vpx_malloc(size *
+                                                   sizeof(*field->blocks));
+  if (field->blocks == NULL)
+    return -1;
+  field->num_blocks = size;
+  field->mi_rows = mi_rows;
+  field->mi_cols = mi_cols;
+  return 0;
+}
+
+MOTION_FIELD *vp9_find_motion_field(MOTION_FIELD_CACHE *cache,
+                                    unsigned int src_id, unsigned int ref_id,
+                                    int mi_rows, int mi_cols) {
+  int i;
+
+  for (i = 0; i < MOTION_FIELD_CACHE_SIZE; ++i) {
+    MOTION_FIELD *const field = &cache->fields[i];
+
+    if (field->blocks != NULL &&
+        field->src_id == src_id && field->ref_id == ref_id &&
+        field->mi_rows == mi_rows && field->mi_cols == mi_cols) {
+      field->last_use = ++cache->use_count;
+      return field;
+    }
+  }
+  return NULL;
+}
+
+MOTION_FIELD *vp9_get_motion_field(MOTION_FIELD_CACHE *cache,
+                                   unsigned int src_id, unsigned int ref_id,
+                                   int mi_rows, int mi_cols) {
+  MOTION_FIELD *field = vp9_find_motion_field(cache, src_id, ref_id,
+                                              mi_rows, mi_cols);
+  int i;
+
+  if (field != NULL)
+    return field;
+
+  field = &cache->fields[0];
+  for (i = 1; i < MOTION_FIELD_CACHE_SIZE && field->blocks != NULL; ++i) {
+    if (cache->fields[i].blocks == NULL ||
+        cache->fields[i].last_use < field->last_use)
+      field = &cache->fields[i];
+  }
+
+  if (field->blocks == NULL ||
+      field->mi_rows != mi_rows || field->mi_cols != mi_cols) {
+    if (alloc_motion_field(field, mi_rows, mi_cols))
+      return NULL;
+  }
+  vpx_memset(field->blocks, 0, field->num_blocks * sizeof(*field->blocks));
+  field->src_id = src_id;
+  field->ref_id = ref_id;
+  field->last_use = ++cache->use_count;
+  return field;
+}
+
+void vp9_accumulate_motion_field_stats(MOTION_FIELD_STATS *dst,
+                                       const MOTION_FIELD_STATS *src) {
+  dst->sads += src->sads;
+  dst->lookups += src->lookups;
+  dst->hits += src->hits;
+  dst->reused += src->reused;
+  dst->sads_saved += src->sads_saved;
+}
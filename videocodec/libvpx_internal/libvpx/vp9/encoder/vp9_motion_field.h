@@ -0,0 +1,99 @@
+/*
+ *  Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef VP9_ENCODER_VP9_MOTION_FIELD_H_
+#define VP9_ENCODER_VP9_MOTION_FIELD_H_
+
+#include "vpx/vpx_integer.h"
+#include "vp9/common/vp9_common.h"
+#include "vp9/common/vp9_common_data.h"
+#include "vp9/common/vp9_enums.h"
+#include "vp9/common/vp9_mv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Number of frame pairs whose motion fields are kept.
+#define MOTION_FIELD_CACHE_SIZE 16
+
+// The full pel motion vector found for a block, and the number of SAD
+// evaluations of the search that found it, 0 if no vector was stored.
+typedef struct {
+  MV mv;
+  unsigned int sad_count;
+} MOTION_FIELD_BLOCK;
+
+// The motion vectors of the blocks of one source frame in one reference
+// frame, for each block size of 8x8 and above at the positions aligned to
+// that size. Frames are identified by the id of their lookahead entry, and a
+// reconstructed frame by the id of the source frame it was coded from.
+typedef struct {
+  unsigned int src_id;
+  unsigned int ref_id;
+  int mi_rows;
+  int mi_cols;
+  unsigned int last_use;
+  int offset[BLOCK_SIZES];  // of the first block of each size in blocks
+  int num_blocks;
+  MOTION_FIELD_BLOCK *blocks;
+} MOTION_FIELD;
+
+// Reuse of the motion field cache.
+typedef struct {
+  int64_t sads;        // SAD evaluations of the searches that used the cache
+  int64_t lookups;     // motion searches that looked up a cached vector
+  int64_t hits;        // lookups that found one
+  int64_t reused;      // hits used as the result of the full pel search
+  // SAD evaluations saved by the hits: all of those of the search of a reused
+  // vector, and for a seed the excess of those of the search that produced it
+  // over those of the seeded search.
+  int64_t sads_saved;
+} MOTION_FIELD_STATS;
+
+typedef struct {
+  MOTION_FIELD fields[MOTION_FIELD_CACHE_SIZE];
+  unsigned int use_count;
+  MOTION_FIELD_STATS stats;  // totals of the encode
+} MOTION_FIELD_CACHE;
+
+void vp9_free_motion_field_cache(MOTION_FIELD_CACHE *cache);
+
+// Returns the field of src_id in ref_id of a mi_rows x mi_cols frame, or
+// NULL if it is not cached.
+MOTION_FIELD *vp9_find_motion_field(MOTION_FIELD_CACHE *cache,
+                                    unsigned int src_id, unsigned int ref_id,
+                                    int mi_rows, int mi_cols);
+
+// As vp9_find_motion_field(), but if the field is not cached, an empty one
+// replaces the least recently used field. Returns NULL if it could not be
+// allocated.
+MOTION_FIELD *vp9_get_motion_field(MOTION_FIELD_CACHE *cache,
+                                   unsigned int src_id, unsigned int ref_id,
+                                   int mi_rows, int mi_cols);
+
+static INLINE MOTION_FIELD_BLOCK *vp9_motion_field_block(
+    const MOTION_FIELD *field, BLOCK_SIZE bsize, int mi_row, int mi_col) {
+  const int bw = num_8x8_blocks_wide_lookup[bsize];
+  const int bh = num_8x8_blocks_high_lookup[bsize];
+  const int cols = (field->mi_cols + bw - 1) / bw;
+
+  return &field->blocks[field->offset[bsize] + (mi_row / bh) * cols +
+                        mi_col / bw];
+}
+
+void vp9_accumulate_motion_field_stats(MOTION_FIELD_STATS *dst,
+                                       const MOTION_FIELD_STATS *src);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // VP9_ENCODER_VP9_MOTION_FIELD_H_
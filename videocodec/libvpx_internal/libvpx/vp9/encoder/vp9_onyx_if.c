@@ -33,6 +33,7 @@
 #include "vp9/encoder/vp9_bitstream.h"
 #include "vp9/encoder/vp9_encodeframe.h"
 #include "vp9/encoder/vp9_encodemv.h"
+#include "vp9/encoder/vp9_ethread.h"
 #include "vp9/encoder/vp9_firstpass.h"
 #include "vp9/encoder/vp9_mbgraph.h"
 #include "vp9/encoder/vp9_onyx_int.h"
@@ -120,7 +121,7 @@ static INLINE void Scale2Ratio(VPX_SCALING mode, int *hr, int *hs) {
 }
 
 static void set_high_precision_mv(VP9_COMP *cpi, int allow_high_precision_mv) {
-  MACROBLOCK *const mb = &cpi->mb;
+  MACROBLOCK *const mb = &cpi->td.mb;
   cpi->common.allow_high_precision_mv = allow_high_precision_mv;
   if (cpi->common.allow_high_precision_mv) {
     mb->mvcost = mb->nmvcost_hp;
@@ -193,6 +194,11 @@ static void dealloc_compressor_data(VP9_COMP *cpi) {
   vp9_free_frame_buffer(&cpi->alt_ref_buffer);
   vp9_lookahead_destroy(cpi->lookahead);
 
+  for (i = 0; i < FRAME_BUFFERS; ++i)
+    vp9_free_pyramid(&cpi->frame_pyramid[i]);
+  vp9_free_pyramid(&cpi->scaled_source_pyramid);
+  vp9_free_motion_field_cache(&cpi->mv_field_cache);
+
   vpx_free(cpi->tok);
   cpi->tok = 0;
 
@@ -550,9 +556,9 @@ static void set_speed_features(VP9_COMP *cpi) {
   set_rd_speed_thresholds(cpi);
   set_rd_speed_thresholds_sub8x8(cpi);
 
-  cpi->mb.fwd_txm4x4 = vp9_fdct4x4;
-  if (cpi->oxcf.lossless || cpi->mb.e_mbd.lossless) {
-    cpi->mb.fwd_txm4x4 = vp9_fwht4x4;
+  cpi->td.mb.fwd_txm4x4 = vp9_fdct4x4;
+  if (cpi->oxcf.lossless || cpi->td.mb.e_mbd.lossless) {
+    cpi->td.mb.fwd_txm4x4 = vp9_fwht4x4;
   }
 }
 
@@ -625,7 +631,7 @@ void vp9_alloc_compressor_data(VP9_COMP *cpi) {
 
 static void update_frame_size(VP9_COMP *cpi) {
   VP9_COMMON *const cm = &cpi->common;
-  MACROBLOCKD *const xd = &cpi->mb.e_mbd;
+  MACROBLOCKD *const xd = &cpi->td.mb.e_mbd;
 
   vp9_update_frame_size(cm);
 
@@ -654,10 +660,10 @@ static void update_frame_size(VP9_COMP *cpi) {
   {
     int y_stride = cpi->scaled_source.y_stride;
 
-    if (cpi->sf.search_method == NSTEP) {
-      vp9_init3smotion_compensation(&cpi->mb, y_stride);
+    if (cpi->sf.search_method == NSTEP || cpi->sf.search_method == PYRAMID) {
+      vp9_init3smotion_compensation(&cpi->td.mb, y_stride);
     } else if (cpi->sf.search_method == DIAMOND) {
-      vp9_init_dsmotion_compensation(&cpi->mb, y_stride);
+      vp9_init_dsmotion_compensation(&cpi->td.mb, y_stride);
     }
   }
 
@@ -877,9 +883,9 @@ void vp9_change_config(struct VP9_COMP *cpi, const VP9_CONFIG *oxcf) {
     // is set.
     cpi->oxcf.worst_allowed_q = 0;
     cpi->oxcf.best_allowed_q = 0;
-    cpi->mb.e_mbd.itxm_add = vp9_iwht4x4_add;
+    cpi->td.mb.e_mbd.itxm_add = vp9_iwht4x4_add;
   } else {
-    cpi->mb.e_mbd.itxm_add = vp9_idct4x4_add;
+    cpi->td.mb.e_mbd.itxm_add = vp9_idct4x4_add;
   }
   rc->baseline_gf_interval = DEFAULT_GF_INTERVAL;
   cpi->ref_frame_flags = VP9_ALT_FLAG | VP9_GOLD_FLAG | VP9_LAST_FLAG;
@@ -1079,10 +1085,8 @@ static void free_mode_context(PICK_MODE_CONTEXT *ctx) {
   }
 }
 
-static void init_pick_mode_context(VP9_COMP *cpi) {
+void vp9_alloc_pick_mode_context(VP9_COMMON *cm, MACROBLOCK *x) {
   int i;
-  VP9_COMMON *const cm = &cpi->common;
-  MACROBLOCK *const x  = &cpi->mb;
 
   for (i = 0; i < BLOCK_SIZES; ++i) {
     const int num_4x4_w = num_4x4_blocks_wide_lookup[i];
@@ -1119,7 +1123,7 @@ static void init_pick_mode_context(VP9_COMP *cpi) {
   }
 }
 
-static void free_pick_mode_context(MACROBLOCK *x) {
+void vp9_free_pick_mode_context(MACROBLOCK *x) {
   int i;
 
   for (i = 0; i < BLOCK_SIZES; ++i) {
@@ -1155,7 +1159,7 @@ static void free_pick_mode_context(MACROBLOCK *x) {
 }
 
 VP9_COMP *vp9_create_compressor(VP9_CONFIG *oxcf) {
-  int i, j;
+  int i;
   VP9_COMP *const cpi = vpx_memalign(32, sizeof(VP9_COMP));
   VP9_COMMON *const cm = cpi != NULL ? &cpi->common : NULL;
   RATE_CONTROL *const rc = cpi != NULL ? &cpi->rc : NULL;
@@ -1173,7 +1177,7 @@ VP9_COMP *vp9_create_compressor(VP9_CONFIG *oxcf) {
 
   cm->error.setjmp = 1;
 
-  CHECK_MEM_ERROR(cm, cpi->mb.ss, vpx_calloc(sizeof(search_site),
+  CHECK_MEM_ERROR(cm, cpi->td.mb.ss, vpx_calloc(sizeof(search_site),
                                              (MAX_MVSEARCH_STEPS * 8) + 1));
 
   vp9_rtcd();
@@ -1182,7 +1186,7 @@ VP9_COMP *vp9_create_compressor(VP9_CONFIG *oxcf) {
 
   init_config(cpi, oxcf);
   init_rate_control(&cpi->oxcf, cpi->pass, &cpi->rc);
-  init_pick_mode_context(cpi);
+  vp9_alloc_pick_mode_context(cm, &cpi->td.mb);
 
   cm->current_video_frame = 0;
 
@@ -1207,6 +1211,8 @@ VP9_COMP *vp9_create_compressor(VP9_CONFIG *oxcf) {
   CHECK_MEM_ERROR(cm, cpi->cyclic_refresh,
                   vp9_cyclic_refresh_alloc(cm->mi_rows, cm->mi_cols));
 
+  CHECK_MEM_ERROR(cm, cpi->deadline, vp9_deadline_alloc());
+
   // And a place holder structure is the coding context
   // for use if we want to save and restore it
   CHECK_MEM_ERROR(cm, cpi->coding_context.last_frame_seg_map_copy,
@@ -1271,6 +1277,7 @@ VP9_COMP *vp9_create_compressor(VP9_CONFIG *oxcf) {
     cpi->totalp_samples = 0;
 
     cpi->tot_recode_hits = 0;
+    cpi->tot_recode_estimates = 0;
     cpi->summed_quality = 0;
     cpi->summed_weights = 0;
     cpi->summedp_quality = 0;
@@ -1300,18 +1307,18 @@ VP9_COMP *vp9_create_compressor(VP9_CONFIG *oxcf) {
   rc->key_frame_rate_correction_factor = 1.0;
   rc->gf_rate_correction_factor = 1.0;
 
-  cal_nmvjointsadcost(cpi->mb.nmvjointsadcost);
-  cpi->mb.nmvcost[0] = &cpi->mb.nmvcosts[0][MV_MAX];
-  cpi->mb.nmvcost[1] = &cpi->mb.nmvcosts[1][MV_MAX];
-  cpi->mb.nmvsadcost[0] = &cpi->mb.nmvsadcosts[0][MV_MAX];
-  cpi->mb.nmvsadcost[1] = &cpi->mb.nmvsadcosts[1][MV_MAX];
-  cal_nmvsadcosts(cpi->mb.nmvsadcost);
+  cal_nmvjointsadcost(cpi->td.mb.nmvjointsadcost);
+  cpi->td.mb.nmvcost[0] = &cpi->td.mb.nmvcosts[0][MV_MAX];
+  cpi->td.mb.nmvcost[1] = &cpi->td.mb.nmvcosts[1][MV_MAX];
+  cpi->td.mb.nmvsadcost[0] = &cpi->td.mb.nmvsadcosts[0][MV_MAX];
+  cpi->td.mb.nmvsadcost[1] = &cpi->td.mb.nmvsadcosts[1][MV_MAX];
+  cal_nmvsadcosts(cpi->td.mb.nmvsadcost);
 
-  cpi->mb.nmvcost_hp[0] = &cpi->mb.nmvcosts_hp[0][MV_MAX];
-  cpi->mb.nmvcost_hp[1] = &cpi->mb.nmvcosts_hp[1][MV_MAX];
-  cpi->mb.nmvsadcost_hp[0] = &cpi->mb.nmvsadcosts_hp[0][MV_MAX];
-  cpi->mb.nmvsadcost_hp[1] = &cpi->mb.nmvsadcosts_hp[1][MV_MAX];
-  cal_nmvsadcosts_hp(cpi->mb.nmvsadcost_hp);
+  cpi->td.mb.nmvcost_hp[0] = &cpi->td.mb.nmvcosts_hp[0][MV_MAX];
+  cpi->td.mb.nmvcost_hp[1] = &cpi->td.mb.nmvcosts_hp[1][MV_MAX];
+  cpi->td.mb.nmvsadcost_hp[0] = &cpi->td.mb.nmvsadcosts_hp[0][MV_MAX];
+  cpi->td.mb.nmvsadcost_hp[1] = &cpi->td.mb.nmvsadcosts_hp[1][MV_MAX];
+  cal_nmvsadcosts_hp(cpi->td.mb.nmvsadcost_hp);
 
 #ifdef OUTPUT_YUV_SRC
   yuv_file = fopen("bd.yuv", "ab");
@@ -1383,14 +1390,6 @@ VP9_COMP *vp9_create_compressor(VP9_CONFIG *oxcf) {
 
   set_speed_features(cpi);
 
-  // Default rd threshold factors for mode selection
-  for (i = 0; i < BLOCK_SIZES; ++i) {
-    for (j = 0; j < MAX_MODES; ++j)
-      cpi->rd_thresh_freq_fact[i][j] = 32;
-    for (j = 0; j < MAX_REFS; ++j)
-      cpi->rd_thresh_freq_sub8x8[i][j] = 32;
-  }
-
 #define BFP(BT, SDF, SDAF, VF, SVF, SVAF, SVFHH, SVFHV, SVFHHV, \
             SDX3F, SDX8F, SDX4DF)\
     cpi->fn_ptr[BT].sdf            = SDF; \
@@ -1547,6 +1546,19 @@ void vp9_remove_compressor(VP9_COMP *cpi) {
                 total_encode_time);
       }
 
+      fprintf(f, "Recodes\tEstimated\n");
+      fprintf(f, "%7u\t%9u\n", cpi->tot_recode_hits,
+              cpi->tot_recode_estimates);
+
+      fprintf(f, "MvSads\tMvLookups\tMvHits\tMvReused\tSadsSaved\n");
+      fprintf(f, "%6"PRId64"\t%9"PRId64"\t%6"PRId64"\t%8"PRId64
+              "\t%9"PRId64"\n",
+              cpi->mv_field_cache.stats.sads,
+              cpi->mv_field_cache.stats.lookups,
+              cpi->mv_field_cache.stats.hits,
+              cpi->mv_field_cache.stats.reused,
+              cpi->mv_field_cache.stats.sads_saved);
+
       if (cpi->b_calculate_ssimg) {
         fprintf(f, "BitRate\tSSIM_Y\tSSIM_U\tSSIM_V\tSSIM_A\t  Time(ms)\n");
         fprintf(f, "%7.2f\t%6.4f\t%6.4f\t%6.4f\t%6.4f\t%8.0f\n", dr,
@@ -1601,9 +1613,31 @@ void vp9_remove_compressor(VP9_COMP *cpi) {
 #endif
   }
 
-  free_pick_mode_context(&cpi->mb);
+  for (i = 0; i < cpi->num_workers; ++i) {
+    VP9Worker *const worker = &cpi->workers[i];
+    EncWorkerData *const thread_data = &cpi->tile_thr_data[i];
+
+    vp9_worker_end(worker);
+
+    // The last worker encodes on cpi->td.
+    if (i < cpi->num_workers - 1) {
+      vp9_free_pick_mode_context(&thread_data->td->mb);
+      vpx_free(thread_data->td->counts);
+      vpx_free(thread_data->td);
+    }
+  }
+  vpx_free(cpi->tile_thr_data);
+  vpx_free(cpi->workers);
+  vp9_enc_row_mt_dealloc(&cpi->row_mt_info);
+  vp9_loop_filter_dealloc(&cpi->lf_row_sync);
+  vpx_free(cpi->tile_data);
+  vpx_free(cpi->row_data);
+  vpx_free(cpi->fp_row_stats);
+
+  vp9_free_pick_mode_context(&cpi->td.mb);
   dealloc_compressor_data(cpi);
-  vpx_free(cpi->mb.ss);
+  vp9_deadline_free(cpi->deadline);
+  vpx_free(cpi->td.mb.ss);
   vpx_free(cpi->tok);
 
   for (i = 0; i < sizeof(cpi->mbgraph_stats) /
@@ -1725,6 +1759,16 @@ static void calc_psnr(const YV12_BUFFER_CONFIG *a, const YV12_BUFFER_CONFIG *b,
                                   (double)total_sse);
 }
 
+static void generate_deadline_packet(VP9_COMP *cpi) {
+  struct vpx_codec_cx_pkt pkt;
+  int64_t elapsed;
+  vp9_deadline_end_frame(cpi->deadline, &elapsed, &pkt.data.deadline.level);
+  pkt.data.deadline.budget = (unsigned long)cpi->frame_budget;
+  pkt.data.deadline.elapsed = (unsigned long)elapsed;
+  pkt.kind = VPX_CODEC_DEADLINE_PKT;
+  vpx_codec_pkt_list_add(cpi->output_pkt_list, &pkt);
+}
+
 static void generate_psnr_packet(VP9_COMP *cpi) {
   struct vpx_codec_cx_pkt pkt;
   int i;
@@ -1792,7 +1836,15 @@ int vp9_set_reference_enc(VP9_COMP *cpi, VP9_REFFRAME ref_frame_flag,
                           YV12_BUFFER_CONFIG *sd) {
   YV12_BUFFER_CONFIG *cfg = get_vp9_ref_frame_buffer(cpi, ref_frame_flag);
   if (cfg) {
+    int i;
+
     vp8_yv12_copy_frame(sd, cfg);
+    // The pyramid of the buffer is rebuilt on its next use, and its content
+    // no longer comes from a known source frame.
+    for (i = 0; i < FRAME_BUFFERS; ++i) {
+      cpi->frame_pyramid[i].valid = 0;
+      cpi->frame_ids[i] = 0;
+    }
     return 0;
   } else {
     return -1;
@@ -2098,7 +2150,7 @@ void vp9_update_reference_frames(VP9_COMP *cpi) {
 }
 
 static void loopfilter_frame(VP9_COMP *cpi, VP9_COMMON *cm) {
-  MACROBLOCKD *xd = &cpi->mb.e_mbd;
+  MACROBLOCKD *xd = &cpi->td.mb.e_mbd;
   struct loopfilter *lf = &cm->lf;
   if (xd->lossless) {
       lf->filter_level = 0;
@@ -2116,7 +2168,10 @@ static void loopfilter_frame(VP9_COMP *cpi, VP9_COMMON *cm) {
   }
 
   if (lf->filter_level > 0) {
-    vp9_loop_filter_frame(cm, xd, lf->filter_level, 0, 0);
+    if (cpi->oxcf.max_threads > 1)
+      vp9_loop_filter_row_mt(cpi, lf->filter_level, 0, 0);
+    else
+      vp9_loop_filter_frame(cm, xd, lf->filter_level, 0, 0);
   }
 
   vp9_extend_frame_inner_borders(cm->frame_to_show);
@@ -2138,6 +2193,8 @@ void vp9_scale_references(VP9_COMP *cpi) {
                                cm->subsampling_x, cm->subsampling_y,
                                VP9_ENC_BORDER_IN_PIXELS, NULL, NULL, NULL);
       scale_and_extend_frame(ref, &cm->frame_bufs[new_fb].buf);
+      cpi->frame_pyramid[new_fb].valid = 0;
+      cpi->frame_ids[new_fb] = cpi->frame_ids[idx];
       cpi->scaled_ref_idx[ref_frame - 1] = new_fb;
     } else {
       cpi->scaled_ref_idx[ref_frame - 1] = idx;
@@ -2146,6 +2203,68 @@ void vp9_scale_references(VP9_COMP *cpi) {
   }
 }
 
+// Builds the pyramids of the source and of the references of the frame for
+// the PYRAMID motion search, keeping those that are still valid.
+static void setup_pyramids(VP9_COMP *cpi) {
+  VP9_COMMON *const cm = &cpi->common;
+  MV_PYRAMID *source_pyramid;
+  MV_REFERENCE_FRAME ref_frame;
+
+  if (cpi->source != NULL && cpi->Source == &cpi->source->img) {
+    source_pyramid = &cpi->source->pyramid;
+  } else {
+    // A scaled or temporally filtered source.
+    source_pyramid = &cpi->scaled_source_pyramid;
+    source_pyramid->valid = 0;
+  }
+  if (!source_pyramid->valid &&
+      vp9_build_pyramid(source_pyramid, cpi->Source))
+    vpx_internal_error(&cm->error, VPX_CODEC_MEM_ERROR,
+                       "Failed to allocate source pyramid");
+  cpi->source_pyramid = source_pyramid;
+
+  for (ref_frame = LAST_FRAME; ref_frame <= ALTREF_FRAME; ++ref_frame) {
+    const int idx = cpi->scaled_ref_idx[ref_frame - 1];
+    MV_PYRAMID *const pyramid = &cpi->frame_pyramid[idx];
+
+    if (!pyramid->valid &&
+        vp9_build_pyramid(pyramid, &cm->frame_bufs[idx].buf))
+      vpx_internal_error(&cm->error, VPX_CODEC_MEM_ERROR,
+                         "Failed to allocate reference pyramid");
+  }
+}
+
+// Sets up the motion fields of Source in its references, and of its
+// references in Source, for the rd motion search.
+static void setup_motion_fields(VP9_COMP *cpi) {
+  VP9_COMMON *const cm = &cpi->common;
+  const unsigned int src_id = cpi->source->id;
+  MV_REFERENCE_FRAME ref_frame;
+
+  vp9_zero(cpi->mv_field);
+  vp9_zero(cpi->mv_field_reverse);
+  if (cpi->sf.mv_field_mode == MV_FIELD_OFF || frame_is_intra_only(cm))
+    return;
+
+  for (ref_frame = LAST_FRAME; ref_frame <= ALTREF_FRAME; ++ref_frame) {
+    const int idx = cm->ref_frame_map[get_ref_frame_idx(cpi, ref_frame)];
+    const unsigned int ref_id = cpi->frame_ids[idx];
+
+    // The alt-ref overlay has the id of the alt-ref frame it references.
+    if (ref_id == 0 || ref_id == src_id)
+      continue;
+    cpi->mv_field[ref_frame] = vp9_get_motion_field(&cpi->mv_field_cache,
+                                                    src_id, ref_id,
+                                                    cm->mi_rows, cm->mi_cols);
+    if (cpi->mv_field[ref_frame] == NULL)
+      vpx_internal_error(&cm->error, VPX_CODEC_MEM_ERROR,
+                         "Failed to allocate motion field");
+    cpi->mv_field_reverse[ref_frame] =
+        vp9_find_motion_field(&cpi->mv_field_cache, ref_id, src_id,
+                              cm->mi_rows, cm->mi_cols);
+  }
+}
+
 static void release_scaled_references(VP9_COMP *cpi) {
   VP9_COMMON *cm = &cpi->common;
   int i;
@@ -2288,6 +2407,17 @@ static void encode_with_recode_loop(VP9_COMP *cpi,
   int q_low = bottom_index, q_high = top_index;
   int frame_over_shoot_limit;
   int frame_under_shoot_limit;
+  // The frame size of a recode can be estimated from the tokens of the last
+  // encode, except on forced key frames which are recoded for their error.
+  const int use_estimate = cpi->sf.use_recode_estimate &&
+                           !cpi->sf.use_nonrd_pick_mode &&
+                           !(cm->frame_type == KEY_FRAME &&
+                             rc->this_key_frame_forced);
+  int can_estimate = 0;
+  int estimate = 0;
+  int encoded_q = q;
+  int encoded_size = 0;
+  int64_t encoded_rate = 0;
 
   // Decide frame size bounds
   vp9_rc_compute_frame_size_bounds(cpi, rc->this_frame_target,
@@ -2315,37 +2445,61 @@ static void encode_with_recode_loop(VP9_COMP *cpi,
       }
     }
 
-    // Variance adaptive and in frame q adjustment experiments are mutually
-    // exclusive.
-    if (cpi->oxcf.aq_mode == VARIANCE_AQ) {
-      vp9_vaq_frame_setup(cpi);
-    } else if (cpi->oxcf.aq_mode == COMPLEXITY_AQ) {
-      vp9_setup_in_frame_q_adj(cpi);
-    }
-
-    // transform / motion compensation build reconstruction frame
-    vp9_encode_frame(cpi);
-
-    // Update the skip mb flag probabilities based on the distribution
-    // seen in the last encoder iteration.
-    // update_base_skip_probs(cpi);
-
-    vp9_clear_system_state();
-
-    // Dummy pack of the bitstream using up to date stats to get an
-    // accurate estimate of output frame size to determine if we need
-    // to recode.
-    if (cpi->sf.recode_loop >= ALLOW_RECODE_KFARFGF) {
-      vp9_save_coding_context(cpi);
-      cpi->dummy_packing = 1;
-      if (!cpi->sf.use_nonrd_pick_mode)
-        vp9_pack_bitstream(cpi, dest, size);
+    if (estimate) {
+      // Project the size of the last encode by the change in the rate of its
+      // tokens requantized at this q.
+      const int64_t rate = vp9_requantized_token_rate(
+          cpi, cpi->recode_token_costs, encoded_q, q);
+      rc->projected_frame_size =
+          MAX(encoded_size + (int)((rate - encoded_rate) / 256), 0);
+#if CONFIG_INTERNAL_STATS
+      cpi->tot_recode_estimates++;
+#endif
+    } else {
+      // Variance adaptive and in frame q adjustment experiments are mutually
+      // exclusive.
+      if (cpi->oxcf.aq_mode == VARIANCE_AQ) {
+        vp9_vaq_frame_setup(cpi);
+      } else if (cpi->oxcf.aq_mode == COMPLEXITY_AQ) {
+        vp9_setup_in_frame_q_adj(cpi);
+      }
 
-      rc->projected_frame_size = (int)(*size) << 3;
-      vp9_restore_coding_context(cpi);
+      // transform / motion compensation build reconstruction frame
+      vp9_encode_frame(cpi);
+
+      // Update the skip mb flag probabilities based on the distribution
+      // seen in the last encoder iteration.
+      // update_base_skip_probs(cpi);
+
+      vp9_clear_system_state();
+
+      // Dummy pack of the bitstream using up to date stats to get an
+      // accurate estimate of output frame size to determine if we need
+      // to recode.
+      if (cpi->sf.recode_loop >= ALLOW_RECODE_KFARFGF) {
+        vp9_save_coding_context(cpi);
+        cpi->dummy_packing = 1;
+        if (!cpi->sf.use_nonrd_pick_mode)
+          vp9_pack_bitstream(cpi, dest, size);
+
+        rc->projected_frame_size = (int)(*size) << 3;
+
+        // Segment q deltas are not known to the tokens, so only estimate
+        // frames without segmentation.
+        can_estimate = use_estimate && !cm->seg.enabled;
+        if (can_estimate) {
+          vp9_fill_token_costs(cpi->recode_token_costs, cm->fc.coef_probs,
+                               NULL);
+          encoded_q = q;
+          encoded_size = rc->projected_frame_size;
+          encoded_rate = vp9_requantized_token_rate(
+              cpi, cpi->recode_token_costs, q, q);
+        }
+        vp9_restore_coding_context(cpi);
 
-      if (frame_over_shoot_limit == 0)
-        frame_over_shoot_limit = 1;
+        if (frame_over_shoot_limit == 0)
+          frame_over_shoot_limit = 1;
+      }
     }
 
     if (cpi->oxcf.end_usage == USAGE_CONSTANT_QUALITY) {
@@ -2476,6 +2630,14 @@ static void encode_with_recode_loop(VP9_COMP *cpi,
         rc->projected_frame_size < rc->max_frame_bandwidth)
       loop = 0;
 
+    if (estimate && !loop && q != encoded_q) {
+      // The estimate is within bounds, encode the frame at this q.
+      loop = 1;
+      estimate = 0;
+    } else {
+      estimate = loop && can_estimate;
+    }
+
     if (loop) {
       loop_count++;
 
@@ -2579,7 +2741,7 @@ static void encode_frame_to_data_rate(VP9_COMP *cpi,
   // Enable or disable mode based tweaking of the zbin.
   // For 2 pass only used where GF/ARF prediction quality
   // is above a threshold.
-  cpi->zbin_mode_boost = 0;
+  cpi->td.mb.zbin_mode_boost = 0;
   cpi->zbin_mode_boost_enabled = 0;
 
   // Current default encoder behavior for the altref sign bias.
@@ -2693,6 +2855,10 @@ static void encode_frame_to_data_rate(VP9_COMP *cpi,
 
   set_speed_features(cpi);
 
+  if (sf->search_method == PYRAMID && !frame_is_intra_only(cm))
+    setup_pyramids(cpi);
+  setup_motion_fields(cpi);
+
   // Decide q and q bounds.
   q = vp9_rc_pick_q_and_bounds(cpi, &bottom_index, &top_index);
 
@@ -2753,7 +2919,8 @@ static void encode_frame_to_data_rate(VP9_COMP *cpi,
   vp9_update_reference_frames(cpi);
 
   for (t = TX_4X4; t <= TX_32X32; t++)
-    full_to_model_counts(cm->counts.coef[t], cpi->coef_counts[t]);
+    full_to_model_counts(cm->counts.coef[t],
+                         cpi->td.rd_counts.coef_counts[t]);
 
   if (!cm->error_resilient_mode && !cm->frame_parallel_decoding_mode)
     vp9_adapt_coef_probs(cm);
@@ -2909,6 +3076,9 @@ int vp9_receive_raw_frame(VP9_COMP *cpi, unsigned int frame_flags,
   const int subsampling_y = sd->uv_height < sd->y_height;
 
   check_initial_width(cpi, subsampling_x, subsampling_y);
+  vp9_lookahead_set_analysis(cpi->lookahead,
+                             cpi->pass == 0 && cpi->oxcf.lookahead_analysis,
+                             cpi->oxcf.max_threads > 1);
   vpx_usec_timer_start(&timer);
   if (vp9_lookahead_push(cpi->lookahead,
                          sd, time_stamp, end_time, frame_flags))
@@ -2988,7 +3158,7 @@ int vp9_get_compressed_data(VP9_COMP *cpi, unsigned int *frame_flags,
                             size_t *size, uint8_t *dest,
                             int64_t *time_stamp, int64_t *time_end, int flush) {
   VP9_COMMON *const cm = &cpi->common;
-  MACROBLOCKD *const xd = &cpi->mb.e_mbd;
+  MACROBLOCKD *const xd = &cpi->td.mb.e_mbd;
   RATE_CONTROL *const rc = &cpi->rc;
   struct vpx_usec_timer  cmptimer;
   YV12_BUFFER_CONFIG *force_src_buffer = NULL;
@@ -3002,6 +3172,7 @@ int vp9_get_compressed_data(VP9_COMP *cpi, unsigned int *frame_flags,
   }
 
   vpx_usec_timer_start(&cmptimer);
+  vp9_deadline_start_frame(cpi->deadline, cpi->frame_budget);
 
   cpi->source = NULL;
   cpi->last_source = NULL;
@@ -3163,6 +3334,8 @@ int vp9_get_compressed_data(VP9_COMP *cpi, unsigned int *frame_flags,
    */
   cm->frame_bufs[cm->new_fb_idx].ref_count--;
   cm->new_fb_idx = get_free_fb(cm);
+  cpi->frame_pyramid[cm->new_fb_idx].valid = 0;
+  cpi->frame_ids[cm->new_fb_idx] = cpi->source->id;
 
 #if CONFIG_MULTIPLE_ARF
   /* Set up the correct ARF frame. */
@@ -3238,6 +3411,9 @@ int vp9_get_compressed_data(VP9_COMP *cpi, unsigned int *frame_flags,
   vpx_usec_timer_mark(&cmptimer);
   cpi->time_compress_data += vpx_usec_timer_elapsed(&cmptimer);
 
+  if (cpi->frame_budget)
+    generate_deadline_packet(cpi);
+
   if (cpi->b_calculate_psnr && cpi->pass != 1 && cm->show_frame)
     generate_psnr_packet(cpi);
 
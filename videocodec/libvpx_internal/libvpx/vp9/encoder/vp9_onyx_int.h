@@ -22,13 +22,20 @@
 #include "vp9/common/vp9_entropy.h"
 #include "vp9/common/vp9_entropymode.h"
 #include "vp9/common/vp9_onyxc_int.h"
+#include "vp9/common/vp9_thread.h"
+#include "vp9/common/vp9_thread_common.h"
+#include "vp9/common/vp9_tile_common.h"
 
 #include "vp9/encoder/vp9_aq_cyclicrefresh.h"
+#include "vp9/encoder/vp9_deadline.h"
 #include "vp9/encoder/vp9_encodemb.h"
+#include "vp9/encoder/vp9_ethread.h"
 #include "vp9/encoder/vp9_firstpass.h"
 #include "vp9/encoder/vp9_lookahead.h"
 #include "vp9/encoder/vp9_mbgraph.h"
 #include "vp9/encoder/vp9_mcomp.h"
+#include "vp9/encoder/vp9_motion_field.h"
+#include "vp9/encoder/vp9_pyramid.h"
 #include "vp9/encoder/vp9_quantize.h"
 #include "vp9/encoder/vp9_ratectrl.h"
 #include "vp9/encoder/vp9_speed_features.h"
@@ -44,9 +51,6 @@ extern "C" {
 
 #define DEFAULT_GF_INTERVAL         10
 
-#define MAX_MODES 30
-#define MAX_REFS  6
-
 typedef struct {
   int nmvjointcost[MV_JOINTS];
   int nmvcosts[2][MV_VALS];
@@ -64,6 +68,21 @@ typedef struct {
   FRAME_CONTEXT fc;
 } CODING_CONTEXT;
 
+// Probabilities the rd cost tables of cpi->td.mb were last built from.
+// vp9_initialize_rd_consts() only rebuilds the tables whose probabilities
+// changed since.
+typedef struct {
+  vp9_coeff_probs_model coef_probs[TX_SIZES][PLANE_TYPES];
+  vp9_prob partition_prob[PARTITION_CONTEXTS][PARTITION_TYPES - 1];
+  vp9_prob y_mode_prob[INTRA_MODES - 1];
+  vp9_prob uv_mode_prob[INTRA_MODES - 1];
+  vp9_prob switchable_interp_prob[SWITCHABLE_FILTER_CONTEXTS]
+                                 [SWITCHABLE_FILTERS - 1];
+  vp9_prob inter_mode_probs[INTER_MODE_CONTEXTS][INTER_MODES - 1];
+  nmv_context nmvc;
+  int allow_high_precision_mv;
+} RD_COST_PROBS;
+
 // This enumerator type needs to be kept aligned with the mode order in
 // const MODE_DEFINITION vp9_mode_order[MAX_MODES] used in the rd code.
 typedef enum {
@@ -276,15 +295,60 @@ typedef struct {
   int tile_columns;
   int tile_rows;
 
+  int max_threads;
+  int row_mt;  // encode the superblock rows of a tile column in parallel
+
+  // Analyze the frames as they enter the lookahead, for the one pass rate
+  // control and key frame placement.
+  int lookahead_analysis;
+
   struct vpx_fixed_buf         two_pass_stats_in;
   struct vpx_codec_pkt_list  *output_pkt_list;
 
   vp8e_tuning tuning;
 } VP9_CONFIG;
 
+// Rate-distortion statistics gathered while encoding the tiles of a frame.
+typedef struct {
+  vp9_coeff_count coef_counts[TX_SIZES][PLANE_TYPES];
+  int64_t comp_pred_diff[REFERENCE_MODES];
+  int64_t tx_select_diff[TX_MODES];
+  int64_t filter_diff[SWITCHABLE_FILTER_CONTEXTS];
+#if CONFIG_INTERNAL_STATS
+  unsigned int mode_chosen_counts[MAX_MODES];
+#endif
+  MOTION_FIELD_STATS mv_field_stats;
+} RD_COUNTS;
+
+// State of a thread encoding tiles. The frame counts and rd statistics are
+// merged into the ones of the main thread once the frame's tiles are done.
+typedef struct ThreadData {
+  MACROBLOCK mb;
+  RD_COUNTS rd_counts;
+  FRAME_COUNTS *counts;
+} ThreadData;
+
+// Per tile state that carries over from frame to frame, so that the coding
+// decisions of a tile do not depend on the tiles encoded before it.
+typedef struct {
+  TileInfo tile_info;
+  int thresh_freq_fact[BLOCK_SIZES][MAX_MODES];
+  int thresh_freq_sub8x8[BLOCK_SIZES][MAX_REFS];
+} TileDataEnc;
+
+// Per superblock row state of a tile column. Each row tokenizes into its own
+// region of the token buffer. With row-based multi-threading the rows also
+// adapt their own rd thresholds, so that they can be encoded in any order.
+typedef struct {
+  TOKENEXTRA *tok;
+  unsigned int tok_count;
+  int thresh_freq_fact[BLOCK_SIZES][MAX_MODES];
+  int thresh_freq_sub8x8[BLOCK_SIZES][MAX_REFS];
+} RowDataEnc;
+
 typedef struct VP9_COMP {
   QUANTS quants;
-  MACROBLOCK mb;
+  ThreadData td;
   VP9_COMMON common;
   VP9_CONFIG oxcf;
   struct lookahead_ctx    *lookahead;
@@ -310,6 +374,21 @@ typedef struct VP9_COMP {
   int gold_is_alt;  // don't do both alt and gold search ( just do gold).
 
   int scaled_ref_idx[3];
+  // Downscaled luma of the frame buffers, and of a source that is not a
+  // lookahead buffer, for the PYRAMID motion search. source_pyramid is the
+  // one of Source while a frame is encoded with it.
+  MV_PYRAMID frame_pyramid[FRAME_BUFFERS];
+  MV_PYRAMID scaled_source_pyramid;
+  const MV_PYRAMID *source_pyramid;
+  // Full pel motion vectors of earlier searches. frame_ids holds the id of
+  // the source frame each frame buffer was coded from, 0 if unknown.
+  // mv_field and mv_field_reverse are the fields of Source in each reference
+  // and of each reference in Source while a frame is encoded, NULL if there
+  // are none.
+  MOTION_FIELD_CACHE mv_field_cache;
+  unsigned int frame_ids[FRAME_BUFFERS];
+  MOTION_FIELD *mv_field[MAX_REF_FRAMES];
+  const MOTION_FIELD *mv_field_reverse[MAX_REF_FRAMES];
   int lst_fb_idx;
   int gld_fb_idx;
   int alt_fb_idx;
@@ -332,7 +411,22 @@ typedef struct VP9_COMP {
   YV12_BUFFER_CONFIG last_frame_uf;
 
   TOKENEXTRA *tok;
-  unsigned int tok_count[4][1 << 6];
+
+  TileDataEnc *tile_data;
+  int allocated_tiles;  // number of entries in tile_data
+
+  // Indexed by tile_col * sb_rows + sb_row, sb_rows being the number of
+  // superblock rows of the frame.
+  RowDataEnc *row_data;
+  int row_data_cols;  // number of tile columns and superblock rows row_data
+  int row_data_rows;  // was set up for
+
+  // Frame level state of the first pass, read by the threads running it over
+  // the macroblock rows.
+  const YV12_BUFFER_CONFIG *fp_first_ref_buf;
+  const YV12_BUFFER_CONFIG *fp_gld_buf;  // NULL if golden is not searched
+  FIRSTPASS_ROW_STATS *fp_row_stats;
+  int fp_row_stats_rows;  // number of entries in fp_row_stats
 
 #if CONFIG_MULTIPLE_ARF
   // Position within a frame coding order (including any additional ARF frames).
@@ -352,27 +446,21 @@ typedef struct VP9_COMP {
   int rd_thresh_mult_sub8x8[MAX_REFS];
 
   int rd_threshes[MAX_SEGMENTS][BLOCK_SIZES][MAX_MODES];
-  int rd_thresh_freq_fact[BLOCK_SIZES][MAX_MODES];
   int rd_thresh_sub8x8[MAX_SEGMENTS][BLOCK_SIZES][MAX_REFS];
-  int rd_thresh_freq_sub8x8[BLOCK_SIZES][MAX_REFS];
 
-  int64_t rd_comp_pred_diff[REFERENCE_MODES];
+  RD_COST_PROBS rd_cost_probs;
+
   int64_t rd_prediction_type_threshes[MAX_REF_FRAMES][REFERENCE_MODES];
-  int64_t rd_tx_select_diff[TX_MODES];
   // FIXME(rbultje) can this overflow?
   int rd_tx_select_threshes[MAX_REF_FRAMES][TX_MODES];
 
-  int64_t rd_filter_diff[SWITCHABLE_FILTER_CONTEXTS];
   int64_t rd_filter_threshes[MAX_REF_FRAMES][SWITCHABLE_FILTER_CONTEXTS];
-  int64_t rd_filter_cache[SWITCHABLE_FILTER_CONTEXTS];
-  int64_t mask_filter_rd;
 
   int RDMULT;
   int RDDIV;
 
   CODING_CONTEXT coding_context;
 
-  int zbin_mode_boost;
   int zbin_mode_boost_enabled;
   int active_arnr_frames;           // <= cpi->oxcf.arnr_max_frames
   int active_arnr_strength;         // <= cpi->oxcf.arnr_max_strength
@@ -386,7 +474,6 @@ typedef struct VP9_COMP {
 
   int cq_target_quality;
 
-  vp9_coeff_count coef_counts[TX_SIZES][PLANE_TYPES];
   vp9_coeff_probs_model frame_coef_probs[TX_SIZES][PLANE_TYPES];
 
   struct vpx_codec_pkt_list  *output_pkt_list;
@@ -394,7 +481,6 @@ typedef struct VP9_COMP {
   MBGRAPH_FRAME_STATS mbgraph_stats[MAX_LAG_BUFFERS];
   int mbgraph_n_frames;             // number of frames filled in the above
   int static_mb_pct;                // % forced skip mbs by segmentation
-  int seg0_progress, seg0_idx, seg0_cnt;
 
   // for real time encoding
   int speed;
@@ -445,6 +531,13 @@ typedef struct VP9_COMP {
   YV12_BUFFER_CONFIG *frames[MAX_LAG_BUFFERS];
   int fixed_divide[512];
 
+  // Frame level state of the temporal filter, read by the threads filtering
+  // the macroblock rows of the alt-ref frame.
+  int tf_frame_count;
+  int tf_alt_ref_index;
+  struct scale_factors tf_scale;
+  MOTION_FIELD *tf_mv_field[MAX_LAG_BUFFERS];
+
 #if CONFIG_INTERNAL_STATS
   unsigned int mode_chosen_counts[MAX_MODES];
 
@@ -469,6 +562,8 @@ typedef struct VP9_COMP {
   double summedp_quality;
   double summedp_weights;
   unsigned int tot_recode_hits;
+  // Recode loop iterations whose frame size was estimated rather than encoded.
+  unsigned int tot_recode_estimates;
 
 
   double total_ssimg_y;
@@ -480,6 +575,11 @@ typedef struct VP9_COMP {
 #endif
   int b_calculate_psnr;
 
+  // Time budget of the frame in microseconds, 0 for none, and the timing of
+  // the frames that have one.
+  int64_t frame_budget;
+  FRAME_DEADLINE *deadline;
+
   // Per MB activity measurement
   unsigned int activity_avg;
   unsigned int *mb_activity_map;
@@ -489,7 +589,9 @@ typedef struct VP9_COMP {
 
   int dummy_packing;    /* flag to indicate if packing is dummy */
 
-  unsigned int tx_stepdown_count[TX_SIZES];
+  // Token costs under the coefficient probabilities of the last dummy pack,
+  // used to estimate the frame size of recode loop iterations.
+  vp9_coeff_cost recode_token_costs[TX_SIZES];
 
   int initial_width;
   int initial_height;
@@ -498,6 +600,14 @@ typedef struct VP9_COMP {
 
   SVC svc;
 
+  // Tile and row encoding workers; the last one runs on the calling thread
+  // and uses td.
+  VP9Worker *workers;
+  struct EncWorkerData *tile_thr_data;
+  int num_workers;
+  VP9RowMTInfo row_mt_info;
+  VP9LfSync lf_row_sync;
+
 #if CONFIG_MULTIPLE_ARF
   // ARF tracking variables.
   int multi_arf_enabled;
@@ -589,6 +699,13 @@ static INLINE YV12_BUFFER_CONFIG *get_ref_frame_buffer(
       .buf;
 }
 
+// Pyramid of the reference buffer searched for ref_frame, scaled to the frame
+// size if needed.
+static INLINE const MV_PYRAMID *get_ref_pyramid(
+    const VP9_COMP *cpi, MV_REFERENCE_FRAME ref_frame) {
+  return &cpi->frame_pyramid[cpi->scaled_ref_idx[ref_frame - 1]];
+}
+
 // Intra only frames, golden frames (except alt ref overlays) and
 // alt ref frames tend to be coded at a higher than ambient quality
 static INLINE int vp9_frame_is_boosted(const VP9_COMP *cpi) {
@@ -611,6 +728,9 @@ int vp9_calc_ss_err(const YV12_BUFFER_CONFIG *source,
 
 void vp9_alloc_compressor_data(VP9_COMP *cpi);
 
+void vp9_alloc_pick_mode_context(VP9_COMMON *cm, MACROBLOCK *x);
+void vp9_free_pick_mode_context(MACROBLOCK *x);
+
 int vp9_compute_qdelta(const VP9_COMP *cpi, double qstart, double qtarget);
 
 int vp9_compute_qdelta_by_rate(VP9_COMP *cpi, int base_q_index,
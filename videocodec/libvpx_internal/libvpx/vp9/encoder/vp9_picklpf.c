@@ -19,6 +19,7 @@
 #include "vp9/common/vp9_onyxc_int.h"
 #include "vp9/common/vp9_quant_common.h"
 
+#include "vp9/encoder/vp9_ethread.h"
 #include "vp9/encoder/vp9_onyx_int.h"
 #include "vp9/encoder/vp9_picklpf.h"
 #include "vp9/encoder/vp9_quantize.h"
@@ -29,26 +30,109 @@ static int get_max_filter_level(VP9_COMP *cpi) {
 }
 
 
+// The decimated search filters and measures one superblock row in every
+// LPF_SAMPLE_STEP. The sampled rows are far enough apart for their filtering
+// not to overlap.
+#define LPF_SAMPLE_STEP 4
+
+static int is_sample_sb_row(int sb_row) {
+  return sb_row % LPF_SAMPLE_STEP == LPF_SAMPLE_STEP / 2;
+}
+
+// Luma rows changed by filtering superblock row sb_row alone: the row itself
+// and the pixels above its top edge, rounded to whole 16x16 blocks.
+static void get_sample_rows(const YV12_BUFFER_CONFIG *frame, int sb_row,
+                            int *y_start, int *y_end) {
+  *y_start = MAX(sb_row * 64 - 16, 0);
+  *y_end = MIN(sb_row * 64 + 64, ALIGN_POWER_OF_TWO(frame->y_height, 4));
+}
+
+static void copy_y_rows(const YV12_BUFFER_CONFIG *src, YV12_BUFFER_CONFIG *dst,
+                        int y_start, int y_end) {
+  const uint8_t *src_row = src->y_buffer + y_start * src->y_stride;
+  uint8_t *dst_row = dst->y_buffer + y_start * dst->y_stride;
+  int y;
+
+  for (y = y_start; y < MIN(y_end, src->y_height); ++y) {
+    vpx_memcpy(dst_row, src_row, src->y_width);
+    src_row += src->y_stride;
+    dst_row += dst->y_stride;
+  }
+}
+
+// Sum squared error of the luma rows [y_start, y_end), as vp9_calc_ss_err()
+// computes it for the whole frame.
+static int calc_rows_ss_err(const YV12_BUFFER_CONFIG *source,
+                            const YV12_BUFFER_CONFIG *reference,
+                            int y_start, int y_end) {
+  const uint8_t *src = source->y_buffer + y_start * source->y_stride;
+  const uint8_t *ref = reference->y_buffer + y_start * reference->y_stride;
+  int total = 0;
+  int i, j;
+
+  for (i = y_start; i < y_end; i += 16) {
+    for (j = 0; j < source->y_width; j += 16) {
+      unsigned int sse;
+      total += vp9_mse16x16(src + j, source->y_stride,
+                            ref + j, reference->y_stride, &sse);
+    }
+
+    src += 16 * source->y_stride;
+    ref += 16 * reference->y_stride;
+  }
+
+  return total;
+}
+
 static int try_filter_frame(const YV12_BUFFER_CONFIG *sd, VP9_COMP *const cpi,
-                            int filt_level, int partial_frame) {
+                            int filt_level, int decimated) {
   VP9_COMMON *const cm = &cpi->common;
-  int filt_err;
+  MACROBLOCKD *const xd = &cpi->td.mb.e_mbd;
+  const int sb_rows = mi_cols_aligned_to_sb(cm->mi_rows) >> MI_BLOCK_SIZE_LOG2;
+  int filt_err = 0;
+  int sb_row;
+
+  if (!decimated) {
+    if (cpi->oxcf.max_threads > 1)
+      vp9_loop_filter_row_mt(cpi, filt_level, 1, 0);
+    else
+      vp9_loop_filter_frame(cm, xd, filt_level, 1, 0);
+    filt_err = vp9_calc_ss_err(sd, cm->frame_to_show);
+
+    // Re-instate the unfiltered frame
+    vpx_yv12_copy_y(&cpi->last_frame_uf, cm->frame_to_show);
+    return filt_err;
+  }
+
+  vp9_loop_filter_frame_init(cm, filt_level);
+  for (sb_row = 0; sb_row < sb_rows; ++sb_row) {
+    const int mi_row = sb_row << MI_BLOCK_SIZE_LOG2;
+    int y_start, y_end;
 
-  vp9_loop_filter_frame(cm, &cpi->mb.e_mbd, filt_level, 1, partial_frame);
-  filt_err = vp9_calc_ss_err(sd, cm->frame_to_show);
+    if (!is_sample_sb_row(sb_row))
+      continue;
 
-  // Re-instate the unfiltered frame
-  vpx_yv12_copy_y(&cpi->last_frame_uf, cm->frame_to_show);
+    get_sample_rows(sd, sb_row, &y_start, &y_end);
+    vp9_loop_filter_rows(cm->frame_to_show, cm, xd, mi_row,
+                         MIN(mi_row + MI_BLOCK_SIZE, cm->mi_rows), 1);
+    filt_err += calc_rows_ss_err(sd, cm->frame_to_show, y_start, y_end);
+
+    // Re-instate the unfiltered rows
+    copy_y_rows(&cpi->last_frame_uf, cm->frame_to_show, y_start, y_end);
+  }
 
   return filt_err;
 }
 
+// Searches the level that minimizes the luma error of the filtered frame, or
+// of a sample of its superblock rows if decimated is set.
 static void search_filter_level(const YV12_BUFFER_CONFIG *sd, VP9_COMP *cpi,
-                                int partial_frame) {
+                                int decimated) {
   VP9_COMMON *const cm = &cpi->common;
   struct loopfilter *const lf = &cm->lf;
   const int min_filter_level = 0;
   const int max_filter_level = get_max_filter_level(cpi);
+  const int sb_rows = mi_cols_aligned_to_sb(cm->mi_rows) >> MI_BLOCK_SIZE_LOG2;
   int best_err;
   int filt_best;
   int filt_direction = 0;
@@ -62,10 +146,25 @@ static void search_filter_level(const YV12_BUFFER_CONFIG *sd, VP9_COMP *cpi,
   // Set each entry to -1
   vpx_memset(ss_err, 0xFF, sizeof(ss_err));
 
+  // Frames with too few superblock rows to sample are searched in full.
+  if (sb_rows <= LPF_SAMPLE_STEP / 2)
+    decimated = 0;
+
   //  Make a copy of the unfiltered / processed recon buffer
-  vpx_yv12_copy_y(cm->frame_to_show, &cpi->last_frame_uf);
+  if (decimated) {
+    int sb_row;
+    for (sb_row = 0; sb_row < sb_rows; ++sb_row) {
+      int y_start, y_end;
+      if (!is_sample_sb_row(sb_row))
+        continue;
+      get_sample_rows(sd, sb_row, &y_start, &y_end);
+      copy_y_rows(cm->frame_to_show, &cpi->last_frame_uf, y_start, y_end);
+    }
+  } else {
+    vpx_yv12_copy_y(cm->frame_to_show, &cpi->last_frame_uf);
+  }
 
-  best_err = try_filter_frame(sd, cpi, filt_mid, partial_frame);
+  best_err = try_filter_frame(sd, cpi, filt_mid, decimated);
   filt_best = filt_mid;
   ss_err[filt_mid] = best_err;
 
@@ -87,7 +186,7 @@ static void search_filter_level(const YV12_BUFFER_CONFIG *sd, VP9_COMP *cpi,
     if (filt_direction <= 0 && filt_low != filt_mid) {
       // Get Low filter error score
       if (ss_err[filt_low] < 0) {
-        filt_err = try_filter_frame(sd, cpi, filt_low, partial_frame);
+        filt_err = try_filter_frame(sd, cpi, filt_low, decimated);
         ss_err[filt_low] = filt_err;
       } else {
         filt_err = ss_err[filt_low];
@@ -106,7 +205,7 @@ static void search_filter_level(const YV12_BUFFER_CONFIG *sd, VP9_COMP *cpi,
     // Now look at filt_high
     if (filt_direction >= 0 && filt_high != filt_mid) {
       if (ss_err[filt_high] < 0) {
-        filt_err = try_filter_frame(sd, cpi, filt_high, partial_frame);
+        filt_err = try_filter_frame(sd, cpi, filt_high, decimated);
         ss_err[filt_high] = filt_err;
       } else {
         filt_err = ss_err[filt_high];
@@ -22,10 +22,17 @@
 #include "vp9/common/vp9_reconinter.h"
 #include "vp9/common/vp9_reconintra.h"
 
+#include "vp9/encoder/vp9_deadline.h"
 #include "vp9/encoder/vp9_onyx_int.h"
 #include "vp9/encoder/vp9_ratectrl.h"
 #include "vp9/encoder/vp9_rdopt.h"
 
+// Full pel distance of the motion search from its start at each deadline
+// level.
+static const int deadline_search_range[DEADLINE_LEVELS] = {
+  MAX_FULL_PEL_VAL, 64, 16, 16
+};
+
 static void full_pixel_motion_search(VP9_COMP *cpi, MACROBLOCK *x,
                                     const TileInfo *const tile,
                                     BLOCK_SIZE bsize, int mi_row, int mi_col,
@@ -85,6 +92,16 @@ static void full_pixel_motion_search(VP9_COMP *cpi, MACROBLOCK *x,
   mvp_full.col >>= 3;
   mvp_full.row >>= 3;
 
+  if (x->deadline_level > 0) {
+    const int range = deadline_search_range[x->deadline_level];
+    clamp_mv(&mvp_full, x->mv_col_min, x->mv_col_max,
+             x->mv_row_min, x->mv_row_max);
+    x->mv_col_min = MAX(x->mv_col_min, mvp_full.col - range);
+    x->mv_col_max = MIN(x->mv_col_max, mvp_full.col + range);
+    x->mv_row_min = MAX(x->mv_row_min, mvp_full.row - range);
+    x->mv_row_max = MIN(x->mv_row_max, mvp_full.row + range);
+  }
+
   if (cpi->sf.search_method == FAST_DIAMOND) {
     // NOTE: this returns SAD
     vp9_fast_dia_search(x, &mvp_full, step_param, sadpb, 0,
@@ -110,6 +127,16 @@ static void full_pixel_motion_search(VP9_COMP *cpi, MACROBLOCK *x,
     vp9_bigdia_search(x, &mvp_full, step_param, sadpb, 1,
                       &cpi->fn_ptr[bsize], 1,
                       &ref_mv, &tmp_mv->as_mv);
+  } else if (cpi->sf.search_method == PYRAMID) {
+    int further_steps = (cpi->sf.max_step_search_steps - 1) -
+                        PYRAMID_STEP_PARAM;
+    vp9_pyramid_search(x, cpi->source_pyramid, get_ref_pyramid(cpi, ref),
+                       cpi->fn_ptr, bsize, mi_row, mi_col, &mvp_full);
+    // NOTE: this returns variance
+    vp9_full_pixel_diamond(cpi, x, &mvp_full, PYRAMID_STEP_PARAM,
+                           sadpb, further_steps, 1,
+                           &cpi->fn_ptr[bsize],
+                           &ref_mv, &tmp_mv->as_mv);
   } else {
     int further_steps = (cpi->sf.max_step_search_steps - 1) - step_param;
     // NOTE: this returns variance
@@ -139,6 +166,9 @@ static void sub_pixel_motion_search(VP9_COMP *cpi, MACROBLOCK *x,
   struct buf_2d backup_yv12[MAX_MB_PLANE] = {{0}};
   int ref = mbmi->ref_frame[0];
   MV ref_mv = mbmi->ref_mvs[ref][0].as_mv;
+  // Quarter pel from deadline level 1, half pel from level 2.
+  const int subpel_force_stop = MAX(cpi->sf.subpel_force_stop,
+                                    MIN(x->deadline_level, 2));
   int dis;
 
   const YV12_BUFFER_CONFIG *scaled_ref_frame = vp9_get_scaled_ref_frame(cpi,
@@ -158,7 +188,7 @@ static void sub_pixel_motion_search(VP9_COMP *cpi, MACROBLOCK *x,
                                cpi->common.allow_high_precision_mv,
                                x->errorperbit,
                                &cpi->fn_ptr[bsize],
-                               cpi->sf.subpel_force_stop,
+                               subpel_force_stop,
                                cpi->sf.subpel_iters_per_step,
                                x->nmvjointcost, x->mvcost,
                                &dis, &x->pred_sse[ref]);
@@ -231,7 +261,7 @@ int64_t vp9_pick_inter_mode(VP9_COMP *cpi, MACROBLOCK *x,
 
   unsigned char segment_id = mbmi->segment_id;
   const int *const rd_threshes = cpi->rd_threshes[segment_id][bsize];
-  const int *const rd_thresh_freq_fact = cpi->rd_thresh_freq_fact[bsize];
+  const int *const rd_thresh_freq_fact = x->thresh_freq_fact[bsize];
   // Mode index conversion form THR_MODES to MB_PREDICTION_MODE for a ref frame.
   int mode_idx[MB_MODE_COUNT] = {0};
 
@@ -292,6 +322,10 @@ int64_t vp9_pick_inter_mode(VP9_COMP *cpi, MACROBLOCK *x,
           (1 << INTER_OFFSET(this_mode)))
         continue;
 
+      if ((this_mode == NEARMV && x->deadline_level >= 2) ||
+          (this_mode == NEWMV && x->deadline_level >= 3))
+        continue;
+
       if (best_rd < ((int64_t)rd_threshes[mode_idx[this_mode]] *
           rd_thresh_freq_fact[this_mode] >> 5) ||
           rd_threshes[mode_idx[this_mode]] == INT_MAX)
@@ -343,7 +377,7 @@ int64_t vp9_pick_inter_mode(VP9_COMP *cpi, MACROBLOCK *x,
 
   // Perform intra prediction search, if the best SAD is above a certain
   // threshold.
-  if (best_rd > inter_mode_thresh) {
+  if (best_rd > inter_mode_thresh && x->deadline_level < 2) {
     for (this_mode = DC_PRED; this_mode <= DC_PRED; ++this_mode) {
       vp9_predict_intra_block(xd, 0, b_width_log2(bsize),
                               mbmi->tx_size, this_mode,
@@ -0,0 +1,249 @@
+/*
+ *  Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <assert.h>
+#include <limits.h>
+
+#include "vpx_mem/vpx_mem.h"
+
+#include "vp9/common/vp9_common.h"
+#include "vp9/common/vp9_common_data.h"
+
+#include "vp9/encoder/vp9_pyramid.h"
+
+// Half the side of the square searched at the coarsest level, in pixels of
+// that level. It covers +-64 full resolution pixels around the predicted
+// vector.
+#define PYRAMID_SEARCH_RANGE 16
+
+// Borders of the levels, enough for the search range of a block whose
+// prediction may lie outside of the frame within VP9_ENC_BORDER_IN_PIXELS.
+static INLINE int level_border(int level) {
+  return VP9_ENC_BORDER_IN_PIXELS >> (level + 1);
+}
+
+void vp9_free_pyramid(MV_PYRAMID *pyramid) {
+  vpx_free(pyramid->alloc);
+  vpx_memset(pyramid, 0, sizeof(*pyramid));
+}
+
+static int alloc_pyramid(MV_PYRAMID *pyramid, int width, int height) {
+  size_t size = 0;
+  size_t offset[PYRAMID_LEVELS];
+  int level;
+
+  vp9_free_pyramid(pyramid);
+  for (level = 0; level < PYRAMID_LEVELS; ++level) {
+    const int shift = level + 1;
+    const int border = level_border(level);
+
+    pyramid->width[level] = (width + (1 << shift) - 1) >> shift;
+    pyramid->height[level] = (height + (1 << shift) - 1) >> shift;
+    pyramid->stride[level] = (pyramid->width[level] + 2 * border + 31) & ~31;
+    offset[level] = size + border * pyramid->stride[level] + border;
+    size += (pyramid->height[level] + 2 * border) * pyramid->stride[level];
+  }
+
+  pyramid->alloc = (uint8_t *)vpx_memalign(32, size);
+  if (pyramid->alloc == NULL)
+    return -1;
+  for (level = 0; level < PYRAMID_LEVELS; ++level)
+    pyramid->buf[level] = pyramid->alloc + offset[level];
+  pyramid->frame_width = width;
+  pyramid->frame_height = height;
+  return 0;
+}
+
+// Averages 2x2 pixels of src into each pixel of the width x height dst. src
+// is read up to one pixel past 2 * width - 1 columns and rows, which the
+// borders cover.
+static void downscale_2x2(const uint8_t *src, int src_stride,
+                          uint8_t *dst, int dst_stride,
+                          int width, int height) {
+  int r, c;
+
+  for (r = 0; r < height; ++r) {
+    const uint8_t *const s0 = src + 2 * r * src_stride;
+    const uint8_t *const s1 = s0 + src_stride;
+
+    for (c = 0; c < width; ++c)
+      dst[c] = (s0[2 * c] + s0[2 * c + 1] + s1[2 * c] + s1[2 * c + 1] + 2) >> 2;
+    dst += dst_stride;
+  }
+}
+
+static void extend_level(MV_PYRAMID *pyramid, int level) {
+  const int border = level_border(level);
+  const int stride = pyramid->stride[level];
+  const int width = pyramid->width[level];
+  const int height = pyramid->height[level];
+  uint8_t *const buf = pyramid->buf[level];
+  int r;
+
+  for (r = 0; r < height; ++r) {
+    uint8_t *const row = buf + r * stride;
+
+    vpx_memset(row - border, row[0], border);
+    vpx_memset(row + width, row[width - 1], stride - width - border);
+  }
+  for (r = 1; r <= border; ++r) {
+    vpx_memcpy(buf - r * stride - border, buf - border, stride);
+    vpx_memcpy(buf + (height - 1 + r) * stride - border,
+               buf + (height - 1) * stride - border, stride);
+  }
+}
+
+int vp9_build_pyramid(MV_PYRAMID *pyramid, const YV12_BUFFER_CONFIG *src) {
+  int level;
+
+  if (pyramid->alloc == NULL ||
+      pyramid->frame_width != src->y_crop_width ||
+      pyramid->frame_height != src->y_crop_height) {
+    if (alloc_pyramid(pyramid, src->y_crop_width, src->y_crop_height))
+      return -1;
+  }
+
+  downscale_2x2(src->y_buffer, src->y_stride,
+                pyramid->buf[0], pyramid->stride[0],
+                pyramid->width[0], pyramid->height[0]);
+  extend_level(pyramid, 0);
+  for (level = 1; level < PYRAMID_LEVELS; ++level) {
+    downscale_2x2(pyramid->buf[level - 1], pyramid->stride[level - 1],
+                  pyramid->buf[level], pyramid->stride[level],
+                  pyramid->width[level], pyramid->height[level]);
+    extend_level(pyramid, level);
+  }
+  pyramid->valid = 1;
+  return 0;
+}
+
+// Size of a block of at least 4x4 pixels, bsize downscaled by 1 << shift.
+static BLOCK_SIZE scaled_block_size(BLOCK_SIZE bsize, int shift) {
+  const int bwl = MAX(b_width_log2_lookup[bsize] - shift, 0);
+  const int bhl = MAX(b_height_log2_lookup[bsize] - shift, 0);
+  BLOCK_SIZE i;
+
+  for (i = BLOCK_4X4; i < BLOCK_SIZES; ++i)
+    if (b_width_log2_lookup[i] == bwl && b_height_log2_lookup[i] == bhl)
+      break;
+  assert(i < BLOCK_SIZES);
+  return i;
+}
+
+// The vectors of one level of the search within the search range of x.
+typedef struct {
+  vp9_sad_fn_t sdf;
+  const uint8_t *src;
+  int src_stride;
+  const uint8_t *ref;
+  int ref_stride;
+  int row_min, row_max, col_min, col_max;
+} LEVEL_SEARCH;
+
+// Checks the vectors of the square of the given half side around center, in
+// steps of step, updating best and its SAD.
+static void search_square(const LEVEL_SEARCH *s, const MV *center, int range,
+                          int step, MV *best, unsigned int *best_sad) {
+  const int row_min = MAX(center->row - range, s->row_min);
+  const int row_max = MIN(center->row + range, s->row_max);
+  const int col_min = MAX(center->col - range, s->col_min);
+  const int col_max = MIN(center->col + range, s->col_max);
+  int r, c;
+
+  for (r = center->row - range; r <= row_max; r += step) {
+    if (r < row_min)
+      continue;
+    for (c = center->col - range; c <= col_max; c += step) {
+      unsigned int sad;
+
+      if (c < col_min)
+        continue;
+      sad = s->sdf(s->src, s->src_stride, s->ref + r * s->ref_stride + c,
+                   s->ref_stride, *best_sad);
+      if (sad < *best_sad) {
+        *best_sad = sad;
+        best->row = r;
+        best->col = c;
+      }
+    }
+  }
+}
+
+void vp9_pyramid_search(const MACROBLOCK *x, const MV_PYRAMID *src,
+                        const MV_PYRAMID *ref,
+                        const vp9_variance_fn_ptr_t *fn_ptr,
+                        BLOCK_SIZE bsize, int mi_row, int mi_col, MV *mv) {
+  const struct buf_2d *const what = &x->plane[0].src;
+  const struct buf_2d *const in_what = &x->e_mbd.plane[0].pre[0];
+  MV best = *mv;
+  unsigned int best_sad, sad;
+  int level;
+
+  clamp_mv(&best, x->mv_col_min, x->mv_col_max, x->mv_row_min, x->mv_row_max);
+  *mv = best;
+
+  for (level = PYRAMID_LEVELS - 1; level >= 0; --level) {
+    const int shift = level + 1;
+    LEVEL_SEARCH s;
+
+    s.sdf = fn_ptr[scaled_block_size(bsize, shift)].sdf;
+    s.src_stride = src->stride[level];
+    s.src = src->buf[level] + ((mi_row * MI_SIZE) >> shift) * s.src_stride +
+            ((mi_col * MI_SIZE) >> shift);
+    s.ref_stride = ref->stride[level];
+    s.ref = ref->buf[level] + ((mi_row * MI_SIZE) >> shift) * s.ref_stride +
+            ((mi_col * MI_SIZE) >> shift);
+    // The downscaled range of x, rounded inwards.
+    s.row_min = -(-x->mv_row_min >> shift);
+    s.row_max = x->mv_row_max >> shift;
+    s.col_min = -(-x->mv_col_min >> shift);
+    s.col_max = x->mv_col_max >> shift;
+
+    if (level == PYRAMID_LEVELS - 1) {
+      best.row >>= shift;
+      best.col >>= shift;
+    } else {
+      best.row *= 2;
+      best.col *= 2;
+    }
+    clamp_mv(&best, s.col_min, s.col_max, s.row_min, s.row_max);
+    best_sad = s.sdf(s.src, s.src_stride,
+                     s.ref + best.row * s.ref_stride + best.col,
+                     s.ref_stride, UINT_MAX);
+
+    if (level == PYRAMID_LEVELS - 1) {
+      // A coarse grid over the whole range first.
+      const MV center = best;
+      search_square(&s, &center, PYRAMID_SEARCH_RANGE, 2, &best, &best_sad);
+    }
+    {
+      const MV center = best;
+      search_square(&s, &center, 1, 1, &best, &best_sad);
+    }
+  }
+
+  // Keep the predicted vector if the pyramid vector is not better at full
+  // resolution, as the downscaled SAD of small blocks is unreliable.
+  best.row *= 2;
+  best.col *= 2;
+  clamp_mv(&best, x->mv_col_min, x->mv_col_max, x->mv_row_min, x->mv_row_max);
+  if (best.row != mv->row || best.col != mv->col) {
+    best_sad = fn_ptr[bsize].sdf(what->buf, what->stride,
+                                 &in_what->buf[mv->row * in_what->stride +
+                                               mv->col],
+                                 in_what->stride, UINT_MAX);
+    sad = fn_ptr[bsize].sdf(what->buf, what->stride,
+                            &in_what->buf[best.row * in_what->stride +
+                                          best.col],
+                            in_what->stride, best_sad);
+    if (sad < best_sad)
+      *mv = best;
+  }
+}
@@ -0,0 +1,66 @@
+/*
+ *  Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef VP9_ENCODER_VP9_PYRAMID_H_
+#define VP9_ENCODER_VP9_PYRAMID_H_
+
+#include "vpx_scale/yv12config.h"
+#include "vp9/common/vp9_enums.h"
+#include "vp9/common/vp9_mv.h"
+#include "vp9/encoder/vp9_mcomp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Level 0 is downscaled by 2, level 1 by 4.
+#define PYRAMID_LEVELS 2
+
+// Step parameter of the full resolution diamond search that starts from the
+// vector of vp9_pyramid_search(), for a first step of 2 pixels.
+#define PYRAMID_STEP_PARAM (MAX_MVSEARCH_STEPS - 2)
+
+// The luma plane of a frame downscaled by 2 and by 4, with extended borders,
+// for a coarse motion search ahead of the full resolution one.
+typedef struct {
+  uint8_t *buf[PYRAMID_LEVELS];  // first visible pixel of each level
+  int stride[PYRAMID_LEVELS];
+  int width[PYRAMID_LEVELS];
+  int height[PYRAMID_LEVELS];
+  int frame_width;   // size of the frame the levels were allocated for
+  int frame_height;
+  uint8_t *alloc;
+  int valid;  // the levels hold the frame last built from
+} MV_PYRAMID;
+
+// Downscales the luma plane of src, which must have its borders extended,
+// into the levels of pyramid, (re)allocating them for its size as needed.
+// Returns 0 on success, -1 if the levels could not be allocated.
+int vp9_build_pyramid(MV_PYRAMID *pyramid, const YV12_BUFFER_CONFIG *src);
+
+void vp9_free_pyramid(MV_PYRAMID *pyramid);
+
+// Searches the bsize block at (mi_row, mi_col) of the source pyramid in the
+// reference pyramid, from the coarsest level to the finest, around the full
+// pel vector mv. mv is then set to the better of that vector and the
+// downscaled search result at full resolution, for the full resolution
+// search to start from. The vectors are kept within the search range of x,
+// whose source and prediction buffers must be set up for the block. fn_ptr
+// is indexed by block size.
+void vp9_pyramid_search(const MACROBLOCK *x, const MV_PYRAMID *src,
+                        const MV_PYRAMID *ref,
+                        const vp9_variance_fn_ptr_t *fn_ptr,
+                        BLOCK_SIZE bsize, int mi_row, int mi_col, MV *mv);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // VP9_ENCODER_VP9_PYRAMID_H_
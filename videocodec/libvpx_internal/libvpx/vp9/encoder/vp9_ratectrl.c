@@ -114,9 +114,9 @@ void vp9_save_coding_context(VP9_COMP *cpi) {
   // restored with a call to vp9_restore_coding_context. These functions are
   // intended for use in a re-code loop in vp9_compress_frame where the
   // quantizer value is adjusted between loop iterations.
-  vp9_copy(cc->nmvjointcost,  cpi->mb.nmvjointcost);
-  vp9_copy(cc->nmvcosts,  cpi->mb.nmvcosts);
-  vp9_copy(cc->nmvcosts_hp,  cpi->mb.nmvcosts_hp);
+  vp9_copy(cc->nmvjointcost,  cpi->td.mb.nmvjointcost);
+  vp9_copy(cc->nmvcosts,  cpi->td.mb.nmvcosts);
+  vp9_copy(cc->nmvcosts_hp,  cpi->td.mb.nmvcosts_hp);
 
   vp9_copy(cc->segment_pred_probs, cm->seg.pred_probs);
 
@@ -135,9 +135,9 @@ void vp9_restore_coding_context(VP9_COMP *cpi) {
 
   // Restore key state variables to the snapshot state stored in the
   // previous call to vp9_save_coding_context.
-  vp9_copy(cpi->mb.nmvjointcost, cc->nmvjointcost);
-  vp9_copy(cpi->mb.nmvcosts, cc->nmvcosts);
-  vp9_copy(cpi->mb.nmvcosts_hp, cc->nmvcosts_hp);
+  vp9_copy(cpi->td.mb.nmvjointcost, cc->nmvjointcost);
+  vp9_copy(cpi->td.mb.nmvcosts, cc->nmvcosts);
+  vp9_copy(cpi->td.mb.nmvcosts_hp, cc->nmvcosts_hp);
 
   vp9_copy(cm->seg.pred_probs, cc->segment_pred_probs);
 
@@ -1164,9 +1164,89 @@ void vp9_rc_postencode_update_drop_frame(VP9_COMP *cpi) {
   cpi->rc.frames_to_key--;
 }
 
+// Frames between a key frame and the earliest scene cut key frame after it.
+#define MIN_SCENE_CUT_INTERVAL 4
+
+// Returns the lookahead analysis of the index-th frame after the one being
+// encoded, or NULL. The frame pushed last is left out, so that its analysis
+// can run in the background while this frame is encoded. The frames looked
+// at do not depend on how long the analysis takes.
+static const struct lookahead_stats *get_future_stats(const VP9_COMP *cpi,
+                                                      int index) {
+  if (index + 1 >= (int)vp9_lookahead_depth(cpi->lookahead))
+    return NULL;
+  return vp9_lookahead_peek_stats(cpi->lookahead, index);
+}
+
+static double intra_inter_ratio(const struct lookahead_stats *stats) {
+  return stats->intra_error / MAX(stats->coded_error, 1.0);
+}
+
+// Returns 1 if the frame of this_frame starts a new scene. next_frame is the
+// analysis of the frame after it, NULL if not known.
+static int is_scene_cut(const struct lookahead_stats *this_frame,
+                        const struct lookahead_stats *next_frame) {
+  // Hardly any block is predicted from the last frame, or few are and the
+  // next frame is predicted much better from this one.
+  return this_frame->pcnt_inter < 0.05 ||
+         (next_frame != NULL && this_frame->pcnt_inter < 0.35 &&
+          intra_inter_ratio(this_frame) < 2.5 &&
+          intra_inter_ratio(next_frame) > 3.5);
+}
+
+// Returns the average share of the blocks predicted from the last frame
+// without motion, over the frames of the lookahead analyzed up to the
+// num_frames-th one after the frame being encoded. Returns 1.0 if none is.
+static double get_zero_motion_pct(const VP9_COMP *cpi, int num_frames) {
+  double sum = 0.0;
+  int i;
+
+  for (i = 0; i < num_frames; ++i) {
+    const struct lookahead_stats *const stats = get_future_stats(cpi, i);
+    if (stats == NULL)
+      break;
+    sum += stats->pcnt_zero_motion;
+  }
+  return i > 0 ? sum / i : 1.0;
+}
+
 static int test_for_kf_one_pass(VP9_COMP *cpi) {
-  // Placeholder function for auto key frame
-  return 0;
+  const struct lookahead_stats *this_frame;
+
+  // Only a shown frame popped from the lookahead can be a scene cut, not an
+  // alt ref frame nor its overlay.
+  if (!cpi->common.show_frame || cpi->rc.is_src_frame_alt_ref ||
+      cpi->rc.frames_since_key < MIN_SCENE_CUT_INTERVAL)
+    return 0;
+  this_frame = vp9_lookahead_peek_stats(cpi->lookahead, -1);
+  if (this_frame == NULL)
+    return 0;
+  return is_scene_cut(this_frame, get_future_stats(cpi, 0));
+}
+
+// Ends the golden frame group before the next scene cut in the lookahead,
+// without an alt ref frame since that would be the cut frame. The fewer
+// blocks of the group are static, the lower its boost.
+static void define_gf_group_one_pass(VP9_COMP *cpi) {
+  RATE_CONTROL *const rc = &cpi->rc;
+  const int frames_since_key = cpi->common.frame_type == KEY_FRAME ?
+                               0 : rc->frames_since_key;
+  int i;
+
+  for (i = 0; i < rc->baseline_gf_interval; ++i) {
+    const struct lookahead_stats *const stats = get_future_stats(cpi, i);
+    if (stats == NULL)
+      break;
+    if (frames_since_key + i + 1 >= MIN_SCENE_CUT_INTERVAL &&
+        is_scene_cut(stats, get_future_stats(cpi, i + 1))) {
+      rc->baseline_gf_interval = i + 1;
+      rc->source_alt_ref_pending = 0;
+      break;
+    }
+  }
+
+  rc->gfu_boost = gf_low + (int)((DEFAULT_GF_BOOST - gf_low) *
+      get_zero_motion_pct(cpi, rc->baseline_gf_interval));
 }
 // Use this macro to turn on/off use of alt-refs in one-pass mode.
 #define USE_ALTREF_FOR_ONE_PASS   1
@@ -1209,19 +1289,25 @@ void vp9_rc_get_one_pass_vbr_params(VP9_COMP *cpi) {
                                 rc->frames_to_key == 0;
     rc->frames_to_key = cpi->key_frame_frequency;
     rc->kf_boost = DEFAULT_KF_BOOST;
+    if (cpi->oxcf.lookahead_analysis)
+      rc->kf_boost = kf_low + (int)((DEFAULT_KF_BOOST - kf_low) *
+                                    get_zero_motion_pct(cpi,
+                                                        DEFAULT_GF_INTERVAL));
     rc->source_alt_ref_active = 0;
   } else {
     cm->frame_type = INTER_FRAME;
   }
   if (rc->frames_till_gf_update_due == 0) {
     rc->baseline_gf_interval = DEFAULT_GF_INTERVAL;
+    rc->source_alt_ref_pending = USE_ALTREF_FOR_ONE_PASS;
+    rc->gfu_boost = DEFAULT_GF_BOOST;
+    if (cpi->oxcf.lookahead_analysis)
+      define_gf_group_one_pass(cpi);
     rc->frames_till_gf_update_due = rc->baseline_gf_interval;
     // NOTE: frames_till_gf_update_due must be <= frames_to_key.
     if (rc->frames_till_gf_update_due > rc->frames_to_key)
       rc->frames_till_gf_update_due = rc->frames_to_key;
     cpi->refresh_golden_frame = 1;
-    rc->source_alt_ref_pending = USE_ALTREF_FOR_ONE_PASS;
-    rc->gfu_boost = DEFAULT_GF_BOOST;
   }
   if (cm->frame_type == KEY_FRAME)
     target = calc_iframe_target_size_one_pass_vbr(cpi);
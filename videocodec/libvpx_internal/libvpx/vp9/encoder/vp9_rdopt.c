@@ -34,6 +34,7 @@
 #include "vp9/encoder/vp9_encodemb.h"
 #include "vp9/encoder/vp9_encodemv.h"
 #include "vp9/encoder/vp9_mcomp.h"
+#include "vp9/encoder/vp9_motion_field.h"
 #include "vp9/encoder/vp9_onyx_int.h"
 #include "vp9/encoder/vp9_quantize.h"
 #include "vp9/encoder/vp9_ratectrl.h"
@@ -55,6 +56,10 @@
 
 #define MIN_EARLY_TERM_INDEX    3
 
+// Step parameter of a motion search that starts from a cached vector, for a
+// first step of 4 pixels.
+#define MV_FIELD_SEED_STEP_PARAM (MAX_MVSEARCH_STEPS - 3)
+
 typedef struct {
   MB_PREDICTION_MODE mode;
   MV_REFERENCE_FRAME ref_frame[2];
@@ -150,30 +155,54 @@ static int16_t* raster_block_offset_int16(BLOCK_SIZE plane_bsize,
   return base + raster_block_offset(plane_bsize, raster_block, stride);
 }
 
+// Returns whether the n probabilities differ from the cached ones, which
+// are then updated to them.
+static int probs_changed(vp9_prob *cached, const vp9_prob *probs, size_t n) {
+  if (!memcmp(cached, probs, n))
+    return 0;
+  vpx_memcpy(cached, probs, n);
+  return 1;
+}
+
 static void fill_mode_costs(VP9_COMP *cpi) {
-  MACROBLOCK *const x = &cpi->mb;
+  MACROBLOCK *const x = &cpi->td.mb;
   const FRAME_CONTEXT *const fc = &cpi->common.fc;
+  RD_COST_PROBS *const cached = &cpi->rd_cost_probs;
   int i, j;
 
-  for (i = 0; i < INTRA_MODES; i++)
-    for (j = 0; j < INTRA_MODES; j++)
-      vp9_cost_tokens((int *)x->y_mode_costs[i][j], vp9_kf_y_mode_prob[i][j],
-                      vp9_intra_mode_tree);
+  // The key frame tables have fixed probabilities, so they are only built
+  // the first time. No probability is ever zero.
+  if (!cached->y_mode_prob[0]) {
+    for (i = 0; i < INTRA_MODES; i++)
+      for (j = 0; j < INTRA_MODES; j++)
+        vp9_cost_tokens((int *)x->y_mode_costs[i][j],
+                        vp9_kf_y_mode_prob[i][j], vp9_intra_mode_tree);
+
+    vp9_cost_tokens(x->intra_uv_mode_cost[KEY_FRAME],
+                    vp9_kf_uv_mode_prob[TM_PRED], vp9_intra_mode_tree);
+  }
 
   // TODO(rbultje) separate tables for superblock costing?
-  vp9_cost_tokens(x->mbmode_cost, fc->y_mode_prob[1], vp9_intra_mode_tree);
-  vp9_cost_tokens(x->intra_uv_mode_cost[KEY_FRAME],
-                  vp9_kf_uv_mode_prob[TM_PRED], vp9_intra_mode_tree);
-  vp9_cost_tokens(x->intra_uv_mode_cost[INTER_FRAME],
-                  fc->uv_mode_prob[TM_PRED], vp9_intra_mode_tree);
+  if (probs_changed(cached->y_mode_prob, fc->y_mode_prob[1],
+                    sizeof(cached->y_mode_prob)))
+    vp9_cost_tokens(x->mbmode_cost, fc->y_mode_prob[1], vp9_intra_mode_tree);
+  if (probs_changed(cached->uv_mode_prob, fc->uv_mode_prob[TM_PRED],
+                    sizeof(cached->uv_mode_prob)))
+    vp9_cost_tokens(x->intra_uv_mode_cost[INTER_FRAME],
+                    fc->uv_mode_prob[TM_PRED], vp9_intra_mode_tree);
 
   for (i = 0; i < SWITCHABLE_FILTER_CONTEXTS; ++i)
-    vp9_cost_tokens((int *)x->switchable_interp_costs[i],
-                    fc->switchable_interp_prob[i], vp9_switchable_interp_tree);
+    if (probs_changed(cached->switchable_interp_prob[i],
+                      fc->switchable_interp_prob[i],
+                      sizeof(cached->switchable_interp_prob[i])))
+      vp9_cost_tokens((int *)x->switchable_interp_costs[i],
+                      fc->switchable_interp_prob[i],
+                      vp9_switchable_interp_tree);
 }
 
-static void fill_token_costs(vp9_coeff_cost *c,
-                             vp9_coeff_probs_model (*p)[PLANE_TYPES]) {
+void vp9_fill_token_costs(vp9_coeff_cost *c,
+                          vp9_coeff_probs_model (*p)[PLANE_TYPES],
+                          vp9_coeff_probs_model (*cached)[PLANE_TYPES]) {
   int i, j, k, l;
   TX_SIZE t;
   for (t = TX_4X4; t <= TX_32X32; ++t)
@@ -182,6 +211,10 @@ static void fill_token_costs(vp9_coeff_cost *c,
         for (k = 0; k < COEF_BANDS; ++k)
           for (l = 0; l < BAND_COEFF_CONTEXTS(k); ++l) {
             vp9_prob probs[ENTROPY_NODES];
+            if (cached && !probs_changed(cached[t][i][j][k][l],
+                                         p[t][i][j][k][l],
+                                         sizeof(cached[t][i][j][k][l])))
+              continue;
             vp9_model_to_full_probs(p[t][i][j][k][l], probs);
             vp9_cost_tokens((int *)c[t][i][j][k][0][l], probs,
                             vp9_coef_tree);
@@ -238,8 +271,8 @@ static int compute_rd_thresh_factor(int qindex) {
 }
 
 void vp9_initialize_me_consts(VP9_COMP *cpi, int qindex) {
-  cpi->mb.sadperbit16 = sad_per_bit16lut[qindex];
-  cpi->mb.sadperbit4 = sad_per_bit4lut[qindex];
+  cpi->td.mb.sadperbit16 = sad_per_bit16lut[qindex];
+  cpi->td.mb.sadperbit4 = sad_per_bit4lut[qindex];
 }
 
 static void set_block_thresholds(VP9_COMP *cpi) {
@@ -275,7 +308,7 @@ static void set_block_thresholds(VP9_COMP *cpi) {
 
 void vp9_initialize_rd_consts(VP9_COMP *cpi) {
   VP9_COMMON *const cm = &cpi->common;
-  MACROBLOCK *const x = &cpi->mb;
+  MACROBLOCK *const x = &cpi->td.mb;
   int i;
 
   vp9_clear_system_state();
@@ -292,11 +325,15 @@ void vp9_initialize_rd_consts(VP9_COMP *cpi) {
   set_block_thresholds(cpi);
 
   if (!cpi->sf.use_nonrd_pick_mode || cm->frame_type == KEY_FRAME) {
-    fill_token_costs(x->token_costs, cm->fc.coef_probs);
+    vp9_fill_token_costs(x->token_costs, cm->fc.coef_probs,
+                         cpi->rd_cost_probs.coef_probs);
 
     for (i = 0; i < PARTITION_CONTEXTS; i++)
-      vp9_cost_tokens(x->partition_cost[i], get_partition_probs(cm, i),
-                      vp9_partition_tree);
+      if (probs_changed(cpi->rd_cost_probs.partition_prob[i],
+                        get_partition_probs(cm, i),
+                        sizeof(cpi->rd_cost_probs.partition_prob[i])))
+        vp9_cost_tokens(x->partition_cost[i], get_partition_probs(cm, i),
+                        vp9_partition_tree);
   }
 
   if (!cpi->sf.use_nonrd_pick_mode || (cm->current_video_frame & 0x07) == 1 ||
@@ -304,14 +341,26 @@ void vp9_initialize_rd_consts(VP9_COMP *cpi) {
     fill_mode_costs(cpi);
 
     if (!frame_is_intra_only(cm)) {
-      vp9_build_nmv_cost_table(x->nmvjointcost,
-                               cm->allow_high_precision_mv ? x->nmvcost_hp
-                                                           : x->nmvcost,
-                               &cm->fc.nmvc, cm->allow_high_precision_mv);
+      RD_COST_PROBS *const cached = &cpi->rd_cost_probs;
+
+      // The joint costs are shared by both precisions, so the tables are
+      // rebuilt whenever either the context or the precision changes.
+      if (memcmp(&cached->nmvc, &cm->fc.nmvc, sizeof(cached->nmvc)) ||
+          cached->allow_high_precision_mv != cm->allow_high_precision_mv) {
+        vp9_build_nmv_cost_table(x->nmvjointcost,
+                                 cm->allow_high_precision_mv ? x->nmvcost_hp
+                                                             : x->nmvcost,
+                                 &cm->fc.nmvc, cm->allow_high_precision_mv);
+        cached->nmvc = cm->fc.nmvc;
+        cached->allow_high_precision_mv = cm->allow_high_precision_mv;
+      }
 
       for (i = 0; i < INTER_MODE_CONTEXTS; ++i)
-        vp9_cost_tokens((int *)x->inter_mode_cost[i],
-                        cm->fc.inter_mode_probs[i], vp9_inter_mode_tree);
+        if (probs_changed(cached->inter_mode_probs[i],
+                          cm->fc.inter_mode_probs[i],
+                          sizeof(cached->inter_mode_probs[i])))
+          vp9_cost_tokens((int *)x->inter_mode_cost[i],
+                          cm->fc.inter_mode_probs[i], vp9_inter_mode_tree);
     }
   }
 }
@@ -538,6 +587,16 @@ int64_t vp9_block_error_c(const int16_t *coeff, const int16_t *dqcoeff,
   return error;
 }
 
+void vp9_get_coeff_tokens_c(const int16_t *qcoeff, intptr_t n_coeffs,
+                            uint8_t *tokens, uint8_t *token_cache) {
+  intptr_t i;
+
+  for (i = 0; i < n_coeffs; i++) {
+    tokens[i] = (uint8_t)vp9_dct_value_tokens_ptr[qcoeff[i]].token;
+    token_cache[i] = vp9_pt_energy_class[tokens[i]];
+  }
+}
+
 /* The trailing '0' is a terminator which is used inside cost_coeffs() to
  * decide whether to include cost of a trailing EOB node or not (i.e. we
  * can skip this if the last coefficient in this transform block, e.g. the
@@ -565,7 +624,8 @@ static INLINE int cost_coeffs(MACROBLOCK *x,
   const int16_t *const qcoeff = BLOCK_OFFSET(p->qcoeff, block);
   unsigned int (*token_costs)[2][COEFF_CONTEXTS][ENTROPY_TOKENS] =
                    x->token_costs[tx_size][type][is_inter_block(mbmi)];
-  uint8_t token_cache[32 * 32];
+  DECLARE_ALIGNED(16, uint8_t, token_cache[32 * 32]);
+  DECLARE_ALIGNED(16, uint8_t, tokens[32 * 32]);
   int pt = combine_entropy_contexts(*A, *L);
   int c, cost;
   // Check for consistency of tx_size with mode info
@@ -578,10 +638,18 @@ static INLINE int cost_coeffs(MACROBLOCK *x,
     c = 0;
   } else {
     int band_left = *band_count++;
+    // Past a few coefficients of the large transforms, the tokens and their
+    // energy classes are found for the whole block at once.
+    const int n_coeffs = 16 << (tx_size << 1);
+    const int whole_block = tx_size >= TX_16X16 && !use_fast_coef_costing &&
+                            eob > n_coeffs >> 4;
 
     // dc token
     int v = qcoeff[0];
-    int prev_t = vp9_dct_value_tokens_ptr[v].token;
+    int prev_t;
+    if (whole_block)
+      vp9_get_coeff_tokens(qcoeff, n_coeffs, tokens, token_cache);
+    prev_t = vp9_dct_value_tokens_ptr[v].token;
     cost = (*token_costs)[0][pt][prev_t] + vp9_dct_value_cost_ptr[v];
     token_cache[0] = vp9_pt_energy_class[prev_t];
     ++token_costs;
@@ -592,10 +660,15 @@ static INLINE int cost_coeffs(MACROBLOCK *x,
       int t;
 
       v = qcoeff[rc];
-      t = vp9_dct_value_tokens_ptr[v].token;
       if (use_fast_coef_costing) {
+        t = vp9_dct_value_tokens_ptr[v].token;
         cost += (*token_costs)[!prev_t][!prev_t][t] + vp9_dct_value_cost_ptr[v];
+      } else if (whole_block) {
+        t = tokens[rc];
+        pt = get_coef_context(nb, token_cache, c);
+        cost += (*token_costs)[!prev_t][pt][t] + vp9_dct_value_cost_ptr[v];
       } else {
+        t = vp9_dct_value_tokens_ptr[v].token;
         pt = get_coef_context(nb, token_cache, c);
         cost += (*token_costs)[!prev_t][pt][t] + vp9_dct_value_cost_ptr[v];
         token_cache[rc] = vp9_pt_energy_class[t];
@@ -786,7 +859,6 @@ static void choose_largest_txfm_size(VP9_COMP *cpi, MACROBLOCK *x,
   txfm_rd_in_plane(x, rate, distortion, skip,
                    &sse[mbmi->tx_size], ref_best_rd, 0, bs,
                    mbmi->tx_size, cpi->sf.use_fast_coef_costing);
-  cpi->tx_stepdown_count[0]++;
 }
 
 static void choose_txfm_size_from_rd(VP9_COMP *cpi, MACROBLOCK *x,
@@ -854,16 +926,12 @@ static void choose_txfm_size_from_rd(VP9_COMP *cpi, MACROBLOCK *x,
 
   if (max_tx_size == TX_32X32 && best_tx == TX_32X32) {
     tx_cache[TX_MODE_SELECT] = rd[TX_32X32][1];
-    cpi->tx_stepdown_count[0]++;
   } else if (max_tx_size >= TX_16X16 && best_tx == TX_16X16) {
     tx_cache[TX_MODE_SELECT] = rd[TX_16X16][1];
-    cpi->tx_stepdown_count[max_tx_size - TX_16X16]++;
   } else if (rd[TX_8X8][1] < rd[TX_4X4][1]) {
     tx_cache[TX_MODE_SELECT] = rd[TX_8X8][1];
-    cpi->tx_stepdown_count[max_tx_size - TX_8X8]++;
   } else {
     tx_cache[TX_MODE_SELECT] = rd[TX_4X4][1];
-    cpi->tx_stepdown_count[max_tx_size - TX_4X4]++;
   }
 }
 
@@ -931,16 +999,6 @@ static void choose_txfm_size_from_modelrd(VP9_COMP *cpi, MACROBLOCK *x,
   txfm_rd_in_plane(x, rate, distortion, skip,
                    &sse[mbmi->tx_size], ref_best_rd, 0, bs, mbmi->tx_size,
                    cpi->sf.use_fast_coef_costing);
-
-  if (max_tx_size == TX_32X32 && best_tx == TX_32X32) {
-    cpi->tx_stepdown_count[0]++;
-  } else if (max_tx_size >= TX_16X16 &&  best_tx == TX_16X16) {
-    cpi->tx_stepdown_count[max_tx_size - TX_16X16]++;
-  } else if (rd[TX_8X8][1] <= rd[TX_4X4][1]) {
-    cpi->tx_stepdown_count[max_tx_size - TX_8X8]++;
-  } else {
-    cpi->tx_stepdown_count[max_tx_size - TX_4X4]++;
-  }
 }
 
 static void inter_super_block_yrd(VP9_COMP *cpi, MACROBLOCK *x, int *rate,
@@ -1427,12 +1485,12 @@ static int64_t rd_sbuv_dcpred(const VP9_COMP *cpi, MACROBLOCK *x,
   return RDCOST(x->rdmult, x->rddiv, *rate, *distortion);
 }
 
-static void choose_intra_uv_mode(VP9_COMP *cpi, PICK_MODE_CONTEXT *ctx,
+static void choose_intra_uv_mode(VP9_COMP *cpi, MACROBLOCK *const x,
+                                 PICK_MODE_CONTEXT *ctx,
                                  BLOCK_SIZE bsize, TX_SIZE max_tx_size,
                                  int *rate_uv, int *rate_uv_tokenonly,
                                  int64_t *dist_uv, int *skip_uv,
                                  MB_PREDICTION_MODE *mode_uv) {
-  MACROBLOCK *const x = &cpi->mb;
 
   // Use an estimated rd for uv_intra based on DC_PRED if the
   // appropriate speed flag is set.
@@ -1449,9 +1507,8 @@ static void choose_intra_uv_mode(VP9_COMP *cpi, PICK_MODE_CONTEXT *ctx,
   *mode_uv = x->e_mbd.mi[0]->mbmi.uv_mode;
 }
 
-static int cost_mv_ref(const VP9_COMP *cpi, MB_PREDICTION_MODE mode,
-                       int mode_context) {
-  const MACROBLOCK *const x = &cpi->mb;
+static int cost_mv_ref(const VP9_COMP *cpi, const MACROBLOCK *x,
+                       MB_PREDICTION_MODE mode, int mode_context) {
   const int segment_id = x->e_mbd.mi[0]->mbmi.segment_id;
 
   // Don't account for mode here if segment skip is enabled.
@@ -1470,14 +1527,14 @@ static void joint_motion_search(VP9_COMP *cpi, MACROBLOCK *x,
                                 int_mv single_newmv[MAX_REF_FRAMES],
                                 int *rate_mv);
 
-static int labels2mode(VP9_COMP *cpi, MACROBLOCKD *xd, int i,
+static int labels2mode(VP9_COMP *cpi, MACROBLOCK *x, int i,
                        MB_PREDICTION_MODE mode,
                        int_mv this_mv[2],
                        int_mv frame_mv[MB_MODE_COUNT][MAX_REF_FRAMES],
                        int_mv seg_mvs[MAX_REF_FRAMES],
                        int_mv *best_ref_mv[2],
                        const int *mvjcost, int *mvcost[2]) {
-  MODE_INFO *const mic = xd->mi[0];
+  MODE_INFO *const mic = x->e_mbd.mi[0];
   const MB_MODE_INFO *const mbmi = &mic->mbmi;
   int thismvcost = 0;
   int idx, idy;
@@ -1528,7 +1585,7 @@ static int labels2mode(VP9_COMP *cpi, MACROBLOCKD *xd, int i,
       vpx_memcpy(&mic->bmi[i + idy * 2 + idx],
                  &mic->bmi[i], sizeof(mic->bmi[i]));
 
-  return cost_mv_ref(cpi, mode, mbmi->mode_context[mbmi->ref_frame[0]]) +
+  return cost_mv_ref(cpi, x, mode, mbmi->mode_context[mbmi->ref_frame[0]]) +
             thismvcost;
 }
 
@@ -1673,7 +1730,8 @@ static INLINE int mv_has_subpel(const MV *mv) {
 // Check if NEARESTMV/NEARMV/ZEROMV is the cheapest way encode zero motion.
 // TODO(aconverse): Find out if this is still productive then clean up or remove
 static int check_best_zero_mv(
-    const VP9_COMP *cpi, const uint8_t mode_context[MAX_REF_FRAMES],
+    const VP9_COMP *cpi, const MACROBLOCK *x,
+    const uint8_t mode_context[MAX_REF_FRAMES],
     int_mv frame_mv[MB_MODE_COUNT][MAX_REF_FRAMES],
     int disable_inter_mode_mask, int this_mode, int ref_frame,
     int second_ref_frame) {
@@ -1683,9 +1741,9 @@ static int check_best_zero_mv(
       (second_ref_frame == NONE ||
        frame_mv[this_mode][second_ref_frame].as_int == 0)) {
     int rfc = mode_context[ref_frame];
-    int c1 = cost_mv_ref(cpi, NEARMV, rfc);
-    int c2 = cost_mv_ref(cpi, NEARESTMV, rfc);
-    int c3 = cost_mv_ref(cpi, ZEROMV, rfc);
+    int c1 = cost_mv_ref(cpi, x, NEARMV, rfc);
+    int c2 = cost_mv_ref(cpi, x, NEARESTMV, rfc);
+    int c3 = cost_mv_ref(cpi, x, ZEROMV, rfc);
 
     if (this_mode == NEARMV) {
       if (c1 > c3) return 0;
@@ -1777,7 +1835,7 @@ static void rd_check_segment_txsize(VP9_COMP *cpi, MACROBLOCK *x,
         if (disable_inter_mode_mask & (1 << mode_idx))
           continue;
 
-        if (!check_best_zero_mv(cpi, mbmi->mode_context, frame_mv,
+        if (!check_best_zero_mv(cpi, x, mbmi->mode_context, frame_mv,
                                 disable_inter_mode_mask,
                                 this_mode, mbmi->ref_frame[0],
                                 mbmi->ref_frame[1]))
@@ -1952,7 +2010,7 @@ static void rd_check_segment_txsize(VP9_COMP *cpi, MACROBLOCK *x,
         }
 
         bsi->rdstat[i][mode_idx].brate =
-            labels2mode(cpi, xd, i, this_mode, mode_mv[this_mode], frame_mv,
+            labels2mode(cpi, x, i, this_mode, mode_mv[this_mode], frame_mv,
                         seg_mvs[i], bsi->ref_mv, x->nmvjointcost, x->mvcost);
 
         for (ref = 0; ref < 1 + has_second_rf; ++ref) {
@@ -2049,7 +2107,7 @@ static void rd_check_segment_txsize(VP9_COMP *cpi, MACROBLOCK *x,
       vpx_memcpy(t_above, bsi->rdstat[i][mode_idx].ta, sizeof(t_above));
       vpx_memcpy(t_left, bsi->rdstat[i][mode_idx].tl, sizeof(t_left));
 
-      labels2mode(cpi, xd, i, mode_selected, mode_mv[mode_selected],
+      labels2mode(cpi, x, i, mode_selected, mode_mv[mode_selected],
                   frame_mv, seg_mvs[i], bsi->ref_mv, x->nmvjointcost,
                   x->mvcost);
 
@@ -2160,7 +2218,7 @@ static void mv_pred(VP9_COMP *cpi, MACROBLOCK *x,
   int num_mv_refs = MAX_MV_REF_CANDIDATES +
                     (cpi->sf.adaptive_motion_search &&
                      cpi->common.show_frame &&
-                     block_size < cpi->sf.max_partition_size);
+                     block_size < x->max_partition_size);
 
   int_mv pred_mv[3];
   pred_mv[0] = mbmi->ref_mvs[ref_frame][0];
@@ -2201,12 +2259,12 @@ static void mv_pred(VP9_COMP *cpi, MACROBLOCK *x,
   x->pred_mv_sad[ref_frame] = best_sad;
 }
 
-static void estimate_ref_frame_costs(VP9_COMP *cpi, int segment_id,
+static void estimate_ref_frame_costs(VP9_COMP *cpi, const MACROBLOCKD *xd,
+                                     int segment_id,
                                      unsigned int *ref_costs_single,
                                      unsigned int *ref_costs_comp,
                                      vp9_prob *comp_mode_p) {
   VP9_COMMON *const cm = &cpi->common;
-  MACROBLOCKD *const xd = &cpi->mb.e_mbd;
   int seg_ref_active = vp9_segfeature_active(&cm->seg, segment_id,
                                              SEG_LVL_REF_FRAME);
   if (seg_ref_active) {
@@ -2366,6 +2424,81 @@ static INLINE int get_switchable_rate(const MACROBLOCK *x) {
              x->switchable_interp_costs[ctx][mbmi->interp_filter];
 }
 
+// Looks up the full pel vectors of earlier searches of the bsize block at
+// (mi_row, mi_col) in ref. block is its entry in the field of Source in ref.
+// Returns 1 if the vector of block replaces the full pel search, in mvp_full.
+// Otherwise a vector of block, or of the 16x16 block containing it in either
+// direction, may seed the search: mvp_full is set to the better of itself and
+// that vector, and *seed_sads to the SAD evaluations of the search that found
+// the vector if it is taken.
+static int lookup_mv_field(const VP9_COMP *cpi, MACROBLOCK *x, int ref,
+                           BLOCK_SIZE bsize, int mi_row, int mi_col,
+                           const MOTION_FIELD_BLOCK *block, MV *mvp_full,
+                           unsigned int *seed_sads) {
+  const struct buf_2d *const what = &x->plane[0].src;
+  const struct buf_2d *const in_what = &x->e_mbd.plane[0].pre[0];
+  const vp9_variance_fn_ptr_t *const fn_ptr = &cpi->fn_ptr[bsize];
+  MOTION_FIELD_STATS *const stats = x->mv_field_stats;
+  const MOTION_FIELD_BLOCK *cached = NULL;
+  MV mv;
+
+  *seed_sads = 0;
+  ++stats->lookups;
+  if (block->sad_count) {
+    cached = block;
+    mv = block->mv;
+  } else if (bsize != BLOCK_16X16) {
+    const MOTION_FIELD_BLOCK *const mb =
+        vp9_motion_field_block(cpi->mv_field[ref], BLOCK_16X16,
+                               mi_row & ~1, mi_col & ~1);
+    if (mb->sad_count) {
+      cached = mb;
+      mv = mb->mv;
+    }
+  }
+  if (cached == NULL && cpi->mv_field_reverse[ref] != NULL) {
+    const MOTION_FIELD_BLOCK *const mb =
+        vp9_motion_field_block(cpi->mv_field_reverse[ref], BLOCK_16X16,
+                               mi_row & ~1, mi_col & ~1);
+    if (mb->sad_count) {
+      cached = mb;
+      mv.row = -mb->mv.row;
+      mv.col = -mb->mv.col;
+    }
+  }
+  if (cached == NULL)
+    return 0;
+
+  ++stats->hits;
+  clamp_mv(&mv, x->mv_col_min, x->mv_col_max, x->mv_row_min, x->mv_row_max);
+  if (cached == block && cpi->sf.mv_field_mode == MV_FIELD_REUSE) {
+    ++stats->reused;
+    stats->sads_saved += block->sad_count;
+    *mvp_full = mv;
+    return 1;
+  }
+
+  clamp_mv(mvp_full, x->mv_col_min, x->mv_col_max,
+           x->mv_row_min, x->mv_row_max);
+  if (mv.row != mvp_full->row || mv.col != mvp_full->col) {
+    const unsigned int pred_sad =
+        fn_ptr->sdf(what->buf, what->stride,
+                    &in_what->buf[mvp_full->row * in_what->stride +
+                                  mvp_full->col],
+                    in_what->stride, UINT_MAX);
+    const unsigned int sad =
+        fn_ptr->sdf(what->buf, what->stride,
+                    &in_what->buf[mv.row * in_what->stride + mv.col],
+                    in_what->stride, pred_sad);
+    *x->sad_count += 2;
+    if (sad < pred_sad) {
+      *mvp_full = mv;
+      *seed_sads = cached->sad_count;
+    }
+  }
+  return 0;
+}
+
 static void single_motion_search(VP9_COMP *cpi, MACROBLOCK *x,
                                  const TileInfo *const tile,
                                  BLOCK_SIZE bsize,
@@ -2381,6 +2514,9 @@ static void single_motion_search(VP9_COMP *cpi, MACROBLOCK *x,
   MV mvp_full;
   int ref = mbmi->ref_frame[0];
   MV ref_mv = mbmi->ref_mvs[ref][0].as_mv;
+  MOTION_FIELD_BLOCK *mv_field_block = NULL;
+  unsigned int sad_count = 0, seed_sads = 0;
+  int reuse = 0;
 
   int tmp_col_min = x->mv_col_min;
   int tmp_col_max = x->mv_col_max;
@@ -2456,10 +2592,24 @@ static void single_motion_search(VP9_COMP *cpi, MACROBLOCK *x,
   mvp_full.col >>= 3;
   mvp_full.row >>= 3;
 
+  if (cpi->mv_field[ref] != NULL) {
+    x->sad_count = &sad_count;
+    mv_field_block = vp9_motion_field_block(cpi->mv_field[ref], bsize,
+                                            mi_row, mi_col);
+    reuse = lookup_mv_field(cpi, x, ref, bsize, mi_row, mi_col,
+                            mv_field_block, &mvp_full, &seed_sads);
+    if (seed_sads)
+      step_param = MAX(step_param, MV_FIELD_SEED_STEP_PARAM);
+  }
+
   // Further step/diamond searches as necessary
   further_steps = (cpi->sf.max_step_search_steps - 1) - step_param;
 
-  if (cpi->sf.search_method == FAST_DIAMOND) {
+  if (reuse) {
+    tmp_mv->as_mv = mvp_full;
+    bestsme = vp9_get_mvpred_var(x, &tmp_mv->as_mv, &ref_mv,
+                                 &cpi->fn_ptr[bsize], 1);
+  } else if (cpi->sf.search_method == FAST_DIAMOND) {
     bestsme = vp9_fast_dia_search(x, &mvp_full, step_param, sadpb, 0,
                                   &cpi->fn_ptr[bsize], 1,
                                   &ref_mv, &tmp_mv->as_mv);
@@ -2494,6 +2644,15 @@ static void single_motion_search(VP9_COMP *cpi, MACROBLOCK *x,
     if (bestsme < INT_MAX)
       bestsme = vp9_get_mvpred_var(x, &tmp_mv->as_mv, &ref_mv,
                                    &cpi->fn_ptr[bsize], 1);
+  } else if (cpi->sf.search_method == PYRAMID) {
+    if (!seed_sads)
+      vp9_pyramid_search(x, cpi->source_pyramid, get_ref_pyramid(cpi, ref),
+                         cpi->fn_ptr, bsize, mi_row, mi_col, &mvp_full);
+    further_steps = (cpi->sf.max_step_search_steps - 1) - PYRAMID_STEP_PARAM;
+    bestsme = vp9_full_pixel_diamond(cpi, x, &mvp_full, PYRAMID_STEP_PARAM,
+                                     sadpb, further_steps, 1,
+                                     &cpi->fn_ptr[bsize],
+                                     &ref_mv, &tmp_mv->as_mv);
   } else {
     bestsme = vp9_full_pixel_diamond(cpi, x, &mvp_full, step_param,
                                      sadpb, further_steps, 1,
@@ -2501,6 +2660,16 @@ static void single_motion_search(VP9_COMP *cpi, MACROBLOCK *x,
                                      &ref_mv, &tmp_mv->as_mv);
   }
 
+  x->sad_count = NULL;
+  if (mv_field_block != NULL)
+    x->mv_field_stats->sads += sad_count;
+  if (mv_field_block != NULL && !reuse && bestsme < INT_MAX) {
+    mv_field_block->mv = tmp_mv->as_mv;
+    mv_field_block->sad_count = sad_count;
+    if (seed_sads > sad_count)
+      x->mv_field_stats->sads_saved += seed_sads - sad_count;
+  }
+
   x->mv_col_min = tmp_col_min;
   x->mv_col_max = tmp_col_max;
   x->mv_row_min = tmp_row_min;
@@ -2698,7 +2867,9 @@ static int64_t handle_inter_mode(VP9_COMP *cpi, MACROBLOCK *x,
                                  int mi_row, int mi_col,
                                  int_mv single_newmv[MAX_REF_FRAMES],
                                  int64_t *psse,
-                                 const int64_t ref_best_rd) {
+                                 const int64_t ref_best_rd,
+                                 int64_t *filter_cache,
+                                 int64_t *mask_filter) {
   VP9_COMMON *cm = &cpi->common;
   MACROBLOCKD *xd = &x->e_mbd;
   MB_MODE_INFO *mbmi = &xd->mi[0]->mbmi;
@@ -2783,7 +2954,7 @@ static int64_t handle_inter_mode(VP9_COMP *cpi, MACROBLOCK *x,
    * are only three options: Last/Golden, ARF/Last or Golden/ARF, or in other
    * words if you present them in that order, the second one is always known
    * if the first is known */
-  *rate2 += cost_mv_ref(cpi, this_mode, mbmi->mode_context[refs[0]]);
+  *rate2 += cost_mv_ref(cpi, x, this_mode, mbmi->mode_context[refs[0]]);
 
   if (!(*mode_excluded))
     *mode_excluded = is_comp_pred ? cm->reference_mode == SINGLE_REFERENCE
@@ -2797,9 +2968,9 @@ static int64_t handle_inter_mode(VP9_COMP *cpi, MACROBLOCK *x,
 
   // Search for best switchable filter by checking the variance of
   // pred error irrespective of whether the filter will be used
-  cpi->mask_filter_rd = 0;
+  *mask_filter = 0;
   for (i = 0; i < SWITCHABLE_FILTER_CONTEXTS; ++i)
-    cpi->rd_filter_cache[i] = INT64_MAX;
+    filter_cache[i] = INT64_MAX;
 
   if (cm->interp_filter != BILINEAR) {
     *best_filter = EIGHTTAP;
@@ -2820,12 +2991,12 @@ static int64_t handle_inter_mode(VP9_COMP *cpi, MACROBLOCK *x,
 
         if (i > 0 && intpel_mv) {
           rd = RDCOST(x->rdmult, x->rddiv, tmp_rate_sum, tmp_dist_sum);
-          cpi->rd_filter_cache[i] = rd;
-          cpi->rd_filter_cache[SWITCHABLE_FILTERS] =
-              MIN(cpi->rd_filter_cache[SWITCHABLE_FILTERS], rd + rs_rd);
+          filter_cache[i] = rd;
+          filter_cache[SWITCHABLE_FILTERS] =
+              MIN(filter_cache[SWITCHABLE_FILTERS], rd + rs_rd);
           if (cm->interp_filter == SWITCHABLE)
             rd += rs_rd;
-          cpi->mask_filter_rd = MAX(cpi->mask_filter_rd, rd);
+          *mask_filter = MAX(*mask_filter, rd);
         } else {
           int rate_sum = 0;
           int64_t dist_sum = 0;
@@ -2845,12 +3016,12 @@ static int64_t handle_inter_mode(VP9_COMP *cpi, MACROBLOCK *x,
           model_rd_for_sb(cpi, bsize, x, xd, &rate_sum, &dist_sum);
 
           rd = RDCOST(x->rdmult, x->rddiv, rate_sum, dist_sum);
-          cpi->rd_filter_cache[i] = rd;
-          cpi->rd_filter_cache[SWITCHABLE_FILTERS] =
-              MIN(cpi->rd_filter_cache[SWITCHABLE_FILTERS], rd + rs_rd);
+          filter_cache[i] = rd;
+          filter_cache[SWITCHABLE_FILTERS] =
+              MIN(filter_cache[SWITCHABLE_FILTERS], rd + rs_rd);
           if (cm->interp_filter == SWITCHABLE)
             rd += rs_rd;
-          cpi->mask_filter_rd = MAX(cpi->mask_filter_rd, rd);
+          *mask_filter = MAX(*mask_filter, rd);
 
           if (i == 0 && intpel_mv) {
             tmp_rate_sum = rate_sum;
@@ -3146,6 +3317,8 @@ int64_t vp9_rd_pick_inter_mode_sb(VP9_COMP *cpi, MACROBLOCK *x,
   int64_t best_pred_rd[REFERENCE_MODES];
   int64_t best_filter_rd[SWITCHABLE_FILTER_CONTEXTS];
   int64_t best_filter_diff[SWITCHABLE_FILTER_CONTEXTS];
+  int64_t filter_cache[SWITCHABLE_FILTER_CONTEXTS];
+  int64_t mask_filter = 0;
   MB_MODE_INFO best_mbmode = { 0 };
   int mode_index, best_mode_index = 0;
   unsigned int ref_costs_single[MAX_REF_FRAMES], ref_costs_comp[MAX_REF_FRAMES];
@@ -3167,7 +3340,7 @@ int64_t vp9_rd_pick_inter_mode_sb(VP9_COMP *cpi, MACROBLOCK *x,
   int mode_skip_mask = 0;
   int mode_skip_start = cpi->sf.mode_skip_start + 1;
   const int *const rd_threshes = cpi->rd_threshes[segment_id][bsize];
-  const int *const rd_thresh_freq_fact = cpi->rd_thresh_freq_fact[bsize];
+  const int *const rd_thresh_freq_fact = x->thresh_freq_fact[bsize];
   const int mode_search_skip_flags = cpi->sf.mode_search_skip_flags;
   const int intra_y_mode_mask =
       cpi->sf.intra_y_mode_mask[max_txsize_lookup[bsize]];
@@ -3175,7 +3348,7 @@ int64_t vp9_rd_pick_inter_mode_sb(VP9_COMP *cpi, MACROBLOCK *x,
 
   x->skip_encode = cpi->sf.skip_encode_frame && x->q_index < QIDX_SKIP_THRESH;
 
-  estimate_ref_frame_costs(cpi, segment_id, ref_costs_single, ref_costs_comp,
+  estimate_ref_frame_costs(cpi, xd, segment_id, ref_costs_single, ref_costs_comp,
                            &comp_mode_p);
 
   for (i = 0; i < REFERENCE_MODES; ++i)
@@ -3379,7 +3552,7 @@ int64_t vp9_rd_pick_inter_mode_sb(VP9_COMP *cpi, MACROBLOCK *x,
     } else {
       if (x->in_active_map &&
           !vp9_segfeature_active(&cm->seg, mbmi->segment_id, SEG_LVL_SKIP))
-        if (!check_best_zero_mv(cpi, mbmi->mode_context, frame_mv,
+        if (!check_best_zero_mv(cpi, x, mbmi->mode_context, frame_mv,
                                 disable_inter_mode_mask, this_mode, ref_frame,
                                 second_ref_frame))
           continue;
@@ -3422,7 +3595,7 @@ int64_t vp9_rd_pick_inter_mode_sb(VP9_COMP *cpi, MACROBLOCK *x,
 
       uv_tx = get_uv_tx_size_impl(mbmi->tx_size, bsize);
       if (rate_uv_intra[uv_tx] == INT_MAX) {
-        choose_intra_uv_mode(cpi, ctx, bsize, uv_tx,
+        choose_intra_uv_mode(cpi, x, ctx, bsize, uv_tx,
                              &rate_uv_intra[uv_tx], &rate_uv_tokenonly[uv_tx],
                              &dist_uv[uv_tx], &skip_uv[uv_tx], &mode_uv[uv_tx]);
       }
@@ -3445,7 +3618,8 @@ int64_t vp9_rd_pick_inter_mode_sb(VP9_COMP *cpi, MACROBLOCK *x,
                                   &mode_excluded, &disable_skip,
                                   &tmp_best_filter, frame_mv,
                                   mi_row, mi_col,
-                                  single_newmv, &total_sse, best_rd);
+                                  single_newmv, &total_sse, best_rd,
+                                  filter_cache, &mask_filter);
       if (this_rd == INT64_MAX)
         continue;
 
@@ -3610,21 +3784,21 @@ int64_t vp9_rd_pick_inter_mode_sb(VP9_COMP *cpi, MACROBLOCK *x,
 
       /* keep record of best filter type */
       if (!mode_excluded && cm->interp_filter != BILINEAR) {
-        int64_t ref = cpi->rd_filter_cache[cm->interp_filter == SWITCHABLE ?
+        int64_t ref = filter_cache[cm->interp_filter == SWITCHABLE ?
                               SWITCHABLE_FILTERS : cm->interp_filter];
 
         for (i = 0; i < SWITCHABLE_FILTER_CONTEXTS; i++) {
           int64_t adj_rd;
           if (ref == INT64_MAX)
             adj_rd = 0;
-          else if (cpi->rd_filter_cache[i] == INT64_MAX)
+          else if (filter_cache[i] == INT64_MAX)
             // when early termination is triggered, the encoder does not have
             // access to the rate-distortion cost. it only knows that the cost
             // should be above the maximum valid value. hence it takes the known
             // maximum plus an arbitrary constant as the rate-distortion cost.
-            adj_rd = cpi->mask_filter_rd - ref + 10;
+            adj_rd = mask_filter - ref + 10;
           else
-            adj_rd = cpi->rd_filter_cache[i] - ref;
+            adj_rd = filter_cache[i] - ref;
 
           adj_rd += this_rd;
           best_filter_rd[i] = MIN(best_filter_rd[i], adj_rd);
@@ -3686,7 +3860,7 @@ int64_t vp9_rd_pick_inter_mode_sb(VP9_COMP *cpi, MACROBLOCK *x,
   // combination that wins out.
   if (cpi->sf.adaptive_rd_thresh) {
     for (mode_index = 0; mode_index < MAX_MODES; ++mode_index) {
-      int *const fact = &cpi->rd_thresh_freq_fact[bsize][mode_index];
+      int *const fact = &x->thresh_freq_fact[bsize][mode_index];
 
       if (mode_index == best_mode_index) {
         *fact -= (*fact >> 3);
@@ -3776,6 +3950,8 @@ int64_t vp9_rd_pick_inter_mode_sub8x8(VP9_COMP *cpi, MACROBLOCK *x,
   int64_t best_pred_rd[REFERENCE_MODES];
   int64_t best_filter_rd[SWITCHABLE_FILTER_CONTEXTS];
   int64_t best_filter_diff[SWITCHABLE_FILTER_CONTEXTS];
+  int64_t filter_cache[SWITCHABLE_FILTER_CONTEXTS];
+  int64_t mask_filter = 0;
   MB_MODE_INFO best_mbmode = { 0 };
   int mode_index, best_mode_index = 0;
   unsigned int ref_costs_single[MAX_REF_FRAMES], ref_costs_comp[MAX_REF_FRAMES];
@@ -3803,7 +3979,7 @@ int64_t vp9_rd_pick_inter_mode_sub8x8(VP9_COMP *cpi, MACROBLOCK *x,
       seg_mvs[i][j].as_int = INVALID_MV;
   }
 
-  estimate_ref_frame_costs(cpi, segment_id, ref_costs_single, ref_costs_comp,
+  estimate_ref_frame_costs(cpi, xd, segment_id, ref_costs_single, ref_costs_comp,
                            &comp_mode_p);
 
   for (i = 0; i < REFERENCE_MODES; ++i)
@@ -3818,6 +3994,7 @@ int64_t vp9_rd_pick_inter_mode_sub8x8(VP9_COMP *cpi, MACROBLOCK *x,
   *returnrate = INT_MAX;
 
   for (ref_frame = LAST_FRAME; ref_frame <= ALTREF_FRAME; ref_frame++) {
+    x->pred_mv_sad[ref_frame] = INT_MAX;
     if (cpi->ref_frame_flags & flag_list[ref_frame]) {
       vp9_setup_buffer_inter(cpi, x, tile,
                              ref_frame, bsize, mi_row, mi_col,
@@ -3889,7 +4066,7 @@ int64_t vp9_rd_pick_inter_mode_sub8x8(VP9_COMP *cpi, MACROBLOCK *x,
     // Test best rd so far against threshold for trying this mode.
     if ((best_rd <
          ((int64_t)cpi->rd_thresh_sub8x8[segment_id][bsize][mode_index] *
-          cpi->rd_thresh_freq_sub8x8[bsize][mode_index] >> 5)) ||
+          x->thresh_freq_sub8x8[bsize][mode_index] >> 5)) ||
         cpi->rd_thresh_sub8x8[segment_id][bsize][mode_index] == INT_MAX)
       continue;
 
@@ -4000,7 +4177,7 @@ int64_t vp9_rd_pick_inter_mode_sub8x8(VP9_COMP *cpi, MACROBLOCK *x,
       distortion2 += distortion_y;
 
       if (rate_uv_intra[TX_4X4] == INT_MAX) {
-        choose_intra_uv_mode(cpi, ctx, bsize, TX_4X4,
+        choose_intra_uv_mode(cpi, x, ctx, bsize, TX_4X4,
                              &rate_uv_intra[TX_4X4],
                              &rate_uv_tokenonly[TX_4X4],
                              &dist_uv[TX_4X4], &skip_uv[TX_4X4],
@@ -4038,9 +4215,9 @@ int64_t vp9_rd_pick_inter_mode_sub8x8(VP9_COMP *cpi, MACROBLOCK *x,
           cpi->rd_thresh_sub8x8[segment_id][bsize][THR_GOLD] : this_rd_thresh;
       xd->mi[0]->mbmi.tx_size = TX_4X4;
 
-      cpi->mask_filter_rd = 0;
+      mask_filter = 0;
       for (i = 0; i < SWITCHABLE_FILTER_CONTEXTS; ++i)
-        cpi->rd_filter_cache[i] = INT64_MAX;
+        filter_cache[i] = INT64_MAX;
 
       if (cm->interp_filter != BILINEAR) {
         tmp_best_filter = EIGHTTAP;
@@ -4074,14 +4251,14 @@ int64_t vp9_rd_pick_inter_mode_sub8x8(VP9_COMP *cpi, MACROBLOCK *x,
               continue;
             rs = get_switchable_rate(x);
             rs_rd = RDCOST(x->rdmult, x->rddiv, rs, 0);
-            cpi->rd_filter_cache[switchable_filter_index] = tmp_rd;
-            cpi->rd_filter_cache[SWITCHABLE_FILTERS] =
-                MIN(cpi->rd_filter_cache[SWITCHABLE_FILTERS],
+            filter_cache[switchable_filter_index] = tmp_rd;
+            filter_cache[SWITCHABLE_FILTERS] =
+                MIN(filter_cache[SWITCHABLE_FILTERS],
                     tmp_rd + rs_rd);
             if (cm->interp_filter == SWITCHABLE)
               tmp_rd += rs_rd;
 
-            cpi->mask_filter_rd = MAX(cpi->mask_filter_rd, tmp_rd);
+            mask_filter = MAX(mask_filter, tmp_rd);
 
             newbest = (tmp_rd < tmp_best_rd);
             if (newbest) {
@@ -4321,20 +4498,20 @@ int64_t vp9_rd_pick_inter_mode_sub8x8(VP9_COMP *cpi, MACROBLOCK *x,
     /* keep record of best filter type */
     if (!mode_excluded && !disable_skip && ref_frame != INTRA_FRAME &&
         cm->interp_filter != BILINEAR) {
-      int64_t ref = cpi->rd_filter_cache[cm->interp_filter == SWITCHABLE ?
+      int64_t ref = filter_cache[cm->interp_filter == SWITCHABLE ?
                               SWITCHABLE_FILTERS : cm->interp_filter];
       int64_t adj_rd;
       for (i = 0; i < SWITCHABLE_FILTER_CONTEXTS; i++) {
         if (ref == INT64_MAX)
           adj_rd = 0;
-        else if (cpi->rd_filter_cache[i] == INT64_MAX)
+        else if (filter_cache[i] == INT64_MAX)
           // when early termination is triggered, the encoder does not have
           // access to the rate-distortion cost. it only knows that the cost
           // should be above the maximum valid value. hence it takes the known
           // maximum plus an arbitrary constant as the rate-distortion cost.
-          adj_rd = cpi->mask_filter_rd - ref + 10;
+          adj_rd = mask_filter - ref + 10;
         else
-          adj_rd = cpi->rd_filter_cache[i] - ref;
+          adj_rd = filter_cache[i] - ref;
 
         adj_rd += this_rd;
         best_filter_rd[i] = MIN(best_filter_rd[i], adj_rd);
@@ -4404,7 +4581,7 @@ int64_t vp9_rd_pick_inter_mode_sub8x8(VP9_COMP *cpi, MACROBLOCK *x,
   // combination that wins out.
   if (cpi->sf.adaptive_rd_thresh) {
     for (mode_index = 0; mode_index < MAX_REFS; ++mode_index) {
-      int *const fact = &cpi->rd_thresh_freq_sub8x8[bsize][mode_index];
+      int *const fact = &x->thresh_freq_sub8x8[bsize][mode_index];
 
       if (mode_index == best_mode_index) {
         *fact -= (*fact >> 3);
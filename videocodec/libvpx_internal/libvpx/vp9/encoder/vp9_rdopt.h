@@ -34,6 +34,13 @@ int vp9_compute_rd_mult(const VP9_COMP *cpi, int qindex);
 
 void vp9_initialize_rd_consts(VP9_COMP *cpi);
 
+// Fills c with the cost of each token under the coefficient probabilities p.
+// If cached is not NULL it holds the probabilities c was last filled from,
+// and only the contexts whose probabilities differ are filled again.
+void vp9_fill_token_costs(vp9_coeff_cost *c,
+                          vp9_coeff_probs_model (*p)[PLANE_TYPES],
+                          vp9_coeff_probs_model (*cached)[PLANE_TYPES]);
+
 void vp9_initialize_me_consts(VP9_COMP *cpi, int qindex);
 
 void vp9_model_rd_from_var_lapndz(unsigned int var, unsigned int n,
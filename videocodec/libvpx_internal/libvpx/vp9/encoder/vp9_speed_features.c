@@ -40,6 +40,27 @@
                                    (1 << THR_ALTR) | \
                                    (1 << THR_GOLD))
 
+// Partition search breakout thresholds for 8x8, 16x16, 32x32 and 64x64
+// blocks, see partition_search_breakout. They were fitted offline on the
+// PARTITION_NONE rate and distortion of blocks whose exhaustive search did
+// or did not keep PARTITION_NONE, for a breakout precision of about 99% at
+// speed 1 and 97% on frames that are not boosted at speed 2 and above.
+// Against the same speed without the breakout, two pass 352x288 encodes of
+// 60 frames measured:
+//   speed  kbps  encode time  file size  PSNR (dB)
+//     1     400     -4.8%       +1.13%     +0.011
+//     1    1000    -10.5%       +0.42%     -0.064
+//     2     400    -15.5%       -0.61%     +0.028
+//     2    1000    -14.8%        0.00%     -0.045
+//     3     400    -13.0%       +0.29%     +0.032
+//     3    1000     -9.7%       +0.01%     -0.059
+static const int good_breakout_dist_thresh[2][4] = {
+  { 64, 16, 32, 32 }, { 128, 32, 64, 64 }
+};
+static const int good_breakout_rate_thresh[2][4] = {
+  { 32, 64, 8, 4 }, { 64, 32, 32, 32 }
+};
+
 static void set_good_speed_feature(VP9_COMP *cpi,
                                    VP9_COMMON *cm,
                                    SPEED_FEATURES *sf,
@@ -63,12 +84,23 @@ static void set_good_speed_feature(VP9_COMP *cpi,
     sf->use_rd_breakout = 1;
     sf->adaptive_motion_search = 1;
     sf->auto_mv_step_size = 1;
+    // The motion of large frames is often beyond the reach of a search from
+    // the predicted vector.
+    if (MIN(cm->width, cm->height) >= 1080)
+      sf->search_method = PYRAMID;
+    sf->mv_field_mode = MV_FIELD_SEED;
     sf->adaptive_rd_thresh = 2;
     sf->subpel_iters_per_step = 1;
     sf->mode_skip_start = 10;
     sf->adaptive_pred_interp_filter = 1;
 
     sf->recode_loop = ALLOW_RECODE_KFARFGF;
+    sf->use_recode_estimate = 1;
+    sf->partition_search_breakout = 1;
+    for (i = 0; i < 4; ++i) {
+      sf->breakout_dist_thresh[i] = good_breakout_dist_thresh[0][i];
+      sf->breakout_rate_thresh[i] = good_breakout_rate_thresh[0][i];
+    }
     sf->intra_y_mode_mask[TX_32X32] = INTRA_DC_H_V;
     sf->intra_uv_mode_mask[TX_32X32] = INTRA_DC_H_V;
     sf->intra_y_mode_mask[TX_16X16] = INTRA_DC_H_V;
@@ -94,11 +126,18 @@ static void set_good_speed_feature(VP9_COMP *cpi,
                                  FLAG_SKIP_INTRA_LOWVAR;
     sf->disable_filter_search_var_thresh = 100;
     sf->comp_inter_joint_search_thresh = BLOCK_SIZES;
+    sf->mv_field_mode = MV_FIELD_REUSE;
 
     sf->auto_min_max_partition_size = RELAXED_NEIGHBORING_MIN_MAX;
     sf->use_lastframe_partitioning = LAST_FRAME_PARTITION_LOW_MOTION;
     sf->adjust_partitioning_from_last_frame = 1;
     sf->last_partitioning_redo_frequency = 3;
+    if (!vp9_frame_is_boosted(cpi)) {
+      for (i = 0; i < 4; ++i) {
+        sf->breakout_dist_thresh[i] = good_breakout_dist_thresh[1][i];
+        sf->breakout_rate_thresh[i] = good_breakout_rate_thresh[1][i];
+      }
+    }
   }
   // Additions or changes for speed 3 and above
   if (speed >= 3) {
@@ -113,6 +152,7 @@ static void set_good_speed_feature(VP9_COMP *cpi,
     sf->mode_skip_start = 6;
     sf->use_fast_coef_updates = 2;
     sf->use_fast_coef_costing = 1;
+    sf->lpf_pick = LPF_PICK_FROM_SUBIMAGE;
   }
   // Additions or changes for speed 3 and above
   if (speed >= 4) {
@@ -296,6 +336,7 @@ void vp9_set_speed_features(VP9_COMP *cpi) {
   sf->optimize_coefficients = !cpi->oxcf.lossless;
   sf->reduce_first_step_size = 0;
   sf->auto_mv_step_size = 0;
+  sf->mv_field_mode = MV_FIELD_OFF;
   sf->max_step_search_steps = MAX_MVSEARCH_STEPS;
   sf->comp_inter_joint_search_thresh = BLOCK_4X4;
   sf->adaptive_rd_thresh = 0;
@@ -318,6 +359,11 @@ void vp9_set_speed_features(VP9_COMP *cpi) {
   sf->force_frame_boost = 0;
   sf->max_delta_qindex = 0;
   sf->disable_split_var_thresh = 0;
+  sf->partition_search_breakout = 0;
+  for (i = 0; i < 4; ++i) {
+    sf->breakout_dist_thresh[i] = 0;
+    sf->breakout_rate_thresh[i] = 0;
+  }
   sf->disable_filter_search_var_thresh = 0;
   for (i = 0; i < TX_SIZES; i++) {
     sf->intra_y_mode_mask[i] = ALL_INTRA_MODES;
@@ -343,6 +389,8 @@ void vp9_set_speed_features(VP9_COMP *cpi) {
   // Recode loop tolerence %.
   sf->recode_tolerance = 25;
 
+  sf->use_recode_estimate = 0;
+
   switch (cpi->oxcf.mode) {
     case MODE_BESTQUALITY:
     case MODE_SECONDPASS_BEST:  // This is the best quality mode.
@@ -375,7 +423,7 @@ void vp9_set_speed_features(VP9_COMP *cpi) {
     cpi->find_fractional_mv_step_comp = vp9_find_best_sub_pixel_comp_tree;
   }
 
-  cpi->mb.optimize = cpi->sf.optimize_coefficients == 1 && cpi->pass != 1;
+  cpi->td.mb.optimize = cpi->sf.optimize_coefficients == 1 && cpi->pass != 1;
 
   if (cpi->encode_breakout && cpi->oxcf.mode == MODE_REALTIME &&
       sf->encode_breakout_thresh > cpi->encode_breakout)
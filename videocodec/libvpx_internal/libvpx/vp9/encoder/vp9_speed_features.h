@@ -24,9 +24,22 @@ typedef enum {
   BIGDIA = 3,
   SQUARE = 4,
   FAST_HEX = 5,
-  FAST_DIAMOND = 6
+  FAST_DIAMOND = 6,
+  // Grid search of the 4x downscaled frame, refined on the 2x downscaled one,
+  // seeding a short diamond search at full resolution.
+  PYRAMID = 7
 } SEARCH_METHODS;
 
+typedef enum {
+  // The motion field cache is not used.
+  MV_FIELD_OFF = 0,
+  // Vectors found for the block by earlier searches seed the motion search.
+  MV_FIELD_SEED = 1,
+  // As MV_FIELD_SEED, but the vector of an earlier search of the same block
+  // in the same frames replaces the full pel search.
+  MV_FIELD_REUSE = 2
+} MV_FIELD_MODE;
+
 typedef enum {
   // No recode.
   DISALLOW_RECODE = 0,
@@ -65,7 +78,7 @@ typedef enum {
 typedef enum {
   // Try the full image with different values.
   LPF_PICK_FROM_FULL_IMAGE,
-  // Try a small portion of the image with different values.
+  // Try one superblock row in every four with different values.
   LPF_PICK_FROM_SUBIMAGE,
   // Estimate the level based on quantizer and frame type
   LPF_PICK_FROM_Q,
@@ -146,6 +159,10 @@ typedef struct {
   // largest motion vector found in the last frame.
   int auto_mv_step_size;
 
+  // Use of the full pel vectors of earlier searches of a block, cached by the
+  // rd motion search, the temporal filter and the mbgraph.
+  MV_FIELD_MODE mv_field_mode;
+
   // Trellis (dynamic programming) optimization of quantized values (+1, 0).
   int optimize_coefficients;
 
@@ -267,6 +284,16 @@ typedef struct {
   // A source variance threshold below which the split mode is disabled
   unsigned int disable_split_var_thresh;
 
+  // Stop the partition search at a square block once PARTITION_NONE is the
+  // best choice so far and both its rate and distortion are below the
+  // thresholds for the block size, unless the co-located block of the
+  // previous frame was split. The thresholds are indexed by the block width
+  // in log2 of 8x8 units. Distortion is per pixel in 1/4096 of the squared
+  // AC quantizer step, rate is per pixel in the units of the cost tables.
+  int partition_search_breakout;
+  int breakout_dist_thresh[4];
+  int breakout_rate_thresh[4];
+
   // A source variance threshold below which filter search is disabled
   // Choose a very large value (UINT_MAX) to use 8-tap always
   unsigned int disable_filter_search_var_thresh;
@@ -312,6 +339,11 @@ typedef struct {
   // recode a frame. It has no meaning if recode is disabled.
   int recode_tolerance;
 
+  // Predict the frame size of recode loop iterations from the tokens of the
+  // last encode requantized to the new q, and only encode the frame again
+  // once the prediction falls within the frame size bounds.
+  int use_recode_estimate;
+
   // This variable controls the maximum block size where intra blocks can be
   // used in inter frames.
   // TODO(aconverse): Fold this into one of the other many mode skips
@@ -16,13 +16,16 @@
 #include "vp9/common/vp9_quant_common.h"
 #include "vp9/common/vp9_reconinter.h"
 #include "vp9/common/vp9_systemdependent.h"
+#include "vp9/encoder/vp9_ethread.h"
 #include "vp9/encoder/vp9_extend.h"
 #include "vp9/encoder/vp9_firstpass.h"
 #include "vp9/encoder/vp9_mcomp.h"
+#include "vp9/encoder/vp9_motion_field.h"
 #include "vp9/encoder/vp9_onyx_int.h"
 #include "vp9/encoder/vp9_quantize.h"
 #include "vp9/encoder/vp9_ratectrl.h"
 #include "vp9/encoder/vp9_segmentation.h"
+#include "vp9/encoder/vp9_temporal_filter.h"
 #include "vpx_mem/vpx_mem.h"
 #include "vpx_ports/vpx_timer.h"
 #include "vpx_scale/vpx_scale.h"
@@ -124,19 +127,22 @@ void vp9_temporal_filter_apply_c(uint8_t *frame1,
 
 #if ALT_REF_MC_ENABLED
 
+// Stores the full pel vector of the search in mv_block if it is not NULL.
 static int temporal_filter_find_matching_mb_c(VP9_COMP *cpi,
+                                              MACROBLOCK *x,
                                               uint8_t *arf_frame_buf,
                                               uint8_t *frame_ptr_buf,
-                                              int stride) {
-  MACROBLOCK *x = &cpi->mb;
+                                              int stride,
+                                              MOTION_FIELD_BLOCK *mv_block,
+                                              MV *ref_mv) {
   MACROBLOCKD* const xd = &x->e_mbd;
   int step_param;
   int sadpb = x->sadperbit16;
   int bestsme = INT_MAX;
+  unsigned int sad_count = 0;
 
   MV best_ref_mv1 = {0, 0};
   MV best_ref_mv1_full; /* full-pixel value of best_ref_mv1 */
-  MV *ref_mv = &x->e_mbd.mi[0]->bmi[0].as_mv[0].as_mv;
 
   // Save input state
   struct buf_2d src = x->plane[0].src;
@@ -160,8 +166,15 @@ static int temporal_filter_find_matching_mb_c(VP9_COMP *cpi,
 
   /*cpi->sf.search_method == HEX*/
   // Ignore mv costing by sending NULL pointer instead of cost arrays
+  if (mv_block != NULL)
+    x->sad_count = &sad_count;
   vp9_hex_search(x, &best_ref_mv1_full, step_param, sadpb, 1,
                  &cpi->fn_ptr[BLOCK_16X16], 0, &best_ref_mv1, ref_mv);
+  if (mv_block != NULL) {
+    x->sad_count = NULL;
+    mv_block->mv = *ref_mv;
+    mv_block->sad_count = sad_count;
+  }
 
   // Try sub-pixel MC?
   // if (bestsme > error_thresh && bestsme < INT_MAX)
@@ -187,180 +200,204 @@ static int temporal_filter_find_matching_mb_c(VP9_COMP *cpi,
 }
 #endif
 
-static void temporal_filter_iterate_c(VP9_COMP *cpi,
-                                      int frame_count,
-                                      int alt_ref_index,
-                                      int strength,
-                                      struct scale_factors *scale) {
+void vp9_temporal_filter_iterate_row(VP9_COMP *cpi, ThreadData *td,
+                                     int mb_row) {
+  MACROBLOCK *const x = &td->mb;
+  MACROBLOCKD *const mbd = &x->e_mbd;
+  const int frame_count = cpi->tf_frame_count;
+  const int alt_ref_index = cpi->tf_alt_ref_index;
+  const int strength = cpi->active_arnr_strength;
   int byte;
   int frame;
-  int mb_col, mb_row;
+  int mb_col;
   unsigned int filter_weight;
   int mb_cols = cpi->common.mb_cols;
-  int mb_rows = cpi->common.mb_rows;
-  int mb_y_offset = 0;
-  int mb_uv_offset = 0;
   DECLARE_ALIGNED_ARRAY(16, unsigned int, accumulator, 16 * 16 * 3);
   DECLARE_ALIGNED_ARRAY(16, uint16_t, count, 16 * 16 * 3);
-  MACROBLOCKD *mbd = &cpi->mb.e_mbd;
   YV12_BUFFER_CONFIG *f = cpi->frames[alt_ref_index];
   uint8_t *dst1, *dst2;
   DECLARE_ALIGNED_ARRAY(16, uint8_t,  predictor, 16 * 16 * 3);
   const int mb_uv_height = 16 >> mbd->plane[1].subsampling_y;
+  int mb_y_offset = mb_row * 16 * f->y_stride;
+  int mb_uv_offset = mb_row * mb_uv_height * f->uv_stride;
 
-  // Save input state
-  uint8_t* input_buffer[MAX_MB_PLANE];
-  int i;
-
-  // TODO(aconverse): Add 4:2:2 support
-  assert(mbd->plane[1].subsampling_x == mbd->plane[1].subsampling_y);
-
-  for (i = 0; i < MAX_MB_PLANE; i++)
-    input_buffer[i] = mbd->plane[i].pre[0].buf;
-
-  for (mb_row = 0; mb_row < mb_rows; mb_row++) {
 #if ALT_REF_MC_ENABLED
-    // Source frames are extended to 16 pixels.  This is different than
-    //  L/A/G reference frames that have a border of 32 (VP9ENCBORDERINPIXELS)
-    // A 6/8 tap filter is used for motion search.  This requires 2 pixels
-    //  before and 3 pixels after.  So the largest Y mv on a border would
-    //  then be 16 - VP9_INTERP_EXTEND. The UV blocks are half the size of the
-    //  Y and therefore only extended by 8.  The largest mv that a UV block
-    //  can support is 8 - VP9_INTERP_EXTEND.  A UV mv is half of a Y mv.
-    //  (16 - VP9_INTERP_EXTEND) >> 1 which is greater than
-    //  8 - VP9_INTERP_EXTEND.
-    // To keep the mv in play for both Y and UV planes the max that it
-    //  can be on a border is therefore 16 - (2*VP9_INTERP_EXTEND+1).
-    cpi->mb.mv_row_min = -((mb_row * 16) + (17 - 2 * VP9_INTERP_EXTEND));
-    cpi->mb.mv_row_max = ((cpi->common.mb_rows - 1 - mb_row) * 16)
-                         + (17 - 2 * VP9_INTERP_EXTEND);
+  // Source frames are extended to 16 pixels.  This is different than
+  //  L/A/G reference frames that have a border of 32 (VP9ENCBORDERINPIXELS)
+  // A 6/8 tap filter is used for motion search.  This requires 2 pixels
+  //  before and 3 pixels after.  So the largest Y mv on a border would
+  //  then be 16 - VP9_INTERP_EXTEND. The UV blocks are half the size of the
+  //  Y and therefore only extended by 8.  The largest mv that a UV block
+  //  can support is 8 - VP9_INTERP_EXTEND.  A UV mv is half of a Y mv.
+  //  (16 - VP9_INTERP_EXTEND) >> 1 which is greater than
+  //  8 - VP9_INTERP_EXTEND.
+  // To keep the mv in play for both Y and UV planes the max that it
+  //  can be on a border is therefore 16 - (2*VP9_INTERP_EXTEND+1).
+  x->mv_row_min = -((mb_row * 16) + (17 - 2 * VP9_INTERP_EXTEND));
+  x->mv_row_max = ((cpi->common.mb_rows - 1 - mb_row) * 16)
+                  + (17 - 2 * VP9_INTERP_EXTEND);
 #endif
 
-    for (mb_col = 0; mb_col < mb_cols; mb_col++) {
-      int i, j, k;
-      int stride;
+  for (mb_col = 0; mb_col < mb_cols; mb_col++) {
+    int i, j, k;
+    int stride;
 
-      vpx_memset(accumulator, 0, 16 * 16 * 3 * sizeof(accumulator[0]));
-      vpx_memset(count, 0, 16 * 16 * 3 * sizeof(count[0]));
+    vpx_memset(accumulator, 0, 16 * 16 * 3 * sizeof(accumulator[0]));
+    vpx_memset(count, 0, 16 * 16 * 3 * sizeof(count[0]));
 
 #if ALT_REF_MC_ENABLED
-      cpi->mb.mv_col_min = -((mb_col * 16) + (17 - 2 * VP9_INTERP_EXTEND));
-      cpi->mb.mv_col_max = ((cpi->common.mb_cols - 1 - mb_col) * 16)
-                           + (17 - 2 * VP9_INTERP_EXTEND);
+    x->mv_col_min = -((mb_col * 16) + (17 - 2 * VP9_INTERP_EXTEND));
+    x->mv_col_max = ((cpi->common.mb_cols - 1 - mb_col) * 16)
+                    + (17 - 2 * VP9_INTERP_EXTEND);
 #endif
 
-      for (frame = 0; frame < frame_count; frame++) {
-        if (cpi->frames[frame] == NULL)
-          continue;
+    for (frame = 0; frame < frame_count; frame++) {
+      // The motion vector of this macroblock in the frame. It is kept
+      // locally rather than in the shared mode info, so the rows can be
+      // filtered in parallel.
+      MV mv = { 0, 0 };
 
-        mbd->mi[0]->bmi[0].as_mv[0].as_mv.row = 0;
-        mbd->mi[0]->bmi[0].as_mv[0].as_mv.col = 0;
+      if (cpi->frames[frame] == NULL)
+        continue;
 
-        if (frame == alt_ref_index) {
-          filter_weight = 2;
-        } else {
-          int err = 0;
+      if (frame == alt_ref_index) {
+        filter_weight = 2;
+      } else {
+        int err = 0;
 #if ALT_REF_MC_ENABLED
 #define THRESH_LOW   10000
 #define THRESH_HIGH  20000
 
-          // Find best match in this frame by MC
-          err = temporal_filter_find_matching_mb_c
-                (cpi,
-                 cpi->frames[alt_ref_index]->y_buffer + mb_y_offset,
-                 cpi->frames[frame]->y_buffer + mb_y_offset,
-                 cpi->frames[frame]->y_stride);
+        const MOTION_FIELD *const mv_field = cpi->tf_mv_field[frame];
+
+        // Find best match in this frame by MC
+        err = temporal_filter_find_matching_mb_c
+              (cpi, x,
+               cpi->frames[alt_ref_index]->y_buffer + mb_y_offset,
+               cpi->frames[frame]->y_buffer + mb_y_offset,
+               cpi->frames[frame]->y_stride,
+               mv_field != NULL ? vp9_motion_field_block(mv_field, BLOCK_16X16,
+                                                         2 * mb_row,
+                                                         2 * mb_col)
+                                : NULL,
+               &mv);
 #endif
-          // Assign higher weight to matching MB if it's error
-          // score is lower. If not applying MC default behavior
-          // is to weight all MBs equal.
-          filter_weight = err < THRESH_LOW
-                          ? 2 : err < THRESH_HIGH ? 1 : 0;
-        }
-
-        if (filter_weight != 0) {
-          // Construct the predictors
-          temporal_filter_predictors_mb_c
-          (mbd,
-           cpi->frames[frame]->y_buffer + mb_y_offset,
-           cpi->frames[frame]->u_buffer + mb_uv_offset,
-           cpi->frames[frame]->v_buffer + mb_uv_offset,
-           cpi->frames[frame]->y_stride,
-           mb_uv_height,
-           mbd->mi[0]->bmi[0].as_mv[0].as_mv.row,
-           mbd->mi[0]->bmi[0].as_mv[0].as_mv.col,
-           predictor, scale,
-           mb_col * 16, mb_row * 16);
-
-          // Apply the filter (YUV)
-          vp9_temporal_filter_apply(f->y_buffer + mb_y_offset, f->y_stride,
-                                    predictor, 16, strength, filter_weight,
-                                    accumulator, count);
-
-          vp9_temporal_filter_apply(f->u_buffer + mb_uv_offset, f->uv_stride,
-                                    predictor + 256, mb_uv_height, strength,
-                                    filter_weight, accumulator + 256,
-                                    count + 256);
-
-          vp9_temporal_filter_apply(f->v_buffer + mb_uv_offset, f->uv_stride,
-                                    predictor + 512, mb_uv_height, strength,
-                                    filter_weight, accumulator + 512,
-                                    count + 512);
-        }
+        // Assign higher weight to matching MB if it's error
+        // score is lower. If not applying MC default behavior
+        // is to weight all MBs equal.
+        filter_weight = err < THRESH_LOW
+                        ? 2 : err < THRESH_HIGH ? 1 : 0;
       }
 
-      // Normalize filter output to produce AltRef frame
-      dst1 = cpi->alt_ref_buffer.y_buffer;
-      stride = cpi->alt_ref_buffer.y_stride;
-      byte = mb_y_offset;
-      for (i = 0, k = 0; i < 16; i++) {
-        for (j = 0; j < 16; j++, k++) {
-          unsigned int pval = accumulator[k] + (count[k] >> 1);
-          pval *= cpi->fixed_divide[count[k]];
-          pval >>= 19;
+      if (filter_weight != 0) {
+        // Construct the predictors
+        temporal_filter_predictors_mb_c
+        (mbd,
+         cpi->frames[frame]->y_buffer + mb_y_offset,
+         cpi->frames[frame]->u_buffer + mb_uv_offset,
+         cpi->frames[frame]->v_buffer + mb_uv_offset,
+         cpi->frames[frame]->y_stride,
+         mb_uv_height,
+         mv.row, mv.col,
+         predictor, &cpi->tf_scale,
+         mb_col * 16, mb_row * 16);
+
+        // Apply the filter (YUV)
+        vp9_temporal_filter_apply(f->y_buffer + mb_y_offset, f->y_stride,
+                                  predictor, 16, strength, filter_weight,
+                                  accumulator, count);
+
+        vp9_temporal_filter_apply(f->u_buffer + mb_uv_offset, f->uv_stride,
+                                  predictor + 256, mb_uv_height, strength,
+                                  filter_weight, accumulator + 256,
+                                  count + 256);
+
+        vp9_temporal_filter_apply(f->v_buffer + mb_uv_offset, f->uv_stride,
+                                  predictor + 512, mb_uv_height, strength,
+                                  filter_weight, accumulator + 512,
+                                  count + 512);
+      }
+    }
 
-          dst1[byte] = (uint8_t)pval;
+    // Normalize filter output to produce AltRef frame
+    dst1 = cpi->alt_ref_buffer.y_buffer;
+    stride = cpi->alt_ref_buffer.y_stride;
+    byte = mb_y_offset;
+    for (i = 0, k = 0; i < 16; i++) {
+      for (j = 0; j < 16; j++, k++) {
+        unsigned int pval = accumulator[k] + (count[k] >> 1);
+        pval *= cpi->fixed_divide[count[k]];
+        pval >>= 19;
 
-          // move to next pixel
-          byte++;
-        }
+        dst1[byte] = (uint8_t)pval;
 
-        byte += stride - 16;
+        // move to next pixel
+        byte++;
       }
 
-      dst1 = cpi->alt_ref_buffer.u_buffer;
-      dst2 = cpi->alt_ref_buffer.v_buffer;
-      stride = cpi->alt_ref_buffer.uv_stride;
-      byte = mb_uv_offset;
-      for (i = 0, k = 256; i < mb_uv_height; i++) {
-        for (j = 0; j < mb_uv_height; j++, k++) {
-          int m = k + 256;
-
-          // U
-          unsigned int pval = accumulator[k] + (count[k] >> 1);
-          pval *= cpi->fixed_divide[count[k]];
-          pval >>= 19;
-          dst1[byte] = (uint8_t)pval;
-
-          // V
-          pval = accumulator[m] + (count[m] >> 1);
-          pval *= cpi->fixed_divide[count[m]];
-          pval >>= 19;
-          dst2[byte] = (uint8_t)pval;
-
-          // move to next pixel
-          byte++;
-        }
-
-        byte += stride - mb_uv_height;
+      byte += stride - 16;
+    }
+
+    dst1 = cpi->alt_ref_buffer.u_buffer;
+    dst2 = cpi->alt_ref_buffer.v_buffer;
+    stride = cpi->alt_ref_buffer.uv_stride;
+    byte = mb_uv_offset;
+    for (i = 0, k = 256; i < mb_uv_height; i++) {
+      for (j = 0; j < mb_uv_height; j++, k++) {
+        int m = k + 256;
+
+        // U
+        unsigned int pval = accumulator[k] + (count[k] >> 1);
+        pval *= cpi->fixed_divide[count[k]];
+        pval >>= 19;
+        dst1[byte] = (uint8_t)pval;
+
+        // V
+        pval = accumulator[m] + (count[m] >> 1);
+        pval *= cpi->fixed_divide[count[m]];
+        pval >>= 19;
+        dst2[byte] = (uint8_t)pval;
+
+        // move to next pixel
+        byte++;
       }
 
-      mb_y_offset += 16;
-      mb_uv_offset += mb_uv_height;
+      byte += stride - mb_uv_height;
     }
 
-    mb_y_offset += 16 * (f->y_stride - mb_cols);
-    mb_uv_offset += mb_uv_height * (f->uv_stride - mb_cols);
+    mb_y_offset += 16;
+    mb_uv_offset += mb_uv_height;
+  }
+}
+
+static void temporal_filter_iterate_c(VP9_COMP *cpi,
+                                      int frame_count,
+                                      int alt_ref_index,
+                                      struct scale_factors *scale) {
+  MACROBLOCKD *mbd = &cpi->td.mb.e_mbd;
+  int mb_row;
+
+  // Save input state
+  uint8_t* input_buffer[MAX_MB_PLANE];
+  int i;
+
+  // TODO(aconverse): Add 4:2:2 support
+  assert(mbd->plane[1].subsampling_x == mbd->plane[1].subsampling_y);
+
+  for (i = 0; i < MAX_MB_PLANE; i++)
+    input_buffer[i] = mbd->plane[i].pre[0].buf;
+
+  cpi->tf_frame_count = frame_count;
+  cpi->tf_alt_ref_index = alt_ref_index;
+  cpi->tf_scale = *scale;
+
+  // The macroblocks only read the source frames and each writes its own part
+  // of the alt-ref frame, so the rows do not depend on each other.
+  if (cpi->oxcf.max_threads > 1) {
+    vp9_temporal_filter_row_mt(cpi);
+  } else {
+    for (mb_row = 0; mb_row < cpi->common.mb_rows; mb_row++)
+      vp9_temporal_filter_iterate_row(cpi, &cpi->td, mb_row);
   }
 
   // Restore input state
@@ -378,9 +415,9 @@ void vp9_temporal_filter_prepare(VP9_COMP *cpi, int distance) {
   int frames_to_blur = 0;
   int start_frame = 0;
 
-  int strength = cpi->active_arnr_strength;
   int blur_type = cpi->oxcf.arnr_type;
   int max_frames = cpi->active_arnr_frames;
+  unsigned int frame_ids[MAX_LAG_BUFFERS];
 
   const int num_frames_backward = distance;
   const int num_frames_forward = vp9_lookahead_depth(cpi->lookahead)
@@ -451,15 +488,33 @@ void vp9_temporal_filter_prepare(VP9_COMP *cpi, int distance) {
 
   // Setup frame pointers, NULL indicates frame not included in filter
   vp9_zero(cpi->frames);
+  vp9_zero(cpi->tf_mv_field);
   for (frame = 0; frame < frames_to_blur; frame++) {
     int which_buffer = start_frame - frame;
     struct lookahead_entry *buf = vp9_lookahead_peek(cpi->lookahead,
                                                      which_buffer);
     cpi->frames[frames_to_blur - 1 - frame] = &buf->img;
+    frame_ids[frames_to_blur - 1 - frame] = buf->id;
+  }
+
+  // Keep the vectors of the alt-ref frame in the other frames for the motion
+  // searches of the frames that will reference it.
+  if (cpi->sf.mv_field_mode != MV_FIELD_OFF) {
+    for (frame = 0; frame < frames_to_blur; frame++) {
+      if (frame == frames_to_blur_backward)
+        continue;
+      cpi->tf_mv_field[frame] =
+          vp9_get_motion_field(&cpi->mv_field_cache,
+                               frame_ids[frames_to_blur_backward],
+                               frame_ids[frame], cm->mi_rows, cm->mi_cols);
+      if (cpi->tf_mv_field[frame] == NULL)
+        vpx_internal_error(&cm->error, VPX_CODEC_MEM_ERROR,
+                           "Failed to allocate motion field");
+    }
   }
 
   temporal_filter_iterate_c(cpi, frames_to_blur, frames_to_blur_backward,
-                            strength, &sf);
+                            &sf);
 }
 
 void vp9_configure_arnr_filter(VP9_COMP *cpi,
@@ -15,7 +15,14 @@
 extern "C" {
 #endif
 
+struct ThreadData;
+
 void vp9_temporal_filter_prepare(VP9_COMP *cpi, int distance);
+// Filters macroblock row mb_row of the frames set up by
+// vp9_temporal_filter_prepare() into cpi->alt_ref_buffer. The rows are
+// independent of each other.
+void vp9_temporal_filter_iterate_row(VP9_COMP *cpi, struct ThreadData *td,
+                                     int mb_row);
 void vp9_configure_arnr_filter(VP9_COMP *cpi,
                                const unsigned int frames_to_arnr,
                                const int group_boost);
@@ -160,15 +160,17 @@ void vp9_tokenize_initialize() {
 
 struct tokenize_b_args {
   VP9_COMP *cpi;
-  MACROBLOCKD *xd;
+  ThreadData *td;
   TOKENEXTRA **tp;
 };
 
 static void set_entropy_context_b(int plane, int block, BLOCK_SIZE plane_bsize,
                                   TX_SIZE tx_size, void *arg) {
   struct tokenize_b_args* const args = arg;
-  MACROBLOCKD *const xd = args->xd;
-  struct macroblock_plane *p = &args->cpi->mb.plane[plane];
+  ThreadData *const td = args->td;
+  MACROBLOCK *const x = &td->mb;
+  MACROBLOCKD *const xd = &x->e_mbd;
+  struct macroblock_plane *p = &x->plane[plane];
   struct macroblockd_plane *pd = &xd->plane[plane];
   int aoff, loff;
   txfrm_block_to_raster_xy(plane_bsize, tx_size, block, &aoff, &loff);
@@ -210,10 +212,12 @@ static void tokenize_b(int plane, int block, BLOCK_SIZE plane_bsize,
                        TX_SIZE tx_size, void *arg) {
   struct tokenize_b_args* const args = arg;
   VP9_COMP *cpi = args->cpi;
-  MACROBLOCKD *xd = args->xd;
+  ThreadData *const td = args->td;
+  MACROBLOCK *const x = &td->mb;
+  MACROBLOCKD *const xd = &x->e_mbd;
   TOKENEXTRA **tp = args->tp;
   uint8_t token_cache[32 * 32];
-  struct macroblock_plane *p = &cpi->mb.plane[plane];
+  struct macroblock_plane *p = &x->plane[plane];
   struct macroblockd_plane *pd = &xd->plane[plane];
   MB_MODE_INFO *mbmi = &xd->mi[0]->mbmi;
   int pt; /* near block/prev token context index */
@@ -227,11 +231,11 @@ static void tokenize_b(int plane, int block, BLOCK_SIZE plane_bsize,
   const scan_order *so;
   const int ref = is_inter_block(mbmi);
   unsigned int (*const counts)[COEFF_CONTEXTS][ENTROPY_TOKENS] =
-      cpi->coef_counts[tx_size][type][ref];
+      td->rd_counts.coef_counts[tx_size][type][ref];
   vp9_prob (*const coef_probs)[COEFF_CONTEXTS][UNCONSTRAINED_NODES] =
       cpi->common.fc.coef_probs[tx_size][type][ref];
   unsigned int (*const eob_branch)[COEFF_CONTEXTS] =
-      cpi->common.counts.eob_branch[tx_size][type][ref];
+      td->counts->eob_branch[tx_size][type][ref];
 
   const uint8_t *const band = get_band_translate(tx_size);
   const int seg_eob = get_tx_eob(&cpi->common.seg, segment_id, tx_size);
@@ -285,6 +289,108 @@ static void tokenize_b(int plane, int block, BLOCK_SIZE plane_bsize,
   vp9_set_contexts(xd, pd, plane_bsize, tx_size, c > 0, aoff, loff);
 }
 
+// Level a coefficient coded as level at dequantizer dq_from would be quantized
+// to with the zero bin, rounding and dequantizer of the new q. The 32x32
+// quantizer halves its coefficients, zero bin and rounding alike, so the same
+// arithmetic holds for it.
+static INLINE int requantize(int level, int dq_from, int dq_to, int zbin,
+                             int round) {
+  const int coeff = level * dq_from;
+  if (coeff < zbin)
+    return 0;
+  return MIN((coeff + round) / dq_to, DCT_MAX_VALUE - 1);
+}
+
+int64_t vp9_requantized_token_rate(const VP9_COMP *cpi,
+                                   vp9_coeff_cost *token_costs,
+                                   int from_q, int to_q) {
+  const VP9_COMMON *const cm = &cpi->common;
+  const QUANTS *const quants = &cpi->quants;
+  const vp9_prob *const probs = &cm->fc.coef_probs[0][0][0][0][0][0];
+  const int num_rows = cpi->row_data_cols * cpi->row_data_rows;
+  // Indexed by plane type and by whether the coefficient is AC.
+  const int16_t *const dq_from[PLANE_TYPES] = { cm->y_dequant[from_q],
+                                                cm->uv_dequant[from_q] };
+  const int16_t *const dq_to[PLANE_TYPES] = { cm->y_dequant[to_q],
+                                              cm->uv_dequant[to_q] };
+  const int16_t *const zbin[PLANE_TYPES] = { quants->y_zbin[to_q],
+                                             quants->uv_zbin[to_q] };
+  const int16_t *const round[PLANE_TYPES] = { quants->y_round[to_q],
+                                              quants->uv_round[to_q] };
+  int64_t rate = 0;
+  int r;
+
+  for (r = 0; r < num_rows; ++r) {
+    const TOKENEXTRA *p = cpi->row_data[r].tok;
+    const TOKENEXTRA *const stop = p + cpi->row_data[r].tok_count;
+    // Trailing run of zeros of the requantized block. At the end of the block
+    // it is dropped for an EOB token, costed at the first zero of the run.
+    int zero_run = 0;
+    int64_t zero_run_rate = 0;
+    int eob_rate = 0;
+
+    for (; p < stop; ++p) {
+      int index, ctx, band, ref, type, tx_size, level;
+      unsigned int (*costs)[COEFF_CONTEXTS][ENTROPY_TOKENS];
+
+      if (p->token == EOSB_TOKEN) {
+        rate += zero_run ? eob_rate : 0;
+        zero_run = 0;
+        zero_run_rate = 0;
+        continue;
+      }
+
+      index = (int)(p->context_tree - probs) / UNCONSTRAINED_NODES;
+      ctx = index % COEFF_CONTEXTS;
+      index /= COEFF_CONTEXTS;
+      band = index % COEF_BANDS;
+      index /= COEF_BANDS;
+      ref = index % REF_TYPES;
+      index /= REF_TYPES;
+      type = index % PLANE_TYPES;
+      tx_size = index / PLANE_TYPES;
+      costs = token_costs[tx_size][type][ref][band];
+
+      // Only the first coefficient of a block is in band 0, so a block coded
+      // up to its last coefficient, without an EOB token, ends here.
+      if (band == 0) {
+        rate += zero_run ? eob_rate : 0;
+        zero_run = 0;
+        zero_run_rate = 0;
+      }
+
+      if (p->token == EOB_TOKEN) {
+        rate += zero_run ? eob_rate : costs[0][ctx][EOB_TOKEN];
+        zero_run = 0;
+        zero_run_rate = 0;
+        continue;
+      }
+
+      level = p->token == ZERO_TOKEN ? 0 :
+          vp9_extra_bits[p->token].base_val + (p->extra >> 1);
+      if (level) {
+        const int ac = band > 0;
+        level = requantize(level, dq_from[type][ac], dq_to[type][ac],
+                           zbin[type][ac], round[type][ac]);
+      }
+
+      if (level) {
+        const int token = vp9_dct_value_tokens_ptr[level].token;
+        rate += zero_run_rate + costs[zero_run > 0][ctx][token] +
+                vp9_dct_value_cost_ptr[level];
+        zero_run = 0;
+        zero_run_rate = 0;
+      } else {
+        if (!zero_run)
+          eob_rate = costs[0][ctx][EOB_TOKEN];
+        zero_run_rate += costs[zero_run > 0][ctx][ZERO_TOKEN];
+        ++zero_run;
+      }
+    }
+  }
+  return rate;
+}
+
 struct is_skippable_args {
   MACROBLOCK *x;
   int *skippable;
@@ -305,19 +411,19 @@ int vp9_is_skippable_in_plane(MACROBLOCK *x, BLOCK_SIZE bsize, int plane) {
   return result;
 }
 
-void vp9_tokenize_sb(VP9_COMP *cpi, TOKENEXTRA **t, int dry_run,
-                     BLOCK_SIZE bsize) {
+void vp9_tokenize_sb(VP9_COMP *cpi, ThreadData *td, TOKENEXTRA **t,
+                     int dry_run, BLOCK_SIZE bsize) {
   VP9_COMMON *const cm = &cpi->common;
-  MACROBLOCKD *const xd = &cpi->mb.e_mbd;
+  MACROBLOCKD *const xd = &td->mb.e_mbd;
   MB_MODE_INFO *const mbmi = &xd->mi[0]->mbmi;
   TOKENEXTRA *t_backup = *t;
   const int ctx = vp9_get_skip_context(xd);
   const int skip_inc = !vp9_segfeature_active(&cm->seg, mbmi->segment_id,
                                               SEG_LVL_SKIP);
-  struct tokenize_b_args arg = {cpi, xd, t};
+  struct tokenize_b_args arg = {cpi, td, t};
   if (mbmi->skip) {
     if (!dry_run)
-      cm->counts.skip[ctx][1] += skip_inc;
+      td->counts->skip[ctx][1] += skip_inc;
     reset_skip_context(xd, bsize);
     if (dry_run)
       *t = t_backup;
@@ -325,7 +431,7 @@ void vp9_tokenize_sb(VP9_COMP *cpi, TOKENEXTRA **t, int dry_run,
   }
 
   if (!dry_run) {
-    cm->counts.skip[ctx][0] += skip_inc;
+    td->counts->skip[ctx][0] += skip_inc;
     vp9_foreach_transformed_block(xd, bsize, tokenize_b, &arg);
   } else {
     vp9_foreach_transformed_block(xd, bsize, set_entropy_context_b, &arg);
@@ -43,9 +43,18 @@ extern struct vp9_token vp9_coef_encodings[];
 int vp9_is_skippable_in_plane(MACROBLOCK *x, BLOCK_SIZE bsize, int plane);
 
 struct VP9_COMP;
+struct ThreadData;
 
-void vp9_tokenize_sb(struct VP9_COMP *cpi, TOKENEXTRA **t, int dry_run,
-                     BLOCK_SIZE bsize);
+void vp9_tokenize_sb(struct VP9_COMP *cpi, struct ThreadData *td,
+                     TOKENEXTRA **t, int dry_run, BLOCK_SIZE bsize);
+
+// Returns the rate, in 1/256 bit units, of the tokens the last frame encode
+// left in cpi->row_data if their coefficients had been quantized at qindex
+// to_q instead of from_q. Each token keeps the entropy context it was coded
+// with, and the token costs are looked up in token_costs.
+int64_t vp9_requantized_token_rate(const struct VP9_COMP *cpi,
+                                   vp9_coeff_cost *token_costs,
+                                   int from_q, int to_q);
 
 extern const int16_t *vp9_dct_value_cost_ptr;
 /* TODO: The Token field should be broken out into a separate char array to
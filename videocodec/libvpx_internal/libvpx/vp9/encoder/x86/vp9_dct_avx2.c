@@ -11,6 +11,7 @@
 #include <immintrin.h>  // AVX2
 #include "vp9/common/vp9_idct.h"  // for cospi constants
 #include "vpx_ports/mem.h"
+#include "vp9/encoder/x86/vp9_quantize_avx2.h"
 
 void vp9_fdct4x4_avx2(const int16_t *input, int16_t *output, int stride) {
   // The 2D transform is done with two passes which are actually pretty
@@ -276,7 +277,9 @@ void vp9_fht4x4_avx2(const int16_t *input, int16_t *output,
   }
 }
 
-void vp9_fdct8x8_avx2(const int16_t *input, int16_t *output, int stride) {
+// The 8x8 forward transform, leaving the rows of coefficients in out.
+static INLINE void fdct8x8_avx2(const int16_t *input, int stride,
+                                __m128i *out) {
   int pass;
   // Constants
   //    When we use them, in one case, they are all the same. In all others
@@ -491,7 +494,7 @@ void vp9_fdct8x8_avx2(const int16_t *input, int16_t *output, int stride) {
       // 07 17 27 37 47 57 67 77
     }
   }
-  // Post-condition output and store it
+  // Post-condition output
   {
     // Post-condition (division by two)
     //    division of two 16 bits signed numbers using shifts
@@ -520,18 +523,26 @@ void vp9_fdct8x8_avx2(const int16_t *input, int16_t *output, int stride) {
     in5 = _mm_srai_epi16(in5, 1);
     in6 = _mm_srai_epi16(in6, 1);
     in7 = _mm_srai_epi16(in7, 1);
-    // store results
-    _mm_store_si128((__m128i *)(output + 0 * 8), in0);
-    _mm_store_si128((__m128i *)(output + 1 * 8), in1);
-    _mm_store_si128((__m128i *)(output + 2 * 8), in2);
-    _mm_store_si128((__m128i *)(output + 3 * 8), in3);
-    _mm_store_si128((__m128i *)(output + 4 * 8), in4);
-    _mm_store_si128((__m128i *)(output + 5 * 8), in5);
-    _mm_store_si128((__m128i *)(output + 6 * 8), in6);
-    _mm_store_si128((__m128i *)(output + 7 * 8), in7);
+    out[0] = in0;
+    out[1] = in1;
+    out[2] = in2;
+    out[3] = in3;
+    out[4] = in4;
+    out[5] = in5;
+    out[6] = in6;
+    out[7] = in7;
   }
 }
 
+void vp9_fdct8x8_avx2(const int16_t *input, int16_t *output, int stride) {
+  __m128i out[8];
+  int i;
+
+  fdct8x8_avx2(input, stride, out);
+  for (i = 0; i < 8; ++i)
+    _mm_store_si128((__m128i *)(output + i * 8), out[i]);
+}
+
 // load 8x8 array
 static INLINE void load_buffer_8x8_avx2(const int16_t *input, __m128i *in,
                                    int stride) {
@@ -1067,6 +1078,59 @@ void vp9_fht8x8_avx2(const int16_t *input, int16_t *output,
   }
 }
 
+void vp9_fdct8x8_quant_avx2(const int16_t *input, int stride,
+                            int16_t *coeff_ptr, intptr_t n_coeffs,
+                            int skip_block, const int16_t *zbin_ptr,
+                            const int16_t *round_ptr, const int16_t *quant_ptr,
+                            const int16_t *quant_shift_ptr,
+                            int16_t *qcoeff_ptr, int16_t *dqcoeff_ptr,
+                            const int16_t *dequant_ptr, int zbin_oq_value,
+                            uint16_t *eob_ptr, const int16_t *scan,
+                            const int16_t *iscan) {
+  const __m256i zero = _mm256_setzero_si256();
+  QUANTIZE_PARAMS_AVX2 dc_params, ac_params;
+  __m256i coeff[4], outside_zbin;
+  __m256i eob_max = zero;
+  __m128i in[8];
+  int i;
+
+  (void)n_coeffs;
+  (void)scan;
+
+  // The coefficients stay in registers for the quantization.
+  fdct8x8_avx2(input, stride, in);
+  write_buffer_8x8_avx2(coeff_ptr, in, 8);
+  for (i = 0; i < 4; ++i)
+    coeff[i] = _mm256_inserti128_si256(_mm256_castsi128_si256(in[2 * i]),
+                                       in[2 * i + 1], 1);
+
+  load_quantize_params_avx2(zbin_ptr, round_ptr, quant_ptr, quant_shift_ptr,
+                            dequant_ptr, zbin_oq_value, 0, &dc_params);
+  ac_params = dc_params;
+  ac_quantize_params_avx2(&ac_params);
+
+  // Blocks with all of their coefficients in the zero bin need no
+  // quantization.
+  outside_zbin = outside_zbin_avx2(&dc_params, coeff[0]);
+  for (i = 1; i < 4; ++i)
+    outside_zbin = _mm256_or_si256(outside_zbin,
+                                   outside_zbin_avx2(&ac_params, coeff[i]));
+  if (skip_block || !_mm256_movemask_epi8(outside_zbin)) {
+    for (i = 0; i < 4; ++i) {
+      _mm256_storeu_si256((__m256i *)(qcoeff_ptr + 16 * i), zero);
+      _mm256_storeu_si256((__m256i *)(dqcoeff_ptr + 16 * i), zero);
+    }
+    *eob_ptr = 0;
+    return;
+  }
+
+  for (i = 0; i < 4; ++i)
+    eob_max = quantize_16_avx2(i == 0 ? &dc_params : &ac_params, 0, coeff[i],
+                               qcoeff_ptr + 16 * i, dqcoeff_ptr + 16 * i,
+                               iscan + 16 * i, eob_max);
+  *eob_ptr = eob_avx2(eob_max);
+}
+
 void vp9_fdct16x16_avx2(const int16_t *input, int16_t *output, int stride) {
   // The 2D transform is done with two passes which are actually pretty
   // similar. In the first one, we transform the columns and transpose
@@ -0,0 +1,77 @@
+/*
+ *  Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <immintrin.h>  // AVX2
+
+#include "./vp9_rtcd.h"
+#include "vp9/encoder/x86/vp9_quantize_avx2.h"
+
+static INLINE void quantize_avx2(const int16_t *coeff_ptr, intptr_t n_coeffs,
+                                 int skip_block, const int16_t *zbin_ptr,
+                                 const int16_t *round_ptr,
+                                 const int16_t *quant_ptr,
+                                 const int16_t *quant_shift_ptr,
+                                 int16_t *qcoeff_ptr, int16_t *dqcoeff_ptr,
+                                 const int16_t *dequant_ptr, int zbin_oq_value,
+                                 uint16_t *eob_ptr, const int16_t *iscan,
+                                 int log_scale) {
+  QUANTIZE_PARAMS_AVX2 params;
+  __m256i eob_max = _mm256_setzero_si256();
+  intptr_t i;
+
+  if (skip_block) {
+    const __m256i zero = _mm256_setzero_si256();
+    for (i = 0; i < n_coeffs; i += 16) {
+      _mm256_storeu_si256((__m256i *)(qcoeff_ptr + i), zero);
+      _mm256_storeu_si256((__m256i *)(dqcoeff_ptr + i), zero);
+    }
+    *eob_ptr = 0;
+    return;
+  }
+
+  load_quantize_params_avx2(zbin_ptr, round_ptr, quant_ptr, quant_shift_ptr,
+                            dequant_ptr, zbin_oq_value, log_scale, &params);
+  for (i = 0; i < n_coeffs; i += 16) {
+    const __m256i coeff = _mm256_loadu_si256((const __m256i *)(coeff_ptr + i));
+    eob_max = quantize_16_avx2(&params, log_scale, coeff, qcoeff_ptr + i,
+                               dqcoeff_ptr + i, iscan + i, eob_max);
+    if (i == 0)
+      ac_quantize_params_avx2(&params);
+  }
+  *eob_ptr = eob_avx2(eob_max);
+}
+
+void vp9_quantize_b_avx2(const int16_t *coeff_ptr, intptr_t n_coeffs,
+                         int skip_block, const int16_t *zbin_ptr,
+                         const int16_t *round_ptr, const int16_t *quant_ptr,
+                         const int16_t *quant_shift_ptr, int16_t *qcoeff_ptr,
+                         int16_t *dqcoeff_ptr, const int16_t *dequant_ptr,
+                         int zbin_oq_value, uint16_t *eob_ptr,
+                         const int16_t *scan, const int16_t *iscan) {
+  (void)scan;
+  quantize_avx2(coeff_ptr, n_coeffs, skip_block, zbin_ptr, round_ptr,
+                quant_ptr, quant_shift_ptr, qcoeff_ptr, dqcoeff_ptr,
+                dequant_ptr, zbin_oq_value, eob_ptr, iscan, 0);
+}
+
+void vp9_quantize_b_32x32_avx2(const int16_t *coeff_ptr, intptr_t n_coeffs,
+                               int skip_block, const int16_t *zbin_ptr,
+                               const int16_t *round_ptr,
+                               const int16_t *quant_ptr,
+                               const int16_t *quant_shift_ptr,
+                               int16_t *qcoeff_ptr, int16_t *dqcoeff_ptr,
+                               const int16_t *dequant_ptr, int zbin_oq_value,
+                               uint16_t *eob_ptr, const int16_t *scan,
+                               const int16_t *iscan) {
+  (void)scan;
+  quantize_avx2(coeff_ptr, n_coeffs, skip_block, zbin_ptr, round_ptr,
+                quant_ptr, quant_shift_ptr, qcoeff_ptr, dqcoeff_ptr,
+                dequant_ptr, zbin_oq_value, eob_ptr, iscan, 1);
+}
@@ -0,0 +1,148 @@
+/*
+ *  Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef VP9_ENCODER_X86_VP9_QUANTIZE_AVX2_H_
+#define VP9_ENCODER_X86_VP9_QUANTIZE_AVX2_H_
+
+#include <immintrin.h>  // AVX2
+
+#include "./vpx_config.h"
+#include "vpx/vpx_integer.h"
+#include "vp9/common/vp9_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The quantizer parameters of 16 coefficients, as used by quantize_16_avx2().
+typedef struct {
+  __m256i zbin;
+  __m256i round;
+  __m256i quant;
+  __m256i shift;
+  __m256i dequant;
+} QUANTIZE_PARAMS_AVX2;
+
+static INLINE __m256i dc_ac_epi16(int dc, int ac) {
+  const __m256i ac16 = _mm256_set1_epi16((int16_t)ac);
+  const __m128i dc16 = _mm_insert_epi16(_mm256_castsi256_si128(ac16), dc, 0);
+  return _mm256_inserti128_si256(ac16, dc16, 0);
+}
+
+// Sets the parameters of the first 16 coefficients of a block, those of the
+// DC coefficient in the first element and those of the AC coefficients in the
+// others. log_scale is 1 for the 32x32 quantizer and 0 otherwise, and folds
+// its halved zero bin, rounding and dequantization and doubled shift into the
+// parameters. The zero bin is limited to 0 so that the coefficients can be
+// compared to it unsigned.
+static INLINE void load_quantize_params_avx2(const int16_t *zbin_ptr,
+                                             const int16_t *round_ptr,
+                                             const int16_t *quant_ptr,
+                                             const int16_t *quant_shift_ptr,
+                                             const int16_t *dequant_ptr,
+                                             int zbin_oq_value, int log_scale,
+                                             QUANTIZE_PARAMS_AVX2 *params) {
+  // (x + log_scale) >> log_scale rounds as ROUND_POWER_OF_TWO(x, 1) does for
+  // 32x32 blocks and leaves x as is otherwise.
+  params->zbin = dc_ac_epi16(
+      MAX((zbin_ptr[0] + zbin_oq_value + log_scale) >> log_scale, 0),
+      MAX((zbin_ptr[1] + zbin_oq_value + log_scale) >> log_scale, 0));
+  params->round = dc_ac_epi16((round_ptr[0] + log_scale) >> log_scale,
+                              (round_ptr[1] + log_scale) >> log_scale);
+  params->quant = dc_ac_epi16(quant_ptr[0], quant_ptr[1]);
+  params->shift = dc_ac_epi16(quant_shift_ptr[0] << log_scale,
+                              quant_shift_ptr[1] << log_scale);
+  params->dequant = dc_ac_epi16(dequant_ptr[0], dequant_ptr[1]);
+}
+
+static INLINE __m256i broadcast_ac_epi16(__m256i v) {
+  return _mm256_broadcastw_epi16(_mm_srli_si128(_mm256_castsi256_si128(v), 2));
+}
+
+// Switches the parameters to those of 16 AC coefficients.
+static INLINE void ac_quantize_params_avx2(QUANTIZE_PARAMS_AVX2 *params) {
+  params->zbin = broadcast_ac_epi16(params->zbin);
+  params->round = broadcast_ac_epi16(params->round);
+  params->quant = broadcast_ac_epi16(params->quant);
+  params->shift = broadcast_ac_epi16(params->shift);
+  params->dequant = broadcast_ac_epi16(params->dequant);
+}
+
+// Returns the mask of the coefficients outside of the zero bin.
+static INLINE __m256i outside_zbin_avx2(const QUANTIZE_PARAMS_AVX2 *params,
+                                        __m256i coeff) {
+  // The magnitudes are compared unsigned, which keeps that of -32768 exact.
+  const __m256i abs_coeff = _mm256_abs_epi16(coeff);
+  return _mm256_cmpeq_epi16(_mm256_max_epu16(abs_coeff, params->zbin),
+                            abs_coeff);
+}
+
+// Quantizes 16 coefficients as vp9_quantize_b_c() or, with log_scale 1,
+// vp9_quantize_b_32x32_c() do, and returns eob_max raised to the iscan + 1 of
+// the nonzero quantized coefficients.
+static INLINE __m256i quantize_16_avx2(const QUANTIZE_PARAMS_AVX2 *params,
+                                       int log_scale, __m256i coeff,
+                                       int16_t *qcoeff_ptr,
+                                       int16_t *dqcoeff_ptr,
+                                       const int16_t *iscan_ptr,
+                                       __m256i eob_max) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i mask = outside_zbin_avx2(params, coeff);
+  __m256i tmp, qcoeff, dqcoeff, iscan;
+
+  if (!_mm256_movemask_epi8(mask)) {
+    _mm256_storeu_si256((__m256i *)qcoeff_ptr, zero);
+    _mm256_storeu_si256((__m256i *)dqcoeff_ptr, zero);
+    return eob_max;
+  }
+
+  // As unsigned 16 bit values the intermediate results are exact, including
+  // the sum of the first product, which may exceed INT16_MAX.
+  tmp = _mm256_adds_epu16(_mm256_abs_epi16(coeff), params->round);
+  tmp = _mm256_min_epu16(tmp, _mm256_set1_epi16(INT16_MAX));
+  tmp = _mm256_add_epi16(_mm256_mulhi_epi16(tmp, params->quant), tmp);
+  tmp = _mm256_mulhi_epu16(tmp, params->shift);
+  tmp = _mm256_and_si256(tmp, mask);
+  qcoeff = _mm256_sign_epi16(tmp, coeff);
+
+  if (log_scale) {
+    // The low 16 bits of half of the 32 bit product.
+    const __m256i lo = _mm256_mullo_epi16(tmp, params->dequant);
+    const __m256i hi = _mm256_mulhi_epu16(tmp, params->dequant);
+    dqcoeff = _mm256_or_si256(_mm256_srli_epi16(lo, 1),
+                              _mm256_slli_epi16(hi, 15));
+    dqcoeff = _mm256_sign_epi16(dqcoeff, coeff);
+  } else {
+    dqcoeff = _mm256_mullo_epi16(qcoeff, params->dequant);
+  }
+  _mm256_storeu_si256((__m256i *)qcoeff_ptr, qcoeff);
+  _mm256_storeu_si256((__m256i *)dqcoeff_ptr, dqcoeff);
+
+  // iscan + 1 where qcoeff is nonzero, 0 elsewhere.
+  iscan = _mm256_loadu_si256((const __m256i *)iscan_ptr);
+  iscan = _mm256_sub_epi16(iscan, _mm256_cmpeq_epi16(zero, zero));
+  iscan = _mm256_andnot_si256(_mm256_cmpeq_epi16(qcoeff, zero), iscan);
+  return _mm256_max_epi16(eob_max, iscan);
+}
+
+static INLINE uint16_t eob_avx2(__m256i eob_max) {
+  __m128i eob = _mm_max_epi16(_mm256_castsi256_si128(eob_max),
+                              _mm256_extracti128_si256(eob_max, 1));
+  eob = _mm_max_epi16(eob, _mm_srli_si128(eob, 8));
+  eob = _mm_max_epi16(eob, _mm_srli_si128(eob, 4));
+  eob = _mm_max_epi16(eob, _mm_srli_si128(eob, 2));
+  return (uint16_t)_mm_extract_epi16(eob, 0);
+}
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // VP9_ENCODER_X86_VP9_QUANTIZE_AVX2_H_
@@ -0,0 +1,54 @@
+/*
+ *  Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <emmintrin.h>  // SSE2
+
+#include "./vp9_rtcd.h"
+#include "vpx/vpx_integer.h"
+
+void vp9_get_coeff_tokens_sse2(const int16_t *qcoeff, intptr_t n_coeffs,
+                               uint8_t *tokens, uint8_t *token_cache) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i three = _mm_set1_epi8(3);
+  // Largest magnitude of FOUR_TOKEN and of each category up to CATEGORY5_TOKEN.
+  const __m128i four = _mm_set1_epi8(4);
+  const __m128i cat1_max = _mm_set1_epi8(6);
+  const __m128i cat2_max = _mm_set1_epi8(10);
+  const __m128i cat3_max = _mm_set1_epi8(18);
+  const __m128i cat4_max = _mm_set1_epi8(34);
+  const __m128i cat5_max = _mm_set1_epi8(66);
+  intptr_t i;
+
+  for (i = 0; i < n_coeffs; i += 16) {
+    const __m128i coeff0 = _mm_load_si128((const __m128i *)(qcoeff + i));
+    const __m128i coeff1 = _mm_load_si128((const __m128i *)(qcoeff + i + 8));
+    const __m128i abs0 = _mm_max_epi16(coeff0, _mm_sub_epi16(zero, coeff0));
+    const __m128i abs1 = _mm_max_epi16(coeff1, _mm_sub_epi16(zero, coeff1));
+    // Saturating to 127 keeps every magnitude of CATEGORY6_TOKEN above 66.
+    const __m128i mag = _mm_packs_epi16(abs0, abs1);
+    const __m128i gt4 = _mm_cmpgt_epi8(mag, four);
+    const __m128i gt10 = _mm_cmpgt_epi8(mag, cat2_max);
+    // The compare masks are -1 where set, so subtracting them counts them.
+    __m128i token = _mm_min_epu8(mag, four);
+    __m128i energy = _mm_min_epu8(mag, three);
+
+    token = _mm_sub_epi8(token, gt4);
+    token = _mm_sub_epi8(token, _mm_cmpgt_epi8(mag, cat1_max));
+    token = _mm_sub_epi8(token, gt10);
+    token = _mm_sub_epi8(token, _mm_cmpgt_epi8(mag, cat3_max));
+    token = _mm_sub_epi8(token, _mm_cmpgt_epi8(mag, cat4_max));
+    token = _mm_sub_epi8(token, _mm_cmpgt_epi8(mag, cat5_max));
+    energy = _mm_sub_epi8(energy, gt4);
+    energy = _mm_sub_epi8(energy, gt10);
+
+    _mm_store_si128((__m128i *)(tokens + i), token);
+    _mm_store_si128((__m128i *)(token_cache + i), energy);
+  }
+}
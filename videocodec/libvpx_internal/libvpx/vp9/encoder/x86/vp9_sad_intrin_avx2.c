@@ -0,0 +1,111 @@
+/*
+ *  Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+#include <immintrin.h>  // AVX2
+
+#include "./vp9_rtcd.h"
+#include "vpx/vpx_integer.h"
+
+// 32 pixels of a block of the given width: one row of 32, two rows of 16 or
+// four rows of 8.
+static INLINE __m256i load_32(const uint8_t *p, int stride, int width) {
+  if (width >= 32) {
+    return _mm256_loadu_si256((const __m256i *)p);
+  } else if (width == 16) {
+    return _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)p)),
+        _mm_loadu_si128((const __m128i *)(p + stride)), 1);
+  } else {
+    const __m128i rows01 = _mm_unpacklo_epi64(
+        _mm_loadl_epi64((const __m128i *)p),
+        _mm_loadl_epi64((const __m128i *)(p + stride)));
+    const __m128i rows23 = _mm_unpacklo_epi64(
+        _mm_loadl_epi64((const __m128i *)(p + 2 * stride)),
+        _mm_loadl_epi64((const __m128i *)(p + 3 * stride)));
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(rows01), rows23, 1);
+  }
+}
+
+// Adds up the four 64-bit sums of _mm256_sad_epu8().
+static INLINE unsigned int sum_sad(__m256i sum) {
+  const __m128i sum_128 = _mm_add_epi64(_mm256_castsi256_si128(sum),
+                                        _mm256_extracti128_si256(sum, 1));
+  return _mm_cvtsi128_si32(_mm_add_epi64(sum_128,
+                                         _mm_srli_si128(sum_128, 8)));
+}
+
+// SAD of a width x height block, against the average of ref and second_pred
+// if second_pred is not NULL. Blocks of more than 512 pixels stop every 512
+// pixels once the partial SAD exceeds max_sad, and return that partial SAD.
+static INLINE unsigned int sad_avx2(const uint8_t *src, int src_stride,
+                                    const uint8_t *ref, int ref_stride,
+                                    const uint8_t *second_pred,
+                                    int width, int height,
+                                    unsigned int max_sad) {
+  const int load_rows = width >= 32 ? 1 : 32 / width;
+  const int check_rows = 512 / width;
+  __m256i sum = _mm256_setzero_si256();
+  int x, y;
+
+  for (y = 0; y < height; y += load_rows) {
+    for (x = 0; x < width; x += 32) {
+      const __m256i src_reg = load_32(src + x, src_stride, width);
+      __m256i ref_reg = load_32(ref + x, ref_stride, width);
+
+      if (second_pred != NULL) {
+        const __m256i pred_reg =
+            _mm256_loadu_si256((const __m256i *)(second_pred + x));
+        ref_reg = _mm256_avg_epu8(ref_reg, pred_reg);
+      }
+      sum = _mm256_add_epi32(sum, _mm256_sad_epu8(src_reg, ref_reg));
+    }
+
+    src += load_rows * src_stride;
+    ref += load_rows * ref_stride;
+    if (second_pred != NULL)
+      second_pred += load_rows * width;
+
+    if ((y + load_rows) % check_rows == 0 && y + load_rows < height) {
+      const unsigned int partial_sad = sum_sad(sum);
+      if (partial_sad > max_sad)
+        return partial_sad;
+    }
+  }
+
+  return sum_sad(sum);
+}
+
+#define sad_mxn_avx2(m, n) \
+unsigned int vp9_sad##m##x##n##_avx2(const uint8_t *src_ptr, int src_stride, \
+                                     const uint8_t *ref_ptr, int ref_stride, \
+                                     unsigned int max_sad) { \
+  return sad_avx2(src_ptr, src_stride, ref_ptr, ref_stride, NULL, m, n, \
+                  max_sad); \
+} \
+unsigned int vp9_sad##m##x##n##_avg_avx2(const uint8_t *src_ptr, \
+                                         int src_stride, \
+                                         const uint8_t *ref_ptr, \
+                                         int ref_stride, \
+                                         const uint8_t *second_pred, \
+                                         unsigned int max_sad) { \
+  return sad_avx2(src_ptr, src_stride, ref_ptr, ref_stride, second_pred, \
+                  m, n, max_sad); \
+}
+
+sad_mxn_avx2(64, 64)
+sad_mxn_avx2(64, 32)
+sad_mxn_avx2(32, 64)
+sad_mxn_avx2(32, 32)
+sad_mxn_avx2(32, 16)
+sad_mxn_avx2(16, 32)
+sad_mxn_avx2(16, 16)
+sad_mxn_avx2(16, 8)
+sad_mxn_avx2(8, 16)
+sad_mxn_avx2(8, 8)
+sad_mxn_avx2(8, 4)
@@ -0,0 +1,84 @@
+/*
+ *  Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <immintrin.h>  // AVX2
+
+#include "./vp9_rtcd.h"
+#include "vpx/vpx_integer.h"
+
+void vp9_temporal_filter_apply_avx2(uint8_t *frame1,
+                                    unsigned int stride,
+                                    uint8_t *frame2,
+                                    unsigned int block_size,
+                                    int strength,
+                                    int filter_weight,
+                                    unsigned int *accumulator,
+                                    uint16_t *count) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i three = _mm256_set1_epi16(3);
+  const __m256i sixteen = _mm256_set1_epi16(16);
+  const __m256i rounding = _mm256_set1_epi16(strength > 0 ?
+                                             1 << (strength - 1) : 0);
+  const __m256i weight = _mm256_set1_epi16(filter_weight);
+  const __m128i shift = _mm_cvtsi32_si128(strength);
+  const unsigned int num_pels = block_size * block_size;
+  unsigned int i;
+
+  // 16 pixels at a time: a row of a 16x16 block or two rows of an 8x8 one.
+  // frame2, accumulator and count are contiguous blocks.
+  for (i = 0; i < num_pels; i += 16) {
+    __m128i src_8;
+    __m256i src, pred, diff, sq, lo, hi, modifier, acc_lo, acc_hi;
+
+    if (block_size == 16) {
+      src_8 = _mm_loadu_si128((const __m128i *)frame1);
+      frame1 += stride;
+    } else {
+      src_8 = _mm_unpacklo_epi64(
+          _mm_loadl_epi64((const __m128i *)frame1),
+          _mm_loadl_epi64((const __m128i *)(frame1 + stride)));
+      frame1 += 2 * stride;
+    }
+    src = _mm256_cvtepu8_epi16(src_8);
+    pred = _mm256_cvtepu8_epi16(
+        _mm_loadu_si128((const __m128i *)(frame2 + i)));
+
+    // modifier = (3 * diff * diff + rounding) >> strength, clamped to 16.
+    // diff * diff fits in 16 unsigned bits but 3 times it may not. Whenever
+    // it does not, or the rounding saturates, the result is clamped anyway.
+    diff = _mm256_sub_epi16(src, pred);
+    sq = _mm256_mullo_epi16(diff, diff);
+    lo = _mm256_mullo_epi16(sq, three);
+    hi = _mm256_mulhi_epu16(sq, three);
+    modifier = _mm256_srl_epi16(_mm256_adds_epu16(lo, rounding), shift);
+    modifier = _mm256_or_si256(modifier, _mm256_cmpgt_epi16(hi, zero));
+
+    // modifier = (16 - modifier) * filter_weight, with the saturation taking
+    // care of modifier > 16.
+    modifier = _mm256_mullo_epi16(_mm256_subs_epu16(sixteen, modifier),
+                                  weight);
+
+    _mm256_storeu_si256((__m256i *)(count + i),
+        _mm256_add_epi16(_mm256_loadu_si256((const __m256i *)(count + i)),
+                         modifier));
+
+    // modifier * pixel_value is at most 32 * 255.
+    modifier = _mm256_mullo_epi16(modifier, pred);
+    acc_lo = _mm256_loadu_si256((const __m256i *)(accumulator + i));
+    acc_hi = _mm256_loadu_si256((const __m256i *)(accumulator + i + 8));
+    acc_lo = _mm256_add_epi32(acc_lo, _mm256_cvtepu16_epi32(
+                                          _mm256_castsi256_si128(modifier)));
+    acc_hi = _mm256_add_epi32(acc_hi, _mm256_cvtepu16_epi32(
+                                          _mm256_extracti128_si256(modifier,
+                                                                   1)));
+    _mm256_storeu_si256((__m256i *)(accumulator + i), acc_lo);
+    _mm256_storeu_si256((__m256i *)(accumulator + i + 8), acc_hi);
+  }
+}
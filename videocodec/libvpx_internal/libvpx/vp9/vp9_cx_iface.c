@@ -38,6 +38,9 @@ struct vp9_extracfg {
   unsigned int                frame_parallel_decoding_mode;
   AQ_MODE                     aq_mode;
   unsigned int                frame_periodic_boost;
+  unsigned int                row_mt;
+  unsigned int                lookahead_analysis;
+  unsigned int                deadline_aware;
 };
 
 struct extraconfig_map {
@@ -67,6 +70,9 @@ static const struct extraconfig_map extracfg_map[] = {
       0,                          // frame_parallel_decoding_mode
       NO_AQ,                      // aq_mode
       0,                          // frame_periodic_delta_q
+      0,                          // row_mt
+      0,                          // lookahead_analysis
+      0,                          // deadline_aware
     }
   }
 };
@@ -153,6 +159,9 @@ static vpx_codec_err_t validate_config(vpx_codec_alg_priv_t *ctx,
   RANGE_CHECK_BOOL(extra_cfg, lossless);
   RANGE_CHECK(extra_cfg, aq_mode,           0, AQ_MODE_COUNT - 1);
   RANGE_CHECK(extra_cfg, frame_periodic_boost, 0, 1);
+  RANGE_CHECK_BOOL(extra_cfg, row_mt);
+  RANGE_CHECK_BOOL(extra_cfg, lookahead_analysis);
+  RANGE_CHECK_BOOL(extra_cfg, deadline_aware);
   RANGE_CHECK_HI(cfg, g_threads,          64);
   RANGE_CHECK_HI(cfg, g_lag_in_frames,    MAX_LAG_BUFFERS);
   RANGE_CHECK(cfg, rc_end_usage,          VPX_VBR, VPX_Q);
@@ -354,6 +363,9 @@ static vpx_codec_err_t set_vp9e_config(VP9_CONFIG *oxcf,
 
   oxcf->tile_columns = extra_cfg->tile_columns;
   oxcf->tile_rows    = extra_cfg->tile_rows;
+  oxcf->max_threads  = cfg->g_threads;
+  oxcf->row_mt       = extra_cfg->row_mt;
+  oxcf->lookahead_analysis = extra_cfg->lookahead_analysis;
 
   oxcf->lossless = extra_cfg->lossless;
 
@@ -489,6 +501,9 @@ static vpx_codec_err_t set_param(vpx_codec_alg_priv_t *ctx, int ctrl_id,
         extra_cfg.frame_parallel_decoding_mode);
     MAP(VP9E_SET_AQ_MODE,                 extra_cfg.aq_mode);
     MAP(VP9E_SET_FRAME_PERIODIC_BOOST,   extra_cfg.frame_periodic_boost);
+    MAP(VP9E_SET_ROW_MT,                  extra_cfg.row_mt);
+    MAP(VP9E_SET_LOOKAHEAD_ANALYSIS,      extra_cfg.lookahead_analysis);
+    MAP(VP9E_SET_DEADLINE_AWARE,          extra_cfg.deadline_aware);
   }
 
   res = validate_config(ctx, &ctx->cfg, &extra_cfg);
@@ -595,8 +610,10 @@ static void pick_quickcompress_mode(vpx_codec_alg_priv_t  *ctx,
                                (uint64_t)ctx->cfg.g_timebase.den;
 
     // If the deadline is more that the duration this frame is to be shown,
-    // use good quality mode. Otherwise use realtime mode.
-    new_qc = (deadline > duration_us) ? MODE_GOODQUALITY : MODE_REALTIME;
+    // use good quality mode. Otherwise use realtime mode. A deadline-aware
+    // encoder meets any deadline in realtime mode.
+    new_qc = (deadline > duration_us && !ctx->extra_cfg.deadline_aware) ?
+                 MODE_GOODQUALITY : MODE_REALTIME;
   }
 
   if (ctx->cfg.g_pass == VPX_RC_FIRST_PASS)
@@ -732,6 +749,12 @@ static vpx_codec_err_t vp9e_encode(vpx_codec_alg_priv_t  *ctx,
     if (ctx->base.init_flags & VPX_CODEC_USE_PSNR)
       ((VP9_COMP *)ctx->cpi)->b_calculate_psnr = 1;
 
+    // The deadline of a deadline-aware realtime encode is the time budget of
+    // its frames.
+    ((VP9_COMP *)ctx->cpi)->frame_budget =
+        (ctx->extra_cfg.deadline_aware && ctx->oxcf.mode == MODE_REALTIME) ?
+            deadline : 0;
+
     // Convert API flags to internal codec lib flags
     lib_flags = (flags & VPX_EFLAG_FORCE_KF) ? FRAMEFLAGS_KEY : 0;
 
@@ -1006,6 +1029,19 @@ static vpx_codec_err_t vp9e_set_scalemode(vpx_codec_alg_priv_t *ctx,
   }
 }
 
+static vpx_codec_err_t vp9e_set_twopass_range(vpx_codec_alg_priv_t *ctx,
+                                              int ctr_id, va_list args) {
+  vpx_twopass_range_t *const range = va_arg(args, vpx_twopass_range_t *);
+
+  if (range) {
+    const int res = vp9_twopass_set_range(ctx->cpi, range->first_frame,
+                                          range->num_frames);
+    return (res == 0) ? VPX_CODEC_OK : VPX_CODEC_INVALID_PARAM;
+  } else {
+    return VPX_CODEC_INVALID_PARAM;
+  }
+}
+
 static vpx_codec_err_t vp9e_set_svc(vpx_codec_alg_priv_t *ctx, int ctr_id,
                                     va_list args) {
   int data = va_arg(args, int);
@@ -1100,10 +1136,14 @@ static vpx_codec_ctrl_fn_map_t vp9e_ctf_maps[] = {
   {VP9E_SET_FRAME_PARALLEL_DECODING,  set_param},
   {VP9E_SET_AQ_MODE,                  set_param},
   {VP9E_SET_FRAME_PERIODIC_BOOST,     set_param},
+  {VP9E_SET_ROW_MT,                   set_param},
+  {VP9E_SET_LOOKAHEAD_ANALYSIS,       set_param},
   {VP9_GET_REFERENCE,                 get_reference},
   {VP9E_SET_SVC,                      vp9e_set_svc},
   {VP9E_SET_SVC_PARAMETERS,           vp9e_set_svc_parameters},
   {VP9E_SET_SVC_LAYER_ID,             vp9e_set_svc_layer_id},
+  {VP9E_SET_TWOPASS_RANGE,            vp9e_set_twopass_range},
+  {VP9E_SET_DEADLINE_AWARE,           set_param},
   { -1, NULL},
 };
 
@@ -23,6 +23,13 @@
 #define VP9_CAP_POSTPROC (CONFIG_VP9_POSTPROC ? VPX_CODEC_CAP_POSTPROC : 0)
 typedef vpx_codec_stream_info_t  vp9_stream_info_t;
 
+// A shown frame that is, or was, decoded by a frame worker.
+typedef struct {
+  int fb_idx;
+  void *user_priv;
+  vpx_image_t img;
+} vp9_frame_output_t;
+
 struct vpx_codec_alg_priv {
   vpx_codec_priv_t        base;
   vpx_codec_dec_cfg_t     cfg;
@@ -42,6 +49,17 @@ struct vpx_codec_alg_priv {
   int                     img_setup;
   int                     img_avail;
   int                     invert_tile_order;
+  int                     two_stage_decode;
+
+  // Frame-based multi-threading. Shown frames are queued in decode order and
+  // handed out once their frame worker has been retired. Frames handed out
+  // hold a reference until the next call to vp9_decode().
+  int                     frame_parallel_decode;
+  vp9_frame_output_t      frame_outputs[FRAME_BUFFERS];
+  int                     next_frame_output;
+  int                     num_frame_outputs;
+  int                     num_returned_outputs;
+  int                     last_output_fb_idx;
 
   // External frame buffer info to save for VP9 common.
   void *ext_priv;  // Private data associated with the external frame buffers.
@@ -77,6 +95,16 @@ static vpx_codec_err_t vp9_init(vpx_codec_ctx_t *ctx,
   return VPX_CODEC_OK;
 }
 
+// Drops the references of the frames handed out by vp9_get_frame().
+static void release_returned_outputs(vpx_codec_alg_priv_t *ctx) {
+  while (ctx->num_returned_outputs > 0) {
+    const int i = (ctx->next_frame_output + FRAME_BUFFERS -
+                   ctx->num_returned_outputs) % FRAME_BUFFERS;
+    vp9_unref_frame_buffer(ctx->pbi, ctx->frame_outputs[i].fb_idx);
+    --ctx->num_returned_outputs;
+  }
+}
+
 static vpx_codec_err_t vp9_destroy(vpx_codec_alg_priv_t *ctx) {
   if (ctx->pbi)
     vp9_remove_decompressor(ctx->pbi);
@@ -190,6 +218,14 @@ static vpx_codec_err_t decode_one(vpx_codec_alg_priv_t *ctx,
     oxcf.version = 9;
     oxcf.max_threads = ctx->cfg.threads;
     oxcf.inv_tile_order = ctx->invert_tile_order;
+    oxcf.two_stage_decode = ctx->two_stage_decode;
+    // Frame workers output frames before post-processing could be applied.
+    oxcf.frame_parallel_decode =
+        (ctx->base.init_flags & VPX_CODEC_USE_FRAME_THREADING) &&
+        !(ctx->base.init_flags & VPX_CODEC_USE_POSTPROC) &&
+        ctx->cfg.threads > 1;
+    ctx->frame_parallel_decode = oxcf.frame_parallel_decode;
+    ctx->last_output_fb_idx = -1;
     optr = vp9_create_decompressor(&oxcf);
 
     // If postprocessing was enabled by the application and a
@@ -260,7 +296,19 @@ static vpx_codec_err_t decode_one(vpx_codec_alg_priv_t *ctx,
     if (vp9_receive_compressed_data(pbi, data_sz, data, deadline))
       res = update_error_state(ctx, &cm->error);
 
-    if (!res && 0 == vp9_get_raw_frame(pbi, &sd, &time_stamp,
+    if (ctx->frame_parallel_decode) {
+      // The frame may still be decoding; queue it for vp9_get_frame().
+      if (!res && cm->show_frame) {
+        const int i = (ctx->next_frame_output + ctx->num_frame_outputs) %
+                      FRAME_BUFFERS;
+        assert(ctx->num_returned_outputs + ctx->num_frame_outputs <
+               FRAME_BUFFERS);
+        ctx->frame_outputs[i].fb_idx = cm->new_fb_idx;
+        ctx->frame_outputs[i].user_priv = user_priv;
+        vp9_ref_frame_buffer(pbi, cm->new_fb_idx);
+        ++ctx->num_frame_outputs;
+      }
+    } else if (!res && 0 == vp9_get_raw_frame(pbi, &sd, &time_stamp,
                                        &time_end_stamp, &flags)) {
       yuvconfig2image(&ctx->img, &sd, user_priv);
 
@@ -314,6 +362,17 @@ static vpx_codec_err_t vp9_decode(vpx_codec_alg_priv_t  *ctx,
   uint32_t sizes[8];
   int frames_this_pts, frame_count = 0;
 
+  if (ctx->frame_parallel_decode && ctx->pbi != NULL) {
+    release_returned_outputs(ctx);
+
+    // A NULL buffer flushes the frames in flight.
+    if (data == NULL && data_sz == 0) {
+      if (vp9_sync_frame_workers(ctx->pbi))
+        return update_error_state(ctx, &ctx->pbi->common.error);
+      return VPX_CODEC_OK;
+    }
+  }
+
   if (data == NULL || data_sz == 0) return VPX_CODEC_INVALID_PARAM;
 
   parse_superframe_index(data, data_sz, sizes, &frames_this_pts);
@@ -366,10 +425,46 @@ static vpx_codec_err_t vp9_decode(vpx_codec_alg_priv_t  *ctx,
   return res;
 }
 
+// Returns the oldest queued frame if its frame worker has been retired.
+static vpx_image_t *get_frame_output(vpx_codec_alg_priv_t *ctx) {
+  VP9D_COMP *const pbi = ctx->pbi;
+  vp9_frame_output_t *out;
+  YV12_BUFFER_CONFIG sd;
+  RefCntBuffer *buf;
+
+  if (pbi == NULL || ctx->num_frame_outputs == 0)
+    return NULL;
+
+  out = &ctx->frame_outputs[ctx->next_frame_output];
+  if (vp9_frame_worker_busy(pbi, out->fb_idx))
+    return NULL;
+
+  buf = &pbi->common.frame_bufs[out->fb_idx];
+  sd = buf->buf;
+  sd.y_width = sd.y_crop_width;
+  sd.y_height = sd.y_crop_height;
+  sd.uv_width = sd.y_width >> pbi->common.subsampling_x;
+  sd.uv_height = sd.y_height >> pbi->common.subsampling_y;
+  yuvconfig2image(&out->img, &sd, out->user_priv);
+  out->img.fb_priv = buf->raw_frame_buffer.priv;
+
+  ctx->last_output_fb_idx = out->fb_idx;
+  ctx->next_frame_output = (ctx->next_frame_output + 1) % FRAME_BUFFERS;
+  --ctx->num_frame_outputs;
+  ++ctx->num_returned_outputs;
+  return &out->img;
+}
+
 static vpx_image_t *vp9_get_frame(vpx_codec_alg_priv_t  *ctx,
                                   vpx_codec_iter_t      *iter) {
   vpx_image_t *img = NULL;
 
+  if (ctx->frame_parallel_decode) {
+    // iter is not needed: every call returns the next frame that is ready.
+    (void)iter;
+    return get_frame_output(ctx);
+  }
+
   if (ctx->img_avail) {
     /* iter acts as a flip flop, so an image is only returned on the first
      * call to get_frame.
@@ -411,6 +506,8 @@ static vpx_codec_err_t set_reference(vpx_codec_alg_priv_t *ctx, int ctr_id,
     YV12_BUFFER_CONFIG sd;
 
     image2yuvconfig(&frame->img, &sd);
+    if (ctx->frame_parallel_decode && vp9_sync_frame_workers(ctx->pbi))
+      return update_error_state(ctx, &ctx->pbi->common.error);
     return vp9_set_reference_dec(&ctx->pbi->common,
                                  (VP9_REFFRAME)frame->frame_type, &sd);
   } else {
@@ -427,6 +524,8 @@ static vpx_codec_err_t copy_reference(vpx_codec_alg_priv_t *ctx, int ctr_id,
     YV12_BUFFER_CONFIG sd;
 
     image2yuvconfig(&frame->img, &sd);
+    if (ctx->frame_parallel_decode && vp9_sync_frame_workers(ctx->pbi))
+      return update_error_state(ctx, &ctx->pbi->common.error);
 
     return vp9_copy_reference_dec(ctx->pbi,
                                   (VP9_REFFRAME)frame->frame_type, &sd);
@@ -442,6 +541,8 @@ static vpx_codec_err_t get_reference(vpx_codec_alg_priv_t *ctx, int ctr_id,
   if (data) {
     YV12_BUFFER_CONFIG* fb;
 
+    if (ctx->frame_parallel_decode && vp9_sync_frame_workers(ctx->pbi))
+      return update_error_state(ctx, &ctx->pbi->common.error);
     vp9_get_reference_dec(ctx->pbi, data->idx, &fb);
     yuvconfig2image(&data->img, fb, NULL);
     return VPX_CODEC_OK;
@@ -508,7 +609,10 @@ static vpx_codec_err_t get_frame_corrupted(vpx_codec_alg_priv_t *ctx,
   int *corrupted = va_arg(args, int *);
 
   if (corrupted) {
-    if (ctx->pbi)
+    if (ctx->pbi && ctx->frame_parallel_decode)
+      *corrupted = ctx->last_output_fb_idx >= 0 &&
+          ctx->pbi->common.frame_bufs[ctx->last_output_fb_idx].buf.corrupted;
+    else if (ctx->pbi)
       *corrupted = ctx->pbi->common.frame_to_show->corrupted;
     else
       return VPX_CODEC_ERROR;
@@ -543,6 +647,33 @@ static vpx_codec_err_t set_invert_tile_order(vpx_codec_alg_priv_t *ctx,
   return VPX_CODEC_OK;
 }
 
+static vpx_codec_err_t set_two_stage_decode(vpx_codec_alg_priv_t *ctx,
+                                            int ctr_id,
+                                            va_list args) {
+  ctx->two_stage_decode = va_arg(args, int);
+  if (ctx->pbi != NULL)
+    ctx->pbi->oxcf.two_stage_decode = ctx->two_stage_decode;
+  return VPX_CODEC_OK;
+}
+
+static vpx_codec_err_t get_stage_times(vpx_codec_alg_priv_t *ctx,
+                                       int ctrl_id, va_list args) {
+  vp9_decode_stage_times_t *const stage_times =
+      va_arg(args, vp9_decode_stage_times_t *);
+
+  if (stage_times) {
+    if (ctx->pbi) {
+      *stage_times = ctx->pbi->stage_times;
+      vp9_zero(ctx->pbi->stage_times);
+    } else {
+      vp9_zero(*stage_times);
+    }
+    return VPX_CODEC_OK;
+  } else {
+    return VPX_CODEC_INVALID_PARAM;
+  }
+}
+
 static vpx_codec_ctrl_fn_map_t ctf_maps[] = {
   {VP8_SET_REFERENCE,             set_reference},
   {VP8_COPY_REFERENCE,            copy_reference},
@@ -556,6 +687,8 @@ static vpx_codec_ctrl_fn_map_t ctf_maps[] = {
   {VP9_GET_REFERENCE,             get_reference},
   {VP9D_GET_DISPLAY_SIZE,         get_display_size},
   {VP9_INVERT_TILE_DECODE_ORDER,  set_invert_tile_order},
+  {VP9D_SET_TWO_STAGE_DECODE,     set_two_stage_decode},
+  {VP9D_GET_STAGE_TIMES,          get_stage_times},
   { -1, NULL},
 };
 
@@ -567,7 +700,7 @@ CODEC_INTERFACE(vpx_codec_vp9_dx) = {
   "WebM Project VP9 Decoder" VERSION_STRING,
   VPX_CODEC_INTERNAL_ABI_VERSION,
   VPX_CODEC_CAP_DECODER | VP9_CAP_POSTPROC |
-      VPX_CODEC_CAP_EXTERNAL_FRAME_BUFFER,
+      VPX_CODEC_CAP_EXTERNAL_FRAME_BUFFER | VPX_CODEC_CAP_FRAME_THREADING,
   /* vpx_codec_caps_t          caps; */
   vp9_init,         /* vpx_codec_init_fn_t       init; */
   vp9_destroy,      /* vpx_codec_destroy_fn_t    destroy; */
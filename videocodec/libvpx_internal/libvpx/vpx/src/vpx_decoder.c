@@ -44,6 +44,9 @@ vpx_codec_err_t vpx_codec_dec_init_ver(vpx_codec_ctx_t      *ctx,
   else if ((flags & VPX_CODEC_USE_INPUT_FRAGMENTS) &&
            !(iface->caps & VPX_CODEC_CAP_INPUT_FRAGMENTS))
     res = VPX_CODEC_INCAPABLE;
+  else if ((flags & VPX_CODEC_USE_FRAME_THREADING) &&
+           !(iface->caps & VPX_CODEC_CAP_FRAME_THREADING))
+    res = VPX_CODEC_INCAPABLE;
   else if (!(iface->caps & VPX_CODEC_CAP_DECODER))
     res = VPX_CODEC_INCAPABLE;
   else {
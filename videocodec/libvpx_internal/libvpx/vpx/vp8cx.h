@@ -201,7 +201,55 @@ enum vp8e_enc_control_id {
    *                     layer and 0..#vpx_codec_enc_cfg::ts_number_layers for
    *                     temporal layer.
    */
-  VP9E_SET_SVC_LAYER_ID
+  VP9E_SET_SVC_LAYER_ID,
+
+  /*!\brief control function to enable row-based multi-threading
+   *
+   * When enabled, the superblock rows of each tile column are encoded in
+   * parallel, each row following the one above it, so that more than one
+   * thread per tile column can be used. The output then depends on neither
+   * the number of threads nor the number of tile columns encoded in
+   * parallel, but differs from the output with row-based multi-threading
+   * disabled.
+   *
+   * \note Valid range: 0..1
+   */
+  VP9E_SET_ROW_MT,
+
+  /*!\brief control function to analyze the frames in the lookahead
+   *
+   * When enabled in one pass encoding, each frame is analyzed as it enters
+   * the lookahead, in a background thread if more than one thread is
+   * allowed. The intra and inter errors and the motion of the frames
+   * waiting in the lookahead then place the key frames at scene cuts and
+   * size the golden frame groups and their boost.
+   *
+   * \note Valid range: 0..1
+   */
+  VP9E_SET_LOOKAHEAD_ANALYSIS,
+
+  /*!\brief control function to encode a range of the two pass stats
+   *
+   * Makes the last pass encode only the frames of the given range of the
+   * first pass stats, given for the whole clip, e.g. one closed GOP segment
+   * of a clip split across several encoders. The segment gets the share of
+   * the bits of the clip that its frames would get in a single encode. Must
+   * be set before the first frame is encoded.
+   */
+  VP9E_SET_TWOPASS_RANGE,
+
+  /*!\brief control function to encode realtime frames within their deadline
+   *
+   * When enabled in one pass encoding, a nonzero deadline passed to
+   * vpx_codec_encode() selects the realtime mode and is the time budget of
+   * the frame in microseconds. The non-RD search of the encoder checks the
+   * time taken after each superblock row, and degrades to meet the budget.
+   * A #VPX_CODEC_DEADLINE_PKT packet then reports the encode time and the
+   * degradation of each frame.
+   *
+   * \note Valid range: 0..1
+   */
+  VP9E_SET_DEADLINE_AWARE
 };
 
 /*!\brief vpx 1-D scaling mode
@@ -259,6 +307,17 @@ typedef struct vpx_scaling_mode {
   VPX_SCALING_MODE    v_scaling_mode;  /**< vertical scaling mode   */
 } vpx_scaling_mode_t;
 
+/*!\brief  vp9 two pass stats range
+ *
+ * This defines the frames of the first pass stats encoded by the last pass,
+ * with the #VP9E_SET_TWOPASS_RANGE control.
+ *
+ */
+typedef struct vpx_twopass_range {
+  unsigned int first_frame;   /**< index of the first frame of the range */
+  unsigned int num_frames;    /**< number of frames in the range */
+} vpx_twopass_range_t;
+
 /*!\brief VP8 token partition mode
  *
  * This defines VP8 partitioning mode for compressed data, i.e., the number of
@@ -367,6 +426,14 @@ VPX_CTRL_USE_TYPE(VP9E_SET_AQ_MODE, unsigned int)
 
 VPX_CTRL_USE_TYPE(VP9E_SET_FRAME_PERIODIC_BOOST, unsigned int)
 
+VPX_CTRL_USE_TYPE(VP9E_SET_ROW_MT, unsigned int)
+
+VPX_CTRL_USE_TYPE(VP9E_SET_LOOKAHEAD_ANALYSIS, unsigned int)
+
+VPX_CTRL_USE_TYPE(VP9E_SET_TWOPASS_RANGE, vpx_twopass_range_t *)
+
+VPX_CTRL_USE_TYPE(VP9E_SET_DEADLINE_AWARE, unsigned int)
+
 /*! @} - end defgroup vp8_encoder */
 #ifdef __cplusplus
 }  // extern "C"
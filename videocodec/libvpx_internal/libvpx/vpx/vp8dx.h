@@ -77,6 +77,15 @@ enum vp8_dec_control_id {
   /** For testing. */
   VP9_INVERT_TILE_DECODE_ORDER,
 
+  /** control function to parse each VP9 frame completely before it is
+   *  reconstructed and loop filtered (0 = off, the default), e.g. on another
+   *  thread */
+  VP9D_SET_TWO_STAGE_DECODE,
+
+  /** control function to get the time spent in each decoding stage since the
+   *  previous call, see #vp9_decode_stage_times_t */
+  VP9D_GET_STAGE_TIMES,
+
   VP8_DECODER_CTRL_ID_MAX
 };
 
@@ -94,6 +103,23 @@ typedef struct vp8_decrypt_init {
     void *decrypt_state;
 } vp8_decrypt_init;
 
+/*!\brief Time spent in each VP9 decoding stage
+ *
+ * In microseconds. Only the time spent on the thread calling
+ * vpx_codec_decode() is counted, so with frame-based multi-threading the
+ * tiles of the frames in flight are not.
+ */
+typedef struct vp9_decode_stage_times {
+    /*! Frame header parsing and setup. */
+    int64_t header_us;
+    /*! Tile decoding, including the loop filter when it is applied inline. */
+    int64_t tiles_us;
+    /*! Loop filter applied after the tiles of a frame are decoded. */
+    int64_t loop_filter_us;
+    /*! Post-processing of the frames output. */
+    int64_t postproc_us;
+} vp9_decode_stage_times_t;
+
 /*!\brief VP8 decoder control function parameter type
  *
  * Defines the data types that VP8D control functions take. Note that
@@ -108,6 +134,8 @@ VPX_CTRL_USE_TYPE(VP8D_GET_LAST_REF_USED,      int *)
 VPX_CTRL_USE_TYPE(VP8D_SET_DECRYPTOR,          vp8_decrypt_init *)
 VPX_CTRL_USE_TYPE(VP9D_GET_DISPLAY_SIZE,       int *)
 VPX_CTRL_USE_TYPE(VP9_INVERT_TILE_DECODE_ORDER, int)
+VPX_CTRL_USE_TYPE(VP9D_SET_TWO_STAGE_DECODE,    int)
+VPX_CTRL_USE_TYPE(VP9D_GET_STAGE_TIMES,         vp9_decode_stage_times_t *)
 
 /*! @} - end defgroup vp8_decoder */
 
@@ -156,6 +156,7 @@ extern "C" {
     VPX_CODEC_CX_FRAME_PKT,    /**< Compressed video frame */
     VPX_CODEC_STATS_PKT,       /**< Two-pass statistics for this frame */
     VPX_CODEC_PSNR_PKT,        /**< PSNR statistics for this frame */
+    VPX_CODEC_DEADLINE_PKT,    /**< Encode time of this frame */
     VPX_CODEC_CUSTOM_PKT = 256 /**< Algorithm extensions  */
   };
 
@@ -190,6 +191,11 @@ extern "C" {
         uint64_t     sse[4];      /**< sum squared error, total/y/u/v */
         double       psnr[4];     /**< PSNR, total/y/u/v */
       } psnr;                       /**< data for PSNR packet */
+      struct vpx_deadline_pkt {
+        unsigned long budget;   /**< deadline of the frame, in microseconds */
+        unsigned long elapsed;  /**< encode time, in microseconds */
+        int           level;    /**< degradation of the search, 0 for none */
+      } deadline;                   /**< data for deadline packet */
       struct vpx_fixed_buf raw;     /**< data for arbitrary packets */
 
       /* This packet size is fixed to allow codecs to extend this
@@ -25,6 +25,12 @@ extern "C" {
  */
 #define VPX_MAXIMUM_WORK_BUFFERS 1
 
+/*!\brief The maximum number of additional buffers used by a VP9 decoder
+ * initialized with VPX_CODEC_USE_FRAME_THREADING: one for each frame being
+ * decoded in parallel and one for each decoded frame waiting to be output.
+ */
+#define VPX_MAXIMUM_FRAME_THREADING_BUFFERS 8
+
 /*!\brief The maximum number of reference buffers that a VP9 encoder may use.
  */
 #define VP9_MAXIMUM_REF_BUFFERS 8
@@ -38,8 +44,16 @@ typedef struct vpx_codec_frame_buffer {
   size_t size;  /**< Size of data in bytes */
   void *priv;  /**< Frame's private data */
 
-  int fb_index;
+  int fb_index;  /**< Application's index of the buffer */
+  /*!\brief Luma stride of the frame in the buffer
+   *
+   * Set by the decoder to the minimum stride before the get callback is
+   * invoked. The callback may raise it, e.g. to match the layout of a buffer
+   * that the frame is displayed from. The chroma stride is half of it for
+   * 4:2:0 content.
+   */
   int fb_stride;
+  /*!\brief Number of luma rows in the buffer, see fb_stride */
   int fb_height_stride;
 } vpx_codec_frame_buffer_t;
 
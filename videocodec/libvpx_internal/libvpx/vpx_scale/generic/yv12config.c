@@ -172,6 +172,11 @@ int vp9_realloc_frame_buffer(YV12_BUFFER_CONFIG *ybf,
 
       assert(fb != NULL);
 
+      // The callback may lay the frame out with a larger stride and height
+      // than these.
+      fb->fb_stride = y_stride;
+      fb->fb_height_stride = aligned_height;
+
       // Allocation to hold larger frame, or first allocation.
       if (cb(cb_priv, external_frame_size, fb) < 0)
         return -1;
@@ -211,6 +216,8 @@ int vp9_realloc_frame_buffer(YV12_BUFFER_CONFIG *ybf,
 #else
             frame_size = yplane_size + 2 * uvplane_size;
 #endif
+            if (fb->size < (size_t)frame_size + align_addr_extra_size)
+              return -1;
         } else {
             LOGD("buffer stride get from external should not less than calculated!");
             return -1;
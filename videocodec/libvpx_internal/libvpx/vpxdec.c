@@ -81,12 +81,14 @@ static const arg_def_t fb_arg =
 
 static const arg_def_t md5arg = ARG_DEF(NULL, "md5", 0,
                                         "Compute the MD5 sum of the decoded frame");
+static const arg_def_t frameparallelarg = ARG_DEF(NULL, "frame-parallel", 0,
+                                                  "Frame parallel decode");
 
 static const arg_def_t *all_args[] = {
   &codecarg, &use_yv12, &use_i420, &flipuvarg, &noblitarg,
   &progressarg, &limitarg, &skiparg, &postprocarg, &summaryarg, &outputfile,
   &threadsarg, &verbosearg, &scalearg, &fb_arg,
-  &md5arg,
+  &md5arg, &frameparallelarg,
   &error_concealment,
   NULL
 };
@@ -516,6 +518,7 @@ int main_loop(int argc, const char **argv_) {
   int                     do_scale = 0;
   vpx_image_t             *scaled_img = NULL;
   int                     frame_avail, got_data;
+  int                     frame_parallel = 0, flushed = 0;
   int                     num_external_frame_buffers = 0;
   struct ExternalFrameBufferList ext_fb_list = {0};
 
@@ -568,6 +571,8 @@ int main_loop(int argc, const char **argv_) {
       postproc = 1;
     else if (arg_match(&arg, &md5arg, argi))
       do_md5 = 1;
+    else if (arg_match(&arg, &frameparallelarg, argi))
+      frame_parallel = 1;
     else if (arg_match(&arg, &summaryarg, argi))
       summary = 1;
     else if (arg_match(&arg, &threadsarg, argi))
@@ -719,7 +724,8 @@ int main_loop(int argc, const char **argv_) {
     interface = get_vpx_decoder_by_index(0);
 
   dec_flags = (postproc ? VPX_CODEC_USE_POSTPROC : 0) |
-              (ec_enabled ? VPX_CODEC_USE_ERROR_CONCEALMENT : 0);
+              (ec_enabled ? VPX_CODEC_USE_ERROR_CONCEALMENT : 0) |
+              (frame_parallel ? VPX_CODEC_USE_FRAME_THREADING : 0);
   if (vpx_codec_dec_init(&decoder, interface->interface(), &cfg, dec_flags)) {
     fprintf(stderr, "Failed to initialize decoder: %s\n",
             vpx_codec_error(&decoder));
@@ -818,6 +824,15 @@ int main_loop(int argc, const char **argv_) {
       }
     }
 
+    // Flush the frames that are still being decoded at the end of the input.
+    if (!frame_avail && frame_parallel && !flushed) {
+      flushed = 1;
+      if (vpx_codec_decode(&decoder, NULL, 0, NULL, 0)) {
+        warn("Failed to flush decoder: %s", vpx_codec_error(&decoder));
+        goto fail;
+      }
+    }
+
     vpx_usec_timer_start(&timer);
 
     got_data = 0;
@@ -18,6 +18,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#if CONFIG_MULTITHREAD && HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
 
 #include "vpx/vpx_encoder.h"
 #if CONFIG_DECODERS
@@ -235,6 +238,9 @@ static const arg_def_t disable_warning_prompt =
 static const arg_def_t experimental_bitstream =
     ARG_DEF(NULL, "experimental-bitstream", 0,
             "Allow experimental bitstream features.");
+static const arg_def_t segments_arg = ARG_DEF(NULL, "segments", 1,
+    "Encode closed GOP segments of kf-max-dist frames on this many encoders "
+    "in parallel");
 
 
 static const arg_def_t *main_args[] = {
@@ -242,7 +248,7 @@ static const arg_def_t *main_args[] = {
   &outputfile, &codecarg, &passes, &pass_arg, &fpf_name, &limit, &skip,
   &deadline, &best_dl, &good_dl, &rt_dl,
   &quietarg, &verbosearg, &psnrarg, &use_ivf, &out_part, &q_hist_n,
-  &rate_hist_n, &disable_warnings, &disable_warning_prompt,
+  &rate_hist_n, &disable_warnings, &disable_warning_prompt, &segments_arg,
   NULL
 };
 
@@ -405,12 +411,24 @@ static const arg_def_t aq_mode = ARG_DEF(
 static const arg_def_t frame_periodic_boost = ARG_DEF(
     NULL, "frame_boost", 1,
     "Enable frame periodic boost (0: off (by default), 1: on)");
+static const arg_def_t row_mt = ARG_DEF(
+    NULL, "row-mt", 1,
+    "Encode superblock rows in parallel (0: off (by default), 1: on)");
+static const arg_def_t lookahead_analysis = ARG_DEF(
+    NULL, "lookahead-analysis", 1,
+    "Analyze the lookahead frames in one pass mode (0: off (by default), "
+    "1: on)");
+static const arg_def_t deadline_aware = ARG_DEF(
+    NULL, "deadline-aware", 1,
+    "Encode realtime frames within the deadline, in microseconds "
+    "(0: off (by default), 1: on)");
 
 static const arg_def_t *vp9_args[] = {
   &cpu_used, &auto_altref, &noise_sens, &sharpness, &static_thresh,
   &tile_cols, &tile_rows, &arnr_maxframes, &arnr_strength, &arnr_type,
   &tune_ssim, &cq_level, &max_intra_rate_pct, &lossless,
-  &frame_parallel_decoding, &aq_mode, &frame_periodic_boost,
+  &frame_parallel_decoding, &aq_mode, &frame_periodic_boost, &row_mt,
+  &lookahead_analysis, &deadline_aware,
   NULL
 };
 static const int vp9_arg_ctrl_map[] = {
@@ -420,7 +438,8 @@ static const int vp9_arg_ctrl_map[] = {
   VP8E_SET_ARNR_MAXFRAMES, VP8E_SET_ARNR_STRENGTH, VP8E_SET_ARNR_TYPE,
   VP8E_SET_TUNING, VP8E_SET_CQ_LEVEL, VP8E_SET_MAX_INTRA_BITRATE_PCT,
   VP9E_SET_LOSSLESS, VP9E_SET_FRAME_PARALLEL_DECODING, VP9E_SET_AQ_MODE,
-  VP9E_SET_FRAME_PERIODIC_BOOST,
+  VP9E_SET_FRAME_PERIODIC_BOOST, VP9E_SET_ROW_MT,
+  VP9E_SET_LOOKAHEAD_ANALYSIS, VP9E_SET_DEADLINE_AWARE,
   0
 };
 #endif
@@ -725,6 +744,8 @@ static void parse_global_config(struct VpxEncoderConfig *global, char **argv) {
       global->disable_warning_prompt = 1;
     else if (arg_match(&arg, &experimental_bitstream, argi))
       global->experimental_bitstream = 1;
+    else if (arg_match(&arg, &segments_arg, argi))
+      global->segments = arg_parse_uint(&arg);
     else
       argj++;
   }
@@ -1311,105 +1332,112 @@ static void update_quantizer_histogram(struct stream_state *stream) {
 }
 
 
-static void get_cx_data(struct stream_state *stream,
-                        struct VpxEncoderConfig *global,
-                        int *got_data) {
-  const vpx_codec_cx_pkt_t *pkt;
+static void write_cx_pkt(struct stream_state *stream,
+                         struct VpxEncoderConfig *global,
+                         const vpx_codec_cx_pkt_t *pkt,
+                         int *got_data) {
   const struct vpx_codec_enc_cfg *cfg = &stream->config.cfg;
-  vpx_codec_iter_t iter = NULL;
+  static size_t fsize = 0;
+  static off_t ivf_header_pos = 0;
 
-  *got_data = 0;
-  while ((pkt = vpx_codec_get_cx_data(&stream->encoder, &iter))) {
-    static size_t fsize = 0;
-    static off_t ivf_header_pos = 0;
-
-    switch (pkt->kind) {
-      case VPX_CODEC_CX_FRAME_PKT:
-        if (!(pkt->data.frame.flags & VPX_FRAME_IS_FRAGMENT)) {
-          stream->frames_out++;
-        }
-        if (!global->quiet)
-          fprintf(stderr, " %6luF", (unsigned long)pkt->data.frame.sz);
+  switch (pkt->kind) {
+    case VPX_CODEC_CX_FRAME_PKT:
+      if (!(pkt->data.frame.flags & VPX_FRAME_IS_FRAGMENT)) {
+        stream->frames_out++;
+      }
+      if (!global->quiet)
+        fprintf(stderr, " %6luF", (unsigned long)pkt->data.frame.sz);
 
-        update_rate_histogram(stream->rate_hist, cfg, pkt);
+      update_rate_histogram(stream->rate_hist, cfg, pkt);
 #if CONFIG_WEBM_IO
-        if (stream->config.write_webm) {
-          /* Update the hash */
-          if (!stream->ebml.debug)
-            stream->hash = murmur(pkt->data.frame.buf,
-                                  (int)pkt->data.frame.sz,
-                                  stream->hash);
-
-          write_webm_block(&stream->ebml, cfg, pkt);
-        }
+      if (stream->config.write_webm) {
+        /* Update the hash */
+        if (!stream->ebml.debug)
+          stream->hash = murmur(pkt->data.frame.buf,
+                                (int)pkt->data.frame.sz,
+                                stream->hash);
+
+        write_webm_block(&stream->ebml, cfg, pkt);
+      }
 #endif
-        if (!stream->config.write_webm) {
-          if (pkt->data.frame.partition_id <= 0) {
-            ivf_header_pos = ftello(stream->file);
-            fsize = pkt->data.frame.sz;
-
-            ivf_write_frame_header(stream->file, pkt->data.frame.pts, fsize);
-          } else {
-            fsize += pkt->data.frame.sz;
-
-            if (!(pkt->data.frame.flags & VPX_FRAME_IS_FRAGMENT)) {
-              off_t currpos = ftello(stream->file);
-              fseeko(stream->file, ivf_header_pos, SEEK_SET);
-              ivf_write_frame_size(stream->file, fsize);
-              fseeko(stream->file, currpos, SEEK_SET);
-            }
+      if (!stream->config.write_webm) {
+        if (pkt->data.frame.partition_id <= 0) {
+          ivf_header_pos = ftello(stream->file);
+          fsize = pkt->data.frame.sz;
+
+          ivf_write_frame_header(stream->file, pkt->data.frame.pts, fsize);
+        } else {
+          fsize += pkt->data.frame.sz;
+
+          if (!(pkt->data.frame.flags & VPX_FRAME_IS_FRAGMENT)) {
+            off_t currpos = ftello(stream->file);
+            fseeko(stream->file, ivf_header_pos, SEEK_SET);
+            ivf_write_frame_size(stream->file, fsize);
+            fseeko(stream->file, currpos, SEEK_SET);
           }
-
-          (void) fwrite(pkt->data.frame.buf, 1, pkt->data.frame.sz,
-                        stream->file);
         }
-        stream->nbytes += pkt->data.raw.sz;
 
-        *got_data = 1;
+        (void) fwrite(pkt->data.frame.buf, 1, pkt->data.frame.sz,
+                      stream->file);
+      }
+      stream->nbytes += pkt->data.raw.sz;
+
+      *got_data = 1;
 #if CONFIG_DECODERS
-        if (global->test_decode != TEST_DECODE_OFF && !stream->mismatch_seen) {
-          vpx_codec_decode(&stream->decoder, pkt->data.frame.buf,
-                           (unsigned int)pkt->data.frame.sz, NULL, 0);
-          if (stream->decoder.err) {
-            warn_or_exit_on_error(&stream->decoder,
-                                  global->test_decode == TEST_DECODE_FATAL,
-                                  "Failed to decode frame %d in stream %d",
-                                  stream->frames_out + 1, stream->index);
-            stream->mismatch_seen = stream->frames_out + 1;
-          }
+      if (global->test_decode != TEST_DECODE_OFF && !stream->mismatch_seen) {
+        vpx_codec_decode(&stream->decoder, pkt->data.frame.buf,
+                         (unsigned int)pkt->data.frame.sz, NULL, 0);
+        if (stream->decoder.err) {
+          warn_or_exit_on_error(&stream->decoder,
+                                global->test_decode == TEST_DECODE_FATAL,
+                                "Failed to decode frame %d in stream %d",
+                                stream->frames_out + 1, stream->index);
+          stream->mismatch_seen = stream->frames_out + 1;
         }
+      }
 #endif
-        break;
-      case VPX_CODEC_STATS_PKT:
-        stream->frames_out++;
-        stats_write(&stream->stats,
-                    pkt->data.twopass_stats.buf,
-                    pkt->data.twopass_stats.sz);
-        stream->nbytes += pkt->data.raw.sz;
-        break;
-      case VPX_CODEC_PSNR_PKT:
+      break;
+    case VPX_CODEC_STATS_PKT:
+      stream->frames_out++;
+      stats_write(&stream->stats,
+                  pkt->data.twopass_stats.buf,
+                  pkt->data.twopass_stats.sz);
+      stream->nbytes += pkt->data.raw.sz;
+      break;
+    case VPX_CODEC_PSNR_PKT:
 
-        if (global->show_psnr) {
-          int i;
+      if (global->show_psnr) {
+        int i;
 
-          stream->psnr_sse_total += pkt->data.psnr.sse[0];
-          stream->psnr_samples_total += pkt->data.psnr.samples[0];
-          for (i = 0; i < 4; i++) {
-            if (!global->quiet)
-              fprintf(stderr, "%.3f ", pkt->data.psnr.psnr[i]);
-            stream->psnr_totals[i] += pkt->data.psnr.psnr[i];
-          }
-          stream->psnr_count++;
+        stream->psnr_sse_total += pkt->data.psnr.sse[0];
+        stream->psnr_samples_total += pkt->data.psnr.samples[0];
+        for (i = 0; i < 4; i++) {
+          if (!global->quiet)
+            fprintf(stderr, "%.3f ", pkt->data.psnr.psnr[i]);
+          stream->psnr_totals[i] += pkt->data.psnr.psnr[i];
         }
+        stream->psnr_count++;
+      }
 
-        break;
-      default:
-        break;
-    }
+      break;
+    default:
+      break;
   }
 }
 
 
+static void get_cx_data(struct stream_state *stream,
+                        struct VpxEncoderConfig *global,
+                        int *got_data) {
+  const vpx_codec_cx_pkt_t *pkt;
+  vpx_codec_iter_t iter = NULL;
+
+  *got_data = 0;
+  while ((pkt = vpx_codec_get_cx_data(&stream->encoder, &iter)))
+    write_cx_pkt(stream, global, pkt, got_data);
+}
+
+
 static void show_psnr(struct stream_state  *stream) {
   int i;
   double ovpsnr;
@@ -1511,6 +1539,275 @@ static void print_time(const char *label, int64_t etl) {
 }
 
 
+/* A closed GOP segment of the input, from one key frame to the next,
+ * encoded on its own encoder by encode_segments().
+ */
+struct segment {
+  int                       first_frame;  /* Index among the frames encoded */
+  int                       num_frames;
+  off_t                     offset;       /* Input position of first_frame */
+  struct stream_state       stream;       /* Copy of the output stream */
+  vpx_codec_cx_pkt_t       *pkts;
+  int                       pkt_cnt;
+  int                       pkt_alloc;
+  int                       done;         /* Encoded, packets not written */
+};
+
+
+struct segment_queue {
+  struct VpxEncoderConfig  *global;
+  struct VpxInputContext   *input;
+  struct segment           *segments;
+  int                       segment_cnt;
+  int                       next_segment;
+#if CONFIG_MULTITHREAD && HAVE_PTHREAD_H
+  pthread_mutex_t           mutex;
+  pthread_cond_t            done_cond;
+#endif
+};
+
+
+/* Reads the input through, splitting the frames to encode into segments of
+ * segment_frames frames. Returns the number of frames read.
+ */
+static int scan_segments(struct segment_queue *queue, vpx_image_t *raw,
+                         int segment_frames) {
+  struct VpxEncoderConfig *const global = queue->global;
+  struct VpxInputContext *const input = queue->input;
+  int frames_in = 0;
+
+  while (!global->limit || frames_in < global->limit) {
+    const off_t offset = ftello(input->file);
+    int frame;
+
+    if (!read_frame(input, raw))
+      break;
+    frames_in++;
+    if (frames_in <= global->skip_frames)
+      continue;
+
+    frame = frames_in - global->skip_frames - 1;
+    if (frame % segment_frames == 0) {
+      struct segment *segment;
+
+      queue->segments = realloc(queue->segments, (queue->segment_cnt + 1) *
+                                                 sizeof(*queue->segments));
+      if (!queue->segments)
+        fatal("Failed to allocate segments.");
+      segment = &queue->segments[queue->segment_cnt++];
+      memset(segment, 0, sizeof(*segment));
+      segment->first_frame = frame;
+      segment->offset = offset;
+    }
+    queue->segments[queue->segment_cnt - 1].num_frames++;
+  }
+  return frames_in;
+}
+
+
+static void store_cx_data(struct segment *segment, int *got_data) {
+  const vpx_codec_cx_pkt_t *pkt;
+  vpx_codec_iter_t iter = NULL;
+
+  *got_data = 0;
+  while ((pkt = vpx_codec_get_cx_data(&segment->stream.encoder, &iter))) {
+    vpx_codec_cx_pkt_t *copy;
+
+    if (pkt->kind != VPX_CODEC_CX_FRAME_PKT &&
+        pkt->kind != VPX_CODEC_PSNR_PKT)
+      continue;
+
+    if (segment->pkt_cnt == segment->pkt_alloc) {
+      segment->pkt_alloc = segment->pkt_alloc ? 2 * segment->pkt_alloc : 64;
+      segment->pkts = realloc(segment->pkts,
+                              segment->pkt_alloc * sizeof(*segment->pkts));
+      if (!segment->pkts)
+        fatal("Failed to allocate packets.");
+    }
+    copy = &segment->pkts[segment->pkt_cnt++];
+    *copy = *pkt;
+    if (pkt->kind == VPX_CODEC_CX_FRAME_PKT) {
+      copy->data.frame.buf = malloc(pkt->data.frame.sz);
+      if (!copy->data.frame.buf)
+        fatal("Failed to allocate packet data.");
+      memcpy(copy->data.frame.buf, pkt->data.frame.buf, pkt->data.frame.sz);
+      *got_data = 1;
+    }
+  }
+}
+
+
+/* Encodes a segment on its own encoder and input file, keeping its packets
+ * for the output to be written in order.
+ */
+static void encode_segment(struct segment_queue *queue,
+                           struct segment *segment) {
+  struct VpxEncoderConfig *const global = queue->global;
+  struct stream_state *const stream = &segment->stream;
+  struct VpxInputContext input = *queue->input;
+  vpx_image_t raw;
+  int frames_in = global->skip_frames + segment->first_frame;
+  int frame_avail = 1, got_data = 0;
+
+  open_input_file(&input);
+  if (segment->first_frame + global->skip_frames > 0) {
+    if (fseeko(input.file, segment->offset, SEEK_SET))
+      fatal("Failed to seek to frame %d", frames_in);
+    /* The file type detection bytes belong to the first frame. */
+    input.detect.position = input.detect.buf_read;
+  }
+
+  if (input.file_type == FILE_TYPE_Y4M)
+    memset(&raw, 0, sizeof(raw));
+  else
+    vpx_img_alloc(&raw, input.use_i420 ? VPX_IMG_FMT_I420 : VPX_IMG_FMT_YV12,
+                  input.width, input.height, 32);
+
+  initialize_encoder(stream, global);
+#if CONFIG_VP9_ENCODER
+  if (stream->config.cfg.g_pass == VPX_RC_LAST_PASS) {
+    vpx_twopass_range_t range;
+
+    range.first_frame = segment->first_frame;
+    range.num_frames = segment->num_frames;
+    vpx_codec_control(&stream->encoder, VP9E_SET_TWOPASS_RANGE, &range);
+    ctx_exit_on_error(&stream->encoder, "Failed to set the two pass range");
+  }
+#endif
+
+  while (frame_avail || got_data) {
+    frame_avail = frames_in < global->skip_frames + segment->first_frame +
+                              segment->num_frames && read_frame(&input, &raw);
+    if (frame_avail)
+      frames_in++;
+
+    encode_frame(stream, global, frame_avail ? &raw : NULL, frames_in);
+    update_quantizer_histogram(stream);
+    store_cx_data(segment, &got_data);
+  }
+
+  vpx_codec_destroy(&stream->encoder);
+  if (stream->img)
+    vpx_img_free(stream->img);
+  vpx_img_free(&raw);
+  close_input_file(&input);
+}
+
+
+#if CONFIG_MULTITHREAD && HAVE_PTHREAD_H
+static void *segment_worker(void *arg) {
+  struct segment_queue *const queue = (struct segment_queue *)arg;
+
+  for (;;) {
+    struct segment *segment;
+
+    pthread_mutex_lock(&queue->mutex);
+    segment = queue->next_segment < queue->segment_cnt ?
+              &queue->segments[queue->next_segment++] : NULL;
+    pthread_mutex_unlock(&queue->mutex);
+    if (!segment)
+      break;
+
+    encode_segment(queue, segment);
+
+    pthread_mutex_lock(&queue->mutex);
+    segment->done = 1;
+    pthread_cond_broadcast(&queue->done_cond);
+    pthread_mutex_unlock(&queue->mutex);
+  }
+  return NULL;
+}
+#endif
+
+
+/* Splits the input into closed GOP segments of kf_max_dist frames and
+ * encodes them on global->segments encoders in parallel, each from its key
+ * frame. In the last pass, each segment encodes its range of the first pass
+ * stats of the whole clip, which gives it its share of the bits. The packets
+ * are written to the stream in order as the segments complete. Returns the
+ * number of frames read.
+ */
+static int encode_segments(struct stream_state *stream,
+                           struct VpxEncoderConfig *global,
+                           struct VpxInputContext *input,
+                           vpx_image_t *raw) {
+  struct segment_queue queue;
+  int frames_in, i, j;
+#if CONFIG_MULTITHREAD && HAVE_PTHREAD_H
+  pthread_t *threads;
+  int thread_cnt;
+#endif
+
+  memset(&queue, 0, sizeof(queue));
+  queue.global = global;
+  queue.input = input;
+  frames_in = scan_segments(&queue, raw, stream->config.cfg.kf_max_dist);
+
+  for (i = 0; i < queue.segment_cnt; i++) {
+    struct stream_state *const segment_stream = &queue.segments[i].stream;
+
+    *segment_stream = *stream;
+    memset(&segment_stream->encoder, 0, sizeof(segment_stream->encoder));
+    memset(segment_stream->counts, 0, sizeof(segment_stream->counts));
+    segment_stream->img = NULL;
+    segment_stream->file = NULL;
+  }
+
+#if CONFIG_MULTITHREAD && HAVE_PTHREAD_H
+  thread_cnt = global->segments < queue.segment_cnt ? global->segments
+                                                    : queue.segment_cnt;
+  threads = calloc(thread_cnt, sizeof(*threads));
+  if (thread_cnt && !threads)
+    fatal("Failed to allocate segment threads.");
+  pthread_mutex_init(&queue.mutex, NULL);
+  pthread_cond_init(&queue.done_cond, NULL);
+  for (i = 0; i < thread_cnt; i++)
+    if (pthread_create(&threads[i], NULL, segment_worker, &queue))
+      fatal("Failed to create segment thread.");
+#endif
+
+  for (i = 0; i < queue.segment_cnt; i++) {
+    struct segment *const segment = &queue.segments[i];
+    int got_data;
+
+#if CONFIG_MULTITHREAD && HAVE_PTHREAD_H
+    pthread_mutex_lock(&queue.mutex);
+    while (!segment->done)
+      pthread_cond_wait(&queue.done_cond, &queue.mutex);
+    pthread_mutex_unlock(&queue.mutex);
+#else
+    encode_segment(&queue, segment);
+#endif
+
+    for (j = 0; j < segment->pkt_cnt; j++) {
+      write_cx_pkt(stream, global, &segment->pkts[j], &got_data);
+      if (segment->pkts[j].kind == VPX_CODEC_CX_FRAME_PKT)
+        free(segment->pkts[j].data.frame.buf);
+    }
+    free(segment->pkts);
+    for (j = 0; j < 64; j++)
+      stream->counts[j] += segment->stream.counts[j];
+
+    if (!global->quiet)
+      fprintf(stderr, "\rPass %d/%d segment %4d/%-4d %7"PRId64"B\033[K",
+              stream->config.cfg.g_pass == VPX_RC_LAST_PASS ? 2 : 1,
+              global->passes, i + 1, queue.segment_cnt,
+              (int64_t)stream->nbytes);
+  }
+
+#if CONFIG_MULTITHREAD && HAVE_PTHREAD_H
+  for (i = 0; i < thread_cnt; i++)
+    pthread_join(threads[i], NULL);
+  free(threads);
+  pthread_cond_destroy(&queue.done_cond);
+  pthread_mutex_destroy(&queue.mutex);
+#endif
+
+  free(queue.segments);
+  return frames_in;
+}
+
+
 int main(int argc, const char **argv_) {
   int pass;
   vpx_image_t raw;
@@ -1631,6 +1928,23 @@ int main(int argc, const char **argv_) {
 
     FOREACH_STREAM(set_default_kf_interval(stream, &global));
 
+    if (global.segments > 1) {
+      if (stream_cnt > 1)
+        die("Error: --%s supports a single stream\n", segments_arg.long_name);
+      if (global.test_decode != TEST_DECODE_OFF || global.out_part)
+        die("Error: --%s supports neither --%s nor --%s\n",
+            segments_arg.long_name, recontest.long_name, out_part.long_name);
+      if (!strcmp(input.filename, "-"))
+        die("Error: --%s requires an input file\n", segments_arg.long_name);
+      if (streams->config.cfg.kf_mode == VPX_KF_DISABLED ||
+          !streams->config.cfg.kf_max_dist)
+        die("Error: --%s requires a --%s\n", segments_arg.long_name,
+            kf_max_dist.long_name);
+      if (global.passes == 2 && strcmp(global.codec->name, "vp9"))
+        die("Error: --%s in two pass mode requires vp9\n",
+            segments_arg.long_name);
+    }
+
     /* Show configuration */
     if (global.verbose && pass == 0)
       FOREACH_STREAM(show_stream_config(stream, &global, &input));
@@ -1654,9 +1968,21 @@ int main(int argc, const char **argv_) {
 
     FOREACH_STREAM(setup_pass(stream, &global, pass));
     FOREACH_STREAM(open_output_file(stream, &global));
-    FOREACH_STREAM(initialize_encoder(stream, &global));
+    if (global.segments > 1 &&
+        streams->config.cfg.g_pass != VPX_RC_FIRST_PASS) {
+      struct vpx_usec_timer timer;
 
-    frame_avail = 1;
+      vpx_usec_timer_start(&timer);
+      frames_in = encode_segments(streams, &global, &input, &raw);
+      vpx_usec_timer_mark(&timer);
+      cx_time = streams->cx_time = vpx_usec_timer_elapsed(&timer);
+      seen_frames = frames_in > global.skip_frames ?
+                        frames_in - global.skip_frames : 0;
+      frame_avail = 0;
+    } else {
+      FOREACH_STREAM(initialize_encoder(stream, &global));
+      frame_avail = 1;
+    }
     got_data = 0;
 
     while (frame_avail || got_data) {
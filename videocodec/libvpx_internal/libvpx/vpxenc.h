@@ -47,6 +47,7 @@ struct VpxEncoderConfig {
   int disable_warnings;
   int disable_warning_prompt;
   int experimental_bitstream;
+  int segments;
 };
 
 #ifdef __cplusplus
@@ -311,6 +311,10 @@ void vp9_idct4x4_16_add_c(const int16_t *input, uint8_t *dest, int dest_stride);
 void vp9_idct4x4_16_add_sse2(const int16_t *input, uint8_t *dest, int dest_stride);
 RTCD_EXTERN void (*vp9_idct4x4_16_add)(const int16_t *input, uint8_t *dest, int dest_stride);
 
+void vp9_idct4x4_16_add_x4_c(int16_t *const *input, uint8_t *const *dest, int dest_stride);
+void vp9_idct4x4_16_add_x4_sse2(int16_t *const *input, uint8_t *const *dest, int dest_stride);
+RTCD_EXTERN void (*vp9_idct4x4_16_add_x4)(int16_t *const *input, uint8_t *const *dest, int dest_stride);
+
 void vp9_idct8x8_1_add_c(const int16_t *input, uint8_t *dest, int dest_stride);
 void vp9_idct8x8_1_add_sse2(const int16_t *input, uint8_t *dest, int dest_stride);
 RTCD_EXTERN void (*vp9_idct8x8_1_add)(const int16_t *input, uint8_t *dest, int dest_stride);
@@ -574,6 +578,9 @@ static void setup_rtcd_internal(void)
     vp9_idct4x4_16_add = vp9_idct4x4_16_add_c;
     if (flags & HAS_SSE2) vp9_idct4x4_16_add = vp9_idct4x4_16_add_sse2;
 
+    vp9_idct4x4_16_add_x4 = vp9_idct4x4_16_add_x4_c;
+    if (flags & HAS_SSE2) vp9_idct4x4_16_add_x4 = vp9_idct4x4_16_add_x4_sse2;
+
     vp9_idct8x8_1_add = vp9_idct8x8_1_add_c;
     if (flags & HAS_SSE2) vp9_idct8x8_1_add = vp9_idct8x8_1_add_sse2;
 
@@ -0,0 +1,347 @@
+/*
+* Copyright (c) 2014 Intel Corporation.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+// Host test of VP9DecodeQueue. A fake decoder stands in for libvpx and a fake
+// port harness drives the queue the way OMXVideoDecoderVP9HWR::ProcessorProcess
+// does: inputs are queued until the queue is full, and frames are taken out
+// and held by the "client" for a while before their buffers are returned.
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "VP9DecodeQueue.h"
+
+static int gFailures = 0;
+
+#define CHECK(cond)                                                        \
+    do {                                                                   \
+        if (!(cond)) {                                                     \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            gFailures++;                                                   \
+        }                                                                  \
+    } while (0)
+
+enum {
+    FLAG_EOS = 1,
+    NUM_FRAME_BUFFERS = 6,
+    INPUT_DEPTH = 2,
+    OUTPUT_DEPTH = 3,
+};
+
+// Decodes inputs holding a frame number into one frame each, using one of
+// NUM_FRAME_BUFFERS buffers. Can be gated to hold the decode thread.
+class FakeDecoder : public VP9DecodeQueue::Decoder {
+public:
+    FakeDecoder() : mGated(false), mDecoded(0), mDecoding(0) {
+        pthread_mutex_init(&mLock, NULL);
+        pthread_cond_init(&mCond, NULL);
+        memset(mHeld, 0, sizeof(mHeld));
+    }
+
+    virtual ~FakeDecoder() {
+        pthread_cond_destroy(&mCond);
+        pthread_mutex_destroy(&mLock);
+    }
+
+    virtual int decodeInput(const VP9DecodeQueue::InputBuffer &input,
+                            VP9DecodeQueue::OutputFrame *frames, int maxFrames) {
+        pthread_mutex_lock(&mLock);
+        mDecoding++;
+        pthread_cond_broadcast(&mCond);
+        while (mGated) {
+            pthread_cond_wait(&mCond, &mLock);
+        }
+        mDecoding--;
+        pthread_mutex_unlock(&mLock);
+
+        CHECK(maxFrames >= 1);
+        memset(&frames[0], 0, sizeof(frames[0]));
+        frames[0].timeStamp = input.timeStamp;
+        frames[0].flags = input.flags;
+        if (input.size == 0) {
+            return 1;
+        }
+        if (input.size != sizeof(int)) {
+            frames[0].status = -1;
+            return 1;
+        }
+
+        int fb = takeBuffer();
+        CHECK(fb >= 0);
+        int number;
+        memcpy(&number, input.data, sizeof(number));
+        frames[0].hasImage = true;
+        frames[0].image.fb_index = fb;
+        frames[0].image.user_priv = (void *)(intptr_t)number;
+        __sync_fetch_and_add(&mDecoded, 1);
+        return 1;
+    }
+
+    virtual bool canDecode() {
+        pthread_mutex_lock(&mLock);
+        int free = 0;
+        for (int i = 0; i < NUM_FRAME_BUFFERS; i++) {
+            free += !mHeld[i];
+        }
+        pthread_mutex_unlock(&mLock);
+        return free > 0;
+    }
+
+    virtual void dropFrame(const VP9DecodeQueue::OutputFrame &frame) {
+        if (frame.hasImage) {
+            releaseBuffer(frame.image.fb_index);
+        }
+    }
+
+    int takeBuffer() {
+        pthread_mutex_lock(&mLock);
+        for (int i = 0; i < NUM_FRAME_BUFFERS; i++) {
+            if (!mHeld[i]) {
+                mHeld[i] = true;
+                pthread_mutex_unlock(&mLock);
+                return i;
+            }
+        }
+        pthread_mutex_unlock(&mLock);
+        return -1;
+    }
+
+    void releaseBuffer(int fb) {
+        pthread_mutex_lock(&mLock);
+        CHECK(mHeld[fb]);
+        mHeld[fb] = false;
+        pthread_mutex_unlock(&mLock);
+    }
+
+    int heldBuffers() {
+        pthread_mutex_lock(&mLock);
+        int held = 0;
+        for (int i = 0; i < NUM_FRAME_BUFFERS; i++) {
+            held += mHeld[i];
+        }
+        pthread_mutex_unlock(&mLock);
+        return held;
+    }
+
+    void setGate(bool gated) {
+        pthread_mutex_lock(&mLock);
+        mGated = gated;
+        pthread_cond_broadcast(&mCond);
+        pthread_mutex_unlock(&mLock);
+    }
+
+    // Waits until the decode thread is held at the gate.
+    void waitAtGate() {
+        pthread_mutex_lock(&mLock);
+        while (mDecoding == 0) {
+            pthread_cond_wait(&mCond, &mLock);
+        }
+        pthread_mutex_unlock(&mLock);
+    }
+
+    int decoded() {
+        return __sync_fetch_and_add(&mDecoded, 0);
+    }
+
+private:
+    pthread_mutex_t mLock;
+    pthread_cond_t mCond;
+    bool mGated;
+    bool mHeld[NUM_FRAME_BUFFERS];
+    volatile int mDecoded;
+    int mDecoding;
+};
+
+// Feeds |numFrames| inputs and an EOS through the queue like the OMX ports
+// do, with the client holding |clientDepth| frames. Checks that every frame
+// comes out once, in order, with its time stamp.
+static void RunPorts(int numFrames, int clientDepth)
+{
+    FakeDecoder decoder;
+    VP9DecodeQueue queue(&decoder, INPUT_DEPTH, OUTPUT_DEPTH, 1);
+    CHECK(queue.start());
+
+    int client[NUM_FRAME_BUFFERS];
+    int numClient = 0;
+    int next = 0;
+    int expected = 0;
+    bool eosQueued = false;
+    bool eosDone = false;
+    int calls = 0;
+
+    while (!eosDone && calls++ < 100000) {
+        // Input port.
+        bool inputRetained = false;
+        if (next < numFrames) {
+            if (queue.queueInput((const uint8_t *)&next, sizeof(next), next * 1000, 0)) {
+                next++;
+            } else {
+                inputRetained = true;
+            }
+        } else if (!eosQueued) {
+            eosQueued = queue.queueInput(NULL, 0, 0, FLAG_EOS);
+            inputRetained = !eosQueued;
+        }
+
+        // Output port.
+        VP9DecodeQueue::OutputFrame frame;
+        bool dequeued = queue.dequeueOutput(&frame, inputRetained || eosQueued);
+        if (dequeued) {
+            CHECK(frame.status == 0);
+            if (frame.hasImage) {
+                CHECK((intptr_t)frame.image.user_priv == expected);
+                CHECK(frame.timeStamp == expected * 1000);
+                expected++;
+                client[numClient++] = frame.image.fb_index;
+            }
+            if (frame.flags & FLAG_EOS) {
+                CHECK(!frame.hasImage);
+                eosDone = true;
+            }
+        }
+
+        // The client returns its oldest frame once it holds enough of them,
+        // or when it gets nothing back.
+        if (numClient > clientDepth || (!dequeued && numClient > 0)) {
+            decoder.releaseBuffer(client[0]);
+            memmove(&client[0], &client[1], --numClient * sizeof(client[0]));
+            queue.signal();
+        }
+        while (eosDone && numClient > 0) {
+            decoder.releaseBuffer(client[--numClient]);
+        }
+    }
+
+    CHECK(eosDone);
+    CHECK(expected == numFrames);
+    CHECK(decoder.heldBuffers() == 0);
+    queue.stop();
+}
+
+// Inputs are accepted while a frame decodes, up to the queue depth.
+static void TestInputDoesNotWaitForDecode()
+{
+    FakeDecoder decoder;
+    VP9DecodeQueue queue(&decoder, INPUT_DEPTH, OUTPUT_DEPTH, 1);
+    CHECK(queue.start());
+    decoder.setGate(true);
+
+    int number = 0;
+    CHECK(queue.queueInput((const uint8_t *)&number, sizeof(number), 0, 0));
+    decoder.waitAtGate();
+    for (int i = 1; i < INPUT_DEPTH; i++) {
+        number++;
+        CHECK(queue.queueInput((const uint8_t *)&number, sizeof(number), 0, 0));
+    }
+    // The input being decoded keeps its slot until it is done.
+    CHECK(queue.isInputFull());
+    CHECK(!queue.queueInput((const uint8_t *)&number, sizeof(number), 0, 0));
+
+    VP9DecodeQueue::OutputFrame frame;
+    CHECK(!queue.dequeueOutput(&frame, false));
+    decoder.setGate(false);
+    CHECK(queue.dequeueOutput(&frame, true));
+    CHECK((intptr_t)frame.image.user_priv == 0);
+    decoder.dropFrame(frame);
+    queue.stop();
+    CHECK(decoder.heldBuffers() == 0);
+}
+
+// The decode thread waits for frame buffers instead of failing.
+static void TestWaitsForFrameBuffers()
+{
+    FakeDecoder decoder;
+    VP9DecodeQueue queue(&decoder, INPUT_DEPTH, OUTPUT_DEPTH, 1);
+    CHECK(queue.start());
+
+    int held[NUM_FRAME_BUFFERS];
+    for (int i = 0; i < NUM_FRAME_BUFFERS; i++) {
+        held[i] = decoder.takeBuffer();
+    }
+    int number = 7;
+    CHECK(queue.queueInput((const uint8_t *)&number, sizeof(number), 0, 0));
+    CHECK(!queue.isOutputPending());
+
+    VP9DecodeQueue::OutputFrame frame;
+    CHECK(!queue.dequeueOutput(&frame, true));
+    CHECK(decoder.decoded() == 0);
+
+    decoder.releaseBuffer(held[0]);
+    queue.signal();
+    CHECK(queue.dequeueOutput(&frame, true));
+    CHECK(frame.image.fb_index == held[0]);
+    decoder.dropFrame(frame);
+    for (int i = 1; i < NUM_FRAME_BUFFERS; i++) {
+        decoder.releaseBuffer(held[i]);
+    }
+    queue.stop();
+}
+
+// Flushing drops queued inputs and frames and releases their buffers; decoding
+// goes on with the inputs queued afterwards. Nothing is decoded while paused.
+static void TestFlushAndPause()
+{
+    FakeDecoder decoder;
+    VP9DecodeQueue queue(&decoder, INPUT_DEPTH, OUTPUT_DEPTH, 1);
+    CHECK(queue.start());
+
+    int number;
+    for (number = 0; number < INPUT_DEPTH; number++) {
+        CHECK(queue.queueInput((const uint8_t *)&number, sizeof(number), 0, 0));
+    }
+    while (decoder.decoded() < INPUT_DEPTH) {
+        usleep(1000);
+    }
+    queue.flush();
+    CHECK(decoder.heldBuffers() == 0);
+    VP9DecodeQueue::OutputFrame frame;
+    CHECK(!queue.dequeueOutput(&frame, true));
+
+    queue.pause();
+    CHECK(queue.queueInput((const uint8_t *)&number, sizeof(number), 0, 0));
+    CHECK(!queue.isOutputPending());
+    usleep(10000);
+    CHECK(decoder.decoded() == INPUT_DEPTH);
+    queue.resume();
+    CHECK(queue.dequeueOutput(&frame, true));
+    CHECK((intptr_t)frame.image.user_priv == number);
+    decoder.dropFrame(frame);
+
+    // Inputs that fail to decode come back as frames without an image.
+    CHECK(queue.queueInput((const uint8_t *)"x", 1, 0, 0));
+    CHECK(queue.dequeueOutput(&frame, true));
+    CHECK(!frame.hasImage && frame.status != 0);
+
+    queue.stop();
+    CHECK(decoder.heldBuffers() == 0);
+}
+
+int main()
+{
+    RunPorts(200, 0);
+    RunPorts(200, 2);
+    RunPorts(200, NUM_FRAME_BUFFERS - 1);
+    TestInputDoesNotWaitForDecode();
+    TestWaitsForFrameBuffers();
+    TestFlushAndPause();
+
+    if (gFailures) {
+        fprintf(stderr, "%d checks failed.\n", gFailures);
+        return 1;
+    }
+    printf("All tests passed.\n");
+    return 0;
+}